@@ -977,24 +977,46 @@ IREE_API_EXPORT iree_time_t iree_time_now() {
   FILETIME system_time;
   GetSystemTimePreciseAsFileTime(&system_time);
 
+  // FILETIME is in 100ns ticks since 1601-01-01.
   const int64_t kUnixEpochStartTicks = 116444736000000000i64;
-  const int64_t kFtToMicroSec = 10;
+  const int64_t kFtToNanoSec = 100;
   LARGE_INTEGER li;
   li.LowPart = system_time.dwLowDateTime;
   li.HighPart = system_time.dwHighDateTime;
   li.QuadPart -= kUnixEpochStartTicks;
-  li.QuadPart /= kFtToMicroSec;
-  return li.QuadPart;
+  return li.QuadPart * kFtToNanoSec;
 #elif defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_APPLE) || \
     defined(IREE_PLATFORM_LINUX)
   struct timespec clock_time;
   clock_gettime(CLOCK_REALTIME, &clock_time);
-  return clock_time.tv_nsec;
+  return (iree_time_t)clock_time.tv_sec * 1000000000ll + clock_time.tv_nsec;
 #else
 #error "IREE system clock needs to be set up for your platform"
 #endif  // IREE_PLATFORM_*
 }
 
+IREE_API_EXPORT iree_time_t iree_time_monotonic_now() {
+#if defined(IREE_PLATFORM_WINDOWS)
+  LARGE_INTEGER counter;
+  LARGE_INTEGER frequency;
+  QueryPerformanceCounter(&counter);
+  QueryPerformanceFrequency(&frequency);
+  // Split into whole seconds and the remainder to avoid overflowing when
+  // scaling large tick counts to nanoseconds.
+  int64_t seconds = counter.QuadPart / frequency.QuadPart;
+  int64_t remainder_ticks = counter.QuadPart % frequency.QuadPart;
+  return seconds * 1000000000ll +
+         remainder_ticks * 1000000000ll / frequency.QuadPart;
+#elif defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_APPLE) || \
+    defined(IREE_PLATFORM_LINUX)
+  struct timespec clock_time;
+  clock_gettime(CLOCK_MONOTONIC, &clock_time);
+  return (iree_time_t)clock_time.tv_sec * 1000000000ll + clock_time.tv_nsec;
+#else
+#error "IREE monotonic clock needs to be set up for your platform"
+#endif  // IREE_PLATFORM_*
+}
+
 IREE_API_EXPORT iree_time_t
 iree_relative_timeout_to_deadline_ns(iree_duration_t timeout_ns) {
   if (timeout_ns == IREE_DURATION_ZERO) {
@@ -786,6 +786,13 @@ typedef int64_t iree_duration_t;
 // times they check for negative values in case the time moves backwards.
 IREE_API_EXPORT iree_time_t iree_time_now();
 
+// Returns the current time of a monotonic clock in nanoseconds.
+// The epoch is unspecified (usually system boot) and the result is only
+// meaningful when compared with other values returned by this function, such
+// as when measuring durations. Unlike iree_time_now the clock never moves
+// backwards and is unaffected by changes to the system time.
+IREE_API_EXPORT iree_time_t iree_time_monotonic_now();
+
 // Converts a relative timeout duration to an absolute deadline time.
 // This handles the special cases of IREE_DURATION_ZERO and
 // IREE_DURATION_INFINITE to avoid extraneous time queries.
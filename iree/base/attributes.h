@@ -87,6 +87,20 @@
 #define IREE_RESTRICT restrict
 #endif  // _MSC_VER
 
+//===----------------------------------------------------------------------===//
+// IREE_THREAD_LOCAL
+//===----------------------------------------------------------------------===//
+
+// Declares a variable with thread storage duration (one instance per thread).
+// Only use on variables with trivial initialization and destruction.
+#if defined(__cplusplus)
+#define IREE_THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+#define IREE_THREAD_LOCAL __declspec(thread)
+#else
+#define IREE_THREAD_LOCAL _Thread_local
+#endif  // __cplusplus / _MSC_VER
+
 //===----------------------------------------------------------------------===//
 // IREE_ATTRIBUTE_ALWAYS_INLINE / IREE_ATTRIBUTE_NOINLINE
 //===----------------------------------------------------------------------===//
@@ -18,6 +18,7 @@
 #include <string>
 
 #include "absl/strings/string_view.h"
+#include "iree/base/api.h"
 #include "iree/base/status.h"
 
 namespace iree {
@@ -32,6 +33,22 @@ Status FileExists(const std::string& path);
 // Synchronously reads a file's contents into a string.
 Status GetFileContents(const std::string& path, std::string* out_contents);
 
+// Maps a file's contents into memory read-only.
+//
+// |out_contents| references the file pages directly and remains valid until it
+// is freed with |out_deallocator|:
+//   iree_allocator_free(deallocator, (void*)contents.data);
+// The deallocator can be handed to APIs that take ownership of their input
+// (such as iree_vm_bytecode_module_create) so that data such as rodata stays in
+// the mapped pages for the lifetime of the consumer instead of being copied.
+//
+// Files that cannot be mapped (pipes, character devices, etc) are read into a
+// heap allocation and |out_deallocator| will free that instead. Empty files
+// produce an empty span and iree_allocator_null.
+Status MapFileContents(const std::string& path,
+                       iree_const_byte_span_t* out_contents,
+                       iree_allocator_t* out_deallocator);
+
 // Synchronously writes a string into a file, overwriting its contents.
 Status SetFileContents(const std::string& path, absl::string_view content);
 
@@ -17,6 +17,8 @@
 #if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_APPLE) || \
     defined(IREE_PLATFORM_LINUX)
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -74,6 +76,103 @@ Status GetFileContents(const std::string& path, std::string* out_contents) {
   return OkStatus();
 }
 
+// iree_allocator_t free function for mappings made by MapFileContents.
+// munmap requires the mapping length so it is carried in |self|.
+static void UnmapFileContents(void* self, void* ptr) {
+  ::munmap(ptr, (size_t)(uintptr_t)self);
+}
+
+// Reads |fd| until EOF into a system allocation. Used for files that can't be
+// mapped or seeked, such as pipes and character devices.
+static Status ReadFileDescriptorContents(int fd, const std::string& path,
+                                         iree_const_byte_span_t* out_contents) {
+  iree_allocator_t allocator = iree_allocator_system();
+  void* data = NULL;
+  size_t capacity = 0;
+  size_t length = 0;
+  for (;;) {
+    if (length == capacity) {
+      capacity = capacity ? capacity * 2 : 64 * 1024;
+      iree_status_t status = iree_allocator_realloc(allocator, capacity, &data);
+      if (!iree_status_is_ok(status)) {
+        iree_allocator_free(allocator, data);
+        return status;
+      }
+    }
+    ssize_t read_length =
+        ::read(fd, (uint8_t*)data + length, capacity - length);
+    if (read_length == 0) break;
+    if (read_length == -1) {
+      if (errno == EINTR) continue;
+      int read_errno = errno;
+      iree_allocator_free(allocator, data);
+      return iree_make_status(iree_status_code_from_errno(read_errno),
+                              "failed to read '%s'", path.c_str());
+    }
+    length += (size_t)read_length;
+  }
+  if (length == 0) {
+    iree_allocator_free(allocator, data);
+    return OkStatus();
+  }
+  *out_contents = iree_make_const_byte_span(data, length);
+  return OkStatus();
+}
+
+Status MapFileContents(const std::string& path,
+                       iree_const_byte_span_t* out_contents,
+                       iree_allocator_t* out_deallocator) {
+  IREE_TRACE_SCOPE0("file_io::MapFileContents");
+  *out_contents = iree_make_const_byte_span(NULL, 0);
+  *out_deallocator = iree_allocator_null();
+
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to open file '%s'", path.c_str());
+  }
+  struct stat stat_buf;
+  if (::fstat(fd, &stat_buf) == -1) {
+    int stat_errno = errno;
+    ::close(fd);
+    return iree_make_status(iree_status_code_from_errno(stat_errno),
+                            "size query of '%s'", path.c_str());
+  }
+
+  if (!S_ISREG(stat_buf.st_mode)) {
+    // Not mappable; read into a heap allocation instead.
+    Status status = ReadFileDescriptorContents(fd, path, out_contents);
+    ::close(fd);
+    if (status.ok() && out_contents->data_length > 0) {
+      *out_deallocator = iree_allocator_system();
+    }
+    return status;
+  }
+
+  size_t file_size = (size_t)stat_buf.st_size;
+  if (file_size == 0) {
+    ::close(fd);
+    return OkStatus();
+  }
+
+  // The mapping holds its own reference to the file so we can close the fd
+  // immediately. Pages are faulted in lazily as they are touched so large
+  // rodata that is never used never becomes resident.
+  void* data = ::mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  int mmap_errno = errno;
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return iree_make_status(iree_status_code_from_errno(mmap_errno),
+                            "failed to map %zu bytes of '%s'", file_size,
+                            path.c_str());
+  }
+
+  *out_contents = iree_make_const_byte_span(data, file_size);
+  out_deallocator->self = (void*)(uintptr_t)file_size;
+  out_deallocator->free = UnmapFileContents;
+  return OkStatus();
+}
+
 Status SetFileContents(const std::string& path, absl::string_view content) {
   IREE_TRACE_SCOPE0("file_io::SetFileContents");
   std::unique_ptr<FILE, void (*)(FILE*)> file = {std::fopen(path.c_str(), "wb"),
@@ -84,7 +183,8 @@ Status SetFileContents(const std::string& path, absl::string_view content) {
     return iree_make_status(iree_status_code_from_errno(errno),
                             "failed to open file '%s'", path.c_str());
   }
-  if (std::fwrite(const_cast<char*>(content.data()), content.size(), 1,
+  if (!content.empty() &&
+      std::fwrite(const_cast<char*>(content.data()), content.size(), 1,
                   file.get()) != 1) {
     return iree_make_status(IREE_STATUS_UNAVAILABLE,
                             "unable to write entire file contents of '%.*s'",
@@ -14,14 +14,21 @@
 
 #include "iree/base/internal/file_io.h"
 
+#include <thread>
+
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "iree/base/internal/file_path.h"
 #include "iree/base/logging.h"
 #include "iree/base/status.h"
+#include "iree/base/target_platform.h"
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
 
+#if defined(IREE_PLATFORM_LINUX)
+#include <unistd.h>
+#endif  // IREE_PLATFORM_LINUX
+
 namespace iree {
 namespace file_io {
 namespace {
@@ -51,6 +58,75 @@ TEST(FileIo, GetSetContents) {
   EXPECT_EQ(to_write, read);
 }
 
+TEST(FileIo, MapContents) {
+  std::string unique_name = "MapContents";
+  auto path = GetUniquePath(unique_name);
+  ASSERT_THAT(FileExists(path), StatusIs(StatusCode::kNotFound));
+  auto to_write = GetUniqueContents(unique_name);
+
+  IREE_ASSERT_OK(SetFileContents(path, to_write));
+  iree_const_byte_span_t contents;
+  iree_allocator_t deallocator;
+  IREE_ASSERT_OK(MapFileContents(path, &contents, &deallocator));
+  EXPECT_EQ(to_write,
+            absl::string_view(reinterpret_cast<const char*>(contents.data),
+                              contents.data_length));
+  iree_allocator_free(deallocator, (void*)contents.data);
+  IREE_ASSERT_OK(DeleteFile(path));
+}
+
+TEST(FileIo, MapEmptyContents) {
+  auto path = GetUniquePath("MapEmptyContents");
+  IREE_ASSERT_OK(SetFileContents(path, ""));
+  iree_const_byte_span_t contents;
+  iree_allocator_t deallocator;
+  IREE_ASSERT_OK(MapFileContents(path, &contents, &deallocator));
+  EXPECT_EQ(0, contents.data_length);
+  iree_allocator_free(deallocator, (void*)contents.data);
+}
+
+#if defined(IREE_PLATFORM_LINUX)
+// Pipes can't be mapped and must be read until EOF instead. The contents are
+// larger than a single read so that the buffer has to grow.
+TEST(FileIo, MapPipeContents) {
+  int fds[2];
+  ASSERT_EQ(0, ::pipe(fds));
+  std::string to_write(300 * 1024, 'x');
+  std::thread writer([&]() {
+    for (size_t offset = 0; offset < to_write.size();) {
+      ssize_t written =
+          ::write(fds[1], to_write.data() + offset, to_write.size() - offset);
+      if (written <= 0) break;
+      offset += (size_t)written;
+    }
+    ::close(fds[1]);
+  });
+  iree_const_byte_span_t contents;
+  iree_allocator_t deallocator;
+  Status status = MapFileContents(absl::StrCat("/dev/fd/", fds[0]), &contents,
+                                  &deallocator);
+  // Drain anything left unread so that the writer can finish and be joined.
+  char buffer[4096];
+  while (::read(fds[0], buffer, sizeof(buffer)) > 0) {
+  }
+  writer.join();
+  ::close(fds[0]);
+  IREE_ASSERT_OK(status);
+  EXPECT_EQ(to_write,
+            absl::string_view(reinterpret_cast<const char*>(contents.data),
+                              contents.data_length));
+  iree_allocator_free(deallocator, (void*)contents.data);
+}
+#endif  // IREE_PLATFORM_LINUX
+
+TEST(FileIo, MapMissingFile) {
+  auto path = GetUniquePath("MapMissingFile");
+  iree_const_byte_span_t contents;
+  iree_allocator_t deallocator;
+  EXPECT_THAT(MapFileContents(path, &contents, &deallocator),
+              StatusIs(StatusCode::kNotFound));
+}
+
 TEST(FileIo, SetDeleteExists) {
   std::string unique_name = "SetDeleteExists";
   auto path = GetUniquePath(unique_name);
@@ -66,6 +66,45 @@ Status GetFileContents(const std::string& path, std::string* out_contents) {
   return OkStatus();
 }
 
+// iree_allocator_t free function for views mapped by MapFileContents.
+static void UnmapFileContents(void* self, void* ptr) {
+  ::UnmapViewOfFile(ptr);
+}
+
+Status MapFileContents(const std::string& path,
+                       iree_const_byte_span_t* out_contents,
+                       iree_allocator_t* out_deallocator) {
+  IREE_TRACE_SCOPE0("file_io::MapFileContents");
+  *out_contents = iree_make_const_byte_span(NULL, 0);
+  *out_deallocator = iree_allocator_null();
+  std::unique_ptr<FileHandle> file;
+  IREE_RETURN_IF_ERROR(
+      FileHandle::OpenRead(path, FILE_FLAG_RANDOM_ACCESS, &file));
+  if (file->size() == 0) return OkStatus();
+
+  // The view holds its own reference to the mapping object (and through it the
+  // file) so both handles can be closed once the view exists.
+  HANDLE mapping =
+      ::CreateFileMappingA(file->handle(), NULL, PAGE_READONLY, 0, 0, NULL);
+  if (!mapping) {
+    return iree_make_status(iree_status_code_from_win32_error(GetLastError()),
+                            "unable to create file mapping of '%s'",
+                            path.c_str());
+  }
+  void* data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  DWORD map_error = GetLastError();
+  ::CloseHandle(mapping);
+  if (!data) {
+    return iree_make_status(iree_status_code_from_win32_error(map_error),
+                            "unable to map view of %zu bytes of '%s'",
+                            file->size(), path.c_str());
+  }
+
+  *out_contents = iree_make_const_byte_span(data, file->size());
+  out_deallocator->free = UnmapFileContents;
+  return OkStatus();
+}
+
 Status SetFileContents(const std::string& path, absl::string_view content) {
   IREE_TRACE_SCOPE0("file_io::SetFileContents");
   std::unique_ptr<FileHandle> file;
@@ -16,6 +16,10 @@
 
 #include <assert.h>
 
+#if !defined(IREE_PLATFORM_WINDOWS)
+#include <sched.h>
+#endif  // !IREE_PLATFORM_WINDOWS
+
 #if defined(IREE_PLATFORM_EMSCRIPTEN)
 
 #include <emscripten/threading.h>
@@ -615,6 +619,55 @@ void iree_notification_cancel_wait(iree_notification_t* notification) {
   SYNC_ASSERT((previous_value & IREE_NOTIFICATION_WAITER_MASK) != 0);
 }
 
+// Hints to the processor that the caller is busy-waiting so that it can reduce
+// power and yield pipeline resources to sibling hardware threads.
+static inline void iree_processor_yield(void) {
+#if defined(IREE_COMPILER_MSVC)
+  YieldProcessor();
+#elif defined(IREE_ARCH_X86_32) || defined(IREE_ARCH_X86_64)
+  __builtin_ia32_pause();
+#elif defined(IREE_ARCH_ARM_32) || defined(IREE_ARCH_ARM_64)
+  __asm__ __volatile__("yield");
+#endif  // IREE_ARCH_*
+}
+
+// Yields the remainder of the calling thread's time slice to any other thread
+// that is ready to run. Returns immediately if there are none.
+static void iree_thread_yield_time_slice(void) {
+#if defined(IREE_PLATFORM_WINDOWS)
+  SwitchToThread();
+#else
+  sched_yield();
+#endif  // IREE_PLATFORM_*
+}
+
+// Number of epoch polls performed between clock queries while spinning.
+// Querying the time is much more expensive than polling the epoch and the spin
+// budgets are coarse enough that overshooting by a few polls doesn't matter.
+#define IREE_NOTIFICATION_SPIN_POLL_COUNT 64
+
+bool iree_notification_spin_wait(iree_notification_t* notification,
+                                 iree_wait_token_t wait_token,
+                                 iree_duration_t spin_ns) {
+  if (spin_ns <= 0) return false;
+  iree_time_t deadline_ns = iree_relative_timeout_to_deadline_ns(spin_ns);
+  while (true) {
+    for (int i = 0; i < IREE_NOTIFICATION_SPIN_POLL_COUNT; ++i) {
+      if ((iree_atomic_load_int64(&notification->value,
+                                  iree_memory_order_acquire) >>
+           IREE_NOTIFICATION_EPOCH_SHIFT) != wait_token) {
+        return true;
+      }
+      iree_processor_yield();
+    }
+    if (iree_time_now() >= deadline_ns) return false;
+    // Give up the processor if anything else wants it. When the system is
+    // oversubscribed the thread that will post the notification may be waiting
+    // for our core and spinning on it would only delay the post.
+    iree_thread_yield_time_slice();
+  }
+}
+
 void iree_notification_await(iree_notification_t* notification,
                              iree_condition_fn_t condition_fn,
                              void* condition_arg) {
@@ -341,6 +341,22 @@ void iree_notification_commit_wait(iree_notification_t* notification,
 //   guaranteed.
 void iree_notification_cancel_wait(iree_notification_t* notification);
 
+// Spins for up to |spin_ns| without blocking in the kernel waiting for a
+// notification to be posted after |wait_token| was prepared. The thread yields
+// its time slice periodically so that spinning doesn't starve other threads
+// when the system is oversubscribed. Returns true if a notification was
+// observed.
+//
+// Useful when the expected time until the next post is shorter than the cost of
+// a kernel wait and wake; callers trade CPU time for lower wake latency. The
+// wait need not remain pending while spinning: cancelling it first allows
+// posters to skip the kernel wake as there are no waiters to wake.
+//
+// Acts as (at least) a memory_order_acquire barrier when returning true.
+bool iree_notification_spin_wait(iree_notification_t* notification,
+                                 iree_wait_token_t wait_token,
+                                 iree_duration_t spin_ns);
+
 // Returns true if the condition is true.
 // |arg| is the |condition_arg| passed to the await function.
 // Implementations must ensure they are coherent with their state values.
@@ -184,4 +184,35 @@ TEST(SlimMutexTest, ExclusiveAccessTryLock) {
 
 // Tested implicitly in threading_test.cc.
 
+TEST(NotificationTest, SpinWaitTimeout) {
+  iree_notification_t notification;
+  iree_notification_initialize(&notification);
+  iree_wait_token_t wait_token = iree_notification_prepare_wait(&notification);
+  iree_notification_cancel_wait(&notification);
+  EXPECT_FALSE(iree_notification_spin_wait(&notification, wait_token,
+                                           IREE_DURATION_ZERO));
+  EXPECT_FALSE(
+      iree_notification_spin_wait(&notification, wait_token, 1000000));
+  iree_notification_deinitialize(&notification);
+}
+
+TEST(NotificationTest, SpinWaitPosted) {
+  iree_notification_t notification;
+  iree_notification_initialize(&notification);
+  iree_wait_token_t wait_token = iree_notification_prepare_wait(&notification);
+  iree_notification_cancel_wait(&notification);
+  std::thread thread([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    iree_notification_post(&notification, IREE_ALL_WAITERS);
+  });
+  EXPECT_TRUE(iree_notification_spin_wait(&notification, wait_token,
+                                          IREE_DURATION_INFINITE));
+  thread.join();
+
+  // Posts made prior to spinning are observed immediately.
+  EXPECT_TRUE(iree_notification_spin_wait(&notification, wait_token,
+                                          IREE_DURATION_ZERO + 1));
+  iree_notification_deinitialize(&notification);
+}
+
 }  // namespace
@@ -32,6 +32,10 @@ inline llvm::StringRef getNumWorkgroupsFnAttrName() {
   return "hal.num_workgroups_fn";
 }
 
+/// Attribute on an external function declaration denoting a microkernel that
+/// is provided by a library linked into the executable.
+inline llvm::StringRef getMicrokernelAttrName() { return "hal.microkernel"; }
+
 }  // namespace iree_compiler
 }  // namespace mlir
 
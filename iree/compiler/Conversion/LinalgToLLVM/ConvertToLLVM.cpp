@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "iree/compiler/Conversion/CodegenUtils/FunctionUtils.h"
+#include "iree/compiler/Conversion/Common/Attributes.h"
 #include "iree/compiler/Conversion/LinalgToLLVM/Passes.h"
 #include "iree/compiler/Dialect/Flow/IR/FlowDialect.h"
 #include "iree/compiler/Dialect/HAL/IR/HALDialect.h"
@@ -464,8 +465,11 @@ void ConvertToLLVMPass::runOnOperation() {
                            IREE::HAL::HALDialect, IREE::Flow::FlowDialect>();
 
   // Don't apply patterns to private function (e.g num_workgroups func).
+  // Microkernel declarations are called from the entry points and must be
+  // converted along with them.
   target.addDynamicallyLegalOp<FuncOp>([&](FuncOp funcOp) {
     if (isEntryPoint(funcOp)) return false;
+    if (funcOp.getOperation()->hasAttr(getMicrokernelAttrName())) return false;
     return true;
   });
   target.addDynamicallyLegalDialect<ShapeDialect, StandardOpsDialect,
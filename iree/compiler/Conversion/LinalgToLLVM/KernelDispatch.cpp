@@ -15,9 +15,15 @@
 
 #include "iree/compiler/Conversion/LinalgToLLVM/KernelDispatch.h"
 
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "mlir/Dialect/Linalg/IR/LinalgOps.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/Operation.h"
 
 namespace mlir {
@@ -68,74 +74,367 @@ static llvm::cl::opt<int> batchMatmulL2TileSize(
         "linalg.matmul tile size for workgroups spliting of M, N dimension"),
     llvm::cl::init(4));
 
-struct TileOpParameters {
-  template <typename OpT, TilingLevel tilingLevel>
-  static llvm::SmallVector<int64_t, 4> getSizes(OpT op);
+// The tuning database is a JSON file of the form:
+//   {
+//     "configs": [
+//       {
+//         "target_cpu": "skylake-avx512",
+//         "op": "linalg.matmul",
+//         "element_type": "f32",
+//         "shape": [384, 512, 128],
+//         "tile_sizes": [[64, 128], [32, 32, 32], [4, 4, 4]]
+//       }
+//     ]
+//   }
+// where `shape` holds the static loop ranges of the op in ([B,] M, N, K) order
+// and `tile_sizes` holds the tile sizes for each TilingLevel. `target_cpu` may
+// be omitted to match any target CPU. Databases are produced by
+// scripts/tune_llvm_matmul_tile_sizes.py.
+static llvm::cl::opt<std::string> clTuningDatabasePath(
+    "iree-codegen-linalg-to-llvm-kernel-dispatch-tuning-db",
+    llvm::cl::desc("JSON file of linalg.matmul/linalg.batch_matmul tile sizes "
+                   "tuned for specific problem shapes and target CPUs"),
+    llvm::cl::init(""));
+
+Optional<CPUCacheInfo> getCPUCacheInfo(StringRef targetCPU) {
+  // Typical per-core configurations. Caches shared between cores are divided
+  // by the number of cores commonly sharing them.
+  const int64_t KiB = 1024;
+  return llvm::StringSwitch<Optional<CPUCacheInfo>>(targetCPU)
+      .Cases("haswell", "broadwell", "skylake",
+             CPUCacheInfo{32 * KiB, 256 * KiB})
+      .Cases("skylake-avx512", "cascadelake", "cooperlake",
+             CPUCacheInfo{32 * KiB, 1024 * KiB})
+      .Case("icelake-client", CPUCacheInfo{48 * KiB, 512 * KiB})
+      .Cases("icelake-server", "tigerlake", CPUCacheInfo{48 * KiB, 1280 * KiB})
+      .Case("sapphirerapids", CPUCacheInfo{48 * KiB, 2048 * KiB})
+      .Cases("znver1", "znver2", "znver3", CPUCacheInfo{32 * KiB, 512 * KiB})
+      .Cases("cortex-a53", "cortex-a55", CPUCacheInfo{32 * KiB, 128 * KiB})
+      .Case("cortex-a72", CPUCacheInfo{32 * KiB, 512 * KiB})
+      .Cases("cortex-a75", "cortex-a76", "cortex-a77", "cortex-a78",
+             CPUCacheInfo{64 * KiB, 256 * KiB})
+      .Cases("cortex-x1", "neoverse-n1", CPUCacheInfo{64 * KiB, 1024 * KiB})
+      .Cases("apple-a13", "apple-a14", "apple-m1",
+             CPUCacheInfo{128 * KiB, 4096 * KiB})
+      .Default(llvm::None);
+}
+
+//===----------------------------------------------------------------------===//
+// Tuning database
+//===----------------------------------------------------------------------===//
+
+/// Returns the key of the tuning database entry for an op named |opName| with
+/// |elementType| elements and static |loopRanges| on |targetCPU|.
+static std::string getTuningKey(StringRef targetCPU, StringRef opName,
+                                StringRef elementType,
+                                ArrayRef<int64_t> loopRanges) {
+  std::string key;
+  llvm::raw_string_ostream os(key);
+  os << targetCPU << "|" << opName << "|" << elementType << "|";
+  llvm::interleave(loopRanges, os, "x");
+  return os.str();
+}
+
+class CPUTuningDatabase {
+ public:
+  /// Loads the database from the JSON file at |path|.
+  static llvm::Expected<std::unique_ptr<CPUTuningDatabase>> load(
+      StringRef path);
+
+  /// Returns the tile sizes tuned for |targetCPU|, falling back to those tuned
+  /// for any CPU, or nullptr if there are none.
+  const TileSizesListType *lookup(StringRef targetCPU, StringRef opName,
+                                  StringRef elementType,
+                                  ArrayRef<int64_t> loopRanges) const {
+    auto it = configs.find(
+        getTuningKey(targetCPU, opName, elementType, loopRanges));
+    if (it == configs.end()) {
+      it = configs.find(getTuningKey("*", opName, elementType, loopRanges));
+    }
+    return it == configs.end() ? nullptr : &it->second;
+  }
+
+ private:
+  llvm::StringMap<TileSizesListType> configs;
 };
 
-template <>
-llvm::SmallVector<int64_t, 4>
-TileOpParameters::getSizes<linalg::MatmulOp, TilingLevel::WorkGroupTiles>(
-    linalg::MatmulOp op) {
-  return {matmulWorkgroupTileSize, matmulWorkgroupTileSize};
+static bool parseIntegerArray(const llvm::json::Array *array,
+                              SmallVectorImpl<int64_t> &values) {
+  if (!array) return false;
+  for (const llvm::json::Value &value : *array) {
+    Optional<int64_t> integer = value.getAsInteger();
+    if (!integer || *integer <= 0) return false;
+    values.push_back(*integer);
+  }
+  return true;
+}
+
+llvm::Expected<std::unique_ptr<CPUTuningDatabase>> CPUTuningDatabase::load(
+    StringRef path) {
+  auto fileOrErr = llvm::MemoryBuffer::getFile(path);
+  if (!fileOrErr) {
+    return llvm::createStringError(fileOrErr.getError(),
+                                   "unable to open '%s': %s",
+                                   path.str().c_str(),
+                                   fileOrErr.getError().message().c_str());
+  }
+  llvm::Expected<llvm::json::Value> json =
+      llvm::json::parse((*fileOrErr)->getBuffer());
+  if (!json) return json.takeError();
+  const llvm::json::Object *root = json->getAsObject();
+  const llvm::json::Array *configArray =
+      root ? root->getArray("configs") : nullptr;
+  if (!configArray) {
+    return llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                   "expected an object with a 'configs' array");
+  }
+
+  auto database = std::make_unique<CPUTuningDatabase>();
+  for (auto config : llvm::enumerate(*configArray)) {
+    auto configError = [&](const char *message) {
+      return llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                     "config %zu: %s", config.index(),
+                                     message);
+    };
+    const llvm::json::Object *object = config.value().getAsObject();
+    if (!object) return configError("expected an object");
+    StringRef targetCPU = object->getString("target_cpu").getValueOr("*");
+    Optional<StringRef> opName = object->getString("op");
+    Optional<StringRef> elementType = object->getString("element_type");
+    if (!opName || !elementType) {
+      return configError("expected 'op' and 'element_type' strings");
+    }
+    SmallVector<int64_t, 4> loopRanges;
+    if (!parseIntegerArray(object->getArray("shape"), loopRanges)) {
+      return configError(
+          "expected 'shape' to be an array of positive integers");
+    }
+    const llvm::json::Array *levelArray = object->getArray("tile_sizes");
+    if (!levelArray ||
+        levelArray->size() != static_cast<size_t>(TilingLevel::NumTileLevels)) {
+      return configError("expected 'tile_sizes' to have one entry per level");
+    }
+    TileSizesListType tileSizes(levelArray->size());
+    for (auto level : llvm::enumerate(*levelArray)) {
+      if (!parseIntegerArray(level.value().getAsArray(),
+                             tileSizes[level.index()])) {
+        return configError(
+            "expected 'tile_sizes' entries to be arrays of positive integers");
+      }
+    }
+    database->configs[getTuningKey(targetCPU, *opName, *elementType,
+                                   loopRanges)] = std::move(tileSizes);
+  }
+  return database;
 }
 
-template <>
-llvm::SmallVector<int64_t, 4>
-TileOpParameters::getSizes<linalg::MatmulOp, TilingLevel::Level1Tiles>(
-    linalg::MatmulOp op) {
-  return {matmulL1TileSize, matmulL1TileSize, matmulL1TileSize};
+namespace {
+struct TuningDatabaseState {
+  std::unique_ptr<CPUTuningDatabase> database;
+  std::string error;
+};
+}  // namespace
+
+/// Returns the tuning database named by the flag, loading it on first use.
+static const TuningDatabaseState &getTuningDatabaseState() {
+  static const TuningDatabaseState state = [] {
+    TuningDatabaseState state;
+    if (clTuningDatabasePath.empty()) return state;
+    auto databaseOrErr =
+        CPUTuningDatabase::load(clTuningDatabasePath.getValue());
+    if (databaseOrErr) {
+      state.database = std::move(*databaseOrErr);
+    } else {
+      state.error = llvm::toString(databaseOrErr.takeError());
+    }
+    return state;
+  }();
+  return state;
 }
 
-template <>
-llvm::SmallVector<int64_t, 4>
-TileOpParameters::getSizes<linalg::MatmulOp, TilingLevel::Level2Tiles>(
-    linalg::MatmulOp op) {
-  return {matmulL2TileSize, matmulL2TileSize, matmulL2TileSize};
+//===----------------------------------------------------------------------===//
+// Tile size selection
+//===----------------------------------------------------------------------===//
+
+/// Returns the loop ranges of a linalg.matmul or linalg.batch_matmul in
+/// ([B,] M, N, K) order. Dynamic ranges are ShapedType::kDynamicSize.
+static SmallVector<int64_t, 4> getMatmulLoopRanges(Operation *op) {
+  auto lhsType = op->getOperand(0).getType().cast<ShapedType>();
+  auto rhsType = op->getOperand(1).getType().cast<ShapedType>();
+  SmallVector<int64_t, 4> loopRanges =
+      llvm::to_vector<4>(lhsType.getShape().drop_back());
+  loopRanges.push_back(rhsType.getShape().back());
+  loopRanges.push_back(lhsType.getShape().back());
+  return loopRanges;
 }
 
-template <>
-llvm::SmallVector<int64_t, 4>
-TileOpParameters::getSizes<linalg::BatchMatmulOp, TilingLevel::WorkGroupTiles>(
-    linalg::BatchMatmulOp op) {
-  return {1, batchMatmulWorkgroupTileSize, batchMatmulWorkgroupTileSize};
+/// Returns the tile sizes specified by the
+/// `iree-codegen-linalg-to-llvm-kernel-dispatch-*` flags (or their defaults).
+static TileSizesListType getFlagTileSizes(bool isBatchMatmul) {
+  if (isBatchMatmul) {
+    return {{1, batchMatmulWorkgroupTileSize, batchMatmulWorkgroupTileSize},
+            {1, batchMatmulL1TileSize, batchMatmulL1TileSize,
+             batchMatmulL1TileSize},
+            {1, batchMatmulL2TileSize, batchMatmulL2TileSize,
+             batchMatmulL2TileSize}};
+  }
+  return {{matmulWorkgroupTileSize, matmulWorkgroupTileSize},
+          {matmulL1TileSize, matmulL1TileSize, matmulL1TileSize},
+          {matmulL2TileSize, matmulL2TileSize, matmulL2TileSize}};
 }
 
-template <>
-llvm::SmallVector<int64_t, 4>
-TileOpParameters::getSizes<linalg::BatchMatmulOp, TilingLevel::Level1Tiles>(
-    linalg::BatchMatmulOp op) {
-  return {1, batchMatmulL1TileSize, batchMatmulL1TileSize,
-          batchMatmulL1TileSize};
+/// Returns true if any of the tile size flags for the op kind were specified.
+static bool hasExplicitFlagTileSizes(bool isBatchMatmul) {
+  if (isBatchMatmul) {
+    return batchMatmulWorkgroupTileSize.getNumOccurrences() ||
+           batchMatmulL1TileSize.getNumOccurrences() ||
+           batchMatmulL2TileSize.getNumOccurrences();
+  }
+  return matmulWorkgroupTileSize.getNumOccurrences() ||
+         matmulL1TileSize.getNumOccurrences() ||
+         matmulL2TileSize.getNumOccurrences();
 }
 
-template <>
-llvm::SmallVector<int64_t, 4>
-TileOpParameters::getSizes<linalg::BatchMatmulOp, TilingLevel::Level2Tiles>(
-    linalg::BatchMatmulOp op) {
-  return {1, batchMatmulL2TileSize, batchMatmulL2TileSize,
-          batchMatmulL2TileSize};
+/// Returns the largest power-of-two tile size T such that T x T blocks of the
+/// LHS, RHS, and result with |elementBytes| elements fit in |budgetBytes|.
+static int64_t getLargestSquareTileSize(int64_t budgetBytes,
+                                        int64_t elementBytes) {
+  int64_t maxBlockElements = budgetBytes / (3 * elementBytes);
+  int64_t tileSize = 1;
+  while ((tileSize * 2) * (tileSize * 2) <= maxBlockElements) tileSize *= 2;
+  return tileSize;
 }
 
-#define DEFINE_TILE_OP_GET_SIZES(TileLevel)                                 \
-  template <>                                                               \
-  llvm::SmallVector<int64_t, 4> CPUKernelDispatch::getTileSizes<TileLevel>( \
-      Operation * op) const {                                               \
-    if (isa<linalg::MatmulOp>(op)) {                                        \
-      return TileOpParameters::getSizes<linalg::MatmulOp, TileLevel>(       \
-          dyn_cast<linalg::MatmulOp>(op));                                  \
-    }                                                                       \
-    if (isa<linalg::BatchMatmulOp>(op)) {                                   \
-      return TileOpParameters::getSizes<linalg::BatchMatmulOp, TileLevel>(  \
-          dyn_cast<linalg::BatchMatmulOp>(op));                             \
-    }                                                                       \
-    return {1, 1, 1};                                                       \
-  }
-
-DEFINE_TILE_OP_GET_SIZES(TilingLevel::WorkGroupTiles)
-DEFINE_TILE_OP_GET_SIZES(TilingLevel::Level1Tiles)
-DEFINE_TILE_OP_GET_SIZES(TilingLevel::Level2Tiles)
-#undef DEFINE_TILE_OP_GET_SIZES
+/// Returns tile sizes such that the blocks operated on by a workgroup fit in
+/// the L2 cache and the blocks of each L1 tile fit in the L1 data cache. Half
+/// of each cache is left for the data streamed through it. Tiles are clamped
+/// to the static loop ranges so small problems are not padded out to tiles
+/// sized for the cache.
+static TileSizesListType getCacheAwareTileSizes(const CPUCacheInfo &cacheInfo,
+                                                int64_t elementBytes,
+                                                ArrayRef<int64_t> loopRanges,
+                                                bool isBatchMatmul) {
+  int64_t vectorTileSize =
+      isBatchMatmul ? batchMatmulL2TileSize : matmulL2TileSize;
+  int64_t l1TileSize = std::max(
+      getLargestSquareTileSize(cacheInfo.l1DataCacheBytes / 2, elementBytes),
+      vectorTileSize);
+  int64_t workgroupTileSize = std::max(
+      getLargestSquareTileSize(cacheInfo.l2CacheBytes / 2, elementBytes),
+      l1TileSize);
+
+  auto clampToRange = [](int64_t tileSize, int64_t range) -> int64_t {
+    if (ShapedType::isDynamic(range)) return tileSize;
+    return std::min<int64_t>(tileSize, llvm::PowerOf2Ceil(range));
+  };
+  ArrayRef<int64_t> mnkRanges = loopRanges.take_back(3);
+  int64_t workgroupM = clampToRange(workgroupTileSize, mnkRanges[0]);
+  int64_t workgroupN = clampToRange(workgroupTileSize, mnkRanges[1]);
+  int64_t l1M = std::min(l1TileSize, workgroupM);
+  int64_t l1N = std::min(l1TileSize, workgroupN);
+  int64_t l1K = clampToRange(l1TileSize, mnkRanges[2]);
+  int64_t vectorM = std::min(vectorTileSize, l1M);
+  int64_t vectorN = std::min(vectorTileSize, l1N);
+  int64_t vectorK = std::min(vectorTileSize, l1K);
+
+  if (isBatchMatmul) {
+    return {{1, workgroupM, workgroupN},
+            {1, l1M, l1N, l1K},
+            {1, vectorM, vectorN, vectorK}};
+  }
+  return {{workgroupM, workgroupN},
+          {l1M, l1N, l1K},
+          {vectorM, vectorN, vectorK}};
+}
+
+Optional<CPUKernelDispatch> CPUKernelDispatch::get(Location loc,
+                                                   StringRef targetCPU) {
+  const TuningDatabaseState &tuningDatabaseState = getTuningDatabaseState();
+  if (!tuningDatabaseState.error.empty()) {
+    emitError(loc) << "failed to load kernel dispatch tuning database '"
+                   << clTuningDatabasePath.getValue()
+                   << "': " << tuningDatabaseState.error;
+    return llvm::None;
+  }
+  CPUKernelDispatch cpuKernelDispatch;
+  if (!targetCPU.empty()) cpuKernelDispatch.targetCPU = targetCPU.str();
+  cpuKernelDispatch.cacheInfo = getCPUCacheInfo(cpuKernelDispatch.targetCPU);
+  cpuKernelDispatch.tuningDatabase = tuningDatabaseState.database.get();
+  return cpuKernelDispatch;
+}
+
+TileSizesListType CPUKernelDispatch::getTileSizes(Operation *op) const {
+  if (auto tileSizesAttr =
+          op->getAttrOfType<ArrayAttr>(getCPUTileSizesAttrName())) {
+    TileSizesListType tileSizes;
+    for (Attribute levelAttr : tileSizesAttr) {
+      SmallVector<int64_t, 4> levelTileSizes;
+      for (Attribute tileSizeAttr : levelAttr.cast<ArrayAttr>()) {
+        levelTileSizes.push_back(tileSizeAttr.cast<IntegerAttr>().getInt());
+      }
+      tileSizes.push_back(std::move(levelTileSizes));
+    }
+    return tileSizes;
+  }
+
+  if (!isa<linalg::MatmulOp, linalg::BatchMatmulOp>(op)) {
+    return TileSizesListType(static_cast<size_t>(TilingLevel::NumTileLevels),
+                             {1, 1, 1});
+  }
+  bool isBatchMatmul = isa<linalg::BatchMatmulOp>(op);
+  if (hasExplicitFlagTileSizes(isBatchMatmul)) {
+    return getFlagTileSizes(isBatchMatmul);
+  }
+
+  SmallVector<int64_t, 4> loopRanges = getMatmulLoopRanges(op);
+  Type elementType =
+      op->getOperand(2).getType().cast<ShapedType>().getElementType();
+  if (tuningDatabase && llvm::none_of(loopRanges, ShapedType::isDynamic)) {
+    std::string elementTypeStr;
+    llvm::raw_string_ostream os(elementTypeStr);
+    elementType.print(os);
+    if (const TileSizesListType *tileSizes =
+            tuningDatabase->lookup(targetCPU, op->getName().getStringRef(),
+                                   os.str(), loopRanges)) {
+      return *tileSizes;
+    }
+  }
+
+  if (cacheInfo) {
+    int64_t elementBytes = 4;
+    if (elementType.isIntOrFloat()) {
+      elementBytes =
+          std::max<int64_t>(1, elementType.getIntOrFloatBitWidth() / 8);
+    }
+    return getCacheAwareTileSizes(*cacheInfo, elementBytes, loopRanges,
+                                  isBatchMatmul);
+  }
+
+  return getFlagTileSizes(isBatchMatmul);
+}
+
+template <TilingLevel tilingLevel>
+llvm::SmallVector<int64_t, 4> CPUKernelDispatch::getTileSizes(
+    Operation *op) const {
+  return getTileSizes(op)[static_cast<unsigned>(tilingLevel)];
+}
+
+template llvm::SmallVector<int64_t, 4>
+CPUKernelDispatch::getTileSizes<TilingLevel::WorkGroupTiles>(
+    Operation *op) const;
+template llvm::SmallVector<int64_t, 4>
+CPUKernelDispatch::getTileSizes<TilingLevel::Level1Tiles>(Operation *op) const;
+template llvm::SmallVector<int64_t, 4>
+CPUKernelDispatch::getTileSizes<TilingLevel::Level2Tiles>(Operation *op) const;
+
+void CPUKernelDispatch::annotateTileSizes(Operation *op) const {
+  Builder builder(op->getContext());
+  SmallVector<Attribute, 3> levelAttrs;
+  for (const auto &levelTileSizes : getTileSizes(op)) {
+    levelAttrs.push_back(builder.getI64ArrayAttr(levelTileSizes));
+  }
+  op->setAttr(getCPUTileSizesAttrName(), builder.getArrayAttr(levelAttrs));
+}
 
 #define DEFINE_TILE_SIZE_FN(TileLevel)                                     \
   template <>                                                              \
@@ -161,7 +460,8 @@ DEFINE_TILE_SIZE_FN(TilingLevel::Level2Tiles)
 
 Optional<LaunchConfig> initCPULaunchConfig(
     MLIRContext *context, const linalg::LinalgDependenceGraph &dependenceGraph,
-    ArrayRef<linalg::LinalgOp> linalgOps) {
+    ArrayRef<linalg::LinalgOp> linalgOps,
+    const CPUKernelDispatch &cpuKernelDispatch) {
   LaunchConfig config;
   if (!clLLVMTileSizes.empty()) {
     SmallVector<int64_t, 3> tileSizes(clLLVMTileSizes.begin(),
@@ -182,8 +482,9 @@ Optional<LaunchConfig> initCPULaunchConfig(
     }                                                                        \
     rootOperation = linalgOp;                                                \
     auto opTileSizes =                                                       \
-        TileOpParameters::getSizes<opType, TilingLevel::WorkGroupTiles>(op); \
+        cpuKernelDispatch.getTileSizes<TilingLevel::WorkGroupTiles>(op);     \
     config.setTileSizes(op, opTileSizes, 0);                                 \
+    cpuKernelDispatch.annotateTileSizes(op);                                 \
     continue;                                                                \
   }
 
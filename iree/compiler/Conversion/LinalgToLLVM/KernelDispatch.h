@@ -13,9 +13,11 @@
 // limitations under the License.
 
 #include <cstdint>
+#include <string>
 
 #include "iree/compiler/Conversion/Common/LaunchConfig.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/Operation.h"
 #include "mlir/IR/Value.h"
@@ -33,10 +35,57 @@ enum class TilingLevel {
   NumTileLevels = 3
 };
 
+/// Attribute on a linalg op that carries the tile sizes selected for all
+/// tiling levels from the tile and distribute pass to the tile and vectorize
+/// pass. The attribute value is an array with one array of tile sizes per
+/// TilingLevel.
+inline llvm::StringRef getCPUTileSizesAttrName() {
+  return "iree.cpu_tile_sizes";
+}
+
+/// Per-core data cache sizes of a target CPU.
+struct CPUCacheInfo {
+  int64_t l1DataCacheBytes;
+  int64_t l2CacheBytes;
+};
+
+/// Returns the cache sizes of the CPU named by |targetCPU| (as passed to
+/// `--iree-llvm-target-cpu`) or llvm::None if the CPU is unknown.
+Optional<CPUCacheInfo> getCPUCacheInfo(StringRef targetCPU);
+
+class CPUTuningDatabase;
+
+/// Selects the tile sizes used for each tiling level of the linalg operations
+/// in a dispatch region. Tile sizes are chosen in order of precedence from:
+///  - the `iree-codegen-linalg-to-llvm-kernel-dispatch-*` flags, if specified;
+///  - the tuning database for the target CPU and the static problem shape;
+///  - the cache sizes of the target CPU and the static problem shape;
+///  - fixed defaults for unknown (such as `generic`) targets.
 class CPUKernelDispatch {
  public:
+  CPUKernelDispatch() = default;
+
+  /// Returns the kernel dispatch for |targetCPU|, loading the tuning database
+  /// named by `--iree-codegen-linalg-to-llvm-kernel-dispatch-tuning-db` on
+  /// first use. Emits an error at |loc| and returns llvm::None if the database
+  /// cannot be loaded.
+  static Optional<CPUKernelDispatch> get(Location loc, StringRef targetCPU);
+
+  /// Returns the tile sizes of |op| for all tiling levels. If |op| was
+  /// annotated with getCPUTileSizesAttrName() the annotated sizes are used.
+  TileSizesListType getTileSizes(Operation *op) const;
+
   template <TilingLevel tilingLevel>
   llvm::SmallVector<int64_t, 4> getTileSizes(Operation *op) const;
+
+  /// Annotates |op| with the tile sizes selected for it such that later passes
+  /// that only see tiled views of |op| make consistent decisions.
+  void annotateTileSizes(Operation *op) const;
+
+ private:
+  std::string targetCPU = "generic";
+  Optional<CPUCacheInfo> cacheInfo;
+  const CPUTuningDatabase *tuningDatabase = nullptr;
 };
 
 struct TileSizeFn {
@@ -48,7 +97,8 @@ struct TileSizeFn {
 
 Optional<LaunchConfig> initCPULaunchConfig(
     MLIRContext *context, const linalg::LinalgDependenceGraph &dependenceGraph,
-    ArrayRef<linalg::LinalgOp> linalgOps);
+    ArrayRef<linalg::LinalgOp> linalgOps,
+    const CPUKernelDispatch &cpuKernelDispatch);
 
 }  // namespace iree_compiler
 }  // namespace mlir
@@ -43,8 +43,21 @@ struct LinalgTileAndDistributePass
                     scf::SCFDialect>();
   }
   LinalgTileAndDistributePass() = default;
-  LinalgTileAndDistributePass(const LinalgTileAndDistributePass &pass) {}
+  explicit LinalgTileAndDistributePass(StringRef targetCPU) {
+    this->targetCPU = targetCPU.str();
+  }
+  // Option values are copied explicitly as the pass is cloned for each
+  // thread of a multi-threaded pass manager.
+  LinalgTileAndDistributePass(const LinalgTileAndDistributePass &pass) {
+    this->targetCPU = pass.targetCPU.getValue();
+  }
   void runOnOperation() override;
+
+ private:
+  Option<std::string> targetCPU{
+      *this, "target-cpu",
+      llvm::cl::desc("Target CPU used to select tile sizes"),
+      llvm::cl::init("")};
 };
 }  // namespace
 
@@ -80,6 +93,9 @@ void LinalgTileAndDistributePass::runOnOperation() {
   MLIRContext *context = &getContext();
   IREE::HAL::ExecutableTargetOp targetOp = getOperation();
   ModuleOp module = targetOp.getInnerModule();
+  Optional<CPUKernelDispatch> cpuKernelDispatch =
+      CPUKernelDispatch::get(targetOp.getLoc(), targetCPU);
+  if (!cpuKernelDispatch) return signalPassFailure();
 
   for (FuncOp funcOp : module.getOps<FuncOp>()) {
     if (!isEntryPoint(funcOp)) continue;
@@ -92,7 +108,8 @@ void LinalgTileAndDistributePass::runOnOperation() {
     linalg::Aliases aliases;
     linalg::LinalgDependenceGraph dependenceGraph(aliases, linalgOps);
     Optional<LaunchConfig> launchConfigOpt =
-        initCPULaunchConfig(context, dependenceGraph, linalgOps);
+        initCPULaunchConfig(context, dependenceGraph, linalgOps,
+                            *cpuKernelDispatch);
     if (!launchConfigOpt) {
       funcOp.emitError("unable to find launch configuration");
       return signalPassFailure();
@@ -168,8 +185,8 @@ void LinalgTileAndDistributePass::runOnOperation() {
 }
 
 std::unique_ptr<OperationPass<IREE::HAL::ExecutableTargetOp>>
-createLinalgTileAndDistributePass() {
-  return std::make_unique<LinalgTileAndDistributePass>();
+createLinalgTileAndDistributePass(StringRef targetCPU) {
+  return std::make_unique<LinalgTileAndDistributePass>(targetCPU);
 }
 
 static PassRegistration<LinalgTileAndDistributePass> pass(
@@ -57,14 +57,33 @@ struct TileAndVectorizeWorkgroups
     registry.insert<linalg::LinalgDialect, AffineDialect, scf::SCFDialect,
                     vector::VectorDialect>();
   }
+  TileAndVectorizeWorkgroups() = default;
+  explicit TileAndVectorizeWorkgroups(StringRef targetCPU) {
+    this->targetCPU = targetCPU.str();
+  }
+  // Option values are copied explicitly as the pass is cloned for each
+  // thread of a multi-threaded pass manager.
+  TileAndVectorizeWorkgroups(const TileAndVectorizeWorkgroups &pass) {
+    this->targetCPU = pass.targetCPU.getValue();
+  }
   void runOnFunction() override;
+
+ private:
+  Option<std::string> targetCPU{
+      *this, "target-cpu",
+      llvm::cl::desc("Target CPU used to select tile sizes of ops not "
+                     "annotated by the tile and distribute pass"),
+      llvm::cl::init("")};
 };
 }  // namespace
 
 void TileAndVectorizeWorkgroups::runOnFunction() {
   auto funcOp = getOperation();
   MLIRContext *context = &getContext();
-  CPUKernelDispatch cpuKernelDispatch;
+  Optional<CPUKernelDispatch> cpuKernelDispatchOpt =
+      CPUKernelDispatch::get(funcOp.getLoc(), targetCPU);
+  if (!cpuKernelDispatchOpt) return signalPassFailure();
+  CPUKernelDispatch &cpuKernelDispatch = *cpuKernelDispatchOpt;
 
   // Workgroup first level of tiling.
   {
@@ -170,8 +189,9 @@ void TileAndVectorizeWorkgroups::runOnFunction() {
   }
 }
 
-std::unique_ptr<FunctionPass> createLinalgTileAndVectorizeWorkgroupsPass() {
-  return std::make_unique<TileAndVectorizeWorkgroups>();
+std::unique_ptr<FunctionPass> createLinalgTileAndVectorizeWorkgroupsPass(
+    StringRef targetCPU) {
+  return std::make_unique<TileAndVectorizeWorkgroups>(targetCPU);
 }
 
 static PassRegistration<TileAndVectorizeWorkgroups> pass(
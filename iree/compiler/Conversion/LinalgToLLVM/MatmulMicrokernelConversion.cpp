@@ -0,0 +1,127 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/compiler/Conversion/CodegenUtils/MarkerUtils.h"
+#include "iree/compiler/Conversion/Common/Attributes.h"
+#include "iree/compiler/Conversion/LinalgToLLVM/Passes.h"
+#include "mlir/Dialect/Linalg/IR/LinalgOps.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+namespace {
+
+// Entry point of the SGEMM microkernel library; see
+// iree/hal/local/microkernels/sgemm.h.
+static const char kMatmulF32MicrokernelName[] =
+    "iree_microkernel_linalg_matmul_f32";
+
+/// Returns the type all matmul operands are cast to before being passed to
+/// the microkernel. Fully dynamic sizes, strides, and offset let a single
+/// declaration serve every tile shape and layout.
+static MemRefType getMicrokernelMatrixType(MLIRContext *context) {
+  int64_t dynamic = MemRefType::getDynamicStrideOrOffset();
+  AffineMap layout =
+      makeStridedLinearLayoutMap({dynamic, dynamic}, dynamic, context);
+  return MemRefType::get({ShapedType::kDynamicSize, ShapedType::kDynamicSize},
+                         FloatType::getF32(context), layout);
+}
+
+/// Returns true if |matmulOp| is a workgroup tile of an f32 matmul on strided
+/// buffers that the microkernel can compute.
+static bool isMicrokernelMatmul(linalg::MatmulOp matmulOp) {
+  if (!hasMarker(matmulOp, getWorkgroupMarker())) return false;
+  Operation *op = matmulOp.getOperation();
+  if (op->getNumOperands() != 3 || op->getNumResults() != 0) return false;
+  return llvm::all_of(op->getOperandTypes(), [](Type type) {
+    auto memrefType = type.dyn_cast<MemRefType>();
+    return memrefType && memrefType.getRank() == 2 &&
+           memrefType.getElementType().isF32() && isStrided(memrefType);
+  });
+}
+
+/// Returns the declaration of the microkernel |name| in |moduleOp|, inserting
+/// it if needed.
+static FuncOp getOrInsertMicrokernelDecl(ModuleOp moduleOp, StringRef name,
+                                         FunctionType type) {
+  if (auto funcOp = moduleOp.lookupSymbol<FuncOp>(name)) return funcOp;
+  OpBuilder builder = OpBuilder::atBlockBegin(moduleOp.getBody());
+  auto funcOp = builder.create<FuncOp>(moduleOp.getLoc(), name, type);
+  SymbolTable::setSymbolVisibility(funcOp, SymbolTable::Visibility::Private);
+  funcOp.getOperation()->setAttr(getMicrokernelAttrName(),
+                                 builder.getUnitAttr());
+  return funcOp;
+}
+
+/// Replaces linalg.matmul ops distributed to workgroups with calls to a
+/// packed-panel SGEMM microkernel linked into the executable. The microkernel
+/// performs its own cache blocking and register tiling so the matmul is not
+/// tiled further or vectorized.
+struct MatmulMicrokernelConversionPass
+    : public PassWrapper<MatmulMicrokernelConversionPass,
+                         OperationPass<ModuleOp>> {
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<StandardOpsDialect>();
+  }
+
+  void runOnOperation() override {
+    ModuleOp moduleOp = getOperation();
+    MLIRContext *context = &getContext();
+
+    SmallVector<linalg::MatmulOp, 4> matmulOps;
+    moduleOp.walk([&](linalg::MatmulOp matmulOp) {
+      if (isMicrokernelMatmul(matmulOp)) matmulOps.push_back(matmulOp);
+    });
+    if (matmulOps.empty()) return;
+
+    MemRefType matrixType = getMicrokernelMatrixType(context);
+    FuncOp microkernelOp = getOrInsertMicrokernelDecl(
+        moduleOp, kMatmulF32MicrokernelName,
+        FunctionType::get(context, {matrixType, matrixType, matrixType}, {}));
+    for (linalg::MatmulOp matmulOp : matmulOps) {
+      OpBuilder builder(matmulOp);
+      Location loc = matmulOp.getLoc();
+      SmallVector<Value, 3> operands;
+      for (Value operand : matmulOp.getOperation()->getOperands()) {
+        if (operand.getType() != matrixType) {
+          operand = builder.create<MemRefCastOp>(loc, operand, matrixType);
+        }
+        operands.push_back(operand);
+      }
+      builder.create<CallOp>(loc, microkernelOp, operands);
+      matmulOp.erase();
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<ModuleOp>>
+createMatmulMicrokernelConversionPass() {
+  return std::make_unique<MatmulMicrokernelConversionPass>();
+}
+
+static PassRegistration<MatmulMicrokernelConversionPass> pass(
+    "iree-codegen-linalg-to-llvm-matmul-microkernel-conversion",
+    "Replace workgroup linalg.matmul ops with calls to SGEMM microkernels",
+    [] { return std::make_unique<MatmulMicrokernelConversionPass>(); });
+
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -46,10 +46,17 @@ static llvm::cl::opt<bool> fastExpConversion(
                    "polynomial approximation."),
     llvm::cl::init(false));
 
-void addLinalgToLLVMPasses(OpPassManager &passManager) {
+static llvm::cl::opt<bool> clMatmulMicrokernels(
+    "iree-codegen-linalg-to-llvm-matmul-microkernels",
+    llvm::cl::desc("Lower f32 linalg.matmul workgroup tiles to calls to the "
+                   "packed SGEMM microkernels instead of vectorizing them. "
+                   "Requires --iree-llvm-microkernel-library"),
+    llvm::cl::init(false));
+
+void addLinalgToLLVMPasses(OpPassManager &passManager, StringRef targetCPU) {
   // Distribute linalg op among a 3d grid of parallel threads. Tile each
   // workgroup thread memory then vectorize the linalg op.
-  passManager.addPass(createLinalgTileAndDistributePass());
+  passManager.addPass(createLinalgTileAndDistributePass(targetCPU));
   OpPassManager &nestedModulePM = passManager.nest<ModuleOp>();
   if (!clEnableLLVMLinalgOnTensors) {
     nestedModulePM.addPass(createLegalizeNumWorkgroupsFnPass());
@@ -62,8 +69,13 @@ void addLinalgToLLVMPasses(OpPassManager &passManager) {
         createConvImg2ColMatmulConversionPass());
   }
 
+  // Linalg.MatmulOp -> microkernel calls, skipping vectorization.
+  if (clMatmulMicrokernels) {
+    nestedModulePM.addPass(createMatmulMicrokernelConversionPass());
+  }
+
   nestedModulePM.addNestedPass<FuncOp>(
-      createLinalgTileAndVectorizeWorkgroupsPass());
+      createLinalgTileAndVectorizeWorkgroupsPass(targetCPU));
   nestedModulePM.addNestedPass<FuncOp>(createPlanConvLoopOrderPass());
 
   // Linalg -> SCF
@@ -90,7 +102,8 @@ void addLinalgToLLVMPasses(OpPassManager &passManager) {
   }
 }
 
-void buildLLVMTransformPassPipeline(OpPassManager &passManager) {
+void buildLLVMTransformPassPipeline(OpPassManager &passManager,
+                                    StringRef targetCPU) {
   OpPassManager &nestedModulePM = passManager.nest<ModuleOp>();
   if (!clEnableLLVMLinalgOnTensors)
     nestedModulePM.addPass(createDeclareNumWorkgroupsFnPass());
@@ -113,7 +126,7 @@ void buildLLVMTransformPassPipeline(OpPassManager &passManager) {
     addHLOToLinalgOnBuffersPasses(nestedModulePM);
   }
   // Linalg -> LLVM passes.
-  addLinalgToLLVMPasses(passManager);
+  addLinalgToLLVMPasses(passManager, targetCPU);
 }
 
 static PassPipelineRegistration<> linalgLLVMVPipeline(
@@ -30,11 +30,20 @@ std::unique_ptr<FunctionPass> createConvImg2ColMatmulConversionPass();
 std::unique_ptr<FunctionPass> createPlanConvLoopOrderPass();
 
 /// Distributes linalg ops among hal.interface.workgroup logical threads.
+/// Tile sizes are selected for |targetCPU| (as passed to
+/// `--iree-llvm-target-cpu`).
 std::unique_ptr<OperationPass<IREE::HAL::ExecutableTargetOp>>
-createLinalgTileAndDistributePass();
+createLinalgTileAndDistributePass(StringRef targetCPU = "");
 
 /// Vectorizes linalg ops executed in the same hal.interface.workgroup.
-std::unique_ptr<FunctionPass> createLinalgTileAndVectorizeWorkgroupsPass();
+std::unique_ptr<FunctionPass> createLinalgTileAndVectorizeWorkgroupsPass(
+    StringRef targetCPU = "");
+
+/// Replaces f32 linalg.matmul ops distributed to workgroups with calls to the
+/// SGEMM microkernel in iree/hal/local/microkernels/sgemm.h. The executable
+/// must be linked with the microkernel library.
+std::unique_ptr<OperationPass<ModuleOp>>
+createMatmulMicrokernelConversionPass();
 
 std::unique_ptr<OperationPass<ModuleOp>>
 createFastExpApproximationConversionPass();
@@ -59,8 +68,10 @@ createLinalgTileAndDistributeOnTensorsPass();
 
 /// Populates passes needed to lower a XLA HLO op to LLVM dialect via the
 /// structured ops path. The pass manager `pm` in here should operate on the
-/// module within the IREE::HAL::ExecutableOp.
-void buildLLVMTransformPassPipeline(OpPassManager &passManager);
+/// module within the IREE::HAL::ExecutableOp. Codegen decisions are tuned for
+/// |targetCPU| when provided.
+void buildLLVMTransformPassPipeline(OpPassManager &passManager,
+                                    StringRef targetCPU = "");
 
 }  // namespace iree_compiler
 }  // namespace mlir
@@ -0,0 +1,88 @@
+// RUN: iree-opt -pass-pipeline="hal.executable(hal.executable.target(iree-codegen-llvm-linalg-tile-and-distribute))" -split-input-file %s | IreeFileCheck %s --check-prefix=GENERIC
+// RUN: iree-opt -pass-pipeline="hal.executable(hal.executable.target(iree-codegen-llvm-linalg-tile-and-distribute{target-cpu=skylake-avx512}))" -split-input-file %s | IreeFileCheck %s --check-prefix=SKX
+// RUN: iree-opt -pass-pipeline="hal.executable(hal.executable.target(iree-codegen-llvm-linalg-tile-and-distribute{target-cpu=apple-m1}))" -split-input-file %s | IreeFileCheck %s --check-prefix=M1
+
+hal.executable @large_matmul attributes {sym_visibility = "private"} {
+  hal.interface @legacy_io {
+    hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @arg1, set=0, binding=1, type="StorageBuffer", access="Read"
+    hal.interface.binding @ret0, set=0, binding=2, type="StorageBuffer", access="Write|Discard"
+  }
+  hal.executable.target @llvm_aot, filter="dylib*" {
+    hal.executable.entry_point @large_matmul attributes {
+      interface = @legacy_io, ordinal = 0 : i32,
+      signature = (!flow.dispatch.input<1024x512xf32>, !flow.dispatch.input<512x1024xf32>,
+        !flow.dispatch.output<1024x1024xf32>) -> ()}
+    module {
+      func @large_matmul(%arg0 : memref<1024x512xf32>, %arg1: memref<512x1024xf32>, %arg2: memref<1024x1024xf32>) {
+        linalg.matmul ins(%arg0, %arg1 : memref<1024x512xf32>, memref<512x1024xf32>) outs(%arg2 : memref<1024x1024xf32>)
+        return
+      }
+    }
+  }
+}
+// GENERIC-LABEL: func @large_matmul
+//       GENERIC:   linalg.matmul
+//  GENERIC-SAME:     iree.cpu_tile_sizes = {{\[}}[64, 64], [32, 32, 32], [4, 4, 4]]
+// SKX-LABEL: func @large_matmul
+//       SKX:   linalg.matmul
+//  SKX-SAME:     iree.cpu_tile_sizes = {{\[}}[128, 128], [32, 32, 32], [4, 4, 4]]
+// M1-LABEL: func @large_matmul
+//       M1:   linalg.matmul
+//  M1-SAME:     iree.cpu_tile_sizes = {{\[}}[256, 256], [64, 64, 64], [4, 4, 4]]
+
+// -----
+
+hal.executable @small_matmul attributes {sym_visibility = "private"} {
+  hal.interface @legacy_io {
+    hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @arg1, set=0, binding=1, type="StorageBuffer", access="Read"
+    hal.interface.binding @ret0, set=0, binding=2, type="StorageBuffer", access="Write|Discard"
+  }
+  hal.executable.target @llvm_aot, filter="dylib*" {
+    hal.executable.entry_point @small_matmul attributes {
+      interface = @legacy_io, ordinal = 0 : i32,
+      signature = (!flow.dispatch.input<24x16xf32>, !flow.dispatch.input<16x8xf32>,
+        !flow.dispatch.output<24x8xf32>) -> ()}
+    module {
+      func @small_matmul(%arg0 : memref<24x16xf32>, %arg1: memref<16x8xf32>, %arg2: memref<24x8xf32>) {
+        linalg.matmul ins(%arg0, %arg1 : memref<24x16xf32>, memref<16x8xf32>) outs(%arg2 : memref<24x8xf32>)
+        return
+      }
+    }
+  }
+}
+// GENERIC-LABEL: func @small_matmul
+//       GENERIC:   linalg.matmul
+//  GENERIC-SAME:     iree.cpu_tile_sizes = {{\[}}[64, 64], [32, 32, 32], [4, 4, 4]]
+// SKX-LABEL: func @small_matmul
+//       SKX:   linalg.matmul
+//  SKX-SAME:     iree.cpu_tile_sizes = {{\[}}[32, 8], [32, 8, 16], [4, 4, 4]]
+
+// -----
+
+hal.executable @batch_matmul attributes {sym_visibility = "private"} {
+  hal.interface @legacy_io {
+    hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @arg1, set=0, binding=1, type="StorageBuffer", access="Read"
+    hal.interface.binding @ret0, set=0, binding=2, type="StorageBuffer", access="Write|Discard"
+  }
+  hal.executable.target @llvm_aot, filter="dylib*" {
+    hal.executable.entry_point @batch_matmul attributes {
+      interface = @legacy_io, ordinal = 0 : i32,
+      signature = (!flow.dispatch.input<4x256x256xf32>, !flow.dispatch.input<4x256x256xf32>,
+        !flow.dispatch.output<4x256x256xf32>) -> ()}
+    module {
+      func @batch_matmul(%arg0 : memref<4x256x256xf32>, %arg1: memref<4x256x256xf32>, %arg2: memref<4x256x256xf32>) {
+        linalg.batch_matmul ins(%arg0, %arg1 : memref<4x256x256xf32>, memref<4x256x256xf32>) outs(%arg2 : memref<4x256x256xf32>)
+        return
+      }
+    }
+  }
+}
+// GENERIC-LABEL: func @batch_matmul
+//       GENERIC:   linalg.batch_matmul
+//  GENERIC-SAME:     iree.cpu_tile_sizes = {{\[}}[1, 32, 32], [1, 16, 16, 16], [1, 4, 4, 4]]
+// SKX-LABEL: func @batch_matmul
+//       SKX:   linalg.batch_matmul
+//  SKX-SAME:     iree.cpu_tile_sizes = {{\[}}[1, 128, 128], [1, 32, 32, 32], [1, 4, 4, 4]]
@@ -0,0 +1,61 @@
+// RUN: iree-opt -pass-pipeline="hal.executable(hal.executable.target(iree-codegen-llvm-linalg-tile-and-distribute)),hal.executable(hal.executable.target(module(iree-codegen-linalg-to-llvm-matmul-microkernel-conversion)))" -split-input-file %s | IreeFileCheck %s
+
+hal.executable @static_matmul attributes {sym_visibility = "private"} {
+  hal.interface @legacy_io {
+    hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @arg1, set=0, binding=1, type="StorageBuffer", access="Read"
+    hal.interface.binding @ret0, set=0, binding=2, type="StorageBuffer", access="Write|Discard"
+  }
+  hal.executable.target @llvm_aot, filter="dylib*" {
+    hal.executable.entry_point @matmul_128x128x128 attributes {
+      interface = @legacy_io, ordinal = 0 : i32,
+      signature = (!flow.dispatch.input<128x128xf32>, !flow.dispatch.input<128x128xf32>,
+        !flow.dispatch.output<128x128xf32>) -> ()}
+    module {
+      func @matmul_128x128x128(%arg0 : memref<128x128xf32>, %arg1: memref<128x128xf32>, %arg2: memref<128x128xf32>) {
+        linalg.matmul ins(%arg0, %arg1 : memref<128x128xf32>, memref<128x128xf32>) outs(%arg2 : memref<128x128xf32>)
+        return
+      }
+    }
+  }
+}
+// CHECK:      func private @iree_microkernel_linalg_matmul_f32
+// CHECK-SAME:   (memref<?x?xf32, #{{.+}}>, memref<?x?xf32, #{{.+}}>, memref<?x?xf32, #{{.+}}>)
+// CHECK-SAME:   attributes {hal.microkernel}
+// CHECK-LABEL: func @matmul_128x128x128
+// CHECK-SAME: (%[[ARG0:.+]]: memref<128x128xf32>, %[[ARG1:.+]]: memref<128x128xf32>, %[[ARG2:.+]]: memref<128x128xf32>)
+// CHECK-DAG:   %[[LHS:.+]] = subview %[[ARG0]]
+// CHECK-DAG:   %[[RHS:.+]] = subview %[[ARG1]]
+// CHECK-DAG:   %[[OUT:.+]] = subview %[[ARG2]]
+// CHECK-DAG:   %[[LHS_CAST:.+]] = memref_cast %[[LHS]]
+// CHECK-DAG:   %[[RHS_CAST:.+]] = memref_cast %[[RHS]]
+// CHECK-DAG:   %[[OUT_CAST:.+]] = memref_cast %[[OUT]]
+// CHECK:       call @iree_microkernel_linalg_matmul_f32(%[[LHS_CAST]], %[[RHS_CAST]], %[[OUT_CAST]])
+// CHECK-NOT:   linalg.matmul
+
+// -----
+
+hal.executable @integer_matmul attributes {sym_visibility = "private"} {
+  hal.interface @legacy_io {
+    hal.interface.binding @arg0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @arg1, set=0, binding=1, type="StorageBuffer", access="Read"
+    hal.interface.binding @ret0, set=0, binding=2, type="StorageBuffer", access="Write|Discard"
+  }
+  hal.executable.target @llvm_aot, filter="dylib*" {
+    hal.executable.entry_point @matmul_i32 attributes {
+      interface = @legacy_io, ordinal = 0 : i32,
+      signature = (!flow.dispatch.input<128x128xi32>, !flow.dispatch.input<128x128xi32>,
+        !flow.dispatch.output<128x128xi32>) -> ()}
+    module {
+      func @matmul_i32(%arg0 : memref<128x128xi32>, %arg1: memref<128x128xi32>, %arg2: memref<128x128xi32>) {
+        linalg.matmul ins(%arg0, %arg1 : memref<128x128xi32>, memref<128x128xi32>) outs(%arg2 : memref<128x128xi32>)
+        return
+      }
+    }
+  }
+}
+// Only f32 matmuls have a microkernel.
+// CHECK-NOT:   @iree_microkernel_linalg_matmul_f32
+// CHECK-LABEL: func @matmul_i32
+// CHECK:         linalg.matmul
+// CHECK-NOT:     call
@@ -24,6 +24,7 @@
 #include "iree/compiler/Dialect/Shape/IR/ShapeOps.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Builders.h"
@@ -124,18 +125,15 @@ static void allocateOutputBuffers(IREE::Flow::ExStreamFragmentOp streamOp,
   }
 }
 
-// Allocates a transient buffer for use entirely within the command buffer.
-static Value allocateTransientBuffer(Value streamValue, Value allocator,
-                                     ConversionPatternRewriter &rewriter) {
-  Location loc = streamValue.getLoc();
-  // TODO(benvanik): compute from SSA use-def chain uses.
-  IREE::HAL::MemoryTypeBitfield memoryTypes =
-      IREE::HAL::MemoryTypeBitfield::DeviceLocal;
-  IREE::HAL::BufferUsageBitfield bufferUsage =
-      IREE::HAL::BufferUsageBitfield::Dispatch |
-      IREE::HAL::BufferUsageBitfield::Transfer;
+// Byte alignment of each value placed within the transient slab of a stream.
+// This is the largest minStorageBufferOffsetAlignment we expect any device to
+// require so that every subspan can be bound directly to a dispatch.
+static constexpr int64_t kTransientSlabAlignment = 256;
 
-  // Compute the allocation size for the value.
+// Computes the byte size required to store a transient value.
+static Value computeTransientBufferSize(Value streamValue, Value allocator,
+                                        ConversionPatternRewriter &rewriter) {
+  Location loc = streamValue.getLoc();
   auto elementType = IREE::HAL::getElementTypeValue(
       streamValue.getType().cast<ShapedType>().getElementType());
   if (!elementType) {
@@ -145,32 +143,76 @@ static Value allocateTransientBuffer(Value streamValue, Value allocator,
   if (!shape) {
     return {};
   }
-  auto allocationSize = rewriter
-                            .create<IREE::HAL::AllocatorComputeSizeOp>(
-                                loc, allocator, *shape, elementType.getValue())
-                            .getResult();
+  return rewriter
+      .create<IREE::HAL::AllocatorComputeSizeOp>(loc, allocator, *shape,
+                                                 elementType.getValue())
+      .getResult();
+}
 
-  auto buffer =
-      rewriter
-          .create<IREE::HAL::AllocatorAllocateOp>(loc, allocator, memoryTypes,
-                                                  bufferUsage, allocationSize)
-          .getResult();
+// Returns the byte size of |streamValue| if its shape is fully static.
+// This is only an estimate used for packing heuristics and reporting; the
+// allocator computes the real size at runtime.
+static Optional<int64_t> getStaticTransientBufferSize(Value streamValue) {
+  auto shapedType = streamValue.getType().cast<ShapedType>();
+  if (!shapedType.hasStaticShape()) return llvm::None;
+  auto elementType =
+      IREE::HAL::getElementTypeValue(shapedType.getElementType());
+  if (!elementType) return llvm::None;
+  int64_t elementByteCount = ((elementType.getValue() & 0xFF) + 8 - 1) / 8;
+  return shapedType.getNumElements() * elementByteCount;
+}
 
-  return buffer;
+static int64_t alignTransientOffset(int64_t value) {
+  return llvm::alignTo(value, kTransientSlabAlignment);
 }
 
+static Value alignTransientOffset(Location loc, Value value,
+                                  ConversionPatternRewriter &rewriter) {
+  auto alignment = rewriter.createOrFold<mlir::ConstantIndexOp>(
+      loc, kTransientSlabAlignment);
+  auto alignmentMinusOne = rewriter.createOrFold<mlir::ConstantIndexOp>(
+      loc, kTransientSlabAlignment - 1);
+  return rewriter.createOrFold<MulIOp>(
+      loc,
+      rewriter.createOrFold<UnsignedDivIOp>(
+          loc, rewriter.createOrFold<AddIOp>(loc, value, alignmentMinusOne),
+          alignment),
+      alignment);
+}
+
+// A range of the transient slab shared by values with disjoint lifetimes.
+struct TransientSlot {
+  // Values assigned to the slot in definition order.
+  SmallVector<Value, 4> values;
+  // Index of the last op within the stream that uses any assigned value.
+  unsigned lastUse = 0;
+  // Maximum static byte size of all assigned values, if all are static.
+  Optional<int64_t> staticSize = 0;
+  // Maximum runtime byte size of all assigned values.
+  Value size;
+};
+
 // Allocates transient buffers to store the intra-stream results and populates
 // the |bufferSet| with the new mappings.
+//
+// Rather than allocating each transient value independently all values are
+// packed into a single slab allocation. Each value is live from the op that
+// defines it to the last op that uses it (or any identity of it) and values
+// with disjoint live ranges are assigned to the same slot of the slab via
+// greedy interval coloring. Sizes may be dynamic and so slot sizes and offsets
+// are computed at runtime.
 static void allocateTransientBuffers(IREE::Flow::ExStreamFragmentOp streamOp,
                                      BufferSet &bufferSet,
                                      ConversionPatternRewriter &rewriter) {
   LLVM_DEBUG(llvm::dbgs() << ": HAL allocateTransientBuffers: "
                           << *streamOp.getOperation() << "\n");
+  Location loc = streamOp.getLoc();
+  auto &streamBlock = streamOp.body().front();
 
   auto propagateIdentityBuffers = [&]() {
     bool madeChange = false;
     // Pull outputs that terminate on identities to operands.
-    for (auto &op : llvm::reverse(streamOp.body().front())) {
+    for (auto &op : llvm::reverse(streamBlock)) {
       if (isIdentityOp(&op)) {
         auto result = op.getResult(0);
         auto operand = op.getOperand(0);
@@ -186,7 +228,7 @@ static void allocateTransientBuffers(IREE::Flow::ExStreamFragmentOp streamOp,
     }
 
     // Push inputs that originate on identities to results.
-    for (auto &op : streamOp.body().front()) {
+    for (auto &op : streamBlock) {
       if (isIdentityOp(&op)) {
         auto operand = op.getOperand(0);
         auto result = op.getResult(0);
@@ -215,8 +257,28 @@ static void allocateTransientBuffers(IREE::Flow::ExStreamFragmentOp streamOp,
   // changes are made.
   while (propagateIdentityBuffers()) {
   }
-  for (auto &op : streamOp.body().front()) {
-    if (isNoOp(&op) || isIdentityOp(&op)) continue;
+
+  // Gather the transient values and their live ranges as [def, last use] op
+  // indices. Identity results alias the transient value they are derived from
+  // and extend its live range.
+  SmallVector<Value, 8> transientValues;
+  DenseMap<Value, Value> aliasRoots;
+  DenseMap<Value, std::pair<unsigned, unsigned>> liveRanges;
+  unsigned opIndex = 0;
+  for (auto &op : streamBlock) {
+    unsigned index = opIndex++;
+    for (auto operand : op.getOperands()) {
+      if (auto root = aliasRoots.lookup(operand)) {
+        liveRanges[root].second = index;
+      }
+    }
+    if (isNoOp(&op)) continue;
+    if (isIdentityOp(&op)) {
+      if (auto root = aliasRoots.lookup(op.getOperand(0))) {
+        aliasRoots[op.getResult(0)] = root;
+      }
+      continue;
+    }
     for (auto it : llvm::enumerate(op.getResults())) {
       auto result = it.value();
       // If the result is an output buffer we can just use that directly.
@@ -227,11 +289,123 @@ static void allocateTransientBuffers(IREE::Flow::ExStreamFragmentOp streamOp,
       }
       LLVM_DEBUG(llvm::dbgs() << "    -- ALLOCATE BUFFER FOR RESULT("
                               << it.index() << "): " << op << "\n");
-      auto buffer =
-          allocateTransientBuffer(result, bufferSet.allocator, rewriter);
-      bufferSet.rangeMap[result] = BufferRange{buffer};
+      transientValues.push_back(result);
+      aliasRoots[result] = result;
+      liveRanges[result] = std::make_pair(index, index);
+    }
+  }
+  if (transientValues.empty()) return;
+
+  // Assign each value to a free slot, preferring the slot closest in size to
+  // avoid growing it. A slot is free once the last use of everything assigned
+  // to it precedes the definition of the value; ops that both consume and
+  // produce transient values never alias their operands and results.
+  SmallVector<TransientSlot, 4> slots;
+  unsigned packedValueCount = 0;
+  int64_t staticUnpackedSize = 0;
+  bool isFullyStatic = true;
+  for (auto value : transientValues) {
+    auto size =
+        computeTransientBufferSize(value, bufferSet.allocator, rewriter);
+    if (!size) continue;
+    ++packedValueCount;
+    auto staticSize = getStaticTransientBufferSize(value);
+    if (staticSize) {
+      staticUnpackedSize += alignTransientOffset(staticSize.getValue());
+    } else {
+      isFullyStatic = false;
+    }
+
+    auto liveRange = liveRanges[value];
+    auto getSizeDelta = [&](const TransientSlot &slot) -> int64_t {
+      if (!staticSize || !slot.staticSize) return 0;
+      return std::abs(slot.staticSize.getValue() - staticSize.getValue());
+    };
+    TransientSlot *bestSlot = nullptr;
+    for (auto &slot : slots) {
+      if (slot.lastUse >= liveRange.first) continue;
+      if (!bestSlot || getSizeDelta(slot) < getSizeDelta(*bestSlot)) {
+        bestSlot = &slot;
+      }
+    }
+    if (!bestSlot) {
+      slots.emplace_back();
+      bestSlot = &slots.back();
+      bestSlot->size = size;
+    } else {
+      auto isLarger = rewriter.createOrFold<CmpIOp>(loc, CmpIPredicate::ugt,
+                                                    size, bestSlot->size);
+      bestSlot->size =
+          rewriter.createOrFold<SelectOp>(loc, isLarger, size, bestSlot->size);
+    }
+    bestSlot->values.push_back(value);
+    bestSlot->lastUse = liveRange.second;
+    if (staticSize && bestSlot->staticSize) {
+      bestSlot->staticSize =
+          std::max(bestSlot->staticSize.getValue(), staticSize.getValue());
+    } else {
+      bestSlot->staticSize = llvm::None;
+    }
+  }
+  if (slots.empty()) return;
+
+  // Lay out the slots end to end, aligning each one so that its offset is
+  // valid for binding. The final slot is left unaligned.
+  SmallVector<Value, 4> slotOffsets;
+  int64_t staticPackedSize = 0;
+  Value slabSize = rewriter.createOrFold<mlir::ConstantIndexOp>(loc, 0);
+  for (auto &slot : slots) {
+    slotOffsets.push_back(slabSize);
+    auto slotSize = &slot == &slots.back()
+                        ? slot.size
+                        : alignTransientOffset(loc, slot.size, rewriter);
+    slabSize = rewriter.createOrFold<AddIOp>(loc, slabSize, slotSize);
+    if (slot.staticSize) {
+      staticPackedSize += alignTransientOffset(slot.staticSize.getValue());
     }
   }
+  LLVM_DEBUG({
+    llvm::dbgs() << "  + PACKED " << packedValueCount
+                 << " TRANSIENT VALUES INTO " << slots.size() << " SLOTS";
+    if (isFullyStatic) {
+      llvm::dbgs() << " (" << staticUnpackedSize << " -> " << staticPackedSize
+                   << " bytes)";
+    }
+    llvm::dbgs() << "\n";
+  });
+  (void)packedValueCount;
+  (void)staticUnpackedSize;
+  (void)staticPackedSize;
+  (void)isFullyStatic;
+
+  // The slab is only live for the duration of the stream and the runtime can
+  // service it from a pool of recycled allocations.
+  // TODO(benvanik): compute from SSA use-def chain uses.
+  IREE::HAL::MemoryTypeBitfield memoryTypes =
+      IREE::HAL::MemoryTypeBitfield::Transient |
+      IREE::HAL::MemoryTypeBitfield::DeviceLocal;
+  IREE::HAL::BufferUsageBitfield bufferUsage =
+      IREE::HAL::BufferUsageBitfield::Dispatch |
+      IREE::HAL::BufferUsageBitfield::Transfer;
+  auto slabBuffer =
+      rewriter
+          .create<IREE::HAL::AllocatorAllocateOp>(
+              loc, bufferSet.allocator, memoryTypes, bufferUsage, slabSize)
+          .getResult();
+
+  // A lone slot spans the entire slab and can use it directly.
+  for (auto slot : llvm::enumerate(slots)) {
+    auto slotBuffer = slabBuffer;
+    if (slots.size() > 1) {
+      slotBuffer = rewriter.createOrFold<IREE::HAL::BufferSubspanOp>(
+          loc, slabBuffer.getType(), slabBuffer, slotOffsets[slot.index()],
+          slot.value().size);
+    }
+    for (auto value : slot.value().values) {
+      bufferSet.rangeMap[value] = BufferRange{slotBuffer};
+    }
+  }
+
   while (propagateIdentityBuffers()) {
   }
 }
@@ -21,7 +21,7 @@ func @multipleDispatches(%arg0: tensor<128xf32>) -> tensor<128xf32> {
   // CHECK-DAG: %[[C128:.+]] = constant 128
   %cst = constant 128 : index
   // CHECK: %[[RET_BUF:.+]] = hal.allocator.allocate {{.+}}, "HostVisible|DeviceVisible|DeviceLocal", "Constant|Transfer|Mapping|Dispatch"
-  // CHECK: %[[TMP_BUF:.+]] = hal.allocator.allocate {{.+}}, "DeviceVisible|DeviceLocal", "Transfer|Dispatch"
+  // CHECK: %[[TMP_BUF:.+]] = hal.allocator.allocate {{.+}}, "Transient|DeviceVisible|DeviceLocal", "Transfer|Dispatch"
   // CHECK: %[[CMD:.+]] = hal.command_buffer.create {{.+}}, OneShot, "Transfer|Dispatch"
   // CHECK-NEXT: hal.command_buffer.begin %[[CMD]]
   %0 = flow.ex.stream.fragment(%arg1 = %cst : index, %arg2 = %arg0 : tensor<128xf32>) -> tensor<128xf32> {
@@ -44,6 +44,50 @@ func @multipleDispatches(%arg0: tensor<128xf32>) -> tensor<128xf32> {
 
 // -----
 
+hal.executable @ex0 {
+  hal.interface @interface {
+    hal.interface.binding @s0b0, set=0, binding=0, type="StorageBuffer", access="Read"
+    hal.interface.binding @s0b1, set=0, binding=1, type="StorageBuffer", access="Read|Write"
+  }
+  hal.executable.target @vmla, filter="vmla" {
+    hal.executable.entry_point @entry0 attributes {
+      interface = @interface,
+      ordinal = 0 : i32,
+      signature = (tensor<128xf32>) -> tensor<128xf32>
+    }
+    module {}
+  }
+}
+
+// Transient values with disjoint lifetimes share a range of a single slab.
+// CHECK-LABEL: func @packedTransientBuffers
+func @packedTransientBuffers(%arg0: tensor<128xf32>) -> tensor<128xf32> {
+  %cst = constant 128 : index
+  // CHECK-DAG: %[[C0:.+]] = constant 0
+  // CHECK-DAG: %[[C512:.+]] = constant 512
+  // CHECK-DAG: %[[C1024:.+]] = constant 1024
+  // CHECK: %[[RET_BUF:.+]] = hal.allocator.allocate {{.+}}, "HostVisible|DeviceVisible|DeviceLocal", "Constant|Transfer|Mapping|Dispatch"
+  // CHECK: %[[SLAB_BUF:.+]] = hal.allocator.allocate {{.+}}, "Transient|DeviceVisible|DeviceLocal", "Transfer|Dispatch", %[[C1024]]
+  // CHECK-NOT: hal.allocator.allocate
+  // CHECK: %[[TMP_BUF0:.+]] = hal.buffer.subspan %[[SLAB_BUF]], %[[C0]], %[[C512]]
+  // CHECK: %[[TMP_BUF1:.+]] = hal.buffer.subspan %[[SLAB_BUF]], %[[C512]], %[[C512]]
+  %0 = flow.ex.stream.fragment(%arg1 = %cst : index, %arg2 = %arg0 : tensor<128xf32>) -> tensor<128xf32> {
+    // CHECK: bindings=[0 = (%arg0, %c0, %c512), 1 = (%[[TMP_BUF0]], %c0, %c512)]
+    %1 = flow.dispatch @ex0::@entry0[%arg1] (%arg2) : (tensor<128xf32>) -> tensor<128xf32>
+    // CHECK: bindings=[0 = (%[[TMP_BUF0]], %c0, %c512), 1 = (%[[TMP_BUF1]], %c0, %c512)]
+    %2 = flow.dispatch @ex0::@entry0[%arg1] (%1) : (tensor<128xf32>) -> tensor<128xf32>
+    // CHECK: bindings=[0 = (%[[TMP_BUF1]], %c0, %c512), 1 = (%[[TMP_BUF0]], %c0, %c512)]
+    %3 = flow.dispatch @ex0::@entry0[%arg1] (%2) : (tensor<128xf32>) -> tensor<128xf32>
+    // CHECK: bindings=[0 = (%[[TMP_BUF0]], %c0, %c512), 1 = (%[[RET_BUF]], %c0, %c512)]
+    %4 = flow.dispatch @ex0::@entry0[%arg1] (%3) : (tensor<128xf32>) -> tensor<128xf32>
+    flow.return %4 : tensor<128xf32>
+  }
+  // CHECK: return %[[RET_BUF]]
+  return %0 : tensor<128xf32>
+}
+
+// -----
+
 // CHECK-LABEL: @tensorUpdate
 // CHECK-SAME: (%[[UBUF:.+]]:{{.+}}, %[[TBUF:.+]]:{{.+}})
 func @tensorUpdate(%arg0 : tensor<1x1x10xf32>, %arg1 : tensor<5x1x10xf32>) -> tensor<5x1x10xf32> {
@@ -74,7 +74,7 @@ class LLVMAOTTargetBackend final : public TargetBackend {
   std::string filter_pattern() const override { return "dylib*"; }
 
   void buildTranslationPassPipeline(OpPassManager &passManager) override {
-    buildLLVMTransformPassPipeline(passManager);
+    buildLLVMTransformPassPipeline(passManager, options_.targetCPU);
   }
 
   LogicalResult linkExecutables(mlir::ModuleOp moduleOp) override {
@@ -216,6 +216,21 @@ class LLVMAOTTargetBackend final : public TargetBackend {
       funcOp.erase();
     }
 
+    // Microkernels called by the generated code must be linked in; without
+    // the library the dylib would only fail once loaded at runtime.
+    auto microkernelOps = llvm::to_vector<4>(llvm::make_filter_range(
+        targetOp.getInnerModule().getOps<LLVM::LLVMFuncOp>(),
+        [](LLVM::LLVMFuncOp funcOp) {
+          return funcOp.getOperation()->hasAttr(getMicrokernelAttrName());
+        }));
+    if (!microkernelOps.empty() && options_.microkernelLibrary.empty()) {
+      return targetOp.emitError()
+             << "executable calls microkernel '"
+             << microkernelOps.front().getName()
+             << "' but no library was provided with "
+                "--iree-llvm-microkernel-library";
+    }
+
     llvm::Triple targetTriple(options_.targetTriple);
     targetOp.getInnerModule()->setAttr(
         LLVM::LLVMDialect::getTargetTripleAttrName(),
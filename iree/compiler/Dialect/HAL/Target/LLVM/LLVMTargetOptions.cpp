@@ -121,6 +121,14 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
       llvm::cl::init(llvmTargetOptions.keepLinkerArtifacts));
   llvmTargetOptions.keepLinkerArtifacts = clKeepLinkerArtifacts;
 
+  static llvm::cl::opt<std::string> clMicrokernelLibrary(
+      "iree-llvm-microkernel-library",
+      llvm::cl::desc("Static library built for the target that provides the "
+                     "microkernels called by generated code (such as "
+                     "libiree_hal_local_microkernels_sgemm.a)"),
+      llvm::cl::init(""));
+  llvmTargetOptions.microkernelLibrary = clMicrokernelLibrary;
+
   return llvmTargetOptions;
 }
 
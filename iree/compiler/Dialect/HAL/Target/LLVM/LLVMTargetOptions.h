@@ -46,6 +46,10 @@ struct LLVMTargetOptions {
 
   // True to keep linker artifacts for debugging.
   bool keepLinkerArtifacts = false;
+
+  // Static library providing the microkernels called by generated code (see
+  // iree/hal/local/microkernels/). Linked into every produced binary when set.
+  std::string microkernelLibrary;
 };
 
 // Returns LLVMTargetOptions struct intialized with the iree-llvm-* flags.
@@ -264,6 +264,12 @@ class WindowsLinkerTool : public LinkerTool {
       flags.push_back(objectFile.path);
     }
 
+    // Microkernels are resolved from the library after the objects that
+    // reference them; only the archive members used are linked.
+    if (!targetOptions.microkernelLibrary.empty()) {
+      flags.push_back(targetOptions.microkernelLibrary);
+    }
+
     auto commandLine = llvm::join(flags, " ");
     if (failed(runLinkCommand(commandLine))) return llvm::None;
 
@@ -23,6 +23,7 @@
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Builders.h"
@@ -541,8 +542,11 @@ RegisterAllocation::remapSuccessorRegisters(Operation *op, int successorIndex) {
       scratchReg =
           Register::getWithSameType(feedbackEdge.first, ++scratchRefReg);
     } else {
-      scratchReg =
-          Register::getWithSameType(feedbackEdge.first, ++scratchI32Reg);
+      // Wide values need naturally-aligned spans of i32 registers.
+      int width = feedbackEdge.first.byteWidth() / sizeof(int32_t);
+      int ordinal = llvm::alignTo(scratchI32Reg + 1, width);
+      scratchReg = Register::getWithSameType(feedbackEdge.first, ordinal);
+      scratchI32Reg = ordinal + width - 1;
     }
     feedbackArcSet.acyclicEdges.insert(feedbackArcSet.acyclicEdges.begin(),
                                        {feedbackEdge.first, scratchReg});
@@ -155,8 +155,44 @@ class V0BytecodeEncoder : public BytecodeEncoder {
     // this list is small :)
     auto srcDstRegs = registerAllocation_->remapSuccessorRegisters(
         currentOp_, successorIndex);
-    (void)writeUint16(srcDstRegs.size());
+
+    // Split the remappings by bank so the runtime need not check types.
+    // i32 moves are coalesced into runs of contiguous registers while
+    // preserving the order the allocator sequenced them in. Wide values are
+    // emitted as a run covering all of their i32 registers.
+    struct I32Run {
+      uint16_t srcReg;
+      uint16_t dstReg;
+      uint16_t length;
+    };
+    SmallVector<I32Run, 8> i32Runs;
+    SmallVector<std::pair<Register, Register>, 8> refPairs;
     for (auto srcDstReg : srcDstRegs) {
+      if (srcDstReg.first.isRef()) {
+        refPairs.push_back(srcDstReg);
+        continue;
+      }
+      uint16_t srcReg = srcDstReg.first.ordinal();
+      uint16_t dstReg = srcDstReg.second.ordinal();
+      uint16_t length = srcDstReg.first.byteWidth() / sizeof(int32_t);
+      if (!i32Runs.empty() &&
+          i32Runs.back().srcReg + i32Runs.back().length == srcReg &&
+          i32Runs.back().dstReg + i32Runs.back().length == dstReg) {
+        i32Runs.back().length += length;
+      } else {
+        i32Runs.push_back({srcReg, dstReg, length});
+      }
+    }
+
+    if (failed(writeUint16(i32Runs.size()))) return failure();
+    for (auto &run : i32Runs) {
+      if (failed(writeUint16(run.srcReg)) || failed(writeUint16(run.dstReg)) ||
+          failed(writeUint16(run.length))) {
+        return failure();
+      }
+    }
+    if (failed(writeUint16(refPairs.size()))) return failure();
+    for (auto srcDstReg : refPairs) {
       if (failed(writeUint16(srcDstReg.first.encode())) ||
           failed(writeUint16(srcDstReg.second.encode()))) {
         return failure();
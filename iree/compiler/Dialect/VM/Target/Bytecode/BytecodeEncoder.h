@@ -24,6 +24,13 @@ namespace iree_compiler {
 namespace IREE {
 namespace VM {
 
+// Version of the op table and operand encoding produced by BytecodeEncoder.
+// Must be bumped whenever the encoding of existing ops changes or new opcodes
+// are emitted and kept in sync with IREE_VM_BYTECODE_VERSION in
+// iree/vm/bytecode_module_impl.h; the runtime rejects any other version.
+//   1: branch register remap lists split into i32 runs and ref pairs.
+static constexpr uint32_t kBytecodeVersion = 1;
+
 struct EncodedBytecodeFunction {
   std::vector<uint8_t> bytecodeData;
   uint16_t i32RegisterCount = 0;
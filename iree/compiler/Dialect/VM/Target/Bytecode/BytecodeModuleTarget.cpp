@@ -504,6 +504,7 @@ static LogicalResult buildFlatBufferModule(BytecodeTargetOptions targetOptions,
   iree_vm_BytecodeModuleDef_function_descriptors_add(fbb,
                                                      functionDescriptorsRef);
   iree_vm_BytecodeModuleDef_bytecode_data_add(fbb, bytecodeDataRef);
+  iree_vm_BytecodeModuleDef_bytecode_version_add(fbb, kBytecodeVersion);
   iree_vm_BytecodeModuleDef_end_as_root(fbb);
   return success();
 }
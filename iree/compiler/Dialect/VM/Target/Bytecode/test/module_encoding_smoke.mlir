@@ -28,5 +28,6 @@ vm.module @simple_module {
   // CHECK-NEXT:   0,
   // CHECK-NEXT:   0,
   // CHECK-NEXT:   0
-  // CHECK-NEXT: ]
+  // CHECK-NEXT: ],
+  // CHECK-NEXT: "bytecode_version": 1
 }
@@ -135,6 +135,67 @@ IREE_API_EXPORT iree_status_t IREE_API_CALL iree_hal_allocator_create_heap(
     iree_string_view_t identifier, iree_allocator_t host_allocator,
     iree_hal_allocator_t** out_allocator);
 
+// Releases the storage of transient buffers retained for reuse by the heap
+// |allocator| back to its host allocator. Outstanding buffers are unaffected.
+//
+// Storage of buffers allocated with IREE_HAL_MEMORY_TYPE_TRANSIENT is pooled
+// by size class up to a fixed budget
+// (IREE_HAL_HEAP_TRANSIENT_MAX_POOLED_BYTES) as such buffers are expected to
+// be allocated and released at a high frequency. Trimming returns the pooled
+// storage when the transient working set is known to have shrunk.
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_hal_heap_allocator_trim(iree_hal_allocator_t* allocator);
+
+//===----------------------------------------------------------------------===//
+// iree_hal_caching_allocator_t
+//===----------------------------------------------------------------------===//
+
+// Statistics of a caching allocator accumulated since its creation.
+typedef struct {
+  // Total number of allocations serviced from a cached buffer.
+  uint64_t hit_count;
+  // Total number of allocations that required a new buffer from the base
+  // allocator.
+  uint64_t miss_count;
+  // Total number of cached buffers released back to the base allocator due to
+  // the budget being exceeded or the cache being trimmed.
+  uint64_t eviction_count;
+  // Number of buffers currently retained in the cache.
+  iree_host_size_t cached_buffer_count;
+  // Total size of the buffers currently retained in the cache.
+  iree_device_size_t cached_bytes;
+} iree_hal_caching_allocator_statistics_t;
+
+// Creates an allocator that wraps |base_allocator| and caches released
+// buffers for reuse by subsequent allocations. Allocation sizes are rounded up
+// to a power-of-two size class and cached buffers are only reused for requests
+// of the same size class, memory type, and usage. This avoids the cost of the
+// base allocator (and of populating fresh memory) when buffers of similar
+// sizes are repeatedly allocated and released such as the outputs of each
+// invocation.
+//
+// At most |max_cached_bytes| of released buffers are retained. When a released
+// buffer would exceed the budget larger cached buffers are evicted first to
+// make room. Buffers larger than the budget or the largest size class are
+// allocated directly from the base allocator and are not cached.
+//
+// The contents of buffers allocated from the caching allocator are undefined
+// as they may have been used by a prior buffer.
+IREE_API_EXPORT iree_status_t IREE_API_CALL iree_hal_allocator_create_caching(
+    iree_hal_allocator_t* base_allocator, iree_device_size_t max_cached_bytes,
+    iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator);
+
+// Releases all buffers retained in the cache of the caching |allocator| back
+// to its base allocator. Outstanding buffers are unaffected.
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_hal_caching_allocator_trim(iree_hal_allocator_t* allocator);
+
+// Queries the statistics of the caching |allocator|.
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_hal_caching_allocator_query_statistics(
+    iree_hal_allocator_t* allocator,
+    iree_hal_caching_allocator_statistics_t* out_statistics);
+
 //===----------------------------------------------------------------------===//
 // iree_hal_allocator_t implementation details
 //===----------------------------------------------------------------------===//
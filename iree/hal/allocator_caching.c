@@ -0,0 +1,386 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stddef.h>
+
+#include "iree/base/tracing.h"
+#include "iree/hal/allocator.h"
+#include "iree/hal/detail.h"
+#include "iree/hal/size_class_pool.h"
+
+// Buffers are cached in power-of-two size classes covering [2^MIN, 2^MAX]
+// bytes. Allocations larger than the maximum size class or the budget bypass
+// the cache.
+#define IREE_HAL_CACHING_MIN_SIZE_CLASS 8
+#define IREE_HAL_CACHING_MAX_SIZE_CLASS 30
+
+#define _VTABLE_DISPATCH(buffer, method_name) \
+  IREE_HAL_VTABLE_DISPATCH(buffer, iree_hal_buffer, method_name)
+
+//===----------------------------------------------------------------------===//
+// iree_hal_caching_buffer_t
+//===----------------------------------------------------------------------===//
+
+// A buffer allocated from a caching allocator. The storage is a buffer from
+// the base allocator rounded up to the size class and the caching buffer acts
+// as a subspan of it. This keeps the storage as the allocated buffer such that
+// device implementations that look up their native handles from it continue to
+// work.
+//
+// When released the caching buffer (including its storage) is placed in the
+// cache of the allocator and reinitialized when reused.
+typedef struct iree_hal_caching_buffer_s {
+  iree_hal_buffer_t base;
+
+  // Entry in the allocator pool. The size class is that of |storage_buffer|
+  // and the key is the memory type and usage as requested by the caller that
+  // allocated the storage. Cached buffers are matched on the requested bits as
+  // the base allocator may have added bits to those of the storage buffer.
+  iree_hal_size_class_pool_entry_t entry;
+
+  // Buffer allocated from the base allocator providing the storage.
+  iree_hal_buffer_t* storage_buffer;
+} iree_hal_caching_buffer_t;
+
+static iree_hal_caching_buffer_t* iree_hal_caching_buffer_from_entry(
+    iree_hal_size_class_pool_entry_t* entry) {
+  return (iree_hal_caching_buffer_t*)((uint8_t*)entry -
+                                      offsetof(iree_hal_caching_buffer_t,
+                                               entry));
+}
+
+// Returns the pool key matching buffers requested with |memory_type| and
+// |allowed_usage|.
+static uint64_t iree_hal_caching_buffer_key(
+    iree_hal_memory_type_t memory_type, iree_hal_buffer_usage_t allowed_usage) {
+  return ((uint64_t)memory_type << 32) | (uint64_t)allowed_usage;
+}
+
+static const iree_hal_buffer_vtable_t iree_hal_caching_buffer_vtable;
+
+//===----------------------------------------------------------------------===//
+// iree_hal_caching_allocator_t
+//===----------------------------------------------------------------------===//
+
+typedef struct {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  iree_hal_allocator_t* base_allocator;
+
+  // Released buffers available for reuse with a budget of the maximum total
+  // size of their storage.
+  iree_hal_size_class_pool_t pool;
+} iree_hal_caching_allocator_t;
+
+static const iree_hal_allocator_vtable_t iree_hal_caching_allocator_vtable;
+
+IREE_API_EXPORT iree_status_t IREE_API_CALL iree_hal_allocator_create_caching(
+    iree_hal_allocator_t* base_allocator, iree_device_size_t max_cached_bytes,
+    iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator) {
+  IREE_ASSERT_ARGUMENT(base_allocator);
+  IREE_ASSERT_ARGUMENT(out_allocator);
+  *out_allocator = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_caching_allocator_t* allocator = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*allocator), (void**)&allocator);
+  if (iree_status_is_ok(status)) {
+    iree_hal_resource_initialize(&iree_hal_caching_allocator_vtable,
+                                 &allocator->resource);
+    allocator->host_allocator = host_allocator;
+    allocator->base_allocator = base_allocator;
+    iree_hal_allocator_retain(base_allocator);
+    iree_hal_size_class_pool_initialize(
+        IREE_HAL_CACHING_MIN_SIZE_CLASS, IREE_HAL_CACHING_MAX_SIZE_CLASS,
+        /*subclass_bits=*/0, max_cached_bytes, &allocator->pool);
+    *out_allocator = (iree_hal_allocator_t*)allocator;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Releases the storage of each buffer in |entry_list| and frees them.
+static void iree_hal_caching_allocator_free_buffers(
+    iree_hal_caching_allocator_t* allocator,
+    iree_hal_size_class_pool_entry_t* entry_list) {
+  while (entry_list) {
+    iree_hal_size_class_pool_entry_t* next_entry = entry_list->next;
+    iree_hal_caching_buffer_t* buffer =
+        iree_hal_caching_buffer_from_entry(entry_list);
+    iree_hal_buffer_release(buffer->storage_buffer);
+    iree_allocator_free(allocator->host_allocator, buffer);
+    entry_list = next_entry;
+  }
+}
+
+static void iree_hal_caching_allocator_destroy(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_caching_allocator_t* allocator =
+      (iree_hal_caching_allocator_t*)base_allocator;
+  iree_allocator_t host_allocator = allocator->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // All buffers have been returned to the cache as outstanding buffers retain
+  // the allocator.
+  iree_hal_caching_allocator_free_buffers(
+      allocator, iree_hal_size_class_pool_evict(&allocator->pool, 0));
+  iree_hal_size_class_pool_deinitialize(&allocator->pool);
+  iree_hal_allocator_release(allocator->base_allocator);
+  iree_allocator_free(host_allocator, allocator);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_hal_caching_allocator_trim(iree_hal_allocator_t* base_allocator) {
+  IREE_ASSERT_ARGUMENT(base_allocator);
+  if (!iree_hal_resource_is(base_allocator,
+                            &iree_hal_caching_allocator_vtable)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "allocator is not a caching allocator");
+  }
+  iree_hal_caching_allocator_t* allocator =
+      (iree_hal_caching_allocator_t*)base_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_caching_allocator_free_buffers(
+      allocator, iree_hal_size_class_pool_evict(&allocator->pool, 0));
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_hal_caching_allocator_query_statistics(
+    iree_hal_allocator_t* base_allocator,
+    iree_hal_caching_allocator_statistics_t* out_statistics) {
+  IREE_ASSERT_ARGUMENT(base_allocator);
+  IREE_ASSERT_ARGUMENT(out_statistics);
+  if (!iree_hal_resource_is(base_allocator,
+                            &iree_hal_caching_allocator_vtable)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "allocator is not a caching allocator");
+  }
+  iree_hal_caching_allocator_t* allocator =
+      (iree_hal_caching_allocator_t*)base_allocator;
+  iree_hal_size_class_pool_statistics_t statistics;
+  iree_hal_size_class_pool_query_statistics(&allocator->pool, &statistics);
+  out_statistics->hit_count = statistics.hit_count;
+  out_statistics->miss_count = statistics.miss_count;
+  out_statistics->eviction_count = statistics.eviction_count;
+  out_statistics->cached_buffer_count = statistics.entry_count;
+  out_statistics->cached_bytes = statistics.pooled_bytes;
+  return iree_ok_status();
+}
+
+static iree_allocator_t iree_hal_caching_allocator_host_allocator(
+    const iree_hal_allocator_t* base_allocator) {
+  iree_hal_caching_allocator_t* allocator =
+      (iree_hal_caching_allocator_t*)base_allocator;
+  return allocator->host_allocator;
+}
+
+static iree_hal_buffer_compatibility_t
+iree_hal_caching_allocator_query_buffer_compatibility(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage,
+    iree_hal_buffer_usage_t intended_usage,
+    iree_device_size_t allocation_size) {
+  iree_hal_caching_allocator_t* allocator =
+      (iree_hal_caching_allocator_t*)base_allocator;
+  return iree_hal_allocator_query_buffer_compatibility(
+      allocator->base_allocator, memory_type, allowed_usage, intended_usage,
+      allocation_size);
+}
+
+// Allocates a new caching buffer of |size_class| with storage from the base
+// allocator. If the base allocator is out of memory the cache is trimmed and
+// the allocation is retried once.
+static iree_status_t iree_hal_caching_allocator_allocate_uncached(
+    iree_hal_caching_allocator_t* allocator, uint32_t size_class,
+    iree_hal_memory_type_t memory_type, iree_hal_buffer_usage_t allowed_usage,
+    iree_hal_caching_buffer_t** out_buffer) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_device_size_t storage_size =
+      iree_hal_size_class_pool_class_size(&allocator->pool, size_class);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, storage_size);
+
+  iree_hal_buffer_t* storage_buffer = NULL;
+  iree_status_t status = iree_hal_allocator_allocate_buffer(
+      allocator->base_allocator, memory_type, allowed_usage, storage_size,
+      &storage_buffer);
+  if (iree_status_is_resource_exhausted(status)) {
+    iree_status_ignore(status);
+    status = iree_hal_caching_allocator_trim((iree_hal_allocator_t*)allocator);
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_allocator_allocate_buffer(
+          allocator->base_allocator, memory_type, allowed_usage, storage_size,
+          &storage_buffer);
+    }
+  }
+
+  iree_hal_caching_buffer_t* buffer = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_allocator_malloc(allocator->host_allocator, sizeof(*buffer),
+                                   (void**)&buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    buffer->entry.next = NULL;
+    buffer->entry.size_class = size_class;
+    buffer->entry.key =
+        iree_hal_caching_buffer_key(memory_type, allowed_usage);
+    buffer->storage_buffer = storage_buffer;
+    *out_buffer = buffer;
+  } else {
+    iree_hal_buffer_release(storage_buffer);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static iree_status_t iree_hal_caching_allocator_allocate_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage, iree_host_size_t allocation_size,
+    iree_hal_buffer_t** out_buffer) {
+  iree_hal_caching_allocator_t* allocator =
+      (iree_hal_caching_allocator_t*)base_allocator;
+
+  // Buffers that cannot be cached are allocated directly from the base
+  // allocator.
+  uint32_t size_class =
+      iree_hal_size_class_pool_select(&allocator->pool, allocation_size);
+  if (size_class >= allocator->pool.class_count) {
+    return iree_hal_allocator_allocate_buffer(allocator->base_allocator,
+                                              memory_type, allowed_usage,
+                                              allocation_size, out_buffer);
+  }
+
+  iree_hal_caching_buffer_t* buffer = NULL;
+  iree_hal_size_class_pool_entry_t* entry = iree_hal_size_class_pool_acquire(
+      &allocator->pool, size_class,
+      iree_hal_caching_buffer_key(memory_type, allowed_usage));
+  if (entry) {
+    buffer = iree_hal_caching_buffer_from_entry(entry);
+  } else {
+    IREE_RETURN_IF_ERROR(iree_hal_caching_allocator_allocate_uncached(
+        allocator, size_class, memory_type, allowed_usage, &buffer));
+  }
+
+  // (Re)initialize the buffer as a subspan of its storage. The buffer retains
+  // the allocator until it is returned to the cache.
+  iree_hal_buffer_t* storage_buffer = buffer->storage_buffer;
+  iree_hal_resource_initialize(&iree_hal_caching_buffer_vtable,
+                               &buffer->base.resource);
+  buffer->base.allocator = base_allocator;
+  iree_hal_allocator_retain(base_allocator);
+  buffer->base.allocated_buffer = storage_buffer->allocated_buffer;
+  buffer->base.allocation_size = storage_buffer->allocation_size;
+  buffer->base.byte_offset = storage_buffer->byte_offset;
+  buffer->base.byte_length = allocation_size;
+  buffer->base.memory_type = storage_buffer->memory_type;
+  buffer->base.allowed_access = storage_buffer->allowed_access;
+  buffer->base.allowed_usage = storage_buffer->allowed_usage;
+  *out_buffer = &buffer->base;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_caching_allocator_wrap_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_byte_span_t data,
+    iree_allocator_t data_allocator, iree_hal_buffer_t** out_buffer) {
+  iree_hal_caching_allocator_t* allocator =
+      (iree_hal_caching_allocator_t*)base_allocator;
+  return iree_hal_allocator_wrap_buffer(allocator->base_allocator, memory_type,
+                                        allowed_access, allowed_usage, data,
+                                        data_allocator, out_buffer);
+}
+
+static const iree_hal_allocator_vtable_t iree_hal_caching_allocator_vtable = {
+    .destroy = iree_hal_caching_allocator_destroy,
+    .host_allocator = iree_hal_caching_allocator_host_allocator,
+    .query_buffer_compatibility =
+        iree_hal_caching_allocator_query_buffer_compatibility,
+    .allocate_buffer = iree_hal_caching_allocator_allocate_buffer,
+    .wrap_buffer = iree_hal_caching_allocator_wrap_buffer,
+};
+
+//===----------------------------------------------------------------------===//
+// iree_hal_caching_buffer_t implementation
+//===----------------------------------------------------------------------===//
+
+static void iree_hal_caching_buffer_destroy(iree_hal_buffer_t* base_buffer) {
+  iree_hal_caching_buffer_t* buffer = (iree_hal_caching_buffer_t*)base_buffer;
+  iree_hal_caching_allocator_t* allocator =
+      (iree_hal_caching_allocator_t*)base_buffer->allocator;
+
+  // Subspans of the buffer reference the storage directly and may outlive the
+  // buffer. The storage can only be reused once we hold the last reference.
+  bool storage_shared =
+      iree_atomic_load_int32(&base_buffer->allocated_buffer->resource.ref_count,
+                             iree_memory_order_acquire) != 1;
+
+  iree_hal_size_class_pool_entry_t* evicted_list = NULL;
+  if (!storage_shared) {
+    evicted_list =
+        iree_hal_size_class_pool_release(&allocator->pool, &buffer->entry);
+  } else {
+    buffer->entry.next = NULL;
+    evicted_list = &buffer->entry;
+  }
+  iree_hal_caching_allocator_free_buffers(allocator, evicted_list);
+  iree_hal_allocator_release((iree_hal_allocator_t*)allocator);
+}
+
+static iree_status_t iree_hal_caching_buffer_map_range(
+    iree_hal_buffer_t* buffer, iree_hal_mapping_mode_t mapping_mode,
+    iree_hal_memory_access_t memory_access,
+    iree_device_size_t local_byte_offset, iree_device_size_t local_byte_length,
+    void** out_data_ptr) {
+  return _VTABLE_DISPATCH(buffer->allocated_buffer, map_range)(
+      buffer->allocated_buffer, mapping_mode, memory_access, local_byte_offset,
+      local_byte_length, out_data_ptr);
+}
+
+static void iree_hal_caching_buffer_unmap_range(
+    iree_hal_buffer_t* buffer, iree_device_size_t local_byte_offset,
+    iree_device_size_t local_byte_length, void* data_ptr) {
+  _VTABLE_DISPATCH(buffer->allocated_buffer, unmap_range)
+  (buffer->allocated_buffer, local_byte_offset, local_byte_length, data_ptr);
+}
+
+static iree_status_t iree_hal_caching_buffer_invalidate_range(
+    iree_hal_buffer_t* buffer, iree_device_size_t local_byte_offset,
+    iree_device_size_t local_byte_length) {
+  return _VTABLE_DISPATCH(buffer->allocated_buffer, invalidate_range)(
+      buffer->allocated_buffer, local_byte_offset, local_byte_length);
+}
+
+static iree_status_t iree_hal_caching_buffer_flush_range(
+    iree_hal_buffer_t* buffer, iree_device_size_t local_byte_offset,
+    iree_device_size_t local_byte_length) {
+  return _VTABLE_DISPATCH(buffer->allocated_buffer, flush_range)(
+      buffer->allocated_buffer, local_byte_offset, local_byte_length);
+}
+
+static const iree_hal_buffer_vtable_t iree_hal_caching_buffer_vtable = {
+    .destroy = iree_hal_caching_buffer_destroy,
+    .map_range = iree_hal_caching_buffer_map_range,
+    .unmap_range = iree_hal_caching_buffer_unmap_range,
+    .invalidate_range = iree_hal_caching_buffer_invalidate_range,
+    .flush_range = iree_hal_caching_buffer_flush_range,
+};
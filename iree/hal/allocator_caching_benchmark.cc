@@ -0,0 +1,116 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures allocator churn as seen when servicing a stream of requests: each
+// request allocates a handful of output buffers of varying sizes, touches
+// them, and releases them all when the request completes. Compares allocating
+// directly from the heap allocator with allocating through a caching allocator
+// wrapping it.
+
+#include "benchmark/benchmark.h"
+#include "iree/base/api.h"
+#include "iree/base/logging.h"
+#include "iree/hal/api.h"
+
+namespace {
+
+// Writes one byte to each page of |buffer| to fault in its storage.
+static void TouchBuffer(iree_hal_buffer_t* buffer) {
+  iree_hal_buffer_mapping_t mapping;
+  IREE_CHECK_OK(iree_hal_buffer_map_range(
+      buffer, IREE_HAL_MEMORY_ACCESS_WRITE, 0, IREE_WHOLE_BUFFER,
+      &mapping));
+  for (iree_host_size_t i = 0; i < mapping.contents.data_length; i += 4096) {
+    mapping.contents.data[i] = (uint8_t)i;
+  }
+  iree_hal_buffer_unmap_range(&mapping);
+}
+
+// Creates a heap allocator, optionally wrapped in a caching allocator with a
+// budget of |max_cached_bytes|.
+static iree_hal_allocator_t* CreateAllocator(
+    bool caching, iree_device_size_t max_cached_bytes) {
+  iree_hal_allocator_t* heap_allocator = NULL;
+  IREE_CHECK_OK(iree_hal_allocator_create_heap(
+      iree_make_cstring_view("heap"), iree_allocator_system(),
+      &heap_allocator));
+  if (!caching) return heap_allocator;
+  iree_hal_allocator_t* caching_allocator = NULL;
+  IREE_CHECK_OK(iree_hal_allocator_create_caching(
+      heap_allocator, max_cached_bytes, iree_allocator_system(),
+      &caching_allocator));
+  iree_hal_allocator_release(heap_allocator);
+  return caching_allocator;
+}
+
+// Reports the cache hit rate of |allocator| if it is a caching allocator.
+static void ReportHitRate(iree_hal_allocator_t* allocator,
+                          benchmark::State& state) {
+  iree_hal_caching_allocator_statistics_t statistics;
+  if (!iree_status_is_ok(
+          iree_hal_caching_allocator_query_statistics(allocator,
+                                                      &statistics))) {
+    return;
+  }
+  uint64_t total_count = statistics.hit_count + statistics.miss_count;
+  state.counters["hit_rate"] =
+      total_count ? (double)statistics.hit_count / total_count : 0.0;
+}
+
+// Allocates, touches, and releases the output buffers of one request per
+// iteration. Output sizes vary between requests but fall into a small number
+// of size classes. state.range(0) selects the caching allocator and
+// state.range(1) is its budget in KiB.
+static void BM_RequestOutputChurn(benchmark::State& state) {
+  const bool caching = state.range(0) != 0;
+  const iree_device_size_t max_cached_bytes =
+      (iree_device_size_t)state.range(1) * 1024;
+  static const iree_host_size_t kOutputSizes[] = {
+      16, 3 * 1024, 100 * 1024, 120 * 1024, 900 * 1024, 1000 * 1024,
+  };
+  static const int kOutputSizeCount = IREE_ARRAYSIZE(kOutputSizes);
+  static const int kOutputsPerRequest = 4;
+  iree_hal_allocator_t* allocator = CreateAllocator(caching, max_cached_bytes);
+  const iree_hal_memory_type_t memory_type =
+      IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+  int64_t bytes_processed = 0;
+  int request = 0;
+  for (auto _ : state) {
+    iree_hal_buffer_t* outputs[kOutputsPerRequest] = {NULL};
+    for (int i = 0; i < kOutputsPerRequest; ++i) {
+      iree_host_size_t allocation_size =
+          kOutputSizes[(request + i * 2) % kOutputSizeCount];
+      IREE_CHECK_OK(iree_hal_allocator_allocate_buffer(
+          allocator, memory_type, IREE_HAL_BUFFER_USAGE_ALL, allocation_size,
+          &outputs[i]));
+      TouchBuffer(outputs[i]);
+      bytes_processed += allocation_size;
+    }
+    for (int i = 0; i < kOutputsPerRequest; ++i) {
+      iree_hal_buffer_release(outputs[i]);
+    }
+    ++request;
+  }
+  ReportHitRate(allocator, state);
+  iree_hal_allocator_release(allocator);
+  state.SetBytesProcessed(bytes_processed);
+}
+BENCHMARK(BM_RequestOutputChurn)
+    ->ArgNames({"caching", "budget_kb"})
+    ->Args({0, 0})
+    ->Args({1, 1024})
+    ->Args({1, 16 * 1024})
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
@@ -0,0 +1,320 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <mutex>
+#include <unordered_map>
+
+#include "iree/base/api.h"
+#include "iree/base/logging.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+// Host allocator tracking the live allocations made through it. Used as the
+// host allocator of the base heap allocator so that tests can observe when
+// the caching allocator returns storage to it.
+class TrackingHostAllocator {
+ public:
+  iree_allocator_t allocator() { return {this, Alloc, Free}; }
+
+  iree_host_size_t live_count() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return live_.size();
+  }
+
+  iree_host_size_t live_bytes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return live_bytes_;
+  }
+
+ private:
+  static iree_status_t Alloc(void* self, iree_allocation_mode_t mode,
+                             iree_host_size_t byte_length, void** out_ptr) {
+    auto* tracker = reinterpret_cast<TrackingHostAllocator*>(self);
+    void* existing_ptr =
+        (mode & IREE_ALLOCATION_MODE_TRY_REUSE_EXISTING) ? *out_ptr : NULL;
+    IREE_RETURN_IF_ERROR(
+        iree_allocator_system_allocate(NULL, mode, byte_length, out_ptr));
+    std::lock_guard<std::mutex> lock(tracker->mutex_);
+    if (existing_ptr) tracker->Untrack(existing_ptr);
+    tracker->live_[*out_ptr] = byte_length;
+    tracker->live_bytes_ += byte_length;
+    return iree_ok_status();
+  }
+
+  static void Free(void* self, void* ptr) {
+    auto* tracker = reinterpret_cast<TrackingHostAllocator*>(self);
+    {
+      std::lock_guard<std::mutex> lock(tracker->mutex_);
+      tracker->Untrack(ptr);
+    }
+    iree_allocator_system_free(NULL, ptr);
+  }
+
+  void Untrack(void* ptr) {
+    auto it = live_.find(ptr);
+    if (it == live_.end()) return;
+    live_bytes_ -= it->second;
+    live_.erase(it);
+  }
+
+  std::mutex mutex_;
+  std::unordered_map<void*, iree_host_size_t> live_;
+  iree_host_size_t live_bytes_ = 0;
+};
+
+static const iree_hal_memory_type_t kMemoryType =
+    IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE;
+static const iree_hal_buffer_usage_t kUsage = IREE_HAL_BUFFER_USAGE_ALL;
+
+class AllocatorCachingTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+        iree_make_cstring_view("heap"), host_allocator_.allocator(),
+        &heap_allocator_));
+    baseline_count_ = host_allocator_.live_count();
+  }
+
+  void TearDown() override {
+    iree_hal_allocator_release(allocator_);
+    iree_hal_allocator_release(heap_allocator_);
+    EXPECT_EQ(0, host_allocator_.live_count());
+  }
+
+  void CreateCaching(iree_device_size_t max_cached_bytes) {
+    IREE_ASSERT_OK(iree_hal_allocator_create_caching(
+        heap_allocator_, max_cached_bytes, iree_allocator_system(),
+        &allocator_));
+  }
+
+  iree_hal_buffer_t* Allocate(iree_host_size_t size,
+                              iree_hal_memory_type_t memory_type = kMemoryType,
+                              iree_hal_buffer_usage_t usage = kUsage) {
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_CHECK_OK(iree_hal_allocator_allocate_buffer(allocator_, memory_type,
+                                                     usage, size, &buffer));
+    return buffer;
+  }
+
+  iree_hal_caching_allocator_statistics_t QueryStatistics() {
+    iree_hal_caching_allocator_statistics_t statistics;
+    IREE_CHECK_OK(
+        iree_hal_caching_allocator_query_statistics(allocator_, &statistics));
+    return statistics;
+  }
+
+  // Returns the number of storage allocations held by the base allocator.
+  iree_host_size_t live_storage_count() {
+    return host_allocator_.live_count() - baseline_count_;
+  }
+
+  TrackingHostAllocator host_allocator_;
+  iree_host_size_t baseline_count_ = 0;
+  iree_hal_allocator_t* heap_allocator_ = NULL;
+  iree_hal_allocator_t* allocator_ = NULL;
+};
+
+TEST_F(AllocatorCachingTest, ReusesSizeClass) {
+  CreateCaching(1024 * 1024);
+
+  iree_hal_buffer_t* buffer = Allocate(1000);
+  EXPECT_EQ(1000, iree_hal_buffer_byte_length(buffer));
+  EXPECT_LE(1024, iree_hal_buffer_allocation_size(buffer));
+  iree_hal_buffer_t* storage = iree_hal_buffer_allocated_buffer(buffer);
+  iree_hal_buffer_release(buffer);
+
+  // Any size in the same size class reuses the storage.
+  buffer = Allocate(600);
+  EXPECT_EQ(600, iree_hal_buffer_byte_length(buffer));
+  EXPECT_EQ(storage, iree_hal_buffer_allocated_buffer(buffer));
+  iree_hal_buffer_release(buffer);
+
+  // Other size classes do not.
+  buffer = Allocate(4000);
+  EXPECT_NE(storage, iree_hal_buffer_allocated_buffer(buffer));
+  iree_hal_buffer_release(buffer);
+
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(1, statistics.hit_count);
+  EXPECT_EQ(2, statistics.miss_count);
+}
+
+TEST_F(AllocatorCachingTest, MatchesMemoryTypeAndUsage) {
+  CreateCaching(1024 * 1024);
+
+  iree_hal_buffer_t* buffer = Allocate(1000);
+  iree_hal_buffer_t* storage = iree_hal_buffer_allocated_buffer(buffer);
+  iree_hal_buffer_release(buffer);
+
+  // The base allocator adds bits to those requested; matching must be on the
+  // requested bits and not on those of the storage.
+  buffer = Allocate(1000, IREE_HAL_MEMORY_TYPE_HOST_LOCAL, kUsage);
+  EXPECT_NE(storage, iree_hal_buffer_allocated_buffer(buffer));
+  iree_hal_buffer_release(buffer);
+  buffer = Allocate(1000, kMemoryType, IREE_HAL_BUFFER_USAGE_DISPATCH);
+  EXPECT_NE(storage, iree_hal_buffer_allocated_buffer(buffer));
+  iree_hal_buffer_release(buffer);
+
+  buffer = Allocate(1000, kMemoryType, kUsage);
+  EXPECT_EQ(storage, iree_hal_buffer_allocated_buffer(buffer));
+  EXPECT_TRUE(
+      iree_all_bits_set(iree_hal_buffer_allowed_usage(buffer), kUsage));
+  EXPECT_TRUE(iree_all_bits_set(iree_hal_buffer_memory_type(buffer),
+                                kMemoryType));
+  iree_hal_buffer_release(buffer);
+
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(1, statistics.hit_count);
+  EXPECT_EQ(3, statistics.miss_count);
+  EXPECT_EQ(3, statistics.cached_buffer_count);
+}
+
+TEST_F(AllocatorCachingTest, EvictsLargestFirst) {
+  // Room for the 4KB and 1KB size classes but not an additional 2KB.
+  CreateCaching(6 * 1024);
+
+  iree_hal_buffer_t* large = Allocate(4000);
+  iree_hal_buffer_t* small = Allocate(1000);
+  iree_hal_buffer_t* medium = Allocate(2000);
+  iree_hal_buffer_t* small_storage = iree_hal_buffer_allocated_buffer(small);
+  iree_hal_buffer_t* medium_storage = iree_hal_buffer_allocated_buffer(medium);
+  iree_hal_buffer_release(large);
+  iree_hal_buffer_release(small);
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(2, statistics.cached_buffer_count);
+  EXPECT_EQ(5 * 1024, statistics.cached_bytes);
+  EXPECT_EQ(0, statistics.eviction_count);
+
+  iree_host_size_t live_bytes = host_allocator_.live_bytes();
+  iree_hal_buffer_release(medium);
+  statistics = QueryStatistics();
+  EXPECT_EQ(2, statistics.cached_buffer_count);
+  EXPECT_EQ(3 * 1024, statistics.cached_bytes);
+  EXPECT_EQ(1, statistics.eviction_count);
+  // Only the 4KB storage (and its buffer bookkeeping) was released.
+  EXPECT_GE(live_bytes - 4 * 1024, host_allocator_.live_bytes());
+  EXPECT_LE(live_bytes - 4 * 1024 - 512, host_allocator_.live_bytes());
+
+  small = Allocate(1000);
+  medium = Allocate(2000);
+  large = Allocate(4000);
+  EXPECT_EQ(small_storage, iree_hal_buffer_allocated_buffer(small));
+  EXPECT_EQ(medium_storage, iree_hal_buffer_allocated_buffer(medium));
+  statistics = QueryStatistics();
+  EXPECT_EQ(2, statistics.hit_count);
+  EXPECT_EQ(4, statistics.miss_count);
+  iree_hal_buffer_release(small);
+  iree_hal_buffer_release(medium);
+  iree_hal_buffer_release(large);
+}
+
+TEST_F(AllocatorCachingTest, DoesNotCacheOverBudget) {
+  CreateCaching(2 * 1024);
+
+  iree_hal_buffer_t* buffer = Allocate(4000);
+  iree_host_size_t storage_count = live_storage_count();
+  EXPECT_LT(0, storage_count);
+  iree_hal_buffer_release(buffer);
+  EXPECT_EQ(0, live_storage_count());
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(0, statistics.cached_buffer_count);
+  EXPECT_EQ(0, statistics.cached_bytes);
+}
+
+TEST_F(AllocatorCachingTest, Trim) {
+  CreateCaching(1024 * 1024);
+
+  iree_hal_buffer_t* outstanding = Allocate(1000);
+  iree_host_size_t outstanding_count = live_storage_count();
+  iree_hal_buffer_release(Allocate(2000));
+  iree_hal_buffer_release(Allocate(4000));
+  EXPECT_LT(outstanding_count, live_storage_count());
+  EXPECT_EQ(2, QueryStatistics().cached_buffer_count);
+
+  IREE_ASSERT_OK(iree_hal_caching_allocator_trim(allocator_));
+  EXPECT_EQ(outstanding_count, live_storage_count());
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(0, statistics.cached_buffer_count);
+  EXPECT_EQ(0, statistics.cached_bytes);
+  EXPECT_EQ(2, statistics.eviction_count);
+
+  // Outstanding buffers are unaffected and are cached once released.
+  iree_hal_buffer_mapping_t mapping;
+  IREE_ASSERT_OK(iree_hal_buffer_map_range(outstanding,
+                                           IREE_HAL_MEMORY_ACCESS_WRITE, 0,
+                                           IREE_WHOLE_BUFFER, &mapping));
+  memset(mapping.contents.data, 0xCD, mapping.contents.data_length);
+  iree_hal_buffer_unmap_range(&mapping);
+  iree_hal_buffer_release(outstanding);
+  EXPECT_EQ(1, QueryStatistics().cached_buffer_count);
+}
+
+TEST_F(AllocatorCachingTest, TrimRequiresCachingAllocator) {
+  iree_status_t status = iree_hal_caching_allocator_trim(heap_allocator_);
+  EXPECT_TRUE(iree_status_is_invalid_argument(status));
+  iree_status_ignore(status);
+  iree_hal_caching_allocator_statistics_t statistics;
+  status =
+      iree_hal_caching_allocator_query_statistics(heap_allocator_, &statistics);
+  EXPECT_TRUE(iree_status_is_invalid_argument(status));
+  iree_status_ignore(status);
+}
+
+TEST_F(AllocatorCachingTest, LiveSubspanPreventsReuse) {
+  CreateCaching(1024 * 1024);
+
+  iree_hal_buffer_t* buffer = Allocate(1000);
+  iree_hal_buffer_t* storage = iree_hal_buffer_allocated_buffer(buffer);
+  iree_hal_buffer_t* subspan = NULL;
+  IREE_ASSERT_OK(iree_hal_buffer_subspan(buffer, 16, 64, &subspan));
+  iree_hal_buffer_release(buffer);
+
+  // The storage is still referenced by the subspan and must not be handed out
+  // again.
+  EXPECT_EQ(0, QueryStatistics().cached_buffer_count);
+  iree_hal_buffer_t* other = Allocate(1000);
+  EXPECT_NE(storage, iree_hal_buffer_allocated_buffer(other));
+  iree_hal_buffer_release(other);
+
+  // The subspan remains usable and the storage is returned to the base
+  // allocator once it is released.
+  iree_hal_buffer_mapping_t mapping;
+  IREE_ASSERT_OK(iree_hal_buffer_map_range(
+      subspan, IREE_HAL_MEMORY_ACCESS_WRITE, 0, IREE_WHOLE_BUFFER, &mapping));
+  EXPECT_EQ(64, mapping.contents.data_length);
+  memset(mapping.contents.data, 0xCD, mapping.contents.data_length);
+  iree_hal_buffer_unmap_range(&mapping);
+  iree_host_size_t storage_count = live_storage_count();
+  iree_hal_buffer_release(subspan);
+  EXPECT_GT(storage_count, live_storage_count());
+  EXPECT_EQ(1, QueryStatistics().cached_buffer_count);
+}
+
+TEST_F(AllocatorCachingTest, ZeroLengthBypassesCache) {
+  CreateCaching(1024 * 1024);
+
+  iree_hal_buffer_t* buffer = Allocate(0);
+  EXPECT_EQ(0, iree_hal_buffer_byte_length(buffer));
+  iree_hal_buffer_release(buffer);
+
+  auto statistics = QueryStatistics();
+  EXPECT_EQ(0, statistics.hit_count);
+  EXPECT_EQ(0, statistics.miss_count);
+  EXPECT_EQ(0, statistics.cached_buffer_count);
+}
+
+}  // namespace
@@ -12,14 +12,42 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "iree/base/alignment.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/allocator.h"
 #include "iree/hal/detail.h"
+#include "iree/hal/size_class_pool.h"
+
+// Transient buffer storage is pooled in size classes covering [2^MIN, 2^MAX]
+// bytes of buffer contents. Each power of two is split into 2^SUBCLASS_BITS
+// size classes so that less than 20% of a block is lost to rounding. Requests
+// larger than the maximum size class or the pool budget are serviced directly
+// from the host allocator.
+#define IREE_HAL_HEAP_TRANSIENT_MIN_SIZE_CLASS 12
+#define IREE_HAL_HEAP_TRANSIENT_MAX_SIZE_CLASS 30
+#define IREE_HAL_HEAP_TRANSIENT_SUBCLASS_BITS 2
+
+// Maximum total size of transient storage retained for reuse. Blocks released
+// while the pool is full evict the largest pooled blocks first.
+#if !defined(IREE_HAL_HEAP_TRANSIENT_MAX_POOLED_BYTES)
+#define IREE_HAL_HEAP_TRANSIENT_MAX_POOLED_BYTES (64 * 1024 * 1024)
+#endif  // !IREE_HAL_HEAP_TRANSIENT_MAX_POOLED_BYTES
+
+// Each pooled transient storage block is prefixed with its pool entry. The
+// byte offset of the buffer contents from the start of a block.
+#define IREE_HAL_HEAP_TRANSIENT_BLOCK_HEADER_SIZE \
+  (iree_align(sizeof(iree_hal_size_class_pool_entry_t), iree_max_align_t))
 
 typedef struct iree_hal_heap_allocator_s {
   iree_hal_resource_t resource;
   iree_allocator_t host_allocator;
   iree_string_view_t identifier;
+
+  // Free transient storage blocks available for reuse. The pool grows to the
+  // peak transient working set (up to its budget) and blocks are returned to
+  // the host allocator when evicted, trimmed, or when the allocator is
+  // destroyed.
+  iree_hal_size_class_pool_t transient_pool;
 } iree_hal_heap_allocator_t;
 
 static const iree_hal_allocator_vtable_t iree_hal_heap_allocator_vtable;
@@ -38,6 +66,11 @@ IREE_API_EXPORT iree_status_t IREE_API_CALL iree_hal_allocator_create_heap(
     iree_hal_resource_initialize(&iree_hal_heap_allocator_vtable,
                                  &allocator->resource);
     allocator->host_allocator = host_allocator;
+    iree_hal_size_class_pool_initialize(
+        IREE_HAL_HEAP_TRANSIENT_MIN_SIZE_CLASS,
+        IREE_HAL_HEAP_TRANSIENT_MAX_SIZE_CLASS,
+        IREE_HAL_HEAP_TRANSIENT_SUBCLASS_BITS,
+        IREE_HAL_HEAP_TRANSIENT_MAX_POOLED_BYTES, &allocator->transient_pool);
     iree_string_view_append_to_buffer(
         identifier, &allocator->identifier,
         (char*)allocator + total_size - identifier.size);
@@ -48,6 +81,17 @@ IREE_API_EXPORT iree_status_t IREE_API_CALL iree_hal_allocator_create_heap(
   return iree_ok_status();
 }
 
+// Frees each transient storage block in |entry_list| to the host allocator.
+static void iree_hal_heap_allocator_free_transient_blocks(
+    iree_hal_heap_allocator_t* allocator,
+    iree_hal_size_class_pool_entry_t* entry_list) {
+  while (entry_list) {
+    iree_hal_size_class_pool_entry_t* next_entry = entry_list->next;
+    iree_allocator_free(allocator->host_allocator, entry_list);
+    entry_list = next_entry;
+  }
+}
+
 static void iree_hal_heap_allocator_destroy(
     iree_hal_allocator_t* base_allocator) {
   iree_hal_heap_allocator_t* allocator =
@@ -55,11 +99,33 @@ static void iree_hal_heap_allocator_destroy(
   iree_allocator_t host_allocator = allocator->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // All transient blocks have been returned to the pool as outstanding
+  // transient buffers retain the allocator.
+  iree_hal_heap_allocator_free_transient_blocks(
+      allocator, iree_hal_size_class_pool_evict(&allocator->transient_pool, 0));
+  iree_hal_size_class_pool_deinitialize(&allocator->transient_pool);
+
   iree_allocator_free(host_allocator, allocator);
 
   IREE_TRACE_ZONE_END(z0);
 }
 
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_hal_heap_allocator_trim(iree_hal_allocator_t* base_allocator) {
+  IREE_ASSERT_ARGUMENT(base_allocator);
+  if (!iree_hal_resource_is(base_allocator, &iree_hal_heap_allocator_vtable)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "allocator is not a heap allocator");
+  }
+  iree_hal_heap_allocator_t* allocator =
+      (iree_hal_heap_allocator_t*)base_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_heap_allocator_free_transient_blocks(
+      allocator, iree_hal_size_class_pool_evict(&allocator->transient_pool, 0));
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
 static iree_allocator_t iree_hal_heap_allocator_host_allocator(
     const iree_hal_allocator_t* base_allocator) {
   iree_hal_heap_allocator_t* allocator =
@@ -116,6 +182,66 @@ static iree_status_t iree_hal_heap_allocator_make_compatible(
   return iree_ok_status();
 }
 
+// Returns the storage of a transient buffer to the pool it was acquired from.
+// Used as the free function of the data allocator of transient buffers.
+static void IREE_API_PTR iree_hal_heap_transient_block_free(void* self,
+                                                            void* ptr) {
+  iree_hal_heap_allocator_t* allocator = (iree_hal_heap_allocator_t*)self;
+  uint8_t* block_base =
+      (uint8_t*)ptr - IREE_HAL_HEAP_TRANSIENT_BLOCK_HEADER_SIZE;
+  iree_hal_size_class_pool_entry_t* entry =
+      (iree_hal_size_class_pool_entry_t*)block_base;
+  iree_hal_heap_allocator_free_transient_blocks(
+      allocator,
+      iree_hal_size_class_pool_release(&allocator->transient_pool, entry));
+  iree_hal_allocator_release((iree_hal_allocator_t*)allocator);
+}
+
+// Acquires storage for a transient buffer from the pool, allocating a new
+// block from the host allocator if none are available. If the host allocator
+// is out of memory the pool is trimmed and the allocation is retried once.
+// Unlike non-transient allocations the contents are undefined as they may have
+// been used by a prior transient buffer.
+//
+// The storage retains the allocator until it is returned to the pool by
+// freeing it with the returned |out_data_allocator|.
+static iree_status_t iree_hal_heap_allocator_acquire_transient(
+    iree_hal_heap_allocator_t* allocator, uint32_t size_class,
+    void** out_data_ptr, iree_allocator_t* out_data_allocator) {
+  iree_hal_size_class_pool_entry_t* entry = iree_hal_size_class_pool_acquire(
+      &allocator->transient_pool, size_class, /*key=*/0);
+  if (!entry) {
+    IREE_TRACE_ZONE_BEGIN(z0);
+    iree_host_size_t block_size =
+        IREE_HAL_HEAP_TRANSIENT_BLOCK_HEADER_SIZE +
+        (iree_host_size_t)iree_hal_size_class_pool_class_size(
+            &allocator->transient_pool, size_class);
+    IREE_TRACE_ZONE_APPEND_VALUE(z0, block_size);
+    iree_status_t status = iree_allocator_malloc(
+        allocator->host_allocator, block_size, (void**)&entry);
+    if (iree_status_is_resource_exhausted(status)) {
+      iree_status_ignore(status);
+      iree_hal_heap_allocator_free_transient_blocks(
+          allocator,
+          iree_hal_size_class_pool_evict(&allocator->transient_pool, 0));
+      status = iree_allocator_malloc(allocator->host_allocator, block_size,
+                                     (void**)&entry);
+    }
+    IREE_TRACE_ZONE_END(z0);
+    IREE_RETURN_IF_ERROR(status);
+    entry->size_class = size_class;
+    entry->key = 0;
+  }
+  entry->next = NULL;
+
+  iree_hal_allocator_retain((iree_hal_allocator_t*)allocator);
+  *out_data_ptr = (uint8_t*)entry + IREE_HAL_HEAP_TRANSIENT_BLOCK_HEADER_SIZE;
+  out_data_allocator->self = allocator;
+  out_data_allocator->alloc = NULL;
+  out_data_allocator->free = iree_hal_heap_transient_block_free;
+  return iree_ok_status();
+}
+
 static iree_status_t iree_hal_heap_allocator_allocate_buffer(
     iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
     iree_hal_buffer_usage_t allowed_usage, iree_host_size_t allocation_size,
@@ -128,6 +254,28 @@ static iree_status_t iree_hal_heap_allocator_allocate_buffer(
   IREE_RETURN_IF_ERROR(iree_hal_heap_allocator_make_compatible(
       &memory_type, &allowed_access, &allowed_usage));
 
+  // Transient buffers are expected to be allocated and released at a high
+  // frequency (such as once per invocation) and are serviced from the pool to
+  // avoid the cost of allocating, zeroing, and faulting in fresh memory.
+  uint32_t size_class = allocator->transient_pool.class_count;
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_TRANSIENT)) {
+    size_class = iree_hal_size_class_pool_select(&allocator->transient_pool,
+                                                 allocation_size);
+  }
+  if (size_class < allocator->transient_pool.class_count) {
+    iree_byte_span_t data = iree_make_byte_span(NULL, allocation_size);
+    iree_allocator_t data_allocator;
+    IREE_RETURN_IF_ERROR(iree_hal_heap_allocator_acquire_transient(
+        allocator, size_class, (void**)&data.data, &data_allocator));
+    iree_status_t status = iree_hal_heap_buffer_wrap(
+        base_allocator, memory_type, allowed_access, allowed_usage,
+        allocation_size, data, data_allocator, out_buffer);
+    if (!iree_status_is_ok(status)) {
+      iree_allocator_free(data_allocator, data.data);
+    }
+    return status;
+  }
+
   iree_byte_span_t data = iree_make_byte_span(NULL, allocation_size);
   if (allocation_size > 0) {
     // Zero-length buffers are valid but we don't want to try to malloc them.
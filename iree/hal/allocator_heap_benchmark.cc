@@ -0,0 +1,112 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the latency of the per-invocation allocation pattern of transient
+// buffers: allocate a buffer, touch each page of it as a dispatch would, and
+// release it. Transient buffers are recycled by the heap allocator while
+// non-transient buffers are freshly allocated (and zeroed) each time.
+
+#include "benchmark/benchmark.h"
+#include "iree/base/api.h"
+#include "iree/base/logging.h"
+#include "iree/hal/api.h"
+
+namespace {
+
+// Writes one byte to each page of |buffer| to fault in its storage.
+static void TouchBuffer(iree_hal_buffer_t* buffer) {
+  iree_hal_buffer_mapping_t mapping;
+  IREE_CHECK_OK(iree_hal_buffer_map_range(
+      buffer, IREE_HAL_MEMORY_ACCESS_WRITE, 0, IREE_WHOLE_BUFFER,
+      &mapping));
+  for (iree_host_size_t i = 0; i < mapping.contents.data_length; i += 4096) {
+    mapping.contents.data[i] = (uint8_t)i;
+  }
+  iree_hal_buffer_unmap_range(&mapping);
+}
+
+static iree_hal_memory_type_t GetMemoryType(bool transient) {
+  iree_hal_memory_type_t memory_type =
+      IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+  if (transient) memory_type |= IREE_HAL_MEMORY_TYPE_TRANSIENT;
+  return memory_type;
+}
+
+// Allocates, touches, and releases a single buffer of state.range(0) bytes.
+static void BM_AllocateTouchRelease(benchmark::State& state) {
+  const iree_host_size_t allocation_size = (iree_host_size_t)state.range(0);
+  const iree_hal_memory_type_t memory_type = GetMemoryType(state.range(1));
+  iree_hal_allocator_t* allocator = NULL;
+  IREE_CHECK_OK(iree_hal_allocator_create_heap(
+      iree_make_cstring_view("heap"), iree_allocator_system(), &allocator));
+  for (auto _ : state) {
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_CHECK_OK(iree_hal_allocator_allocate_buffer(
+        allocator, memory_type, IREE_HAL_BUFFER_USAGE_ALL, allocation_size,
+        &buffer));
+    TouchBuffer(buffer);
+    iree_hal_buffer_release(buffer);
+  }
+  iree_hal_allocator_release(allocator);
+  state.SetBytesProcessed(state.iterations() * allocation_size);
+}
+BENCHMARK(BM_AllocateTouchRelease)
+    ->ArgNames({"size", "transient"})
+    ->Args({4 * 1024, 0})
+    ->Args({4 * 1024, 1})
+    ->Args({256 * 1024, 0})
+    ->Args({256 * 1024, 1})
+    ->Args({4 * 1024 * 1024, 0})
+    ->Args({4 * 1024 * 1024, 1})
+    ->Unit(benchmark::kMicrosecond);
+
+// Models sustained load with several transient buffers of varying sizes live
+// at once as when multiple invocations are in flight. The set of live buffers
+// is rotated each iteration such that every allocation size is reused.
+static void BM_SustainedRotation(benchmark::State& state) {
+  const iree_hal_memory_type_t memory_type = GetMemoryType(state.range(0));
+  static const iree_host_size_t kAllocationSizes[] = {
+      64 * 1024, 200 * 1024, 1024 * 1024, 3 * 1024 * 1024,
+  };
+  static const int kSizeCount = IREE_ARRAYSIZE(kAllocationSizes);
+  iree_hal_allocator_t* allocator = NULL;
+  IREE_CHECK_OK(iree_hal_allocator_create_heap(
+      iree_make_cstring_view("heap"), iree_allocator_system(), &allocator));
+  iree_hal_buffer_t* live_buffers[kSizeCount] = {NULL};
+  int64_t bytes_processed = 0;
+  int iteration = 0;
+  for (auto _ : state) {
+    int slot = iteration++ % kSizeCount;
+    iree_hal_buffer_release(live_buffers[slot]);
+    iree_host_size_t allocation_size =
+        kAllocationSizes[(slot + iteration) % kSizeCount];
+    IREE_CHECK_OK(iree_hal_allocator_allocate_buffer(
+        allocator, memory_type, IREE_HAL_BUFFER_USAGE_ALL, allocation_size,
+        &live_buffers[slot]));
+    TouchBuffer(live_buffers[slot]);
+    bytes_processed += allocation_size;
+  }
+  for (int i = 0; i < kSizeCount; ++i) {
+    iree_hal_buffer_release(live_buffers[i]);
+  }
+  iree_hal_allocator_release(allocator);
+  state.SetBytesProcessed(bytes_processed);
+}
+BENCHMARK(BM_SustainedRotation)
+    ->ArgNames({"transient"})
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
@@ -238,6 +238,136 @@ TEST_P(CommandBufferTest, CopySubBuffer) {
   iree_hal_buffer_release(host_buffer);
 }
 
+TEST_P(CommandBufferTest, SubmitReusableMultipleTimes) {
+  // No ONE_SHOT bit: the command buffer may be submitted multiple times.
+  iree_hal_command_buffer_t* command_buffer;
+  IREE_ASSERT_OK(iree_hal_command_buffer_create(
+      device_, /*mode=*/0, IREE_HAL_COMMAND_CATEGORY_TRANSFER,
+      &command_buffer));
+
+  iree_hal_buffer_t* host_buffer;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      device_allocator_,
+      IREE_HAL_MEMORY_TYPE_HOST_VISIBLE | IREE_HAL_MEMORY_TYPE_HOST_CACHED |
+          IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+      IREE_HAL_BUFFER_USAGE_ALL, kBufferSize, &host_buffer));
+  iree_hal_buffer_t* device_buffer;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      device_allocator_,
+      IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+      IREE_HAL_BUFFER_USAGE_ALL, kBufferSize, &device_buffer));
+
+  // Copy the host buffer to the first half of the device buffer in two pieces
+  // and then the first half to the second half after a barrier.
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer, /*source_buffer=*/host_buffer, /*source_offset=*/0,
+      /*target_buffer=*/device_buffer, /*target_offset=*/0,
+      /*length=*/kBufferSize / 4));
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer, /*source_buffer=*/host_buffer,
+      /*source_offset=*/kBufferSize / 4, /*target_buffer=*/device_buffer,
+      /*target_offset=*/kBufferSize / 4, /*length=*/kBufferSize / 4));
+  IREE_ASSERT_OK(iree_hal_command_buffer_execution_barrier(
+      command_buffer, IREE_HAL_EXECUTION_STAGE_TRANSFER,
+      IREE_HAL_EXECUTION_STAGE_TRANSFER, IREE_HAL_EXECUTION_BARRIER_FLAG_NONE,
+      /*memory_barrier_count=*/0, /*memory_barriers=*/NULL,
+      /*buffer_barrier_count=*/0, /*buffer_barriers=*/NULL));
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer, /*source_buffer=*/device_buffer, /*source_offset=*/0,
+      /*target_buffer=*/device_buffer, /*target_offset=*/kBufferSize / 2,
+      /*length=*/kBufferSize / 2));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+
+  // Each submission must observe the host buffer contents at the time it runs.
+  for (uint8_t i8_val = 1; i8_val <= 3; ++i8_val) {
+    IREE_ASSERT_OK(iree_hal_buffer_fill(host_buffer, /*byte_offset=*/0,
+                                        /*byte_length=*/kBufferSize, &i8_val,
+                                        /*pattern_length=*/sizeof(i8_val)));
+    IREE_ASSERT_OK(SubmitCommandBufferAndWait(
+        IREE_HAL_COMMAND_CATEGORY_TRANSFER, command_buffer));
+
+    std::vector<uint8_t> reference_buffer(kBufferSize, i8_val);
+    std::vector<uint8_t> actual_data(kBufferSize);
+    IREE_ASSERT_OK(iree_hal_buffer_read_data(
+        device_buffer, /*source_offset=*/0,
+        /*target_buffer=*/actual_data.data(), /*data_length=*/kBufferSize));
+    EXPECT_THAT(actual_data, ContainerEq(reference_buffer));
+  }
+
+  // Must release the command buffer before resources used by it.
+  iree_hal_command_buffer_release(command_buffer);
+  iree_hal_buffer_release(device_buffer);
+  iree_hal_buffer_release(host_buffer);
+}
+
+TEST_P(CommandBufferTest, BarriersOrderOverlappingCommands) {
+  iree_hal_command_buffer_t* command_buffer;
+  IREE_ASSERT_OK(iree_hal_command_buffer_create(
+      device_, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT,
+      IREE_HAL_COMMAND_CATEGORY_TRANSFER, &command_buffer));
+
+  iree_hal_buffer_t* device_buffer;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      device_allocator_,
+      IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+      IREE_HAL_BUFFER_USAGE_ALL, kBufferSize, &device_buffer));
+  const iree_device_size_t kQuarterSize = kBufferSize / 4;
+  auto execution_barrier = [&]() {
+    return iree_hal_command_buffer_execution_barrier(
+        command_buffer, IREE_HAL_EXECUTION_STAGE_TRANSFER,
+        IREE_HAL_EXECUTION_STAGE_TRANSFER, IREE_HAL_EXECUTION_BARRIER_FLAG_NONE,
+        /*memory_barrier_count=*/0, /*memory_barriers=*/NULL,
+        /*buffer_barrier_count=*/0, /*buffer_barriers=*/NULL);
+  };
+
+  // Each barrier separates commands that read or write the same quarters of
+  // the buffer (read-after-write, write-after-read, and write-after-write)
+  // from commands that touch unrelated quarters.
+  uint8_t values[4] = {1, 2, 3, 4};
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer, device_buffer, /*target_offset=*/0 * kQuarterSize,
+      /*length=*/kQuarterSize, &values[0], /*pattern_length=*/1));
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer, device_buffer, /*target_offset=*/2 * kQuarterSize,
+      /*length=*/kQuarterSize, &values[1], /*pattern_length=*/1));
+  IREE_ASSERT_OK(execution_barrier());
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer, /*source_buffer=*/device_buffer,
+      /*source_offset=*/0 * kQuarterSize, /*target_buffer=*/device_buffer,
+      /*target_offset=*/1 * kQuarterSize, /*length=*/kQuarterSize));
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer, device_buffer, /*target_offset=*/3 * kQuarterSize,
+      /*length=*/kQuarterSize, &values[2], /*pattern_length=*/1));
+  IREE_ASSERT_OK(execution_barrier());
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer, device_buffer, /*target_offset=*/0 * kQuarterSize,
+      /*length=*/kQuarterSize, &values[3], /*pattern_length=*/1));
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer, /*source_buffer=*/device_buffer,
+      /*source_offset=*/1 * kQuarterSize, /*target_buffer=*/device_buffer,
+      /*target_offset=*/3 * kQuarterSize, /*length=*/kQuarterSize));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+  IREE_ASSERT_OK(SubmitCommandBufferAndWait(IREE_HAL_COMMAND_CATEGORY_TRANSFER,
+                                            command_buffer));
+
+  std::vector<uint8_t> reference_buffer(kBufferSize);
+  std::memset(&reference_buffer[0 * kQuarterSize], 4, kQuarterSize);
+  std::memset(&reference_buffer[1 * kQuarterSize], 1, kQuarterSize);
+  std::memset(&reference_buffer[2 * kQuarterSize], 2, kQuarterSize);
+  std::memset(&reference_buffer[3 * kQuarterSize], 1, kQuarterSize);
+  std::vector<uint8_t> actual_data(kBufferSize);
+  IREE_ASSERT_OK(iree_hal_buffer_read_data(
+      device_buffer, /*source_offset=*/0,
+      /*target_buffer=*/actual_data.data(), /*data_length=*/kBufferSize));
+  EXPECT_THAT(actual_data, ContainerEq(reference_buffer));
+
+  // Must release the command buffer before resources used by it.
+  iree_hal_command_buffer_release(command_buffer);
+  iree_hal_buffer_release(device_buffer);
+}
+
 INSTANTIATE_TEST_SUITE_P(
     AllDrivers, CommandBufferTest,
     ::testing::ValuesIn(testing::EnumerateAvailableDrivers()),
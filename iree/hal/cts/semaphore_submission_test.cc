@@ -200,6 +200,63 @@ TEST_P(SemaphoreSubmissionTest, SubmitWithMultipleSemaphores) {
   iree_hal_semaphore_release(signal_semaphore_2);
 }
 
+// Submits a reusable command buffer multiple times while the first submission
+// is still waiting on a semaphore. Later submissions must queue up behind the
+// pending one instead of racing ahead of it.
+TEST_P(SemaphoreSubmissionTest, SubmitReusableWhileWaitPending) {
+  iree_hal_command_buffer_t* command_buffer;
+  IREE_ASSERT_OK(iree_hal_command_buffer_create(
+      device_, /*mode=*/0, IREE_HAL_COMMAND_CATEGORY_DISPATCH,
+      &command_buffer));
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+
+  iree_hal_semaphore_t* wait_semaphore;
+  IREE_ASSERT_OK(iree_hal_semaphore_create(device_, 0ull, &wait_semaphore));
+  iree_hal_semaphore_t* signal_semaphores[3];
+  for (size_t i = 0; i < IREE_ARRAYSIZE(signal_semaphores); ++i) {
+    IREE_ASSERT_OK(
+        iree_hal_semaphore_create(device_, 0ull, &signal_semaphores[i]));
+  }
+  uint64_t payload_value = 1ull;
+
+  for (size_t i = 0; i < IREE_ARRAYSIZE(signal_semaphores); ++i) {
+    // Only the first submission waits; the rest are ordered behind it.
+    iree_hal_submission_batch_t submission_batch;
+    submission_batch.wait_semaphores.count = i == 0 ? 1 : 0;
+    submission_batch.wait_semaphores.semaphores = &wait_semaphore;
+    submission_batch.wait_semaphores.payload_values = &payload_value;
+    submission_batch.command_buffer_count = 1;
+    submission_batch.command_buffers = &command_buffer;
+    submission_batch.signal_semaphores.count = 1;
+    submission_batch.signal_semaphores.semaphores = &signal_semaphores[i];
+    submission_batch.signal_semaphores.payload_values = &payload_value;
+    IREE_ASSERT_OK(iree_hal_device_queue_submit(
+        device_, IREE_HAL_COMMAND_CATEGORY_DISPATCH,
+        /*queue_affinity=*/0,
+        /*batch_count=*/1, &submission_batch));
+  }
+
+  // Nothing can complete until the first submission's wait is satisfied.
+  for (size_t i = 0; i < IREE_ARRAYSIZE(signal_semaphores); ++i) {
+    uint64_t value;
+    IREE_ASSERT_OK(iree_hal_semaphore_query(signal_semaphores[i], &value));
+    EXPECT_EQ(0ull, value);
+  }
+
+  IREE_ASSERT_OK(iree_hal_semaphore_signal(wait_semaphore, 1ull));
+  for (size_t i = 0; i < IREE_ARRAYSIZE(signal_semaphores); ++i) {
+    IREE_ASSERT_OK(iree_hal_semaphore_wait_with_deadline(
+        signal_semaphores[i], 1ull, IREE_TIME_INFINITE_FUTURE));
+  }
+
+  iree_hal_command_buffer_release(command_buffer);
+  iree_hal_semaphore_release(wait_semaphore);
+  for (size_t i = 0; i < IREE_ARRAYSIZE(signal_semaphores); ++i) {
+    iree_hal_semaphore_release(signal_semaphores[i]);
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(
     AllDrivers, SemaphoreSubmissionTest,
     ::testing::ValuesIn(testing::EnumerateAvailableDrivers()),
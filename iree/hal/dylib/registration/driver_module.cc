@@ -18,6 +18,7 @@
 
 #include "absl/flags/flag.h"
 #include "iree/hal/local/loaders/legacy_library_loader.h"
+#include "iree/hal/local/loaders/system_library_loader.h"
 #include "iree/hal/local/task_driver.h"
 
 // TODO(#4298): remove this driver registration and wrapper.
@@ -31,6 +32,10 @@ ABSL_FLAG(int, dylib_worker_count, 0,
           "Specified number of workers to use or 0 for automatic.");
 ABSL_FLAG(int, dylib_max_worker_count, 16,
           "Maximum number of task system workers to use.");
+ABSL_FLAG(int, dylib_worker_spin_us,
+          IREE_TASK_EXECUTOR_DEFAULT_WORKER_SPIN_NS / 1000,
+          "Microseconds task system workers spin looking for new work before "
+          "parking or 0 to park immediately.");
 
 #define IREE_HAL_DYLIB_DRIVER_ID 0x58444C4Cu  // XDLL
 
@@ -77,12 +82,18 @@ static iree_status_t iree_hal_dylib_driver_factory_try_create(
   iree_hal_executable_loader_t* dylib_loader = NULL;
   iree_status_t status =
       iree_hal_legacy_library_loader_create(allocator, &dylib_loader);
-  iree_hal_executable_loader_t* loaders[1] = {dylib_loader};
+  iree_hal_executable_loader_t* system_loader = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_system_library_loader_create(allocator, &system_loader);
+  }
+  iree_hal_executable_loader_t* loaders[2] = {dylib_loader, system_loader};
 
   iree_task_executor_t* executor = NULL;
   if (iree_status_is_ok(status)) {
-    status = iree_task_executor_create(IREE_TASK_SCHEDULING_MODE_RESERVED,
-                                       &topology, allocator, &executor);
+    status = iree_task_executor_create(
+        IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+        (iree_duration_t)absl::GetFlag(FLAGS_dylib_worker_spin_us) * 1000,
+        allocator, &executor);
   }
 
   if (iree_status_is_ok(status)) {
@@ -93,6 +104,7 @@ static iree_status_t iree_hal_dylib_driver_factory_try_create(
 
   iree_task_executor_release(executor);
   iree_task_topology_deinitialize(&topology);
+  iree_hal_executable_loader_release(system_loader);
   iree_hal_executable_loader_release(dylib_loader);
   return status;
 }
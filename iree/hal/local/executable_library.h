@@ -33,13 +33,19 @@ enum iree_hal_executable_library_version_e {
   // iree_hal_executable_library_v0_t is used as the API communication
   // structure.
   IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0 = 0u,
+
+  // iree_hal_executable_library_v1_t is used as the API communication
+  // structure. Entry points declare the worker-local memory they require and
+  // receive it as an additional argument along with a per-tile
+  // iree_hal_executable_dispatch_state_v1_t identifying the worker and CPU.
+  IREE_HAL_EXECUTABLE_LIBRARY_VERSION_1 = 1u,
 };
 typedef uint32_t iree_hal_executable_library_version_t;
 
 // The latest version of the library API; can be used to populate the
 // iree_hal_executable_library_header_t::version when building libraries.
 #define IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION \
-  IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0
+  IREE_HAL_EXECUTABLE_LIBRARY_VERSION_1
 
 // A header present at the top of all versions of the library API used by the
 // runtime to ensure version compatibility.
@@ -56,7 +62,11 @@ typedef struct {
 // The provided |max_version| is the maximum version the caller supports;
 // callees must return NULL if their lowest available version is greater
 // than the max version supported by the caller.
-typedef const iree_hal_executable_library_header_t* (
+//
+// Returns a pointer to the |header| field leading the versioned library
+// structure (such as iree_hal_executable_library_v1_t). Callers check the
+// header version and then cast the returned pointer to the matching structure.
+typedef const iree_hal_executable_library_header_t* const* (
     *iree_hal_executable_library_query_fn_t)(
     iree_hal_executable_library_version_t max_version);
 
@@ -144,4 +154,104 @@ typedef struct {
   const char** entry_point_tags;
 } iree_hal_executable_library_v0_t;
 
+//===----------------------------------------------------------------------===//
+// IREE_HAL_EXECUTABLE_LIBRARY_VERSION_1
+//===----------------------------------------------------------------------===//
+
+// Bitfield of ISA extensions available on the CPU executing a dispatch.
+// Bits are only defined for the architecture the executable was compiled for
+// and are never set for other architectures. Executables can use these to
+// select between multiple versions of an entry point at runtime.
+enum iree_hal_executable_cpu_feature_e {
+  IREE_HAL_EXECUTABLE_CPU_FEATURE_NONE = 0u,
+
+  // x86/x86-64:
+  IREE_HAL_EXECUTABLE_CPU_FEATURE_X86_SSE3 = 1u << 0,
+  IREE_HAL_EXECUTABLE_CPU_FEATURE_X86_SSSE3 = 1u << 1,
+  IREE_HAL_EXECUTABLE_CPU_FEATURE_X86_SSE4_1 = 1u << 2,
+  IREE_HAL_EXECUTABLE_CPU_FEATURE_X86_SSE4_2 = 1u << 3,
+  IREE_HAL_EXECUTABLE_CPU_FEATURE_X86_AVX = 1u << 4,
+  IREE_HAL_EXECUTABLE_CPU_FEATURE_X86_FMA3 = 1u << 5,
+  IREE_HAL_EXECUTABLE_CPU_FEATURE_X86_AVX2 = 1u << 6,
+  IREE_HAL_EXECUTABLE_CPU_FEATURE_X86_AVX512F = 1u << 7,
+  IREE_HAL_EXECUTABLE_CPU_FEATURE_X86_AVX512DQ = 1u << 8,
+  IREE_HAL_EXECUTABLE_CPU_FEATURE_X86_AVX512BW = 1u << 9,
+  IREE_HAL_EXECUTABLE_CPU_FEATURE_X86_AVX512VL = 1u << 10,
+  IREE_HAL_EXECUTABLE_CPU_FEATURE_X86_AVX512VNNI = 1u << 11,
+
+  // ARM/AArch64:
+  IREE_HAL_EXECUTABLE_CPU_FEATURE_ARM_NEON = 1u << 16,
+  IREE_HAL_EXECUTABLE_CPU_FEATURE_ARM_NEON_FP16 = 1u << 17,
+  IREE_HAL_EXECUTABLE_CPU_FEATURE_ARM_NEON_DOTPROD = 1u << 18,
+};
+typedef uint64_t iree_hal_executable_cpu_features_t;
+
+// Read-only state passed to each tile in a dispatch.
+// Unlike iree_hal_executable_dispatch_state_v0_t the state may differ between
+// tiles as it describes the worker executing the tile.
+typedef struct {
+  // Index of the worker executing the tile in [0, worker_count). No two tiles
+  // with the same worker_id execute concurrently and per-worker storage (such
+  // as partial accumulators) can be indexed by it without synchronization.
+  uint32_t worker_id;
+  // Total number of workers that may execute tiles of the dispatch.
+  uint32_t worker_count;
+  // ISA extensions available on the executing CPU.
+  iree_hal_executable_cpu_features_t cpu_features;
+} iree_hal_executable_dispatch_state_v1_t;
+
+// Function signature of exported executable entry points.
+// Identical to iree_hal_executable_dispatch_v0_t with the per-tile |state|
+// described above and the addition of
+// |local_memory|: scratch memory private to the tile of at least the size
+// declared for the entry point in
+// iree_hal_executable_library_v1_t::entry_point_local_memory_sizes. Useful for
+// packing buffers and other tile-local temporaries that would otherwise need
+// heap allocations or large stack frames.
+//
+// The memory is aligned to at least the largest scalar alignment of the
+// platform. Its contents are undefined on entry and not preserved across tiles
+// as it is reused by all tiles executed on the same thread. It is NULL if the
+// entry point declared that it requires no local memory.
+typedef void (*iree_hal_executable_dispatch_v1_t)(
+    const iree_hal_executable_dispatch_state_v1_t* state,
+    const iree_hal_vec3_t* workgroup_id, const iree_hal_vec3_t* workgroup_size,
+    const iree_hal_vec3_t* workgroup_count,
+    const iree_hal_executable_push_constants_ptr_t push_constants,
+    const iree_hal_executable_binding_ptr_t* bindings, void* local_memory);
+
+// Structure used for v1 library interfaces.
+// Identical to iree_hal_executable_library_v0_t (with v1 entry points) plus the
+// trailing local memory declarations.
+typedef struct {
+  // Version/metadata header. Will have a version of
+  // IREE_HAL_EXECUTABLE_LIBRARY_VERSION_1.
+  const iree_hal_executable_library_header_t* header;
+
+  // The total number of entry points available in the library. Bounds all of
+  // the tables below.
+  uint32_t entry_point_count;
+
+  // Table of export function entry points matching the ordinals defined during
+  // library generation. The runtime will use this table to map the ordinals to
+  // function pointers for execution.
+  const iree_hal_executable_dispatch_v1_t* entry_points;
+
+  // Optional table of export function entry point names 1:1 with entry_points.
+  // These names are only used for tracing/debugging and can be omitted to save
+  // binary size.
+  const char** entry_point_names;
+
+  // Optional table of entry point tags that describe the entry point in a
+  // human-readable format useful for verbose logging. The string values, when
+  // present, may be attached to tracing/debugging events related to the entry
+  // point.
+  const char** entry_point_tags;
+
+  // Optional table of the local memory in bytes required by each tile of the
+  // entry points 1:1 with entry_points. May be omitted if no entry point
+  // requires local memory.
+  const uint32_t* entry_point_local_memory_sizes;
+} iree_hal_executable_library_v1_t;
+
 #endif  // IREE_HAL_LOCAL_EXECUTABLE_LIBRARY_H_
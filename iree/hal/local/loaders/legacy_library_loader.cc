@@ -14,6 +14,32 @@
 
 #include "iree/hal/local/loaders/legacy_library_loader.h"
 
+#include "iree/base/target_platform.h"
+
+// Load embedded libraries from anonymous in-memory files instead of writing
+// them to disk first. This uses memfd_create + dlopen(/proc/self/fd/N) and will
+// fall back to temp files at runtime if the kernel or sandbox does not allow
+// it. Override with -DIREE_HAL_LEGACY_LIBRARY_LOADER_USE_MEMFD=0 to always use
+// temp files (such as when comparing the two).
+#if !defined(IREE_HAL_LEGACY_LIBRARY_LOADER_USE_MEMFD)
+#if defined(IREE_PLATFORM_LINUX)
+#define IREE_HAL_LEGACY_LIBRARY_LOADER_USE_MEMFD 1
+#else
+#define IREE_HAL_LEGACY_LIBRARY_LOADER_USE_MEMFD 0
+#endif  // IREE_PLATFORM_LINUX
+#endif  // !IREE_HAL_LEGACY_LIBRARY_LOADER_USE_MEMFD
+
+#if IREE_HAL_LEGACY_LIBRARY_LOADER_USE_MEMFD
+#include <errno.h>
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if !defined(MFD_CLOEXEC)
+#define MFD_CLOEXEC 0x0001U
+#endif  // !MFD_CLOEXEC
+#endif  // IREE_HAL_LEGACY_LIBRARY_LOADER_USE_MEMFD
+
 #include "iree/base/dynamic_library.h"
 #include "iree/base/internal/file_io.h"
 #include "iree/base/internal/file_path.h"
@@ -105,6 +131,11 @@ typedef struct {
   iree_host_size_t temp_file_count;
   iree_string_view_t temp_files[8];
 
+  // In-memory file the library was loaded from or -1 if loaded from disk.
+  // Must stay open for as long as the library is loaded as the dynamic loader
+  // identifies libraries by path and a recycled fd would alias /proc/self/fd/N.
+  int library_fd;
+
   // Loaded platform dynamic library.
   iree::DynamicLibrary* library;
 
@@ -116,16 +147,75 @@ typedef struct {
 extern const iree_hal_local_executable_vtable_t
     iree_hal_legacy_executable_vtable;
 
+#if IREE_HAL_LEGACY_LIBRARY_LOADER_USE_MEMFD
+static iree_status_t iree_hal_legacy_executable_load_from_memfd(
+    iree_hal_legacy_executable_t* executable,
+    iree_const_byte_span_t library_data) {
+  IREE_TRACE_SCOPE0("DyLibExecutable::LoadFromMemFd");
+#if defined(__NR_memfd_create)
+  int fd = (int)syscall(__NR_memfd_create, "dylib_executable", MFD_CLOEXEC);
+  if (fd == -1) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "memfd_create failed");
+  }
+
+  iree_host_size_t offset = 0;
+  while (offset < library_data.data_length) {
+    ssize_t written = write(fd, library_data.data + offset,
+                            library_data.data_length - offset);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      int write_errno = errno;
+      close(fd);
+      return iree_make_status(iree_status_code_from_errno(write_errno),
+                              "failed to write library to memfd");
+    }
+    offset += (iree_host_size_t)written;
+  }
+
+  char fd_path[32];
+  snprintf(fd_path, sizeof(fd_path), "/proc/self/fd/%d", fd);
+  std::unique_ptr<iree::DynamicLibrary> library;
+  iree_status_t status = iree::DynamicLibrary::Load(fd_path, &library);
+  if (!iree_status_is_ok(status)) {
+    close(fd);
+    return status;
+  }
+
+  // NOTE: debug databases are only attached on Windows and this path is Linux
+  // only so there's nothing to extract.
+  executable->library_fd = fd;
+  executable->library = library.release();
+  return iree_ok_status();
+#else
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "memfd_create not available");
+#endif  // __NR_memfd_create
+}
+#endif  // IREE_HAL_LEGACY_LIBRARY_LOADER_USE_MEMFD
+
 static iree_status_t iree_hal_legacy_executable_extract_and_load(
     iree_hal_legacy_executable_t* executable, iree_allocator_t host_allocator) {
+  flatbuffers_uint8_vec_t embedded_library_vec =
+      iree_DyLibExecutableDef_library_embedded_get(executable->def);
+
+#if IREE_HAL_LEGACY_LIBRARY_LOADER_USE_MEMFD
+  // Try loading directly from memory first. This can fail on older kernels, in
+  // sandboxes that block memfd_create, or when /proc is not mounted; in those
+  // cases we fall back to extracting to disk below.
+  iree_const_byte_span_t library_data = iree_make_const_byte_span(
+      embedded_library_vec, flatbuffers_uint8_vec_len(embedded_library_vec));
+  iree_status_t memfd_status =
+      iree_hal_legacy_executable_load_from_memfd(executable, library_data);
+  if (iree_status_is_ok(memfd_status)) return memfd_status;
+  iree_status_ignore(memfd_status);
+#endif  // IREE_HAL_LEGACY_LIBRARY_LOADER_USE_MEMFD
+
   // Write the embedded library out to a temp file, since all of the dynamic
-  // library APIs work with files. We could instead use in-memory files on
-  // platforms where that is convenient.
+  // library APIs work with files.
   //
-  // TODO(#3845): use dlopen on an fd with either dlopen(/proc/self/fd/NN),
-  // fdlopen, or android_dlopen_ext to avoid needing to write the file to disk.
-  // Can fallback to memfd_create + dlopen where available, and fallback from
-  // that to disk (maybe just windows/mac).
+  // TODO(#3845): use fdlopen or android_dlopen_ext to avoid needing to write
+  // the file to disk on other platforms.
   std::string library_temp_path;
   IREE_RETURN_IF_ERROR(
       iree::file_io::GetTempFile("dylib_executable", &library_temp_path));
@@ -147,8 +237,6 @@ static iree_status_t iree_hal_legacy_executable_extract_and_load(
   library_temp_file.size = library_temp_path.size();
   executable->temp_files[executable->temp_file_count++] = library_temp_file;
 
-  flatbuffers_uint8_vec_t embedded_library_vec =
-      iree_DyLibExecutableDef_library_embedded_get(executable->def);
   IREE_RETURN_IF_ERROR(iree::file_io::SetFileContents(
       library_temp_path,
       absl::string_view(reinterpret_cast<const char*>(embedded_library_vec),
@@ -234,7 +322,8 @@ static iree_status_t iree_hal_legacy_executable_create(
   iree_hal_legacy_executable_t* executable = NULL;
   iree_host_size_t total_size =
       sizeof(*executable) + entry_point_count * sizeof(*executable->entry_fns) +
-      executable_layout_count * sizeof(iree_hal_local_executable_layout_t);
+      executable_layout_count * sizeof(iree_hal_local_executable_layout_t) +
+      executable_layout_count * sizeof(iree_task_dispatch_profile_t);
   iree_status_t status =
       iree_allocator_malloc(host_allocator, total_size, (void**)&executable);
   if (iree_status_is_ok(status)) {
@@ -244,11 +333,15 @@ static iree_status_t iree_hal_legacy_executable_create(
                                                entry_point_count *
                                                    sizeof(
                                                        *executable->entry_fns));
+    iree_task_dispatch_profile_t* dispatch_profiles_ptr =
+        (iree_task_dispatch_profile_t*)(executable_layouts_ptr +
+                                        executable_layout_count);
     iree_hal_local_executable_initialize(
         &iree_hal_legacy_executable_vtable, executable_layout_count,
-        executable_layouts, executable_layouts_ptr, host_allocator,
-        &executable->base);
+        executable_layouts, executable_layouts_ptr, dispatch_profiles_ptr,
+        host_allocator, &executable->base);
     executable->def = executable_def;
+    executable->library_fd = -1;
     executable->entry_fn_count = entry_point_count;
   }
   if (iree_status_is_ok(status)) {
@@ -282,12 +375,16 @@ static void iree_hal_legacy_executable_destroy(
 
 #if IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
   // Leak the library when tracing, since the profiler may still be reading it.
+  // Any in-memory file backing it is leaked as well.
   // TODO(benvanik): move to an atexit handler instead, verify with ASAN/MSAN
   // TODO(scotttodd): Make this compatible with testing:
   //     two test cases, one for each function in the same executable
   //     first test case passes, second fails to open the file (already open)
 #else
   delete executable->library;
+#if IREE_HAL_LEGACY_LIBRARY_LOADER_USE_MEMFD
+  if (executable->library_fd != -1) close(executable->library_fd);
+#endif  // IREE_HAL_LEGACY_LIBRARY_LOADER_USE_MEMFD
 #endif  // IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
 
   for (iree_host_size_t i = 0; i < executable->temp_file_count; ++i) {
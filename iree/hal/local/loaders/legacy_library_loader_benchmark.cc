@@ -0,0 +1,199 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures executable cache preparation time of dylib executables as seen at
+// application startup. Build with -DIREE_HAL_LEGACY_LIBRARY_LOADER_USE_MEMFD=0
+// to compare the in-memory load path against extracting to temp files.
+//
+// BM_PrepareExecutables measures a cold start where every executable is
+// loaded. BM_PrepareSharedExecutables measures starting another instance of
+// a program that is already resident, as when a server hosts multiple
+// instances of the same model, where executables are shared through an
+// iree_hal_local_executable_store_t.
+
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "iree/base/api.h"
+#include "iree/base/logging.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/loaders/legacy_library_loader.h"
+#include "iree/hal/local/local_executable_cache.h"
+#include "iree/hal/local/local_executable_layout.h"
+
+// flatcc schemas:
+#include "iree/base/flatcc.h"
+#include "iree/schemas/bytecode_module_def_reader.h"
+#include "iree/schemas/dylib_executable_def_reader.h"
+
+// Compiled module embedded here to avoid file IO:
+#include "iree/hal/local/loaders/legacy_library_loader_benchmark_module.h"
+
+namespace {
+
+struct EmbeddedExecutable {
+  iree_const_byte_span_t data;
+  iree_host_size_t entry_point_count;
+};
+
+// Returns all dylib executables stored in the rodata of the benchmark module.
+static const std::vector<EmbeddedExecutable>& GetEmbeddedExecutables() {
+  static const std::vector<EmbeddedExecutable> executables = []() {
+    std::vector<EmbeddedExecutable> executables;
+    const auto* module_file_toc =
+        iree::hal::legacy_library_loader_benchmark_module_create();
+    iree_vm_BytecodeModuleDef_table_t module_def =
+        iree_vm_BytecodeModuleDef_as_root(module_file_toc->data);
+    iree_vm_RodataSegmentDef_vec_t rodata_segments =
+        iree_vm_BytecodeModuleDef_rodata_segments(module_def);
+    for (size_t i = 0; i < iree_vm_RodataSegmentDef_vec_len(rodata_segments);
+         ++i) {
+      flatbuffers_uint8_vec_t data = iree_vm_RodataSegmentDef_data(
+          iree_vm_RodataSegmentDef_vec_at(rodata_segments, i));
+      size_t data_length = flatbuffers_uint8_vec_len(data);
+      if (data_length < 16 ||
+          !flatbuffers_has_identifier(
+              data, iree_DyLibExecutableDef_file_identifier)) {
+        continue;
+      }
+      iree_DyLibExecutableDef_table_t executable_def =
+          iree_DyLibExecutableDef_as_root(data);
+      executables.push_back({
+          iree_make_const_byte_span(data, data_length),
+          flatbuffers_string_vec_len(
+              iree_DyLibExecutableDef_entry_points_get(executable_def)),
+      });
+    }
+    IREE_CHECK(!executables.empty())
+        << "benchmark module contains no dylib executables";
+    return executables;
+  }();
+  return executables;
+}
+
+// Prepares |prepared|.size() executables (cycling through those in the
+// module) from |executable_cache|.
+static void PrepareExecutables(
+    iree_hal_executable_cache_t* executable_cache,
+    iree_hal_executable_layout_t* executable_layout,
+    std::vector<iree_hal_executable_t*>& prepared) {
+  const auto& executables = GetEmbeddedExecutables();
+  std::vector<iree_hal_executable_layout_t*> executable_layouts;
+  for (size_t i = 0; i < prepared.size(); ++i) {
+    const auto& executable = executables[i % executables.size()];
+    executable_layouts.assign(executable.entry_point_count, executable_layout);
+    iree_hal_executable_spec_t spec;
+    iree_hal_executable_spec_initialize(&spec);
+    spec.executable_format = iree_hal_make_executable_format("DLIB");
+    spec.executable_data = executable.data;
+    spec.executable_layout_count = executable_layouts.size();
+    spec.executable_layouts = executable_layouts.data();
+    IREE_CHECK_OK(iree_hal_executable_cache_prepare_executable(
+        executable_cache, &spec, &prepared[i]));
+  }
+}
+
+static void ReleaseExecutables(std::vector<iree_hal_executable_t*>& prepared) {
+  for (auto* executable : prepared) {
+    iree_hal_executable_release(executable);
+  }
+}
+
+// Creates a fresh executable cache and prepares state.range(0) executables
+// from it, then releases everything.
+// Each executable is loaded independently as the cache has no shared store.
+static void BM_PrepareExecutables(benchmark::State& state) {
+  iree_hal_executable_layout_t* executable_layout = NULL;
+  IREE_CHECK_OK(iree_hal_local_executable_layout_create(
+      /*push_constants=*/0, /*set_layout_count=*/0, /*set_layouts=*/NULL,
+      iree_allocator_system(), &executable_layout));
+
+  iree_hal_executable_loader_t* loader = NULL;
+  IREE_CHECK_OK(
+      iree_hal_legacy_library_loader_create(iree_allocator_system(), &loader));
+
+  std::vector<iree_hal_executable_t*> prepared(state.range(0));
+  for (auto _ : state) {
+    iree_hal_executable_cache_t* executable_cache = NULL;
+    IREE_CHECK_OK(iree_hal_local_executable_cache_create(
+        iree_make_cstring_view("benchmark"), 1, &loader,
+        /*executable_store=*/NULL, iree_allocator_system(),
+        &executable_cache));
+    PrepareExecutables(executable_cache, executable_layout, prepared);
+    ReleaseExecutables(prepared);
+    iree_hal_executable_cache_release(executable_cache);
+  }
+  state.SetItemsProcessed(state.iterations() * prepared.size());
+
+  iree_hal_executable_loader_release(loader);
+  iree_hal_executable_layout_release(executable_layout);
+}
+BENCHMARK(BM_PrepareExecutables)
+    ->ArgName("executables")
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(32)
+    ->Unit(benchmark::kMicrosecond);
+
+// Creates a fresh executable cache sharing a store with a resident instance
+// that has already prepared the same executables and prepares state.range(0)
+// executables from it, then releases everything but the resident instance.
+// All executables are shared with the resident instance and none are loaded.
+static void BM_PrepareSharedExecutables(benchmark::State& state) {
+  iree_hal_executable_layout_t* executable_layout = NULL;
+  IREE_CHECK_OK(iree_hal_local_executable_layout_create(
+      /*push_constants=*/0, /*set_layout_count=*/0, /*set_layouts=*/NULL,
+      iree_allocator_system(), &executable_layout));
+
+  iree_hal_executable_loader_t* loader = NULL;
+  IREE_CHECK_OK(
+      iree_hal_legacy_library_loader_create(iree_allocator_system(), &loader));
+
+  iree_hal_local_executable_store_t* executable_store = NULL;
+  IREE_CHECK_OK(iree_hal_local_executable_store_create(iree_allocator_system(),
+                                                       &executable_store));
+
+  iree_hal_executable_cache_t* resident_cache = NULL;
+  IREE_CHECK_OK(iree_hal_local_executable_cache_create(
+      iree_make_cstring_view("resident"), 1, &loader, executable_store,
+      iree_allocator_system(), &resident_cache));
+  std::vector<iree_hal_executable_t*> resident(state.range(0));
+  PrepareExecutables(resident_cache, executable_layout, resident);
+
+  std::vector<iree_hal_executable_t*> prepared(state.range(0));
+  for (auto _ : state) {
+    iree_hal_executable_cache_t* executable_cache = NULL;
+    IREE_CHECK_OK(iree_hal_local_executable_cache_create(
+        iree_make_cstring_view("benchmark"), 1, &loader, executable_store,
+        iree_allocator_system(), &executable_cache));
+    PrepareExecutables(executable_cache, executable_layout, prepared);
+    ReleaseExecutables(prepared);
+    iree_hal_executable_cache_release(executable_cache);
+  }
+  state.SetItemsProcessed(state.iterations() * prepared.size());
+
+  ReleaseExecutables(resident);
+  iree_hal_executable_cache_release(resident_cache);
+  iree_hal_local_executable_store_release(executable_store);
+  iree_hal_executable_loader_release(loader);
+  iree_hal_executable_layout_release(executable_layout);
+}
+BENCHMARK(BM_PrepareSharedExecutables)
+    ->ArgName("executables")
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(32)
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
@@ -14,11 +14,195 @@
 
 #include "iree/hal/local/loaders/system_library_loader.h"
 
+#include "iree/base/target_platform.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/local/local_executable.h"
 
-// flatcc schemas:
-#include "iree/base/flatcc.h"
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_APPLE) || \
+    defined(IREE_PLATFORM_LINUX)
+#define IREE_HAL_SYSTEM_LIBRARY_LOADER_USE_DLOPEN 1
+#else
+#define IREE_HAL_SYSTEM_LIBRARY_LOADER_USE_DLOPEN 0
+#endif  // IREE_PLATFORM_ANDROID || IREE_PLATFORM_APPLE || IREE_PLATFORM_LINUX
+
+#if IREE_HAL_SYSTEM_LIBRARY_LOADER_USE_DLOPEN
+#include <dlfcn.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#if defined(IREE_PLATFORM_LINUX)
+#include <sys/syscall.h>
+
+#if !defined(MFD_CLOEXEC)
+#define MFD_CLOEXEC 0x0001U
+#endif  // !MFD_CLOEXEC
+#endif  // IREE_PLATFORM_LINUX
+#endif  // IREE_HAL_SYSTEM_LIBRARY_LOADER_USE_DLOPEN
+
+//===----------------------------------------------------------------------===//
+// Platform dynamic library loading
+//===----------------------------------------------------------------------===//
+
+#if IREE_HAL_SYSTEM_LIBRARY_LOADER_USE_DLOPEN
+
+// Writes all of |library_data| to |fd|.
+static iree_status_t iree_hal_system_library_write_fd(
+    int fd, iree_const_byte_span_t library_data) {
+  iree_host_size_t offset = 0;
+  while (offset < library_data.data_length) {
+    ssize_t written = write(fd, library_data.data + offset,
+                            library_data.data_length - offset);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to write library file");
+    }
+    offset += (iree_host_size_t)written;
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_system_library_dlopen(const char* path,
+                                                    void** out_handle) {
+  *out_handle = dlopen(path, RTLD_LAZY | RTLD_LOCAL);
+  if (!*out_handle) {
+    const char* error = dlerror();
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "unable to load system library: %s",
+                            error ? error : "unknown error");
+  }
+  return iree_ok_status();
+}
+
+// Loads |library_data| from an anonymous in-memory file. |out_fd| must stay
+// open for as long as the library is loaded as the dynamic loader identifies
+// libraries by path and a recycled fd would alias /proc/self/fd/N.
+static iree_status_t iree_hal_system_library_load_from_memfd(
+    iree_const_byte_span_t library_data, void** out_handle, int* out_fd) {
+#if defined(IREE_PLATFORM_LINUX) && defined(__NR_memfd_create)
+  int fd = (int)syscall(__NR_memfd_create, "system_library", MFD_CLOEXEC);
+  if (fd == -1) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "memfd_create failed");
+  }
+  iree_status_t status = iree_hal_system_library_write_fd(fd, library_data);
+  if (iree_status_is_ok(status)) {
+    char fd_path[32];
+    snprintf(fd_path, sizeof(fd_path), "/proc/self/fd/%d", fd);
+    status = iree_hal_system_library_dlopen(fd_path, out_handle);
+  }
+  if (!iree_status_is_ok(status)) {
+    close(fd);
+    return status;
+  }
+  *out_fd = fd;
+  return iree_ok_status();
+#else
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "memfd_create not available");
+#endif  // IREE_PLATFORM_LINUX && __NR_memfd_create
+}
+
+// Loads |library_data| by writing it to a temp file. The file is unlinked as
+// soon as it has been loaded as the mapping keeps the contents alive.
+static iree_status_t iree_hal_system_library_load_from_temp_file(
+    iree_const_byte_span_t library_data, void** out_handle) {
+  const char* temp_dir = getenv("TEST_TMPDIR");
+  if (!temp_dir) temp_dir = getenv("TMPDIR");
+  if (!temp_dir) temp_dir = "/tmp";
+  char temp_path[512];
+  int path_length = snprintf(temp_path, sizeof(temp_path),
+                             "%s/iree_system_library_XXXXXX", temp_dir);
+  if (path_length < 0 || path_length >= (int)sizeof(temp_path)) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "temp path too long: %s", temp_dir);
+  }
+  int fd = mkstemp(temp_path);
+  if (fd == -1) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "unable to create temp file in %s", temp_dir);
+  }
+  iree_status_t status = iree_hal_system_library_write_fd(fd, library_data);
+  close(fd);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_system_library_dlopen(temp_path, out_handle);
+  }
+  unlink(temp_path);
+  return status;
+}
+
+#endif  // IREE_HAL_SYSTEM_LIBRARY_LOADER_USE_DLOPEN
+
+// Loads the platform dynamic library contained in |library_data|.
+// On success |out_handle| is the library handle and |out_fd| is either -1 or
+// a file descriptor that must be closed after the library is unloaded.
+static iree_status_t iree_hal_system_library_load(
+    iree_const_byte_span_t library_data, void** out_handle, int* out_fd) {
+  *out_handle = NULL;
+  *out_fd = -1;
+#if IREE_HAL_SYSTEM_LIBRARY_LOADER_USE_DLOPEN
+  // Try loading directly from memory first. This can fail on older kernels, in
+  // sandboxes that block memfd_create, or when /proc is not mounted; in those
+  // cases we fall back to extracting to disk.
+  iree_status_t status = iree_hal_system_library_load_from_memfd(
+      library_data, out_handle, out_fd);
+  if (iree_status_is_ok(status)) return status;
+  iree_status_ignore(status);
+  return iree_hal_system_library_load_from_temp_file(library_data, out_handle);
+#else
+  // TODO(#3845): support LoadLibrary on Windows.
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "system libraries not supported on this platform");
+#endif  // IREE_HAL_SYSTEM_LIBRARY_LOADER_USE_DLOPEN
+}
+
+static void iree_hal_system_library_unload(void* handle, int fd) {
+#if IREE_HAL_SYSTEM_LIBRARY_LOADER_USE_DLOPEN
+  if (handle) dlclose(handle);
+  if (fd != -1) close(fd);
+#endif  // IREE_HAL_SYSTEM_LIBRARY_LOADER_USE_DLOPEN
+}
+
+// Queries the library interface exported by the loaded library |handle|.
+// Fails if the library is using a newer interface than we support.
+static iree_status_t iree_hal_system_library_query(
+    void* handle,
+    const iree_hal_executable_library_header_t* const** out_library) {
+  *out_library = NULL;
+#if IREE_HAL_SYSTEM_LIBRARY_LOADER_USE_DLOPEN
+  iree_hal_executable_library_query_fn_t query_fn =
+      (iree_hal_executable_library_query_fn_t)dlsym(
+          handle, IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME);
+  if (!query_fn) {
+    return iree_make_status(
+        IREE_STATUS_NOT_FOUND,
+        "symbol %s not exported by the system library, check visibility",
+        IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME);
+  }
+  const iree_hal_executable_library_header_t* const* library =
+      query_fn(IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION);
+  if (!library || !*library) {
+    return iree_make_status(
+        IREE_STATUS_FAILED_PRECONDITION,
+        "executable library does not support version %u or lower",
+        (uint32_t)IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION);
+  }
+  const iree_hal_executable_library_header_t* header = *library;
+  if (header->version > IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION) {
+    return iree_make_status(
+        IREE_STATUS_FAILED_PRECONDITION,
+        "executable library version %u is newer than the supported version %u",
+        header->version, (uint32_t)IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION);
+  }
+  *out_library = library;
+  return iree_ok_status();
+#else
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "system libraries not supported on this platform");
+#endif  // IREE_HAL_SYSTEM_LIBRARY_LOADER_USE_DLOPEN
+}
 
 //===----------------------------------------------------------------------===//
 // iree_hal_system_executable_t
@@ -27,11 +211,15 @@
 typedef struct {
   iree_hal_local_executable_t base;
 
-  // TODO(benvanik): library handle for ownership.
+  // Loaded platform dynamic library owning the library interface.
+  void* library_handle;
+  // In-memory file the library was loaded from or -1 if loaded from disk.
+  int library_fd;
 
   union {
-    const iree_hal_executable_library_header_t* header;
+    const iree_hal_executable_library_header_t* const* header;
     const iree_hal_executable_library_v0_t* v0;
+    const iree_hal_executable_library_v1_t* v1;
   } library;
 } iree_hal_system_executable_t;
 
@@ -39,33 +227,68 @@ static const iree_hal_local_executable_vtable_t
     iree_hal_system_executable_vtable;
 
 static iree_status_t iree_hal_system_executable_create(
-    iree_hal_executable_layout_t* base_layout,
-    const iree_hal_executable_library_header_t* library_header,
+    iree_const_byte_span_t library_data,
     iree_host_size_t executable_layout_count,
     iree_hal_executable_layout_t* const* executable_layouts,
     iree_allocator_t host_allocator, iree_hal_executable_t** out_executable) {
-  IREE_ASSERT_ARGUMENT(library_header);
   IREE_ASSERT_ARGUMENT(!executable_layout_count || executable_layouts);
   IREE_ASSERT_ARGUMENT(out_executable);
   *out_executable = NULL;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  void* library_handle = NULL;
+  int library_fd = -1;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0,
+      iree_hal_system_library_load(library_data, &library_handle, &library_fd));
+
+  const iree_hal_executable_library_header_t* const* library = NULL;
+  iree_status_t status =
+      iree_hal_system_library_query(library_handle, &library);
+
+  // All library versions share the v0 leading fields.
+  if (iree_status_is_ok(status)) {
+    const iree_hal_executable_library_v0_t* library_v0 =
+        (const iree_hal_executable_library_v0_t*)library;
+    if (library_v0->entry_point_count != executable_layout_count) {
+      status = iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                                "executable provides %u entry points but "
+                                "caller provided %zu; must match",
+                                library_v0->entry_point_count,
+                                executable_layout_count);
+    }
+  }
+
   iree_hal_system_executable_t* executable = NULL;
-  iree_host_size_t total_size =
-      sizeof(*executable) +
-      executable_layout_count * sizeof(iree_hal_local_executable_layout_t);
-  iree_status_t status = iree_allocator_malloc(
-      host_allocator, sizeof(*executable), (void**)&executable);
+  if (iree_status_is_ok(status)) {
+    iree_host_size_t total_size =
+        sizeof(*executable) +
+        executable_layout_count * sizeof(iree_hal_local_executable_layout_t*) +
+        executable_layout_count * sizeof(iree_task_dispatch_profile_t);
+    status =
+        iree_allocator_malloc(host_allocator, total_size, (void**)&executable);
+  }
   if (iree_status_is_ok(status)) {
     iree_hal_local_executable_layout_t** executable_layouts_ptr =
         (iree_hal_local_executable_layout_t**)(((uint8_t*)executable) +
                                                sizeof(*executable));
+    iree_task_dispatch_profile_t* dispatch_profiles_ptr =
+        (iree_task_dispatch_profile_t*)(executable_layouts_ptr +
+                                        executable_layout_count);
     iree_hal_local_executable_initialize(
         &iree_hal_system_executable_vtable, executable_layout_count,
-        executable_layouts, executable_layouts_ptr, host_allocator,
-        &executable->base);
-    executable->library.header = library_header;
+        executable_layouts, executable_layouts_ptr, dispatch_profiles_ptr,
+        host_allocator, &executable->base);
+    executable->library_handle = library_handle;
+    executable->library_fd = library_fd;
+    executable->library.header = library;
+    if ((*library)->version >= IREE_HAL_EXECUTABLE_LIBRARY_VERSION_1) {
+      executable->base.local_memory_sizes =
+          executable->library.v1->entry_point_local_memory_sizes;
+    }
     *out_executable = (iree_hal_executable_t*)executable;
+  } else {
+    iree_hal_system_library_unload(library_handle, library_fd);
   }
 
   IREE_TRACE_ZONE_END(z0);
@@ -79,6 +302,9 @@ static void iree_hal_system_executable_destroy(
   iree_allocator_t host_allocator = executable->base.host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_hal_system_library_unload(executable->library_handle,
+                                 executable->library_fd);
+
   iree_hal_local_executable_deinitialize(
       (iree_hal_local_executable_t*)base_executable);
   iree_allocator_free(host_allocator, executable);
@@ -99,8 +325,12 @@ static iree_status_t iree_hal_system_executable_issue_call(
   }
 
 #if IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
-  iree_string_view_t entry_point_name = iree_make_cstring_view(
-      executable->library.v0->entry_point_names[ordinal]);
+  // Entry point names are optional and may be omitted from the library.
+  iree_string_view_t entry_point_name = iree_string_view_empty();
+  if (executable->library.v0->entry_point_names) {
+    entry_point_name = iree_make_cstring_view(
+        executable->library.v0->entry_point_names[ordinal]);
+  }
   if (iree_string_view_is_empty(entry_point_name)) {
     entry_point_name = iree_make_cstring_view("unknown_dylib_call");
   }
@@ -108,9 +338,18 @@ static iree_status_t iree_hal_system_executable_issue_call(
                                       entry_point_name.size);
 #endif  // IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
 
-  executable->library.v0->entry_points[ordinal](
-      call->state, &call->workgroup_id, &call->workgroup_size,
-      &call->workgroup_count, call->push_constants, call->bindings);
+  if ((*executable->library.header)->version >=
+      IREE_HAL_EXECUTABLE_LIBRARY_VERSION_1) {
+    executable->library.v1->entry_points[ordinal](
+        call->state, &call->workgroup_id, &call->workgroup_size,
+        &call->workgroup_count, call->push_constants, call->bindings,
+        call->local_memory);
+  } else {
+    static const iree_hal_executable_dispatch_state_v0_t state_v0 = {0};
+    executable->library.v0->entry_points[ordinal](
+        &state_v0, &call->workgroup_id, &call->workgroup_size,
+        &call->workgroup_count, call->push_constants, call->bindings);
+  }
 
   IREE_TRACE_ZONE_END(z0);
 
@@ -182,19 +421,15 @@ static iree_status_t iree_hal_system_library_loader_try_load(
     iree_hal_executable_loader_t* base_executable_loader,
     const iree_hal_executable_spec_t* executable_spec,
     iree_hal_executable_t** out_executable) {
+  iree_hal_system_library_loader_t* executable_loader =
+      (iree_hal_system_library_loader_t*)base_executable_loader;
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_status_t status =
-      iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                       "new executable library format not yet implemented");
-
-  // Query the executable library to get the latest interface.
-  // Will fail if the executable is using a newer interface than we support.
-  // iree_hal_executable_library_header_t* header = NULL;
-  // IREE_RETURN_AND_END_ZONE_IF_ERROR(
-  //     z0, iree_hal_executable_library_handle_query(
-  //             executable_handle, IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION,
-  //             &header));
+  iree_status_t status = iree_hal_system_executable_create(
+      executable_spec->executable_data,
+      executable_spec->executable_layout_count,
+      executable_spec->executable_layouts, executable_loader->host_allocator,
+      out_executable);
 
   IREE_TRACE_ZONE_END(z0);
   return status;
@@ -27,6 +27,10 @@ extern "C" {
 
 // Creates an executable loader that can load files from platform-supported
 // dynamic libraries (such as .dylib on darwin, .so on linux, .dll on windows).
+//
+// Executables in the "DYEX" format are the raw platform library file exporting
+// IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME (see executable_library.h). Both v0
+// and v1 library interfaces are supported.
 iree_status_t iree_hal_system_library_loader_create(
     iree_allocator_t host_allocator,
     iree_hal_executable_loader_t** out_executable_loader);
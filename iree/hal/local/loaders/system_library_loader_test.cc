@@ -0,0 +1,265 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/hal/local/loaders/system_library_loader.h"
+
+#include <cstring>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/local_executable.h"
+#include "iree/hal/local/loaders/system_library_loader_test_library_embed.h"
+#include "iree/hal/local/task_device.h"
+#include "iree/task/executor.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+// Matches system_library_loader_test_library.c.
+constexpr int32_t kLocalMemoryEntryPoint = 0;
+constexpr int32_t kNoLocalMemoryEntryPoint = 1;
+constexpr uint32_t kLocalMemorySize = 16 * 1024;
+constexpr iree_host_size_t kRecordLength = 8;
+
+constexpr iree_host_size_t kWorkerCount = 2;
+constexpr uint32_t kWorkgroupCount = 64;
+constexpr uint32_t kPushConstant = 42;
+
+class SystemLibraryLoaderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    IREE_ASSERT_OK(iree_hal_system_library_loader_create(
+        iree_allocator_system(), &loader_));
+
+    iree_task_topology_t topology;
+    iree_task_topology_initialize_from_group_count(kWorkerCount, &topology);
+    IREE_ASSERT_OK(iree_task_executor_create(
+        IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+        IREE_TASK_EXECUTOR_DEFAULT_WORKER_SPIN_NS, iree_allocator_system(),
+        &executor_));
+    iree_task_topology_deinitialize(&topology);
+
+    iree_hal_task_device_params_t params;
+    iree_hal_task_device_params_initialize(&params);
+    IREE_ASSERT_OK(iree_hal_task_device_create(
+        iree_make_cstring_view("task"), &params, executor_,
+        /*loader_count=*/1, &loader_, /*executable_store=*/NULL,
+        iree_allocator_system(), &device_));
+
+    iree_hal_descriptor_set_layout_binding_t binding = {
+        /*binding=*/0,
+        /*type=*/IREE_HAL_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        /*access=*/IREE_HAL_MEMORY_ACCESS_ALL,
+    };
+    iree_hal_descriptor_set_layout_t* set_layout = NULL;
+    IREE_ASSERT_OK(iree_hal_descriptor_set_layout_create(
+        device_, IREE_HAL_DESCRIPTOR_SET_LAYOUT_USAGE_TYPE_PUSH_ONLY,
+        /*binding_count=*/1, &binding, &set_layout));
+    IREE_ASSERT_OK(iree_hal_executable_layout_create(
+        device_, /*push_constants=*/1, /*set_layout_count=*/1, &set_layout,
+        &executable_layout_));
+    iree_hal_descriptor_set_layout_release(set_layout);
+  }
+
+  void TearDown() override {
+    iree_hal_executable_layout_release(executable_layout_);
+    iree_hal_device_release(device_);
+    iree_task_executor_release(executor_);
+    iree_hal_executable_loader_release(loader_);
+  }
+
+  // Loads the embedded test library with |layout_count| layouts.
+  iree_status_t LoadTestLibrary(iree_host_size_t layout_count,
+                                iree_hal_executable_t** out_executable) {
+    const auto* file_toc = iree::system_library_loader_test_library_create();
+    std::vector<iree_hal_executable_layout_t*> layouts(layout_count,
+                                                       executable_layout_);
+    iree_hal_executable_spec_t spec;
+    iree_hal_executable_spec_initialize(&spec);
+    spec.executable_format = iree_hal_make_executable_format("DYEX");
+    spec.executable_data = iree_make_const_byte_span(
+        reinterpret_cast<const uint8_t*>(file_toc->data), file_toc->size);
+    spec.executable_layout_count = layouts.size();
+    spec.executable_layouts = layouts.data();
+    return iree_hal_executable_loader_try_load(loader_, &spec, out_executable);
+  }
+
+  // Dispatches |entry_point| of |executable| with one record per workgroup
+  // and returns the records written by all workgroups.
+  std::vector<uint32_t> Dispatch(iree_hal_executable_t* executable,
+                                 int32_t entry_point) {
+    iree_device_size_t buffer_size =
+        kWorkgroupCount * kRecordLength * sizeof(uint32_t);
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_CHECK_OK(iree_hal_allocator_allocate_buffer(
+        iree_hal_device_allocator(device_),
+        IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_ALL, buffer_size, &buffer));
+    IREE_CHECK_OK(iree_hal_buffer_zero(buffer, 0, buffer_size));
+
+    iree_hal_command_buffer_t* command_buffer = NULL;
+    IREE_CHECK_OK(iree_hal_command_buffer_create(
+        device_, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT,
+        IREE_HAL_COMMAND_CATEGORY_DISPATCH, &command_buffer));
+    IREE_CHECK_OK(iree_hal_command_buffer_begin(command_buffer));
+    IREE_CHECK_OK(iree_hal_command_buffer_push_constants(
+        command_buffer, executable_layout_, 0, &kPushConstant,
+        sizeof(kPushConstant)));
+    iree_hal_descriptor_set_binding_t binding = {
+        /*binding=*/0,
+        /*buffer=*/buffer,
+        /*offset=*/0,
+        /*length=*/buffer_size,
+    };
+    IREE_CHECK_OK(iree_hal_command_buffer_push_descriptor_set(
+        command_buffer, executable_layout_, /*set=*/0, 1, &binding));
+    IREE_CHECK_OK(iree_hal_command_buffer_dispatch(
+        command_buffer, executable, entry_point, kWorkgroupCount, 1, 1));
+    IREE_CHECK_OK(iree_hal_command_buffer_end(command_buffer));
+
+    iree_hal_semaphore_t* semaphore = NULL;
+    IREE_CHECK_OK(iree_hal_semaphore_create(device_, 0ull, &semaphore));
+    uint64_t signal_value = 1ull;
+    iree_hal_submission_batch_t batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.command_buffer_count = 1;
+    batch.command_buffers = &command_buffer;
+    batch.signal_semaphores.count = 1;
+    batch.signal_semaphores.semaphores = &semaphore;
+    batch.signal_semaphores.payload_values = &signal_value;
+    IREE_CHECK_OK(iree_hal_device_queue_submit(
+        device_, IREE_HAL_COMMAND_CATEGORY_DISPATCH, /*queue_affinity=*/0,
+        /*batch_count=*/1, &batch));
+    IREE_CHECK_OK(iree_hal_semaphore_wait_with_deadline(
+        semaphore, signal_value, IREE_TIME_INFINITE_FUTURE));
+
+    std::vector<uint32_t> records(kWorkgroupCount * kRecordLength);
+    IREE_CHECK_OK(iree_hal_buffer_read_data(buffer, 0, records.data(),
+                                            buffer_size));
+    iree_hal_semaphore_release(semaphore);
+    iree_hal_command_buffer_release(command_buffer);
+    iree_hal_buffer_release(buffer);
+    return records;
+  }
+
+  // Verifies that every workgroup executed and received valid dispatch state.
+  static void ExpectRecords(const std::vector<uint32_t>& records,
+                            iree_hal_executable_cpu_features_t cpu_features) {
+    for (uint32_t i = 0; i < kWorkgroupCount; ++i) {
+      const uint32_t* record = &records[i * kRecordLength];
+      SCOPED_TRACE(i);
+      EXPECT_EQ(1u, record[0]);
+      EXPECT_LT(record[1], record[2]);
+      EXPECT_EQ(kWorkerCount, record[2]);
+      EXPECT_EQ((uint32_t)cpu_features, record[3]);
+      EXPECT_EQ((uint32_t)(cpu_features >> 32), record[4]);
+      EXPECT_EQ(1u, record[5]);
+      EXPECT_EQ(kPushConstant, record[6]);
+    }
+  }
+
+  iree_hal_executable_loader_t* loader_ = NULL;
+  iree_task_executor_t* executor_ = NULL;
+  iree_hal_device_t* device_ = NULL;
+  iree_hal_executable_layout_t* executable_layout_ = NULL;
+};
+
+TEST_F(SystemLibraryLoaderTest, QuerySupport) {
+  EXPECT_TRUE(iree_hal_executable_loader_query_support(
+      loader_, IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_OPTIMIZATION,
+      iree_hal_make_executable_format("DYEX")));
+  EXPECT_FALSE(iree_hal_executable_loader_query_support(
+      loader_, IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_OPTIMIZATION,
+      iree_hal_make_executable_format("DLIB")));
+}
+
+// The v1 interface exposes the local memory sizes declared by the library.
+TEST_F(SystemLibraryLoaderTest, LoadV1Library) {
+  iree_hal_executable_t* executable = NULL;
+  IREE_ASSERT_OK(LoadTestLibrary(2, &executable));
+  iree_hal_local_executable_t* local_executable =
+      iree_hal_local_executable_cast(executable);
+  ASSERT_NE(nullptr, local_executable->local_memory_sizes);
+  EXPECT_EQ(kLocalMemorySize,
+            local_executable->local_memory_sizes[kLocalMemoryEntryPoint]);
+  EXPECT_EQ(0u, local_executable->local_memory_sizes[kNoLocalMemoryEntryPoint]);
+  iree_hal_executable_release(executable);
+}
+
+// Each library load is independent and may be unloaded in any order.
+TEST_F(SystemLibraryLoaderTest, LoadTwice) {
+  iree_hal_executable_t* executable_0 = NULL;
+  IREE_ASSERT_OK(LoadTestLibrary(2, &executable_0));
+  iree_hal_executable_t* executable_1 = NULL;
+  IREE_ASSERT_OK(LoadTestLibrary(2, &executable_1));
+  iree_hal_executable_release(executable_0);
+  ExpectRecords(Dispatch(executable_1, kNoLocalMemoryEntryPoint),
+                iree_hal_local_executable_cast(executable_1)->cpu_features);
+  iree_hal_executable_release(executable_1);
+}
+
+TEST_F(SystemLibraryLoaderTest, EntryPointCountMismatch) {
+  iree_hal_executable_t* executable = NULL;
+  iree_status_t status = LoadTestLibrary(1, &executable);
+  EXPECT_TRUE(iree_status_is_failed_precondition(status));
+  iree_status_ignore(status);
+  EXPECT_EQ(nullptr, executable);
+}
+
+TEST_F(SystemLibraryLoaderTest, InvalidLibrary) {
+  std::vector<uint8_t> data(1024, 0xCD);
+  iree_hal_executable_spec_t spec;
+  iree_hal_executable_spec_initialize(&spec);
+  spec.executable_format = iree_hal_make_executable_format("DYEX");
+  spec.executable_data = iree_make_const_byte_span(data.data(), data.size());
+  iree_hal_executable_t* executable = NULL;
+  iree_status_t status =
+      iree_hal_executable_loader_try_load(loader_, &spec, &executable);
+  EXPECT_TRUE(iree_status_is_unavailable(status));
+  iree_status_ignore(status);
+  EXPECT_EQ(nullptr, executable);
+}
+
+// Tiles receive their worker, the host CPU features, and the local memory
+// declared by the entry point when dispatched through the task device.
+TEST_F(SystemLibraryLoaderTest, DispatchState) {
+  iree_hal_executable_cache_t* executable_cache = NULL;
+  IREE_ASSERT_OK(iree_hal_executable_cache_create(
+      device_, iree_make_cstring_view("test"), &executable_cache));
+  const auto* file_toc = iree::system_library_loader_test_library_create();
+  iree_hal_executable_layout_t* layouts[2] = {executable_layout_,
+                                              executable_layout_};
+  iree_hal_executable_spec_t spec;
+  iree_hal_executable_spec_initialize(&spec);
+  spec.executable_format = iree_hal_make_executable_format("DYEX");
+  spec.executable_data = iree_make_const_byte_span(
+      reinterpret_cast<const uint8_t*>(file_toc->data), file_toc->size);
+  spec.executable_layout_count = IREE_ARRAYSIZE(layouts);
+  spec.executable_layouts = layouts;
+  iree_hal_executable_t* executable = NULL;
+  IREE_ASSERT_OK(iree_hal_executable_cache_prepare_executable(
+      executable_cache, &spec, &executable));
+  iree_hal_executable_cpu_features_t cpu_features =
+      iree_hal_local_executable_cast(executable)->cpu_features;
+
+  ExpectRecords(Dispatch(executable, kLocalMemoryEntryPoint), cpu_features);
+  ExpectRecords(Dispatch(executable, kNoLocalMemoryEntryPoint), cpu_features);
+
+  iree_hal_executable_release(executable);
+  iree_hal_executable_cache_release(executable_cache);
+}
+
+}  // namespace
@@ -0,0 +1,123 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A v1 executable library as would be produced by the compiler. Each tile
+// writes a record of the dispatch state it received into the first binding so
+// that tests can verify what the runtime passed in.
+//
+// Binding 0 layout: one record of 8 uint32_t values per workgroup (indexed by
+// workgroup_id.x):
+//   [0] 1 once the tile has executed
+//   [1] state->worker_id
+//   [2] state->worker_count
+//   [3] low 32 bits of state->cpu_features
+//   [4] high 32 bits of state->cpu_features
+//   [5] 1 if local_memory was as expected for the entry point
+//   [6] push_constants[0]
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "iree/hal/local/executable_library.h"
+
+#if defined(_WIN32)
+#define IREE_SYM_EXPORT __declspec(dllexport)
+#else
+#define IREE_SYM_EXPORT __attribute__((visibility("default")))
+#endif  // _WIN32
+
+// Bytes of local memory required by each tile of the local_memory entry point.
+#define LOCAL_MEMORY_SIZE (16 * 1024)
+
+static void write_record(const iree_hal_executable_dispatch_state_v1_t* state,
+                         const iree_hal_vec3_t* workgroup_id,
+                         const iree_hal_executable_push_constants_ptr_t
+                             push_constants,
+                         const iree_hal_executable_binding_ptr_t* bindings,
+                         uint32_t local_memory_ok) {
+  uint32_t* record = (uint32_t*)bindings[0] + workgroup_id->x * 8;
+  record[0] = 1;
+  record[1] = state->worker_id;
+  record[2] = state->worker_count;
+  record[3] = (uint32_t)state->cpu_features;
+  record[4] = (uint32_t)(state->cpu_features >> 32);
+  record[5] = local_memory_ok;
+  record[6] = push_constants[0];
+}
+
+// Requires LOCAL_MEMORY_SIZE bytes and verifies all of it is writable.
+static void local_memory(const iree_hal_executable_dispatch_state_v1_t* state,
+                         const iree_hal_vec3_t* workgroup_id,
+                         const iree_hal_vec3_t* workgroup_size,
+                         const iree_hal_vec3_t* workgroup_count,
+                         const iree_hal_executable_push_constants_ptr_t
+                             push_constants,
+                         const iree_hal_executable_binding_ptr_t* bindings,
+                         void* local_memory) {
+  uint32_t local_memory_ok = local_memory != NULL &&
+                             ((uintptr_t)local_memory % sizeof(void*)) == 0;
+  if (local_memory_ok) {
+    uint8_t* bytes = (uint8_t*)local_memory;
+    uint8_t pattern = (uint8_t)(workgroup_id->x + 1);
+    for (size_t i = 0; i < LOCAL_MEMORY_SIZE; ++i) bytes[i] = pattern;
+    for (size_t i = 0; i < LOCAL_MEMORY_SIZE; ++i) {
+      if (bytes[i] != pattern) local_memory_ok = 0;
+    }
+  }
+  write_record(state, workgroup_id, push_constants, bindings, local_memory_ok);
+}
+
+// Requires no local memory and expects none to be passed.
+static void no_local_memory(
+    const iree_hal_executable_dispatch_state_v1_t* state,
+    const iree_hal_vec3_t* workgroup_id, const iree_hal_vec3_t* workgroup_size,
+    const iree_hal_vec3_t* workgroup_count,
+    const iree_hal_executable_push_constants_ptr_t push_constants,
+    const iree_hal_executable_binding_ptr_t* bindings, void* local_memory) {
+  write_record(state, workgroup_id, push_constants, bindings,
+               local_memory == NULL);
+}
+
+static const iree_hal_executable_library_header_t header = {
+    /*.version=*/IREE_HAL_EXECUTABLE_LIBRARY_VERSION_1,
+    /*.name=*/"system_library_loader_test_library",
+};
+static const iree_hal_executable_dispatch_v1_t entry_points[2] = {
+    local_memory,
+    no_local_memory,
+};
+static const char* entry_point_names[2] = {
+    "local_memory",
+    "no_local_memory",
+};
+static const uint32_t entry_point_local_memory_sizes[2] = {
+    LOCAL_MEMORY_SIZE,
+    0,
+};
+static const iree_hal_executable_library_v1_t library = {
+    /*.header=*/&header,
+    /*.entry_point_count=*/2,
+    /*.entry_points=*/entry_points,
+    /*.entry_point_names=*/entry_point_names,
+    /*.entry_point_tags=*/NULL,
+    /*.entry_point_local_memory_sizes=*/entry_point_local_memory_sizes,
+};
+
+IREE_SYM_EXPORT const iree_hal_executable_library_header_t* const*
+iree_hal_executable_library_query(
+    iree_hal_executable_library_version_t max_version) {
+  return max_version >= IREE_HAL_EXECUTABLE_LIBRARY_VERSION_1
+             ? (const iree_hal_executable_library_header_t* const*)&library
+             : NULL;
+}
@@ -108,7 +108,8 @@ static iree_status_t iree_hal_vmla_executable_create(
   iree_hal_vmla_executable_t* executable = NULL;
   iree_host_size_t total_size =
       sizeof(*executable) + entry_count * sizeof(*executable->entry_fns) +
-      executable_layout_count * sizeof(iree_hal_local_executable_layout_t);
+      executable_layout_count * sizeof(iree_hal_local_executable_layout_t) +
+      executable_layout_count * sizeof(iree_task_dispatch_profile_t);
   iree_status_t status =
       iree_allocator_malloc(host_allocator, total_size, (void**)&executable);
   if (iree_status_is_ok(status)) {
@@ -118,10 +119,13 @@ static iree_status_t iree_hal_vmla_executable_create(
                                                entry_count *
                                                    sizeof(
                                                        *executable->entry_fns));
+    iree_task_dispatch_profile_t* dispatch_profiles_ptr =
+        (iree_task_dispatch_profile_t*)(executable_layouts_ptr +
+                                        executable_layout_count);
     iree_hal_local_executable_initialize(
         &iree_hal_vmla_executable_vtable, executable_layout_count,
-        executable_layouts, executable_layouts_ptr, host_allocator,
-        &executable->base);
+        executable_layouts, executable_layouts_ptr, dispatch_profiles_ptr,
+        host_allocator, &executable->base);
     executable->context = context;
     iree_vm_context_retain(executable->context);
 
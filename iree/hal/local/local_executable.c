@@ -14,11 +14,43 @@
 
 #include "iree/hal/local/local_executable.h"
 
+#include <cpuinfo.h>
+
+// Queries the ISA extensions of the host CPU. cpuinfo caches its detection
+// results so this is cheap after the first call.
+// TODO(#4654): heterogeneous (big.LITTLE) systems may have different
+// extensions per core; cpuinfo only reports the common set.
+static iree_hal_executable_cpu_features_t
+iree_hal_local_executable_query_cpu_features(void) {
+  if (!cpuinfo_initialize()) return IREE_HAL_EXECUTABLE_CPU_FEATURE_NONE;
+  iree_hal_executable_cpu_features_t features = 0;
+#define IREE_CPU_FEATURE(query, feature) \
+  if (query()) features |= IREE_HAL_EXECUTABLE_CPU_FEATURE_##feature;
+  IREE_CPU_FEATURE(cpuinfo_has_x86_sse3, X86_SSE3);
+  IREE_CPU_FEATURE(cpuinfo_has_x86_ssse3, X86_SSSE3);
+  IREE_CPU_FEATURE(cpuinfo_has_x86_sse4_1, X86_SSE4_1);
+  IREE_CPU_FEATURE(cpuinfo_has_x86_sse4_2, X86_SSE4_2);
+  IREE_CPU_FEATURE(cpuinfo_has_x86_avx, X86_AVX);
+  IREE_CPU_FEATURE(cpuinfo_has_x86_fma3, X86_FMA3);
+  IREE_CPU_FEATURE(cpuinfo_has_x86_avx2, X86_AVX2);
+  IREE_CPU_FEATURE(cpuinfo_has_x86_avx512f, X86_AVX512F);
+  IREE_CPU_FEATURE(cpuinfo_has_x86_avx512dq, X86_AVX512DQ);
+  IREE_CPU_FEATURE(cpuinfo_has_x86_avx512bw, X86_AVX512BW);
+  IREE_CPU_FEATURE(cpuinfo_has_x86_avx512vl, X86_AVX512VL);
+  IREE_CPU_FEATURE(cpuinfo_has_x86_avx512vnni, X86_AVX512VNNI);
+  IREE_CPU_FEATURE(cpuinfo_has_arm_neon, ARM_NEON);
+  IREE_CPU_FEATURE(cpuinfo_has_arm_neon_fp16_arith, ARM_NEON_FP16);
+  IREE_CPU_FEATURE(cpuinfo_has_arm_neon_dot, ARM_NEON_DOTPROD);
+#undef IREE_CPU_FEATURE
+  return features;
+}
+
 void iree_hal_local_executable_initialize(
     const iree_hal_local_executable_vtable_t* vtable,
     iree_host_size_t executable_layout_count,
     iree_hal_executable_layout_t* const* source_executable_layouts,
     iree_hal_local_executable_layout_t** target_executable_layouts,
+    iree_task_dispatch_profile_t* target_dispatch_profiles,
     iree_allocator_t host_allocator,
     iree_hal_local_executable_t* out_base_executable) {
   iree_hal_resource_initialize(vtable, &out_base_executable->resource);
@@ -31,6 +63,13 @@ void iree_hal_local_executable_initialize(
         (iree_hal_local_executable_layout_t*)source_executable_layouts[i];
     iree_hal_executable_layout_retain(source_executable_layouts[i]);
   }
+  out_base_executable->dispatch_profiles = target_dispatch_profiles;
+  for (iree_host_size_t i = 0; i < executable_layout_count; ++i) {
+    iree_task_dispatch_profile_initialize(&target_dispatch_profiles[i]);
+  }
+  out_base_executable->local_memory_sizes = NULL;
+  out_base_executable->cpu_features =
+      iree_hal_local_executable_query_cpu_features();
 }
 
 void iree_hal_local_executable_deinitialize(
@@ -19,19 +19,24 @@
 #include "iree/hal/api.h"
 #include "iree/hal/local/executable_library.h"
 #include "iree/hal/local/local_executable_layout.h"
+#include "iree/task/task.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif  // __cplusplus
 
 typedef struct {
-  const iree_hal_executable_dispatch_state_v0_t* state;
+  // Per-tile state identifying the worker and CPU executing the call.
+  const iree_hal_executable_dispatch_state_v1_t* state;
   iree_hal_vec3_t workgroup_id;
   iree_hal_vec3_t workgroup_size;
   iree_hal_vec3_t workgroup_count;
   iree_hal_executable_push_constants_ptr_t push_constants;
   const iree_hal_executable_binding_ptr_t* bindings;
   const iree_device_size_t* binding_lengths;
+  // Worker-local scratch memory of at least the local memory size of the entry
+  // point being called (see iree_hal_local_executable_t::local_memory_sizes).
+  void* local_memory;
 } iree_hal_local_executable_call_t;
 
 typedef struct {
@@ -39,6 +44,16 @@ typedef struct {
   iree_allocator_t host_allocator;
   iree_host_size_t executable_layout_count;
   iree_hal_local_executable_layout_t** executable_layouts;
+  // Execution profiles of each entry point used to adaptively tile dispatches.
+  // Indexed by entry point ordinal.
+  iree_task_dispatch_profile_t* dispatch_profiles;
+  // Optional size in bytes of the worker-local memory required by each tile of
+  // each entry point. Indexed by entry point ordinal. NULL if no entry point
+  // requires any.
+  const uint32_t* local_memory_sizes;
+  // ISA extensions available on the host CPU the executable was loaded for.
+  // Passed to entry points so they can select specialized code paths.
+  iree_hal_executable_cpu_features_t cpu_features;
 } iree_hal_local_executable_t;
 
 typedef struct {
@@ -50,12 +65,15 @@ typedef struct {
 } iree_hal_local_executable_vtable_t;
 
 // Callers must allocate memory for |target_executable_layouts| with at least
-// `executable_layout_count * sizeof(*target_executable_layouts)` bytes.
+// `executable_layout_count * sizeof(*target_executable_layouts)` bytes and
+// |target_dispatch_profiles| with at least
+// `executable_layout_count * sizeof(*target_dispatch_profiles)` bytes.
 void iree_hal_local_executable_initialize(
     const iree_hal_local_executable_vtable_t* vtable,
     iree_host_size_t executable_layout_count,
     iree_hal_executable_layout_t* const* source_executable_layouts,
     iree_hal_local_executable_layout_t** target_executable_layouts,
+    iree_task_dispatch_profile_t* target_dispatch_profiles,
     iree_allocator_t host_allocator,
     iree_hal_local_executable_t* out_base_executable);
 
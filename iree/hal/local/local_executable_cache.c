@@ -14,12 +14,355 @@
 
 #include "iree/hal/local/local_executable_cache.h"
 
+#include "iree/base/internal/atomics.h"
+#include "iree/base/synchronization.h"
 #include "iree/base/tracing.h"
+#include "iree/hal/local/local_descriptor_set_layout.h"
+#include "iree/hal/local/local_executable_layout.h"
+
+// Loads |executable_spec| with the first of |loaders| that can handle it.
+static iree_status_t iree_hal_local_executable_cache_load(
+    iree_host_size_t loader_count, iree_hal_executable_loader_t** loaders,
+    const iree_hal_executable_spec_t* executable_spec,
+    iree_hal_executable_t** out_executable) {
+  for (iree_host_size_t i = 0; i < loader_count; ++i) {
+    if (iree_hal_executable_loader_query_support(
+            loaders[i], executable_spec->caching_mode,
+            executable_spec->executable_format)) {
+      return iree_hal_executable_loader_try_load(loaders[i], executable_spec,
+                                                 out_executable);
+    }
+    iree_status_t status = iree_hal_executable_loader_try_load(
+        loaders[i], executable_spec, out_executable);
+    if (iree_status_is_ok(status)) {
+      // Executable was successfully loaded.
+      return status;
+    } else if (!iree_status_is_cancelled(status)) {
+      // Error beyond just the try failing due to unsupported formats.
+      return status;
+    }
+  }
+  return iree_make_status(
+      IREE_STATUS_NOT_FOUND,
+      "no executable loader registered for the given file format");
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_local_executable_store_t
+//===----------------------------------------------------------------------===//
+
+// Caching mode bits that don't change how an executable is loaded from the
+// store: the store always loads from its own copy of the data.
+#define IREE_HAL_LOCAL_EXECUTABLE_STORE_IGNORED_CACHING_MODES \
+  IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA
+
+// An executable loaded from the store.
+// The key (layout signature and executable data) is stored inline after the
+// entry.
+typedef struct iree_hal_local_executable_store_entry_s {
+  struct iree_hal_local_executable_store_entry_s* next;
+  uint64_t hash;
+  iree_hal_executable_caching_mode_t caching_mode;
+  iree_hal_executable_format_t executable_format;
+  iree_host_size_t signature_length;
+  const uint32_t* signature;
+  iree_const_byte_span_t executable_data;
+  iree_hal_executable_t* executable;
+} iree_hal_local_executable_store_entry_t;
+
+struct iree_hal_local_executable_store_s {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+
+  iree_slim_mutex_t mutex;
+  // Singly-linked list of all loaded executables. Programs have tens to
+  // hundreds of executables and lookups only happen when preparing them.
+  iree_hal_local_executable_store_entry_t* entries IREE_GUARDED_BY(mutex);
+};
+
+iree_status_t iree_hal_local_executable_store_create(
+    iree_allocator_t host_allocator,
+    iree_hal_local_executable_store_t** out_executable_store) {
+  IREE_ASSERT_ARGUMENT(out_executable_store);
+  *out_executable_store = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_local_executable_store_t* executable_store = NULL;
+  iree_status_t status =
+      iree_allocator_malloc(host_allocator, sizeof(*executable_store),
+                            (void**)&executable_store);
+  if (iree_status_is_ok(status)) {
+    iree_atomic_ref_count_init(&executable_store->ref_count);
+    executable_store->host_allocator = host_allocator;
+    iree_slim_mutex_initialize(&executable_store->mutex);
+    executable_store->entries = NULL;
+    *out_executable_store = executable_store;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_local_executable_store_entry_free(
+    iree_allocator_t host_allocator,
+    iree_hal_local_executable_store_entry_t* entry) {
+  iree_hal_executable_release(entry->executable);
+  iree_allocator_free(host_allocator, entry);
+}
+
+static void iree_hal_local_executable_store_destroy(
+    iree_hal_local_executable_store_t* executable_store) {
+  iree_allocator_t host_allocator = executable_store->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_local_executable_store_entry_t* entry = executable_store->entries;
+  while (entry) {
+    iree_hal_local_executable_store_entry_t* next = entry->next;
+    iree_hal_local_executable_store_entry_free(host_allocator, entry);
+    entry = next;
+  }
+  iree_slim_mutex_deinitialize(&executable_store->mutex);
+  iree_allocator_free(host_allocator, executable_store);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+void iree_hal_local_executable_store_retain(
+    iree_hal_local_executable_store_t* executable_store) {
+  if (executable_store) {
+    iree_atomic_ref_count_inc(&executable_store->ref_count);
+  }
+}
+
+void iree_hal_local_executable_store_release(
+    iree_hal_local_executable_store_t* executable_store) {
+  if (executable_store &&
+      iree_atomic_ref_count_dec(&executable_store->ref_count) == 1) {
+    iree_hal_local_executable_store_destroy(executable_store);
+  }
+}
+
+void iree_hal_local_executable_store_trim(
+    iree_hal_local_executable_store_t* executable_store) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_slim_mutex_lock(&executable_store->mutex);
+  // New references to an entry can only be acquired from the store while
+  // holding the lock so an entry we hold the only reference to can't be
+  // revived while we free it.
+  iree_hal_local_executable_store_entry_t** entry_ptr =
+      &executable_store->entries;
+  while (*entry_ptr) {
+    iree_hal_local_executable_store_entry_t* entry = *entry_ptr;
+    iree_hal_resource_t* resource = (iree_hal_resource_t*)entry->executable;
+    if (iree_atomic_load_int32(&resource->ref_count,
+                               iree_memory_order_acquire) == 1) {
+      *entry_ptr = entry->next;
+      iree_hal_local_executable_store_entry_free(
+          executable_store->host_allocator, entry);
+    } else {
+      entry_ptr = &entry->next;
+    }
+  }
+  iree_slim_mutex_unlock(&executable_store->mutex);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Writes the structure of the executable layouts in |executable_spec| to
+// |signature| (if not NULL) and returns the number of words it requires.
+// Only the properties local executables observe are included so that
+// equivalent layouts created on different devices produce the same signature.
+static iree_host_size_t iree_hal_local_executable_store_make_signature(
+    const iree_hal_executable_spec_t* executable_spec, uint32_t* signature) {
+  iree_host_size_t length = 0;
+#define IREE_APPEND_SIGNATURE(value)                      \
+  do {                                                    \
+    if (signature) signature[length] = (uint32_t)(value); \
+    ++length;                                             \
+  } while (0)
+  IREE_APPEND_SIGNATURE(executable_spec->executable_layout_count);
+  for (iree_host_size_t i = 0; i < executable_spec->executable_layout_count;
+       ++i) {
+    iree_hal_local_executable_layout_t* executable_layout =
+        iree_hal_local_executable_layout_cast(
+            executable_spec->executable_layouts[i]);
+    IREE_APPEND_SIGNATURE(executable_layout->push_constants);
+    IREE_APPEND_SIGNATURE(executable_layout->set_layout_count);
+    for (iree_host_size_t j = 0; j < executable_layout->set_layout_count;
+         ++j) {
+      iree_hal_local_descriptor_set_layout_t* set_layout =
+          iree_hal_local_descriptor_set_layout_cast(
+              executable_layout->set_layouts[j]);
+      IREE_APPEND_SIGNATURE(set_layout->usage_type);
+      IREE_APPEND_SIGNATURE(set_layout->binding_count);
+      for (iree_host_size_t k = 0; k < set_layout->binding_count; ++k) {
+        IREE_APPEND_SIGNATURE(set_layout->bindings[k].binding);
+        IREE_APPEND_SIGNATURE(set_layout->bindings[k].type);
+        IREE_APPEND_SIGNATURE(set_layout->bindings[k].access);
+      }
+    }
+  }
+#undef IREE_APPEND_SIGNATURE
+  return length;
+}
+
+// FNV-1a; executables are hashed once per prepare request and any collisions
+// are resolved by comparing the full key.
+static uint64_t iree_hal_local_executable_store_hash(uint64_t hash,
+                                                    const void* data,
+                                                    iree_host_size_t length) {
+  const uint8_t* bytes = (const uint8_t*)data;
+  for (iree_host_size_t i = 0; i < length; ++i) {
+    hash ^= bytes[i];
+    hash *= 0x100000001B3ull;
+  }
+  return hash;
+}
+
+// Returns the entry matching the given key or NULL if not found.
+// Must be called with the store lock held.
+static iree_hal_local_executable_store_entry_t*
+iree_hal_local_executable_store_lookup(
+    iree_hal_local_executable_store_t* executable_store, uint64_t hash,
+    iree_hal_executable_caching_mode_t caching_mode,
+    iree_hal_executable_format_t executable_format,
+    iree_host_size_t signature_length, const uint32_t* signature,
+    iree_const_byte_span_t executable_data) {
+  for (iree_hal_local_executable_store_entry_t* entry =
+           executable_store->entries;
+       entry; entry = entry->next) {
+    if (entry->hash == hash && entry->caching_mode == caching_mode &&
+        entry->executable_format == executable_format &&
+        entry->signature_length == signature_length &&
+        entry->executable_data.data_length == executable_data.data_length &&
+        memcmp(entry->signature, signature,
+               signature_length * sizeof(*signature)) == 0 &&
+        memcmp(entry->executable_data.data, executable_data.data,
+               executable_data.data_length) == 0) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+// Returns a reference to the executable for |executable_spec|, loading it with
+// |loaders| if it is not yet present in |executable_store|.
+static iree_status_t iree_hal_local_executable_store_prepare(
+    iree_hal_local_executable_store_t* executable_store,
+    iree_host_size_t loader_count, iree_hal_executable_loader_t** loaders,
+    const iree_hal_executable_spec_t* executable_spec,
+    iree_hal_executable_t** out_executable) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Build the key and look it up against the caller's data first so that hits
+  // don't pay for copying the executable data.
+  iree_hal_executable_caching_mode_t caching_mode =
+      executable_spec->caching_mode &
+      ~IREE_HAL_LOCAL_EXECUTABLE_STORE_IGNORED_CACHING_MODES;
+  iree_hal_executable_format_t executable_format =
+      executable_spec->executable_format;
+  iree_host_size_t signature_length =
+      iree_hal_local_executable_store_make_signature(executable_spec, NULL);
+  uint32_t* signature =
+      (uint32_t*)iree_alloca(signature_length * sizeof(*signature));
+  iree_hal_local_executable_store_make_signature(executable_spec, signature);
+  uint64_t hash = 0xCBF29CE484222325ull;
+  hash = iree_hal_local_executable_store_hash(hash, &caching_mode,
+                                              sizeof(caching_mode));
+  hash = iree_hal_local_executable_store_hash(hash, &executable_format,
+                                              sizeof(executable_format));
+  hash = iree_hal_local_executable_store_hash(
+      hash, signature, signature_length * sizeof(*signature));
+  hash = iree_hal_local_executable_store_hash(
+      hash, executable_spec->executable_data.data,
+      executable_spec->executable_data.data_length);
+
+  iree_slim_mutex_lock(&executable_store->mutex);
+  iree_hal_local_executable_store_entry_t* existing_entry =
+      iree_hal_local_executable_store_lookup(
+          executable_store, hash, caching_mode, executable_format,
+          signature_length, signature, executable_spec->executable_data);
+  if (existing_entry) {
+    *out_executable = existing_entry->executable;
+    iree_hal_executable_retain(*out_executable);
+  }
+  iree_slim_mutex_unlock(&executable_store->mutex);
+  if (existing_entry) {
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, "hit");
+    IREE_TRACE_ZONE_END(z0);
+    return iree_ok_status();
+  }
+
+  // Allocate the entry with a copy of the key.
+  iree_hal_local_executable_store_entry_t* entry = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(
+              executable_store->host_allocator,
+              sizeof(*entry) + signature_length * sizeof(*entry->signature) +
+                  executable_spec->executable_data.data_length,
+              (void**)&entry));
+  uint32_t* entry_signature = (uint32_t*)((uint8_t*)entry + sizeof(*entry));
+  memcpy(entry_signature, signature, signature_length * sizeof(*signature));
+  uint8_t* executable_data = (uint8_t*)(entry_signature + signature_length);
+  memcpy(executable_data, executable_spec->executable_data.data,
+         executable_spec->executable_data.data_length);
+  entry->next = NULL;
+  entry->hash = hash;
+  entry->caching_mode = caching_mode;
+  entry->executable_format = executable_format;
+  entry->signature_length = signature_length;
+  entry->signature = entry_signature;
+  entry->executable_data = iree_make_const_byte_span(
+      executable_data, executable_spec->executable_data.data_length);
+  entry->executable = NULL;
+
+  // Load outside of the lock so that unrelated executables can be loaded
+  // concurrently. The executable is loaded from the copy of the data owned by
+  // the entry so that it may outlive the data provided by the caller.
+  iree_hal_executable_spec_t load_spec = *executable_spec;
+  load_spec.caching_mode |=
+      IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA;
+  load_spec.executable_data = entry->executable_data;
+  iree_status_t status = iree_hal_local_executable_cache_load(
+      loader_count, loaders, &load_spec, &entry->executable);
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(executable_store->host_allocator, entry);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  // Another thread may have loaded the same executable while we were; use
+  // whichever was inserted first so that all callers share one.
+  iree_slim_mutex_lock(&executable_store->mutex);
+  existing_entry = iree_hal_local_executable_store_lookup(
+      executable_store, hash, caching_mode, executable_format,
+      signature_length, signature, entry->executable_data);
+  if (existing_entry) {
+    *out_executable = existing_entry->executable;
+  } else {
+    entry->next = executable_store->entries;
+    executable_store->entries = entry;
+    *out_executable = entry->executable;
+  }
+  iree_hal_executable_retain(*out_executable);
+  iree_slim_mutex_unlock(&executable_store->mutex);
+  if (existing_entry) {
+    iree_hal_local_executable_store_entry_free(
+        executable_store->host_allocator, entry);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_local_executable_cache_t
+//===----------------------------------------------------------------------===//
 
 typedef struct {
   iree_hal_resource_t resource;
   iree_allocator_t host_allocator;
   iree_string_view_t identifier;
+  iree_hal_local_executable_store_t* executable_store;
   iree_host_size_t loader_count;
   iree_hal_executable_loader_t* loaders[];
 } iree_hal_local_executable_cache_t;
@@ -35,7 +378,9 @@ static iree_hal_local_executable_cache_t* iree_hal_local_executable_cache_cast(
 
 iree_status_t iree_hal_local_executable_cache_create(
     iree_string_view_t identifier, iree_host_size_t loader_count,
-    iree_hal_executable_loader_t** loaders, iree_allocator_t host_allocator,
+    iree_hal_executable_loader_t** loaders,
+    iree_hal_local_executable_store_t* executable_store,
+    iree_allocator_t host_allocator,
     iree_hal_executable_cache_t** out_executable_cache) {
   IREE_ASSERT_ARGUMENT(!loader_count || loaders);
   IREE_ASSERT_ARGUMENT(out_executable_cache);
@@ -57,6 +402,9 @@ iree_status_t iree_hal_local_executable_cache_create(
         identifier, &executable_cache->identifier,
         (char*)executable_cache + total_size - identifier.size);
 
+    executable_cache->executable_store = executable_store;
+    iree_hal_local_executable_store_retain(executable_cache->executable_store);
+
     executable_cache->loader_count = loader_count;
     for (iree_host_size_t i = 0; i < executable_cache->loader_count; ++i) {
       executable_cache->loaders[i] = loaders[i];
@@ -80,6 +428,13 @@ static void iree_hal_local_executable_cache_destroy(
   for (iree_host_size_t i = 0; i < executable_cache->loader_count; ++i) {
     iree_hal_executable_loader_release(executable_cache->loaders[i]);
   }
+  if (executable_cache->executable_store) {
+    // Drop any executables only the store is keeping alive; users of the cache
+    // may have been the last ones referencing them.
+    iree_hal_local_executable_store_trim(executable_cache->executable_store);
+    iree_hal_local_executable_store_release(
+        executable_cache->executable_store);
+  }
   iree_allocator_free(host_allocator, executable_cache);
 
   IREE_TRACE_ZONE_END(z0);
@@ -106,26 +461,14 @@ static iree_status_t iree_hal_local_executable_cache_prepare_executable(
     iree_hal_executable_t** out_executable) {
   iree_hal_local_executable_cache_t* executable_cache =
       iree_hal_local_executable_cache_cast(base_executable_cache);
-  for (iree_host_size_t i = 0; i < executable_cache->loader_count; ++i) {
-    if (iree_hal_executable_loader_query_support(
-            executable_cache->loaders[i], executable_spec->caching_mode,
-            executable_spec->executable_format)) {
-      return iree_hal_executable_loader_try_load(
-          executable_cache->loaders[i], executable_spec, out_executable);
-    }
-    iree_status_t status = iree_hal_executable_loader_try_load(
-        executable_cache->loaders[i], executable_spec, out_executable);
-    if (iree_status_is_ok(status)) {
-      // Executable was successfully loaded.
-      return status;
-    } else if (!iree_status_is_cancelled(status)) {
-      // Error beyond just the try failing due to unsupported formats.
-      return status;
-    }
+  if (executable_cache->executable_store) {
+    return iree_hal_local_executable_store_prepare(
+        executable_cache->executable_store, executable_cache->loader_count,
+        executable_cache->loaders, executable_spec, out_executable);
   }
-  return iree_make_status(
-      IREE_STATUS_NOT_FOUND,
-      "no executable loader registered for the given file format");
+  return iree_hal_local_executable_cache_load(executable_cache->loader_count,
+                                              executable_cache->loaders,
+                                              executable_spec, out_executable);
 }
 
 static const iree_hal_executable_cache_vtable_t
@@ -23,17 +23,62 @@
 extern "C" {
 #endif  // __cplusplus
 
-// TODO(benvanik): when we refactor executable caches this can become something
-// more specialized; like nop_executable_cache (does nothing but pass through)
-// or inproc_lru_executable_cache (simple in-memory LRU of recent executables).
+//===----------------------------------------------------------------------===//
+// iree_hal_local_executable_store_t
+//===----------------------------------------------------------------------===//
+
+// A table of loaded executables shared by any number of executable caches.
+// Preparing an executable that has already been loaded through any cache using
+// the store returns a new reference to the existing executable instead of
+// loading (and, for library-based formats, dlopen'ing) it again.
+//
+// Executables are keyed by a hash of their data, format, caching mode, and the
+// structure (not the identity) of their executable layouts. Local executable
+// layouts are just host data and executables loaded on one device can be
+// shared with any other device using the same loaders. The store keeps its own
+// copy of the executable data so that shared executables never alias memory
+// owned by whichever caller happened to prepare them first.
+//
+// Executables remain in the store until the store is the only thing
+// referencing them and a cache using it is destroyed.
 //
-// We can also set this up so they share storage. Ideally a JIT'ed executable in
-// one device is the same JIT'ed executable in another, and in multi-tenant
-// situations we're likely to want that isolation _and_ sharing.
+// Thread-safe.
+typedef struct iree_hal_local_executable_store_s
+    iree_hal_local_executable_store_t;
+
+// Creates a new empty executable store.
+iree_status_t iree_hal_local_executable_store_create(
+    iree_allocator_t host_allocator,
+    iree_hal_local_executable_store_t** out_executable_store);
+
+// Retains the given |executable_store| for the caller.
+void iree_hal_local_executable_store_retain(
+    iree_hal_local_executable_store_t* executable_store);
 
+// Releases the given |executable_store| from the caller.
+void iree_hal_local_executable_store_release(
+    iree_hal_local_executable_store_t* executable_store);
+
+// Releases all executables that are no longer referenced outside of the store.
+void iree_hal_local_executable_store_trim(
+    iree_hal_local_executable_store_t* executable_store);
+
+//===----------------------------------------------------------------------===//
+// iree_hal_local_executable_cache_t
+//===----------------------------------------------------------------------===//
+
+// Creates an executable cache that loads executables with the first of
+// |loaders| supporting their format.
+//
+// If |executable_store| is provided then executables are deduplicated against
+// all other caches using the same store. All caches sharing a store must use
+// the same set of loaders. If omitted every prepare request loads a new
+// executable.
 iree_status_t iree_hal_local_executable_cache_create(
     iree_string_view_t identifier, iree_host_size_t loader_count,
-    iree_hal_executable_loader_t** loaders, iree_allocator_t host_allocator,
+    iree_hal_executable_loader_t** loaders,
+    iree_hal_local_executable_store_t* executable_store,
+    iree_allocator_t host_allocator,
     iree_hal_executable_cache_t** out_executable_cache);
 
 #ifdef __cplusplus
@@ -0,0 +1,336 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/hal/local/local_executable_cache.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/local_descriptor_set_layout.h"
+#include "iree/hal/local/local_executable.h"
+#include "iree/hal/local/local_executable_layout.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+//===----------------------------------------------------------------------===//
+// Fake executable and loader
+//===----------------------------------------------------------------------===//
+
+// Counters shared by the fake loader and the executables it produces.
+struct LoaderCounters {
+  std::atomic<int> loads{0};
+  std::atomic<int> destroys{0};
+};
+
+struct FakeExecutable {
+  iree_hal_local_executable_t base;
+  iree_hal_local_executable_layout_t* layouts[1];
+  iree_task_dispatch_profile_t profiles[1];
+  LoaderCounters* counters;
+};
+
+static void FakeExecutableDestroy(iree_hal_executable_t* base_executable) {
+  FakeExecutable* executable =
+      reinterpret_cast<FakeExecutable*>(base_executable);
+  ++executable->counters->destroys;
+  iree_hal_local_executable_deinitialize(&executable->base);
+  delete executable;
+}
+
+static iree_status_t FakeExecutableIssueCall(
+    iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
+    const iree_hal_local_executable_call_t* call) {
+  return iree_ok_status();
+}
+
+static const iree_hal_local_executable_vtable_t kFakeExecutableVTable = {
+    /*.base=*/{
+        /*.destroy=*/FakeExecutableDestroy,
+    },
+    /*.issue_call=*/FakeExecutableIssueCall,
+};
+
+struct FakeLoader {
+  iree_hal_executable_loader_t base;
+  LoaderCounters* counters;
+};
+
+static void FakeLoaderDestroy(iree_hal_executable_loader_t* base_loader) {
+  delete reinterpret_cast<FakeLoader*>(base_loader);
+}
+
+static bool FakeLoaderQuerySupport(
+    iree_hal_executable_loader_t* base_loader,
+    iree_hal_executable_caching_mode_t caching_mode,
+    iree_hal_executable_format_t executable_format) {
+  return executable_format == iree_hal_make_executable_format("FAKE");
+}
+
+static iree_status_t FakeLoaderTryLoad(
+    iree_hal_executable_loader_t* base_loader,
+    const iree_hal_executable_spec_t* executable_spec,
+    iree_hal_executable_t** out_executable) {
+  FakeLoader* loader = reinterpret_cast<FakeLoader*>(base_loader);
+  ++loader->counters->loads;
+  FakeExecutable* executable = new FakeExecutable();
+  executable->counters = loader->counters;
+  iree_hal_local_executable_initialize(
+      &kFakeExecutableVTable, executable_spec->executable_layout_count,
+      executable_spec->executable_layouts, executable->layouts,
+      executable->profiles, iree_allocator_system(), &executable->base);
+  *out_executable = reinterpret_cast<iree_hal_executable_t*>(executable);
+  return iree_ok_status();
+}
+
+static const iree_hal_executable_loader_vtable_t kFakeLoaderVTable = {
+    /*.destroy=*/FakeLoaderDestroy,
+    /*.query_support=*/FakeLoaderQuerySupport,
+    /*.try_load=*/FakeLoaderTryLoad,
+};
+
+// Counts the allocations made through it in the std::atomic<int> |self| and
+// forwards them to the system allocator.
+static iree_status_t CountingAlloc(void* self, iree_allocation_mode_t mode,
+                                   iree_host_size_t byte_length,
+                                   void** out_ptr) {
+  ++*static_cast<std::atomic<int>*>(self);
+  return iree_allocator_system().alloc(NULL, mode, byte_length, out_ptr);
+}
+
+static void CountingFree(void* self, void* ptr) {
+  iree_allocator_system().free(NULL, ptr);
+}
+
+//===----------------------------------------------------------------------===//
+// Tests
+//===----------------------------------------------------------------------===//
+
+class LocalExecutableStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    FakeLoader* loader = new FakeLoader();
+    loader->counters = &counters_;
+    iree_hal_executable_loader_initialize(&kFakeLoaderVTable, &loader->base);
+    loader_ = &loader->base;
+    iree_allocator_t store_allocator = {&store_allocations_, CountingAlloc,
+                                        CountingFree};
+    IREE_ASSERT_OK(
+        iree_hal_local_executable_store_create(store_allocator, &store_));
+  }
+
+  void TearDown() override {
+    iree_hal_local_executable_store_release(store_);
+    iree_hal_executable_loader_release(loader_);
+  }
+
+  // Creates a cache sharing the test store; each one models a device.
+  iree_hal_executable_cache_t* CreateCache() {
+    iree_hal_executable_cache_t* cache = NULL;
+    IREE_CHECK_OK(iree_hal_local_executable_cache_create(
+        iree_make_cstring_view("test"), 1, &loader_, store_,
+        iree_allocator_system(), &cache));
+    return cache;
+  }
+
+  // Creates a layout with one set of |binding_count| storage buffers.
+  static iree_hal_executable_layout_t* CreateLayout(
+      iree_host_size_t binding_count) {
+    std::vector<iree_hal_descriptor_set_layout_binding_t> bindings(
+        binding_count);
+    for (iree_host_size_t i = 0; i < binding_count; ++i) {
+      bindings[i].binding = (uint32_t)i;
+      bindings[i].type = IREE_HAL_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      bindings[i].access = IREE_HAL_MEMORY_ACCESS_ALL;
+    }
+    iree_hal_descriptor_set_layout_t* set_layout = NULL;
+    IREE_CHECK_OK(iree_hal_local_descriptor_set_layout_create(
+        IREE_HAL_DESCRIPTOR_SET_LAYOUT_USAGE_TYPE_IMMUTABLE, binding_count,
+        bindings.data(), iree_allocator_system(), &set_layout));
+    iree_hal_executable_layout_t* executable_layout = NULL;
+    IREE_CHECK_OK(iree_hal_local_executable_layout_create(
+        /*push_constants=*/4, 1, &set_layout, iree_allocator_system(),
+        &executable_layout));
+    iree_hal_descriptor_set_layout_release(set_layout);
+    return executable_layout;
+  }
+
+  static iree_status_t Prepare(iree_hal_executable_cache_t* cache,
+                               iree_hal_executable_layout_t* layout,
+                               const std::vector<uint8_t>& data,
+                               iree_hal_executable_t** out_executable) {
+    iree_hal_executable_spec_t spec;
+    iree_hal_executable_spec_initialize(&spec);
+    spec.executable_format = iree_hal_make_executable_format("FAKE");
+    spec.executable_data = iree_make_const_byte_span(data.data(), data.size());
+    spec.executable_layout_count = 1;
+    spec.executable_layouts = &layout;
+    return iree_hal_executable_cache_prepare_executable(cache, &spec,
+                                                        out_executable);
+  }
+
+  LoaderCounters counters_;
+  std::atomic<int> store_allocations_{0};
+  iree_hal_executable_loader_t* loader_ = NULL;
+  iree_hal_local_executable_store_t* store_ = NULL;
+};
+
+// Identical data prepared through two caches with distinct but structurally
+// equal layouts loads once and returns the same executable.
+TEST_F(LocalExecutableStoreTest, HitWithEqualLayouts) {
+  iree_hal_executable_cache_t* cache_a = CreateCache();
+  iree_hal_executable_cache_t* cache_b = CreateCache();
+  iree_hal_executable_layout_t* layout_a = CreateLayout(2);
+  iree_hal_executable_layout_t* layout_b = CreateLayout(2);
+  std::vector<uint8_t> data(1000, 7);
+
+  iree_hal_executable_t* executable_a = NULL;
+  IREE_ASSERT_OK(Prepare(cache_a, layout_a, data, &executable_a));
+  EXPECT_EQ(1, counters_.loads);
+  // Mutating the caller's copy must not affect the key of the stored entry.
+  std::vector<uint8_t> data_copy = data;
+  data.assign(data.size(), 0);
+  iree_hal_executable_t* executable_b = NULL;
+  IREE_ASSERT_OK(Prepare(cache_b, layout_b, data_copy, &executable_b));
+  EXPECT_EQ(1, counters_.loads);
+  EXPECT_EQ(executable_a, executable_b);
+
+  iree_hal_executable_release(executable_a);
+  iree_hal_executable_release(executable_b);
+  iree_hal_executable_layout_release(layout_a);
+  iree_hal_executable_layout_release(layout_b);
+  iree_hal_executable_cache_release(cache_a);
+  iree_hal_executable_cache_release(cache_b);
+  EXPECT_EQ(1, counters_.destroys);
+}
+
+// Hits are found without the store allocating an entry or copying the data.
+TEST_F(LocalExecutableStoreTest, HitDoesNotAllocate) {
+  iree_hal_executable_cache_t* cache = CreateCache();
+  iree_hal_executable_layout_t* layout = CreateLayout(2);
+  std::vector<uint8_t> data(1000, 7);
+
+  iree_hal_executable_t* executable_a = NULL;
+  IREE_ASSERT_OK(Prepare(cache, layout, data, &executable_a));
+  int miss_allocations = store_allocations_;
+  EXPECT_GT(miss_allocations, 0);
+  iree_hal_executable_t* executable_b = NULL;
+  IREE_ASSERT_OK(Prepare(cache, layout, data, &executable_b));
+  EXPECT_EQ(miss_allocations, store_allocations_);
+  EXPECT_EQ(executable_a, executable_b);
+  EXPECT_EQ(1, counters_.loads);
+
+  iree_hal_executable_release(executable_a);
+  iree_hal_executable_release(executable_b);
+  iree_hal_executable_layout_release(layout);
+  iree_hal_executable_cache_release(cache);
+}
+
+// The same data with a structurally different layout or different data with
+// the same layout are loaded separately.
+TEST_F(LocalExecutableStoreTest, MissWithDifferentLayoutOrData) {
+  iree_hal_executable_cache_t* cache = CreateCache();
+  iree_hal_executable_layout_t* layout_2 = CreateLayout(2);
+  iree_hal_executable_layout_t* layout_3 = CreateLayout(3);
+  std::vector<uint8_t> data(1000, 7);
+  std::vector<uint8_t> other_data = data;
+  other_data.back() = 8;
+
+  iree_hal_executable_t* executable_0 = NULL;
+  IREE_ASSERT_OK(Prepare(cache, layout_2, data, &executable_0));
+  iree_hal_executable_t* executable_1 = NULL;
+  IREE_ASSERT_OK(Prepare(cache, layout_3, data, &executable_1));
+  EXPECT_EQ(2, counters_.loads);
+  EXPECT_NE(executable_0, executable_1);
+  iree_hal_executable_t* executable_2 = NULL;
+  IREE_ASSERT_OK(Prepare(cache, layout_2, other_data, &executable_2));
+  EXPECT_EQ(3, counters_.loads);
+  EXPECT_NE(executable_0, executable_2);
+
+  iree_hal_executable_release(executable_0);
+  iree_hal_executable_release(executable_1);
+  iree_hal_executable_release(executable_2);
+  iree_hal_executable_layout_release(layout_2);
+  iree_hal_executable_layout_release(layout_3);
+  iree_hal_executable_cache_release(cache);
+  EXPECT_EQ(3, counters_.destroys);
+}
+
+// Trimming releases only executables the store holds the last reference to.
+TEST_F(LocalExecutableStoreTest, TrimKeepsReferencedExecutables) {
+  iree_hal_executable_cache_t* cache = CreateCache();
+  iree_hal_executable_layout_t* layout = CreateLayout(2);
+  std::vector<uint8_t> live_data(100, 1);
+  std::vector<uint8_t> dead_data(100, 2);
+
+  iree_hal_executable_t* live_executable = NULL;
+  IREE_ASSERT_OK(Prepare(cache, layout, live_data, &live_executable));
+  iree_hal_executable_t* dead_executable = NULL;
+  IREE_ASSERT_OK(Prepare(cache, layout, dead_data, &dead_executable));
+  iree_hal_executable_release(dead_executable);
+  EXPECT_EQ(0, counters_.destroys);
+
+  iree_hal_local_executable_store_trim(store_);
+  EXPECT_EQ(1, counters_.destroys);
+
+  // The live executable is still cached; the trimmed one must be reloaded.
+  iree_hal_executable_t* executable = NULL;
+  IREE_ASSERT_OK(Prepare(cache, layout, live_data, &executable));
+  EXPECT_EQ(live_executable, executable);
+  EXPECT_EQ(2, counters_.loads);
+  iree_hal_executable_release(executable);
+  IREE_ASSERT_OK(Prepare(cache, layout, dead_data, &executable));
+  EXPECT_EQ(3, counters_.loads);
+  iree_hal_executable_release(executable);
+
+  iree_hal_executable_release(live_executable);
+  iree_hal_executable_layout_release(layout);
+  iree_hal_executable_cache_release(cache);
+  EXPECT_EQ(3, counters_.destroys);
+}
+
+// Concurrent prepares of the same executable all receive one instance. Racing
+// loads may happen but the losers must be discarded.
+TEST_F(LocalExecutableStoreTest, ConcurrentPrepare) {
+  static const int kThreadCount = 8;
+  iree_hal_executable_cache_t* caches[2] = {CreateCache(), CreateCache()};
+  iree_hal_executable_layout_t* layout = CreateLayout(2);
+  std::vector<uint8_t> data(5000, 3);
+
+  std::vector<iree_hal_executable_t*> executables(kThreadCount);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreadCount; ++i) {
+    threads.emplace_back([&, i]() {
+      IREE_CHECK_OK(Prepare(caches[i % 2], layout, data, &executables[i]));
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (auto* executable : executables) {
+    EXPECT_EQ(executables[0], executable);
+  }
+  EXPECT_GE(counters_.loads, 1);
+  EXPECT_EQ(counters_.loads - 1, counters_.destroys);
+
+  for (auto* executable : executables) iree_hal_executable_release(executable);
+  iree_hal_executable_layout_release(layout);
+  iree_hal_executable_cache_release(caches[0]);
+  iree_hal_executable_cache_release(caches[1]);
+  EXPECT_EQ(counters_.loads, counters_.destroys);
+}
+
+}  // namespace
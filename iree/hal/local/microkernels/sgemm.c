@@ -0,0 +1,238 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/hal/local/microkernels/sgemm.h"
+
+#include "iree/base/alignment.h"
+#include "iree/hal/local/microkernels/sgemm_kernels.h"
+
+// Packing block sizes. A |MC|x|KC| block of lhs and a |KC|x|NC| block of rhs
+// are packed at a time such that the lhs panel of one register block and the
+// whole rhs block stay resident in L1 and L2 respectively while the kernel
+// streams over them. MC and NC are multiples of every kernel's MR and NR so
+// that the zero-padded edge panels always fit in the packing buffers.
+#define IREE_MICROKERNEL_SGEMM_MC 48
+#define IREE_MICROKERNEL_SGEMM_NC 64
+#define IREE_MICROKERNEL_SGEMM_KC 128
+
+//===----------------------------------------------------------------------===//
+// Generic kernel
+//===----------------------------------------------------------------------===//
+
+static void iree_microkernel_sgemm_tile_generic(int64_t k, const float* lhs,
+                                                const float* rhs,
+                                                float* tile) {
+  float acc[4][4] = {{0.0f}};
+  for (int64_t p = 0; p < k; ++p) {
+    for (int i = 0; i < 4; ++i) {
+      for (int j = 0; j < 4; ++j) {
+        acc[i][j] += lhs[i] * rhs[j];
+      }
+    }
+    lhs += 4;
+    rhs += 4;
+  }
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      tile[i * 4 + j] = acc[i][j];
+    }
+  }
+}
+
+const iree_microkernel_sgemm_kernel_t iree_microkernel_sgemm_kernel_generic = {
+    4,
+    4,
+    iree_microkernel_sgemm_tile_generic,
+};
+
+//===----------------------------------------------------------------------===//
+// Instruction set selection
+//===----------------------------------------------------------------------===//
+
+bool iree_microkernel_isa_is_supported(iree_microkernel_isa_t isa) {
+  switch (isa) {
+    case IREE_MICROKERNEL_ISA_AUTO:
+    case IREE_MICROKERNEL_ISA_GENERIC:
+      return true;
+#if defined(IREE_ARCH_X86_64)
+    case IREE_MICROKERNEL_ISA_X86_64_AVX2_FMA:
+      return iree_microkernel_x86_64_has_avx2_fma();
+    case IREE_MICROKERNEL_ISA_X86_64_AVX512F:
+      return iree_microkernel_x86_64_has_avx512f();
+#elif defined(IREE_ARCH_ARM_64)
+    case IREE_MICROKERNEL_ISA_ARM_64_NEON:
+      return true;
+#endif  // IREE_ARCH_*
+    default:
+      return false;
+  }
+}
+
+static const iree_microkernel_sgemm_kernel_t* iree_microkernel_sgemm_select(
+    iree_microkernel_isa_t isa) {
+  switch (isa) {
+#if defined(IREE_ARCH_X86_64)
+    case IREE_MICROKERNEL_ISA_AUTO:
+      if (iree_microkernel_x86_64_has_avx512f()) {
+        return &iree_microkernel_sgemm_kernel_x86_64_avx512f;
+      } else if (iree_microkernel_x86_64_has_avx2_fma()) {
+        return &iree_microkernel_sgemm_kernel_x86_64_avx2_fma;
+      }
+      return &iree_microkernel_sgemm_kernel_generic;
+    case IREE_MICROKERNEL_ISA_X86_64_AVX2_FMA:
+      return &iree_microkernel_sgemm_kernel_x86_64_avx2_fma;
+    case IREE_MICROKERNEL_ISA_X86_64_AVX512F:
+      return &iree_microkernel_sgemm_kernel_x86_64_avx512f;
+#elif defined(IREE_ARCH_ARM_64)
+    case IREE_MICROKERNEL_ISA_AUTO:
+    case IREE_MICROKERNEL_ISA_ARM_64_NEON:
+      return &iree_microkernel_sgemm_kernel_arm_64_neon;
+#endif  // IREE_ARCH_*
+    default:
+      return &iree_microkernel_sgemm_kernel_generic;
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Packing
+//===----------------------------------------------------------------------===//
+
+// Packs the |mc|x|kc| block of |lhs| into panels of |mr| rows stored
+// column-by-column. Rows past |mc| in the last panel are zero-filled.
+static void iree_microkernel_sgemm_pack_lhs(int64_t mc, int64_t kc, int mr,
+                                            const float* lhs, int64_t stride0,
+                                            int64_t stride1, float* packed) {
+  for (int64_t i0 = 0; i0 < mc; i0 += mr) {
+    const int64_t rows = mc - i0 < mr ? mc - i0 : mr;
+    for (int64_t p = 0; p < kc; ++p) {
+      const float* src = lhs + i0 * stride0 + p * stride1;
+      int64_t i = 0;
+      for (; i < rows; ++i) packed[i] = src[i * stride0];
+      for (; i < mr; ++i) packed[i] = 0.0f;
+      packed += mr;
+    }
+  }
+}
+
+// Packs the |kc|x|nc| block of |rhs| into panels of |nr| columns stored
+// row-by-row. Columns past |nc| in the last panel are zero-filled.
+static void iree_microkernel_sgemm_pack_rhs(int64_t kc, int64_t nc, int nr,
+                                            const float* rhs, int64_t stride0,
+                                            int64_t stride1, float* packed) {
+  for (int64_t j0 = 0; j0 < nc; j0 += nr) {
+    const int64_t cols = nc - j0 < nr ? nc - j0 : nr;
+    for (int64_t p = 0; p < kc; ++p) {
+      const float* src = rhs + p * stride0 + j0 * stride1;
+      int64_t j = 0;
+      for (; j < cols; ++j) packed[j] = src[j * stride1];
+      for (; j < nr; ++j) packed[j] = 0.0f;
+      packed += nr;
+    }
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// SGEMM
+//===----------------------------------------------------------------------===//
+
+_Static_assert((IREE_MICROKERNEL_SGEMM_MC * IREE_MICROKERNEL_SGEMM_KC +
+                IREE_MICROKERNEL_SGEMM_KC * IREE_MICROKERNEL_SGEMM_NC) *
+                       sizeof(float) <=
+                   IREE_MICROKERNEL_SGEMM_WORKSPACE_SIZE,
+               "packing blocks must fit in the declared workspace");
+
+void iree_microkernel_sgemm_with_workspace(
+    iree_microkernel_isa_t isa, int64_t m, int64_t n, int64_t k,
+    const float* lhs, int64_t lhs_stride0, int64_t lhs_stride1,
+    const float* rhs, int64_t rhs_stride0, int64_t rhs_stride1, float* out,
+    int64_t out_stride0, int64_t out_stride1, void* workspace) {
+  const iree_microkernel_sgemm_kernel_t* kernel =
+      iree_microkernel_sgemm_select(isa);
+  const int mr = kernel->mr;
+  const int nr = kernel->nr;
+
+  float* packed_lhs = (float*)workspace;
+  float* packed_rhs =
+      packed_lhs + IREE_MICROKERNEL_SGEMM_MC * IREE_MICROKERNEL_SGEMM_KC;
+  iree_alignas(64) float tile[IREE_MICROKERNEL_SGEMM_MAX_MR *
+                              IREE_MICROKERNEL_SGEMM_MAX_NR];
+
+  for (int64_t j0 = 0; j0 < n; j0 += IREE_MICROKERNEL_SGEMM_NC) {
+    const int64_t nc =
+        n - j0 < IREE_MICROKERNEL_SGEMM_NC ? n - j0 : IREE_MICROKERNEL_SGEMM_NC;
+    for (int64_t p0 = 0; p0 < k; p0 += IREE_MICROKERNEL_SGEMM_KC) {
+      const int64_t kc = k - p0 < IREE_MICROKERNEL_SGEMM_KC
+                             ? k - p0
+                             : IREE_MICROKERNEL_SGEMM_KC;
+      iree_microkernel_sgemm_pack_rhs(
+          kc, nc, nr, rhs + p0 * rhs_stride0 + j0 * rhs_stride1, rhs_stride0,
+          rhs_stride1, packed_rhs);
+      for (int64_t i0 = 0; i0 < m; i0 += IREE_MICROKERNEL_SGEMM_MC) {
+        const int64_t mc = m - i0 < IREE_MICROKERNEL_SGEMM_MC
+                               ? m - i0
+                               : IREE_MICROKERNEL_SGEMM_MC;
+        iree_microkernel_sgemm_pack_lhs(
+            mc, kc, mr, lhs + i0 * lhs_stride0 + p0 * lhs_stride1,
+            lhs_stride0, lhs_stride1, packed_lhs);
+        for (int64_t j1 = 0; j1 < nc; j1 += nr) {
+          const int64_t cols = nc - j1 < nr ? nc - j1 : nr;
+          for (int64_t i1 = 0; i1 < mc; i1 += mr) {
+            const int64_t rows = mc - i1 < mr ? mc - i1 : mr;
+            kernel->tile(kc, packed_lhs + i1 * kc, packed_rhs + j1 * kc, tile);
+            float* dst =
+                out + (i0 + i1) * out_stride0 + (j0 + j1) * out_stride1;
+            for (int64_t i = 0; i < rows; ++i) {
+              for (int64_t j = 0; j < cols; ++j) {
+                dst[i * out_stride0 + j * out_stride1] += tile[i * nr + j];
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+void iree_microkernel_sgemm(iree_microkernel_isa_t isa, int64_t m, int64_t n,
+                            int64_t k, const float* lhs, int64_t lhs_stride0,
+                            int64_t lhs_stride1, const float* rhs,
+                            int64_t rhs_stride0, int64_t rhs_stride1,
+                            float* out, int64_t out_stride0,
+                            int64_t out_stride1) {
+  iree_alignas(64) uint8_t workspace[IREE_MICROKERNEL_SGEMM_WORKSPACE_SIZE];
+  iree_microkernel_sgemm_with_workspace(
+      isa, m, n, k, lhs, lhs_stride0, lhs_stride1, rhs, rhs_stride0,
+      rhs_stride1, out, out_stride0, out_stride1, workspace);
+}
+
+void iree_microkernel_linalg_matmul_f32(
+    float* lhs_allocated, float* lhs_aligned, int64_t lhs_offset,
+    int64_t lhs_size0, int64_t lhs_size1, int64_t lhs_stride0,
+    int64_t lhs_stride1, float* rhs_allocated, float* rhs_aligned,
+    int64_t rhs_offset, int64_t rhs_size0, int64_t rhs_size1,
+    int64_t rhs_stride0, int64_t rhs_stride1, float* out_allocated,
+    float* out_aligned, int64_t out_offset, int64_t out_size0,
+    int64_t out_size1, int64_t out_stride0, int64_t out_stride1) {
+  (void)lhs_allocated;
+  (void)rhs_allocated;
+  (void)rhs_size0;
+  (void)out_allocated;
+  (void)out_size0;
+  (void)out_size1;
+  iree_microkernel_sgemm(IREE_MICROKERNEL_ISA_AUTO, lhs_size0, rhs_size1,
+                         lhs_size1, lhs_aligned + lhs_offset, lhs_stride0,
+                         lhs_stride1, rhs_aligned + rhs_offset, rhs_stride0,
+                         rhs_stride1, out_aligned + out_offset, out_stride0,
+                         out_stride1);
+}
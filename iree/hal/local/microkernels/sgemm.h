@@ -0,0 +1,114 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef IREE_HAL_LOCAL_MICROKERNELS_SGEMM_H_
+#define IREE_HAL_LOCAL_MICROKERNELS_SGEMM_H_
+
+// NOTE: this library is linked into the executables produced by the LLVM AOT
+// compiler backend (see --iree-llvm-microkernel-library) and must not take any
+// dependencies on the runtime HAL code or on system libraries beyond the
+// memset/memcpy compilers may emit. Changes to the entry points called by
+// generated code must be made along with the compiler.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//===----------------------------------------------------------------------===//
+// Instruction set selection
+//===----------------------------------------------------------------------===//
+
+// Instruction set used by the register-blocked inner kernel.
+enum iree_microkernel_isa_e {
+  // Selects the best instruction set supported by the executing CPU.
+  IREE_MICROKERNEL_ISA_AUTO = 0u,
+  // Portable C available on all targets.
+  IREE_MICROKERNEL_ISA_GENERIC = 1u,
+  // x86-64 AVX2 with FMA3 using a 6x16 register block.
+  IREE_MICROKERNEL_ISA_X86_64_AVX2_FMA = 2u,
+  // x86-64 AVX-512F using an 8x32 register block.
+  IREE_MICROKERNEL_ISA_X86_64_AVX512F = 3u,
+  // AArch64 NEON using an 8x8 register block.
+  IREE_MICROKERNEL_ISA_ARM_64_NEON = 4u,
+};
+typedef uint32_t iree_microkernel_isa_t;
+
+// Returns true if |isa| is compiled into the library and supported by the
+// executing CPU. IREE_MICROKERNEL_ISA_AUTO is always supported.
+bool iree_microkernel_isa_is_supported(iree_microkernel_isa_t isa);
+
+//===----------------------------------------------------------------------===//
+// Single-precision GEMM
+//===----------------------------------------------------------------------===//
+
+// Size in bytes of the workspace used to pack blocks of the operands.
+#define IREE_MICROKERNEL_SGEMM_WORKSPACE_SIZE (56 * 1024)
+
+// Computes |out| += |lhs| * |rhs| where |lhs| is an |m|x|k| matrix, |rhs| is a
+// |k|x|n| matrix, and |out| is an |m|x|n| matrix of floats. Each matrix is
+// addressed by its row and column strides in elements so that views into
+// larger matrices can be used directly.
+//
+// Blocks of |lhs| and |rhs| are packed into contiguous panels in |workspace|
+// and multiplied with the register-blocked kernel of |isa|, which must be
+// supported (see iree_microkernel_isa_is_supported). |workspace| must be at
+// least IREE_MICROKERNEL_SGEMM_WORKSPACE_SIZE bytes aligned to a float and its
+// contents are undefined on return. Executables using the v1 library interface
+// can declare the size as the local memory of their entry points and pass it
+// through from the dispatch.
+void iree_microkernel_sgemm_with_workspace(
+    iree_microkernel_isa_t isa, int64_t m, int64_t n, int64_t k,
+    const float* lhs, int64_t lhs_stride0, int64_t lhs_stride1,
+    const float* rhs, int64_t rhs_stride0, int64_t rhs_stride1, float* out,
+    int64_t out_stride0, int64_t out_stride1, void* workspace);
+
+// iree_microkernel_sgemm_with_workspace using a workspace on the stack.
+// Callers need IREE_MICROKERNEL_SGEMM_WORKSPACE_SIZE plus ~1KB of free stack.
+// Task system workers run with the platform default thread stack size, which
+// is at least 512KB on all supported platforms.
+void iree_microkernel_sgemm(iree_microkernel_isa_t isa, int64_t m, int64_t n,
+                            int64_t k, const float* lhs, int64_t lhs_stride0,
+                            int64_t lhs_stride1, const float* rhs,
+                            int64_t rhs_stride0, int64_t rhs_stride1,
+                            float* out, int64_t out_stride0,
+                            int64_t out_stride1);
+
+// Entry point called by code generated with
+// --iree-codegen-linalg-to-llvm-matmul-microkernels in place of a linalg.matmul
+// on memref<?x?xf32> operands. Each operand is passed as its expanded MLIR
+// memref descriptor: allocated pointer, aligned pointer, offset, sizes, and
+// strides (in elements).
+//
+// Packs on the stack like iree_microkernel_sgemm as the generated executables
+// still use the v0 library interface without local memory.
+// TODO(#3580): pass the entry point local memory once the LLVM AOT target
+// emits v1 libraries.
+void iree_microkernel_linalg_matmul_f32(
+    float* lhs_allocated, float* lhs_aligned, int64_t lhs_offset,
+    int64_t lhs_size0, int64_t lhs_size1, int64_t lhs_stride0,
+    int64_t lhs_stride1, float* rhs_allocated, float* rhs_aligned,
+    int64_t rhs_offset, int64_t rhs_size0, int64_t rhs_size1,
+    int64_t rhs_stride0, int64_t rhs_stride1, float* out_allocated,
+    float* out_aligned, int64_t out_offset, int64_t out_size0,
+    int64_t out_size1, int64_t out_stride0, int64_t out_stride1);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // IREE_HAL_LOCAL_MICROKERNELS_SGEMM_H_
@@ -0,0 +1,84 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/hal/local/microkernels/sgemm_kernels.h"
+
+#if defined(IREE_ARCH_ARM_64)
+
+#include <arm_neon.h>
+
+//===----------------------------------------------------------------------===//
+// NEON 8x8 kernel
+//===----------------------------------------------------------------------===//
+// 16 q-register accumulators, 2 for the rhs row, and 2 for the lhs column out
+// of the 32 available. Each lhs element is used through a lane-indexed FMA so
+// no broadcasts are needed. NEON is part of the AArch64 baseline.
+
+#define IREE_NEON_FMA_ROW(i, a, lane)                  \
+  c##i##0 = vfmaq_laneq_f32(c##i##0, b0, a, lane);     \
+  c##i##1 = vfmaq_laneq_f32(c##i##1, b1, a, lane);
+
+#define IREE_NEON_STORE_ROW(i)                         \
+  vst1q_f32(tile + i * 8 + 0, c##i##0);                \
+  vst1q_f32(tile + i * 8 + 4, c##i##1);
+
+static void iree_microkernel_sgemm_tile_arm_64_neon(int64_t k,
+                                                    const float* lhs,
+                                                    const float* rhs,
+                                                    float* tile) {
+  float32x4_t c00 = vdupq_n_f32(0.0f), c01 = vdupq_n_f32(0.0f);
+  float32x4_t c10 = vdupq_n_f32(0.0f), c11 = vdupq_n_f32(0.0f);
+  float32x4_t c20 = vdupq_n_f32(0.0f), c21 = vdupq_n_f32(0.0f);
+  float32x4_t c30 = vdupq_n_f32(0.0f), c31 = vdupq_n_f32(0.0f);
+  float32x4_t c40 = vdupq_n_f32(0.0f), c41 = vdupq_n_f32(0.0f);
+  float32x4_t c50 = vdupq_n_f32(0.0f), c51 = vdupq_n_f32(0.0f);
+  float32x4_t c60 = vdupq_n_f32(0.0f), c61 = vdupq_n_f32(0.0f);
+  float32x4_t c70 = vdupq_n_f32(0.0f), c71 = vdupq_n_f32(0.0f);
+  for (int64_t p = 0; p < k; ++p) {
+    const float32x4_t b0 = vld1q_f32(rhs + 0);
+    const float32x4_t b1 = vld1q_f32(rhs + 4);
+    const float32x4_t a0 = vld1q_f32(lhs + 0);
+    const float32x4_t a1 = vld1q_f32(lhs + 4);
+    IREE_NEON_FMA_ROW(0, a0, 0);
+    IREE_NEON_FMA_ROW(1, a0, 1);
+    IREE_NEON_FMA_ROW(2, a0, 2);
+    IREE_NEON_FMA_ROW(3, a0, 3);
+    IREE_NEON_FMA_ROW(4, a1, 0);
+    IREE_NEON_FMA_ROW(5, a1, 1);
+    IREE_NEON_FMA_ROW(6, a1, 2);
+    IREE_NEON_FMA_ROW(7, a1, 3);
+    lhs += 8;
+    rhs += 8;
+  }
+  IREE_NEON_STORE_ROW(0);
+  IREE_NEON_STORE_ROW(1);
+  IREE_NEON_STORE_ROW(2);
+  IREE_NEON_STORE_ROW(3);
+  IREE_NEON_STORE_ROW(4);
+  IREE_NEON_STORE_ROW(5);
+  IREE_NEON_STORE_ROW(6);
+  IREE_NEON_STORE_ROW(7);
+}
+
+#undef IREE_NEON_FMA_ROW
+#undef IREE_NEON_STORE_ROW
+
+const iree_microkernel_sgemm_kernel_t
+    iree_microkernel_sgemm_kernel_arm_64_neon = {
+        8,
+        8,
+        iree_microkernel_sgemm_tile_arm_64_neon,
+};
+
+#endif  // IREE_ARCH_ARM_64
@@ -0,0 +1,135 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compares the single-threaded throughput of the SGEMM microkernels with ruy
+// across matmul shapes. The same shapes compiled through the LLVM AOT backend
+// with and without --iree-codegen-linalg-to-llvm-matmul-microkernels are in
+// sgemm_benchmark.mlir.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "iree/base/api.h"
+#include "iree/hal/local/microkernels/sgemm.h"
+#include "ruy/context.h"
+#include "ruy/mul_params.h"
+#include "ruy/ruy.h"
+
+namespace {
+
+struct SgemmShape {
+  const char* name;
+  int64_t m;
+  int64_t n;
+  int64_t k;
+};
+
+// Transformer encoder layers (sequence length 128, BERT-base/large hidden
+// sizes) along with square and workgroup-tile sized problems.
+static const SgemmShape kSgemmShapes[] = {
+    {"square_64", 64, 64, 64},
+    {"square_256", 256, 256, 256},
+    {"square_1024", 1024, 1024, 1024},
+    {"bert_base_qkv", 128, 768, 768},
+    {"bert_base_ffn_up", 128, 3072, 768},
+    {"bert_base_ffn_down", 128, 768, 3072},
+    {"bert_large_qkv", 128, 1024, 1024},
+    {"bert_large_ffn_up", 128, 4096, 1024},
+};
+
+enum SgemmImpl {
+  kSgemmImplMicrokernel = 0,
+  kSgemmImplRuy = 1,
+};
+
+// Runs kSgemmShapes[state.range(0)] with the implementation state.range(1).
+// Microkernels use the instruction set state.range(2).
+static void BM_Sgemm(benchmark::State& state) {
+  const SgemmShape& shape = kSgemmShapes[state.range(0)];
+  const auto impl = static_cast<SgemmImpl>(state.range(1));
+  const auto isa = static_cast<iree_microkernel_isa_t>(state.range(2));
+  if (impl == kSgemmImplMicrokernel &&
+      !iree_microkernel_isa_is_supported(isa)) {
+    state.SkipWithError("instruction set not supported");
+    return;
+  }
+
+  std::vector<float> lhs(shape.m * shape.k);
+  for (size_t i = 0; i < lhs.size(); ++i) {
+    lhs[i] = static_cast<float>(i % 17) * 0.125f;
+  }
+  std::vector<float> rhs(shape.k * shape.n);
+  for (size_t i = 0; i < rhs.size(); ++i) {
+    rhs[i] = static_cast<float>(i % 13) * 0.0625f - 0.5f;
+  }
+  std::vector<float> out(shape.m * shape.n);
+
+  ruy::Context context;
+  context.set_max_num_threads(1);
+  ruy::Matrix<float> ruy_lhs;
+  ruy_lhs.set_data(lhs.data());
+  ruy::MakeSimpleLayout(shape.m, shape.k, ruy::Order::kRowMajor,
+                        ruy_lhs.mutable_layout());
+  ruy::Matrix<float> ruy_rhs;
+  ruy_rhs.set_data(rhs.data());
+  ruy::MakeSimpleLayout(shape.k, shape.n, ruy::Order::kRowMajor,
+                        ruy_rhs.mutable_layout());
+  ruy::Matrix<float> ruy_out;
+  ruy_out.set_data(out.data());
+  ruy::MakeSimpleLayout(shape.m, shape.n, ruy::Order::kRowMajor,
+                        ruy_out.mutable_layout());
+  ruy::MulParams<float, float> mul_params;
+
+  for (auto _ : state) {
+    // Both implementations produce lhs * rhs into a zeroed output as
+    // linalg.fill + linalg.matmul would.
+    std::fill(out.begin(), out.end(), 0.0f);
+    if (impl == kSgemmImplMicrokernel) {
+      iree_microkernel_sgemm(isa, shape.m, shape.n, shape.k, lhs.data(),
+                             shape.k, 1, rhs.data(), shape.n, 1, out.data(),
+                             shape.n, 1);
+    } else {
+      ruy::Mul(ruy_lhs, ruy_rhs, mul_params, &context, &ruy_out);
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+
+  state.SetLabel(std::string(shape.name));
+  // 2 flops (multiply + add) per MAC.
+  state.counters["flops"] =
+      benchmark::Counter(2.0 * shape.m * shape.n * shape.k * state.iterations(),
+                         benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Sgemm)
+    ->ArgNames({"shape", "ruy", "isa"})
+    ->Apply([](benchmark::internal::Benchmark* benchmark) {
+      static const iree_microkernel_isa_t kISAs[] = {
+          IREE_MICROKERNEL_ISA_GENERIC,
+          IREE_MICROKERNEL_ISA_X86_64_AVX2_FMA,
+          IREE_MICROKERNEL_ISA_X86_64_AVX512F,
+          IREE_MICROKERNEL_ISA_ARM_64_NEON,
+      };
+      for (int64_t i = 0; i < IREE_ARRAYSIZE(kSgemmShapes); ++i) {
+        for (iree_microkernel_isa_t isa : kISAs) {
+          if (!iree_microkernel_isa_is_supported(isa)) continue;
+          benchmark->Args({i, kSgemmImplMicrokernel, isa});
+        }
+        benchmark->Args({i, kSgemmImplRuy, 0});
+      }
+    })
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
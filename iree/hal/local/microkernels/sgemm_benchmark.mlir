@@ -0,0 +1,58 @@
+// The shapes of sgemm_benchmark.cc as modules for comparing the vectorized
+// LLVM AOT matmul lowering with the microkernel lowering. Each dispatch can be
+// benchmarked on its own with:
+//
+//   iree-translate -iree-mlir-to-executable-benchmark-vm-module \
+//       -iree-hal-target-backends=dylib-llvm-aot \
+//       [-iree-codegen-linalg-to-llvm-matmul-microkernels \
+//        -iree-llvm-microkernel-library=libiree_hal_local_microkernels_sgemm.a] \
+//       sgemm_benchmark.mlir -o sgemm_benchmark.vmfb
+//   iree-benchmark-module --driver=dylib --module_file=sgemm_benchmark.vmfb
+
+func @square_64(%lhs: tensor<64x64xf32>, %rhs: tensor<64x64xf32>) -> tensor<64x64xf32>
+    attributes { iree.module.export } {
+  %0 = "mhlo.dot"(%lhs, %rhs) : (tensor<64x64xf32>, tensor<64x64xf32>) -> tensor<64x64xf32>
+  return %0 : tensor<64x64xf32>
+}
+
+func @square_256(%lhs: tensor<256x256xf32>, %rhs: tensor<256x256xf32>) -> tensor<256x256xf32>
+    attributes { iree.module.export } {
+  %0 = "mhlo.dot"(%lhs, %rhs) : (tensor<256x256xf32>, tensor<256x256xf32>) -> tensor<256x256xf32>
+  return %0 : tensor<256x256xf32>
+}
+
+func @square_1024(%lhs: tensor<1024x1024xf32>, %rhs: tensor<1024x1024xf32>) -> tensor<1024x1024xf32>
+    attributes { iree.module.export } {
+  %0 = "mhlo.dot"(%lhs, %rhs) : (tensor<1024x1024xf32>, tensor<1024x1024xf32>) -> tensor<1024x1024xf32>
+  return %0 : tensor<1024x1024xf32>
+}
+
+func @bert_base_qkv(%lhs: tensor<128x768xf32>, %rhs: tensor<768x768xf32>) -> tensor<128x768xf32>
+    attributes { iree.module.export } {
+  %0 = "mhlo.dot"(%lhs, %rhs) : (tensor<128x768xf32>, tensor<768x768xf32>) -> tensor<128x768xf32>
+  return %0 : tensor<128x768xf32>
+}
+
+func @bert_base_ffn_up(%lhs: tensor<128x768xf32>, %rhs: tensor<768x3072xf32>) -> tensor<128x3072xf32>
+    attributes { iree.module.export } {
+  %0 = "mhlo.dot"(%lhs, %rhs) : (tensor<128x768xf32>, tensor<768x3072xf32>) -> tensor<128x3072xf32>
+  return %0 : tensor<128x3072xf32>
+}
+
+func @bert_base_ffn_down(%lhs: tensor<128x3072xf32>, %rhs: tensor<3072x768xf32>) -> tensor<128x768xf32>
+    attributes { iree.module.export } {
+  %0 = "mhlo.dot"(%lhs, %rhs) : (tensor<128x3072xf32>, tensor<3072x768xf32>) -> tensor<128x768xf32>
+  return %0 : tensor<128x768xf32>
+}
+
+func @bert_large_qkv(%lhs: tensor<128x1024xf32>, %rhs: tensor<1024x1024xf32>) -> tensor<128x1024xf32>
+    attributes { iree.module.export } {
+  %0 = "mhlo.dot"(%lhs, %rhs) : (tensor<128x1024xf32>, tensor<1024x1024xf32>) -> tensor<128x1024xf32>
+  return %0 : tensor<128x1024xf32>
+}
+
+func @bert_large_ffn_up(%lhs: tensor<128x1024xf32>, %rhs: tensor<1024x4096xf32>) -> tensor<128x4096xf32>
+    attributes { iree.module.export } {
+  %0 = "mhlo.dot"(%lhs, %rhs) : (tensor<128x1024xf32>, tensor<1024x4096xf32>) -> tensor<128x4096xf32>
+  return %0 : tensor<128x4096xf32>
+}
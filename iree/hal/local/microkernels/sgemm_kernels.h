@@ -0,0 +1,76 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Register-blocked SGEMM inner kernels shared between sgemm.c and the
+// architecture-specific implementations.
+
+#ifndef IREE_HAL_LOCAL_MICROKERNELS_SGEMM_KERNELS_H_
+#define IREE_HAL_LOCAL_MICROKERNELS_SGEMM_KERNELS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "iree/base/target_platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Largest register block of any kernel; sizes the on-stack output tile.
+#define IREE_MICROKERNEL_SGEMM_MAX_MR 8
+#define IREE_MICROKERNEL_SGEMM_MAX_NR 32
+
+// Computes the row-major |mr|x|nr| |tile| as the sum over |k| of the outer
+// products of the packed |lhs| panel (|k| columns of |mr| elements) and the
+// packed |rhs| panel (|k| rows of |nr| elements). |tile| is overwritten.
+typedef void (*iree_microkernel_sgemm_tile_fn_t)(int64_t k, const float* lhs,
+                                                 const float* rhs,
+                                                 float* tile);
+
+typedef struct {
+  // Number of rows of the register block; a divisor of the packing block.
+  int mr;
+  // Number of columns of the register block; a divisor of the packing block.
+  int nr;
+  iree_microkernel_sgemm_tile_fn_t tile;
+} iree_microkernel_sgemm_kernel_t;
+
+extern const iree_microkernel_sgemm_kernel_t
+    iree_microkernel_sgemm_kernel_generic;
+
+#if defined(IREE_ARCH_X86_64)
+
+extern const iree_microkernel_sgemm_kernel_t
+    iree_microkernel_sgemm_kernel_x86_64_avx2_fma;
+extern const iree_microkernel_sgemm_kernel_t
+    iree_microkernel_sgemm_kernel_x86_64_avx512f;
+
+// Returns true if the executing CPU and OS support AVX2 and FMA3.
+bool iree_microkernel_x86_64_has_avx2_fma(void);
+
+// Returns true if the executing CPU and OS support AVX-512F.
+bool iree_microkernel_x86_64_has_avx512f(void);
+
+#elif defined(IREE_ARCH_ARM_64)
+
+extern const iree_microkernel_sgemm_kernel_t
+    iree_microkernel_sgemm_kernel_arm_64_neon;
+
+#endif  // IREE_ARCH_*
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // IREE_HAL_LOCAL_MICROKERNELS_SGEMM_KERNELS_H_
@@ -0,0 +1,195 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/hal/local/microkernels/sgemm.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "iree/testing/gtest.h"
+
+namespace {
+
+struct Shape {
+  int64_t m;
+  int64_t n;
+  int64_t k;
+};
+
+// Covers single register blocks, partial edge blocks, and multiple packing
+// blocks in each dimension.
+static const Shape kShapes[] = {
+    {1, 1, 1},    {4, 4, 4},     {6, 16, 3},   {8, 32, 7},
+    {7, 33, 129}, {48, 64, 128}, {49, 65, 257}, {100, 3, 300},
+};
+
+static const iree_microkernel_isa_t kISAs[] = {
+    IREE_MICROKERNEL_ISA_AUTO,
+    IREE_MICROKERNEL_ISA_GENERIC,
+    IREE_MICROKERNEL_ISA_X86_64_AVX2_FMA,
+    IREE_MICROKERNEL_ISA_X86_64_AVX512F,
+    IREE_MICROKERNEL_ISA_ARM_64_NEON,
+};
+
+std::vector<float> MakeMatrix(int64_t size, int seed) {
+  std::vector<float> matrix(size);
+  for (int64_t i = 0; i < size; ++i) {
+    matrix[i] = static_cast<float>((i * 7 + seed) % 13) * 0.25f - 1.5f;
+  }
+  return matrix;
+}
+
+// Computes out += lhs * rhs for row-major matrices.
+void ReferenceSgemm(const Shape& shape, const float* lhs, const float* rhs,
+                    float* out) {
+  for (int64_t i = 0; i < shape.m; ++i) {
+    for (int64_t j = 0; j < shape.n; ++j) {
+      float sum = 0.0f;
+      for (int64_t p = 0; p < shape.k; ++p) {
+        sum += lhs[i * shape.k + p] * rhs[p * shape.n + j];
+      }
+      out[i * shape.n + j] += sum;
+    }
+  }
+}
+
+void ExpectNear(const std::vector<float>& expected,
+                const std::vector<float>& actual, int64_t k) {
+  ASSERT_EQ(expected.size(), actual.size());
+  // Summation order differs between kernels; allow for rounding growing with
+  // the reduction size.
+  const float tolerance = 1e-5f * static_cast<float>(k) + 1e-5f;
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_NEAR(expected[i], actual[i],
+                tolerance * std::max(1.0f, std::fabs(expected[i])))
+        << "at element " << i;
+  }
+}
+
+TEST(SgemmTest, RowMajor) {
+  for (iree_microkernel_isa_t isa : kISAs) {
+    if (!iree_microkernel_isa_is_supported(isa)) continue;
+    for (const Shape& shape : kShapes) {
+      SCOPED_TRACE(testing::Message() << "isa " << isa << " shape " << shape.m
+                                      << "x" << shape.n << "x" << shape.k);
+      auto lhs = MakeMatrix(shape.m * shape.k, 1);
+      auto rhs = MakeMatrix(shape.k * shape.n, 2);
+      // Accumulates into an existing output.
+      auto expected = MakeMatrix(shape.m * shape.n, 3);
+      auto actual = expected;
+      ReferenceSgemm(shape, lhs.data(), rhs.data(), expected.data());
+      iree_microkernel_sgemm(isa, shape.m, shape.n, shape.k, lhs.data(),
+                             shape.k, 1, rhs.data(), shape.n, 1,
+                             actual.data(), shape.n, 1);
+      ExpectNear(expected, actual, shape.k);
+    }
+  }
+}
+
+TEST(SgemmTest, StridedViews) {
+  // Multiplies column-major views of lhs and rhs into a view of a larger
+  // output; elements outside of the output view must be untouched.
+  const Shape shape = {19, 23, 131};
+  const int64_t out_stride0 = shape.n + 5;
+  for (iree_microkernel_isa_t isa : kISAs) {
+    if (!iree_microkernel_isa_is_supported(isa)) continue;
+    SCOPED_TRACE(testing::Message() << "isa " << isa);
+    auto lhs = MakeMatrix(shape.m * shape.k, 1);
+    auto rhs = MakeMatrix(shape.k * shape.n, 2);
+    std::vector<float> lhs_col_major(lhs.size());
+    std::vector<float> rhs_col_major(rhs.size());
+    for (int64_t i = 0; i < shape.m; ++i) {
+      for (int64_t p = 0; p < shape.k; ++p) {
+        lhs_col_major[p * shape.m + i] = lhs[i * shape.k + p];
+      }
+    }
+    for (int64_t p = 0; p < shape.k; ++p) {
+      for (int64_t j = 0; j < shape.n; ++j) {
+        rhs_col_major[j * shape.k + p] = rhs[p * shape.n + j];
+      }
+    }
+    std::vector<float> expected(shape.m * shape.n, 0.0f);
+    ReferenceSgemm(shape, lhs.data(), rhs.data(), expected.data());
+
+    std::vector<float> out(shape.m * out_stride0, -7.0f);
+    iree_microkernel_sgemm(isa, shape.m, shape.n, shape.k,
+                           lhs_col_major.data(), 1, shape.m,
+                           rhs_col_major.data(), 1, shape.k, out.data(),
+                           out_stride0, 1);
+    std::vector<float> actual(shape.m * shape.n);
+    for (int64_t i = 0; i < shape.m; ++i) {
+      for (int64_t j = 0; j < out_stride0; ++j) {
+        float value = out[i * out_stride0 + j];
+        if (j < shape.n) {
+          actual[i * shape.n + j] = value + 7.0f;
+        } else {
+          ASSERT_EQ(-7.0f, value);
+        }
+      }
+    }
+    ExpectNear(expected, actual, shape.k);
+  }
+}
+
+TEST(SgemmTest, CallerWorkspace) {
+  // The workspace contents on entry must not affect the result; poison it with
+  // NaNs and offset it from any natural alignment beyond that of a float.
+  std::vector<float> workspace(IREE_MICROKERNEL_SGEMM_WORKSPACE_SIZE /
+                                   sizeof(float) +
+                               1);
+  for (iree_microkernel_isa_t isa : kISAs) {
+    if (!iree_microkernel_isa_is_supported(isa)) continue;
+    for (const Shape& shape : kShapes) {
+      SCOPED_TRACE(testing::Message() << "isa " << isa << " shape " << shape.m
+                                      << "x" << shape.n << "x" << shape.k);
+      std::fill(workspace.begin(), workspace.end(), std::nanf(""));
+      auto lhs = MakeMatrix(shape.m * shape.k, 1);
+      auto rhs = MakeMatrix(shape.k * shape.n, 2);
+      auto expected = MakeMatrix(shape.m * shape.n, 3);
+      auto actual = expected;
+      ReferenceSgemm(shape, lhs.data(), rhs.data(), expected.data());
+      iree_microkernel_sgemm_with_workspace(
+          isa, shape.m, shape.n, shape.k, lhs.data(), shape.k, 1, rhs.data(),
+          shape.n, 1, actual.data(), shape.n, 1, workspace.data() + 1);
+      ExpectNear(expected, actual, shape.k);
+    }
+  }
+}
+
+TEST(SgemmTest, LinalgMatmulEntryPoint) {
+  // A 5x6 view at offset (2, 3) of a 16x16 buffer multiplied by a 6x7 view
+  // at offset (1, 1) of an 8x8 buffer.
+  const Shape shape = {5, 7, 6};
+  auto lhs_buffer = MakeMatrix(16 * 16, 1);
+  auto rhs_buffer = MakeMatrix(8 * 8, 2);
+  std::vector<float> out(shape.m * shape.n, 0.0f);
+  iree_microkernel_linalg_matmul_f32(
+      lhs_buffer.data(), lhs_buffer.data(), 2 * 16 + 3, shape.m, shape.k, 16,
+      1, rhs_buffer.data(), rhs_buffer.data(), 1 * 8 + 1, shape.k, shape.n, 8,
+      1, out.data(), out.data(), 0, shape.m, shape.n, shape.n, 1);
+
+  std::vector<float> expected(shape.m * shape.n, 0.0f);
+  for (int64_t i = 0; i < shape.m; ++i) {
+    for (int64_t j = 0; j < shape.n; ++j) {
+      for (int64_t p = 0; p < shape.k; ++p) {
+        expected[i * shape.n + j] += lhs_buffer[(2 + i) * 16 + 3 + p] *
+                                     rhs_buffer[(1 + p) * 8 + 1 + j];
+      }
+    }
+  }
+  ExpectNear(expected, out, shape.k);
+}
+
+}  // namespace
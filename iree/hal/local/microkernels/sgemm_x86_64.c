@@ -0,0 +1,241 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/hal/local/microkernels/sgemm_kernels.h"
+
+#if defined(IREE_ARCH_X86_64)
+
+#include <immintrin.h>
+
+#include "iree/base/internal/atomics.h"
+
+#if defined(IREE_COMPILER_MSVC)
+#include <intrin.h>
+// MSVC allows any intrinsic to be used without enabling the instruction set.
+#define IREE_MICROKERNEL_TARGET(features)
+#else
+#include <cpuid.h>
+#define IREE_MICROKERNEL_TARGET(features) __attribute__((target(features)))
+#endif  // IREE_COMPILER_MSVC
+
+//===----------------------------------------------------------------------===//
+// CPU feature detection
+//===----------------------------------------------------------------------===//
+
+// Feature bits cached by iree_microkernel_x86_64_query_features.
+enum iree_microkernel_x86_64_feature_e {
+  IREE_MICROKERNEL_X86_64_FEATURE_QUERIED = 1 << 0,
+  IREE_MICROKERNEL_X86_64_FEATURE_AVX2_FMA = 1 << 1,
+  IREE_MICROKERNEL_X86_64_FEATURE_AVX512F = 1 << 2,
+};
+
+static void iree_microkernel_x86_64_cpuid(uint32_t leaf, uint32_t subleaf,
+                                          uint32_t regs[4]) {
+#if defined(IREE_COMPILER_MSVC)
+  int info[4];
+  __cpuidex(info, (int)leaf, (int)subleaf);
+  for (int i = 0; i < 4; ++i) regs[i] = (uint32_t)info[i];
+#else
+  __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif  // IREE_COMPILER_MSVC
+}
+
+// Returns the register state enabled by the OS in XCR0.
+static uint64_t iree_microkernel_x86_64_xgetbv(void) {
+#if defined(IREE_COMPILER_MSVC)
+  return _xgetbv(0);
+#else
+  uint32_t eax = 0, edx = 0;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return ((uint64_t)edx << 32) | eax;
+#endif  // IREE_COMPILER_MSVC
+}
+
+static int32_t iree_microkernel_x86_64_detect_features(void) {
+  int32_t features = IREE_MICROKERNEL_X86_64_FEATURE_QUERIED;
+  uint32_t regs[4];
+  iree_microkernel_x86_64_cpuid(0, 0, regs);
+  const uint32_t max_leaf = regs[0];
+  if (max_leaf < 7) return features;
+
+  // OSXSAVE (ecx bit 27) is required before XCR0 can be read.
+  iree_microkernel_x86_64_cpuid(1, 0, regs);
+  const bool has_fma = (regs[2] >> 12) & 1;
+  const bool has_osxsave = (regs[2] >> 27) & 1;
+  const bool has_avx = (regs[2] >> 28) & 1;
+  if (!has_osxsave || !has_avx) return features;
+  const uint64_t xcr0 = iree_microkernel_x86_64_xgetbv();
+  // XMM and YMM state.
+  const bool os_saves_ymm = (xcr0 & 0x6) == 0x6;
+  // XMM, YMM, opmask, and the upper halves of ZMM0-15 and ZMM16-31 state.
+  const bool os_saves_zmm = (xcr0 & 0xE6) == 0xE6;
+
+  iree_microkernel_x86_64_cpuid(7, 0, regs);
+  const bool has_avx2 = (regs[1] >> 5) & 1;
+  const bool has_avx512f = (regs[1] >> 16) & 1;
+  if (os_saves_ymm && has_avx2 && has_fma) {
+    features |= IREE_MICROKERNEL_X86_64_FEATURE_AVX2_FMA;
+  }
+  if (os_saves_zmm && has_avx512f) {
+    features |= IREE_MICROKERNEL_X86_64_FEATURE_AVX512F;
+  }
+  return features;
+}
+
+// Returns the features of the executing CPU. cpuid is expensive (and traps
+// under virtualization) so the result is computed once and cached; racing
+// threads compute the same value.
+static int32_t iree_microkernel_x86_64_query_features(void) {
+  static iree_atomic_int32_t cached_features = IREE_ATOMIC_VAR_INIT(0);
+  int32_t features =
+      iree_atomic_load_int32(&cached_features, iree_memory_order_relaxed);
+  if (features == 0) {
+    features = iree_microkernel_x86_64_detect_features();
+    iree_atomic_store_int32(&cached_features, features,
+                            iree_memory_order_relaxed);
+  }
+  return features;
+}
+
+bool iree_microkernel_x86_64_has_avx2_fma(void) {
+  return (iree_microkernel_x86_64_query_features() &
+          IREE_MICROKERNEL_X86_64_FEATURE_AVX2_FMA) != 0;
+}
+
+bool iree_microkernel_x86_64_has_avx512f(void) {
+  return (iree_microkernel_x86_64_query_features() &
+          IREE_MICROKERNEL_X86_64_FEATURE_AVX512F) != 0;
+}
+
+//===----------------------------------------------------------------------===//
+// AVX2 + FMA3 6x16 kernel
+//===----------------------------------------------------------------------===//
+// 12 ymm accumulators, 2 ymm for the rhs row, and 1 ymm for the broadcast lhs
+// element out of the 16 available.
+
+#define IREE_AVX2_FMA_ROW(i)                      \
+  a = _mm256_broadcast_ss(lhs + i);               \
+  c##i##0 = _mm256_fmadd_ps(a, b0, c##i##0);      \
+  c##i##1 = _mm256_fmadd_ps(a, b1, c##i##1);
+
+#define IREE_AVX2_STORE_ROW(i)                    \
+  _mm256_storeu_ps(tile + i * 16 + 0, c##i##0);   \
+  _mm256_storeu_ps(tile + i * 16 + 8, c##i##1);
+
+IREE_MICROKERNEL_TARGET("avx2,fma")
+static void iree_microkernel_sgemm_tile_x86_64_avx2_fma(int64_t k,
+                                                        const float* lhs,
+                                                        const float* rhs,
+                                                        float* tile) {
+  __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+  __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+  __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+  __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+  __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+  __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+  for (int64_t p = 0; p < k; ++p) {
+    const __m256 b0 = _mm256_loadu_ps(rhs + 0);
+    const __m256 b1 = _mm256_loadu_ps(rhs + 8);
+    __m256 a;
+    IREE_AVX2_FMA_ROW(0);
+    IREE_AVX2_FMA_ROW(1);
+    IREE_AVX2_FMA_ROW(2);
+    IREE_AVX2_FMA_ROW(3);
+    IREE_AVX2_FMA_ROW(4);
+    IREE_AVX2_FMA_ROW(5);
+    lhs += 6;
+    rhs += 16;
+  }
+  IREE_AVX2_STORE_ROW(0);
+  IREE_AVX2_STORE_ROW(1);
+  IREE_AVX2_STORE_ROW(2);
+  IREE_AVX2_STORE_ROW(3);
+  IREE_AVX2_STORE_ROW(4);
+  IREE_AVX2_STORE_ROW(5);
+}
+
+#undef IREE_AVX2_FMA_ROW
+#undef IREE_AVX2_STORE_ROW
+
+const iree_microkernel_sgemm_kernel_t
+    iree_microkernel_sgemm_kernel_x86_64_avx2_fma = {
+        6,
+        16,
+        iree_microkernel_sgemm_tile_x86_64_avx2_fma,
+};
+
+//===----------------------------------------------------------------------===//
+// AVX-512F 8x32 kernel
+//===----------------------------------------------------------------------===//
+// 16 zmm accumulators, 2 zmm for the rhs row, and 1 zmm for the broadcast lhs
+// element out of the 32 available.
+
+#define IREE_AVX512F_FMA_ROW(i)                   \
+  a = _mm512_set1_ps(lhs[i]);                     \
+  c##i##0 = _mm512_fmadd_ps(a, b0, c##i##0);      \
+  c##i##1 = _mm512_fmadd_ps(a, b1, c##i##1);
+
+#define IREE_AVX512F_STORE_ROW(i)                 \
+  _mm512_storeu_ps(tile + i * 32 + 0, c##i##0);   \
+  _mm512_storeu_ps(tile + i * 32 + 16, c##i##1);
+
+IREE_MICROKERNEL_TARGET("avx512f")
+static void iree_microkernel_sgemm_tile_x86_64_avx512f(int64_t k,
+                                                       const float* lhs,
+                                                       const float* rhs,
+                                                       float* tile) {
+  __m512 c00 = _mm512_setzero_ps(), c01 = _mm512_setzero_ps();
+  __m512 c10 = _mm512_setzero_ps(), c11 = _mm512_setzero_ps();
+  __m512 c20 = _mm512_setzero_ps(), c21 = _mm512_setzero_ps();
+  __m512 c30 = _mm512_setzero_ps(), c31 = _mm512_setzero_ps();
+  __m512 c40 = _mm512_setzero_ps(), c41 = _mm512_setzero_ps();
+  __m512 c50 = _mm512_setzero_ps(), c51 = _mm512_setzero_ps();
+  __m512 c60 = _mm512_setzero_ps(), c61 = _mm512_setzero_ps();
+  __m512 c70 = _mm512_setzero_ps(), c71 = _mm512_setzero_ps();
+  for (int64_t p = 0; p < k; ++p) {
+    const __m512 b0 = _mm512_loadu_ps(rhs + 0);
+    const __m512 b1 = _mm512_loadu_ps(rhs + 16);
+    __m512 a;
+    IREE_AVX512F_FMA_ROW(0);
+    IREE_AVX512F_FMA_ROW(1);
+    IREE_AVX512F_FMA_ROW(2);
+    IREE_AVX512F_FMA_ROW(3);
+    IREE_AVX512F_FMA_ROW(4);
+    IREE_AVX512F_FMA_ROW(5);
+    IREE_AVX512F_FMA_ROW(6);
+    IREE_AVX512F_FMA_ROW(7);
+    lhs += 8;
+    rhs += 32;
+  }
+  IREE_AVX512F_STORE_ROW(0);
+  IREE_AVX512F_STORE_ROW(1);
+  IREE_AVX512F_STORE_ROW(2);
+  IREE_AVX512F_STORE_ROW(3);
+  IREE_AVX512F_STORE_ROW(4);
+  IREE_AVX512F_STORE_ROW(5);
+  IREE_AVX512F_STORE_ROW(6);
+  IREE_AVX512F_STORE_ROW(7);
+}
+
+#undef IREE_AVX512F_FMA_ROW
+#undef IREE_AVX512F_STORE_ROW
+
+const iree_microkernel_sgemm_kernel_t
+    iree_microkernel_sgemm_kernel_x86_64_avx512f = {
+        8,
+        32,
+        iree_microkernel_sgemm_tile_x86_64_avx512f,
+};
+
+#endif  // IREE_ARCH_X86_64
@@ -14,6 +14,8 @@
 
 #include "iree/hal/local/task_command_buffer.h"
 
+#include <inttypes.h>
+
 #include "iree/base/internal/debugging.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/local/local_descriptor_set_layout.h"
@@ -22,6 +24,254 @@
 #include "iree/task/list.h"
 #include "iree/task/submission.h"
 #include "iree/task/task.h"
+#include "iree/task/tuning.h"
+
+#if defined(IREE_ARCH_X86_64)
+#include <emmintrin.h>
+#endif  // IREE_ARCH_X86_64
+
+// Maximum number of commands tracked for hazards between global barriers.
+// Recording more commands than this will insert a global barrier that joins all
+// prior work. Must be <= 64 as dependencies are tracked as bitmasks.
+#define IREE_HAL_TASK_COMMAND_BUFFER_MAX_HAZARD_COMMANDS 64
+
+// Maximum number of buffer accesses tracked for hazards between global
+// barriers. Must be large enough to hold the accesses of any single command.
+#define IREE_HAL_TASK_COMMAND_BUFFER_MAX_HAZARD_ACCESSES 128
+
+// Size of each tile of a transfer (fill/copy) split across workers.
+// Must be a multiple of all supported fill pattern lengths.
+#define IREE_HAL_TASK_TRANSFER_TILE_SIZE (256 * 1024)
+
+// Transfers of at least this many bytes are split into tiles that execute
+// concurrently. Smaller transfers run as a single call as the cost of fanning
+// out to multiple workers outweighs the memory bandwidth gained.
+#define IREE_HAL_TASK_TRANSFER_MIN_SPLIT_SIZE (1 * 1024 * 1024)
+
+// Fills of at least this many bytes use non-temporal stores on x86_64 so that
+// they don't evict the entire cache contents of all workers for data that is
+// unlikely to be read again before being evicted. Other architectures always
+// use iree_hal_buffer_fill. Copies always use the system memcpy as it already
+// picks an appropriate strategy for large sizes.
+#define IREE_HAL_TASK_TRANSFER_MIN_NONTEMPORAL_SIZE (32 * 1024 * 1024)
+
+//===----------------------------------------------------------------------===//
+// iree_hal_task_cmd_record_t
+//===----------------------------------------------------------------------===//
+
+// Prefix of each command recorded into a reusable command buffer.
+// Records are allocated immediately before the command (which always starts
+// with its iree_task_t) so that the ordinal of any task in the template DAG can
+// be found without a lookup.
+typedef struct iree_hal_task_cmd_record_s {
+  // Next command in recording order.
+  struct iree_hal_task_cmd_record_s* next;
+  // Ordinal of the command in recording order.
+  iree_host_size_t ordinal;
+  // Size of the task (iree_task_call_t, etc) at the head of the command that
+  // is cloned on each issue.
+  iree_host_size_t task_size;
+} iree_hal_task_cmd_record_t;
+
+// Size of the record prefix padded such that the command following it retains
+// the alignment required by iree_task_t.
+#define IREE_HAL_TASK_CMD_RECORD_SIZE \
+  (iree_align(sizeof(iree_hal_task_cmd_record_t), iree_max_align_t))
+
+static inline iree_task_t* iree_hal_task_cmd_record_task(
+    iree_hal_task_cmd_record_t* record) {
+  return (iree_task_t*)((uint8_t*)record + IREE_HAL_TASK_CMD_RECORD_SIZE);
+}
+
+static inline iree_host_size_t iree_hal_task_cmd_record_ordinal(
+    const iree_task_t* task) {
+  return ((const iree_hal_task_cmd_record_t*)((const uint8_t*)task -
+                                              IREE_HAL_TASK_CMD_RECORD_SIZE))
+      ->ordinal;
+}
+
+//===----------------------------------------------------------------------===//
+// Hazard tracking
+//===----------------------------------------------------------------------===//
+
+// A range of an allocation accessed by a recorded command.
+// Ranges are resolved to the underlying allocated buffer when recorded so that
+// subspans of the same allocation can be compared directly.
+typedef struct {
+  iree_hal_buffer_t* allocated_buffer;
+  // Byte range [begin, end) within the allocated buffer.
+  iree_device_size_t begin;
+  iree_device_size_t end;
+  // True if the command may write to the range.
+  bool is_write;
+} iree_hal_task_access_t;
+
+static iree_hal_task_access_t iree_hal_task_access_make(
+    iree_hal_buffer_t* buffer, iree_device_size_t offset,
+    iree_device_size_t length, bool is_write) {
+  iree_hal_task_access_t access;
+  if (length == IREE_WHOLE_BUFFER) {
+    length = iree_hal_buffer_byte_length(buffer) - offset;
+  }
+  access.allocated_buffer = iree_hal_buffer_allocated_buffer(buffer);
+  access.begin = iree_hal_buffer_byte_offset(buffer) + offset;
+  access.end = access.begin + length;
+  access.is_write = is_write;
+  return access;
+}
+
+// Returns true if |a| and |b| must not execute concurrently.
+static inline bool iree_hal_task_access_is_hazard(
+    const iree_hal_task_access_t* a, const iree_hal_task_access_t* b) {
+  return (a->is_write | b->is_write) &
+         (a->allocated_buffer == b->allocated_buffer) &
+         (a->begin < b->end) & (b->begin < a->end);
+}
+
+// Returns true if |access| sorts before the (|buffer|, |begin|) key.
+static inline bool iree_hal_task_access_is_before(
+    const iree_hal_task_access_t* access, iree_hal_buffer_t* buffer,
+    iree_device_size_t begin) {
+  if (access->allocated_buffer != buffer) {
+    return (uintptr_t)access->allocated_buffer < (uintptr_t)buffer;
+  }
+  return access->begin < begin;
+}
+
+// An execution task recorded since the last global barrier.
+// Bit masks index other commands by their ordinal since the global barrier.
+typedef struct {
+  iree_task_t* task;
+  // Commands that must complete before this command begins. Transitively
+  // reduced such that no command is a predecessor of another predecessor.
+  uint64_t predecessor_mask;
+  // All commands that complete before this command begins (transitively).
+  uint64_t ancestor_mask;
+  // Commands that must wait for this command to complete.
+  uint64_t dependent_mask;
+} iree_hal_task_hazard_node_t;
+
+// Execution tasks emitted since the last global barrier and the buffer ranges
+// they access. Only needed while recording and allocated from the command
+// buffer scratch arena between begin and end.
+typedef struct {
+  // All execution tasks emitted that must execute after the open barrier.
+  // Dependencies between the tasks are only wired up on flush when the full
+  // set of dependents is known.
+  iree_host_size_t node_count;
+  iree_hal_task_hazard_node_t
+      nodes[IREE_HAL_TASK_COMMAND_BUFFER_MAX_HAZARD_COMMANDS];
+
+  // Accesses of all commands in recording order. |access_nodes| maps each
+  // access back to the ordinal of the command that made it.
+  iree_host_size_t access_count;
+  iree_hal_task_access_t
+      accesses[IREE_HAL_TASK_COMMAND_BUFFER_MAX_HAZARD_ACCESSES];
+  uint8_t access_nodes[IREE_HAL_TASK_COMMAND_BUFFER_MAX_HAZARD_ACCESSES];
+
+  // Number of accesses recorded prior to the last execution barrier.
+  // Commands recorded since the barrier are allowed to execute concurrently
+  // regardless of hazards and only these accesses need to be checked.
+  iree_host_size_t barrier_access_count;
+
+  // Indices of the first |barrier_access_count| accesses sorted by allocated
+  // buffer and then by begin offset. Queries only visit accesses of the same
+  // allocation that start within |max_access_length| bytes before the queried
+  // range. Accesses are added to the index when a barrier is recorded.
+  uint8_t sorted_accesses[IREE_HAL_TASK_COMMAND_BUFFER_MAX_HAZARD_ACCESSES];
+  iree_device_size_t max_access_length;
+
+  // The buffer range and access of each flattened descriptor set binding.
+  // Only valid for bindings that are set in the command buffer state and
+  // retained across global barriers.
+  iree_hal_task_access_t
+      binding_accesses[IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *
+                       IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT];
+} iree_hal_task_hazard_tracker_t;
+
+static void iree_hal_task_hazard_tracker_reset(
+    iree_hal_task_hazard_tracker_t* tracker) {
+  tracker->node_count = 0;
+  tracker->access_count = 0;
+  tracker->max_access_length = 0;
+  tracker->barrier_access_count = 0;
+}
+
+// Returns the position in the sorted access list of the first access that
+// doesn't sort before the (|buffer|, |begin|) key.
+static iree_host_size_t iree_hal_task_hazard_tracker_lower_bound(
+    const iree_hal_task_hazard_tracker_t* tracker, iree_hal_buffer_t* buffer,
+    iree_device_size_t begin) {
+  iree_host_size_t low = 0;
+  iree_host_size_t high = tracker->barrier_access_count;
+  while (low < high) {
+    iree_host_size_t mid = low + (high - low) / 2;
+    if (iree_hal_task_access_is_before(
+            &tracker->accesses[tracker->sorted_accesses[mid]], buffer,
+            begin)) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+// Returns a mask of the commands recorded prior to the last execution barrier
+// that have accesses conflicting with |access|.
+static uint64_t iree_hal_task_hazard_tracker_query(
+    const iree_hal_task_hazard_tracker_t* tracker,
+    const iree_hal_task_access_t* access) {
+  // Accesses sorted before |first_begin| end before |access| begins.
+  iree_device_size_t first_begin =
+      access->begin > tracker->max_access_length
+          ? access->begin - tracker->max_access_length
+          : 0;
+  uint64_t conflict_mask = 0;
+  for (iree_host_size_t i = iree_hal_task_hazard_tracker_lower_bound(
+           tracker, access->allocated_buffer, first_begin);
+       i < tracker->barrier_access_count; ++i) {
+    uint8_t j = tracker->sorted_accesses[i];
+    const iree_hal_task_access_t* prior_access = &tracker->accesses[j];
+    if (prior_access->allocated_buffer != access->allocated_buffer ||
+        prior_access->begin >= access->end) {
+      break;
+    }
+    if (iree_hal_task_access_is_hazard(prior_access, access)) {
+      conflict_mask |= 1ull << tracker->access_nodes[j];
+    }
+  }
+  return conflict_mask;
+}
+
+// Records the |access_count| |accesses| made by the command |node_ordinal|.
+static void iree_hal_task_hazard_tracker_append(
+    iree_hal_task_hazard_tracker_t* tracker, iree_host_size_t access_count,
+    const iree_hal_task_access_t* accesses, iree_host_size_t node_ordinal) {
+  for (iree_host_size_t i = 0; i < access_count; ++i) {
+    tracker->accesses[tracker->access_count] = accesses[i];
+    tracker->access_nodes[tracker->access_count] = (uint8_t)node_ordinal;
+    ++tracker->access_count;
+  }
+}
+
+// Marks all accesses recorded so far as being prior to an execution barrier
+// and adds them to the sorted index.
+static void iree_hal_task_hazard_tracker_barrier(
+    iree_hal_task_hazard_tracker_t* tracker) {
+  while (tracker->barrier_access_count < tracker->access_count) {
+    iree_host_size_t j = tracker->barrier_access_count;
+    const iree_hal_task_access_t* access = &tracker->accesses[j];
+    iree_host_size_t i = iree_hal_task_hazard_tracker_lower_bound(
+        tracker, access->allocated_buffer, access->begin);
+    memmove(&tracker->sorted_accesses[i + 1], &tracker->sorted_accesses[i],
+            j - i);
+    tracker->sorted_accesses[i] = (uint8_t)j;
+    tracker->max_access_length =
+        iree_max(tracker->max_access_length, access->end - access->begin);
+    ++tracker->barrier_access_count;
+  }
+}
 
 //===----------------------------------------------------------------------===//
 // iree_hal_task_command_buffer_t
@@ -35,6 +285,21 @@
 // additional allocations required during recording or execution. That means our
 // command buffer here is essentially just a builder for the task system types
 // and manager of the lifetime of the tasks.
+//
+// Reusable (non-ONE_SHOT) command buffers keep the recorded task DAG as a
+// template that is never submitted itself. Each issue clones only the task
+// headers into the submission arena and remaps the DAG edges; the command
+// payloads (buffers, bindings, push constants, etc) are immutable after
+// recording and are referenced from the template by the clones. This makes
+// resubmitting a command buffer a handful of small memcpys per command instead
+// of a full re-record.
+//
+// Execution barriers don't immediately join all prior work. Instead the buffer
+// ranges accessed by each command are tracked and a command recorded after a
+// barrier only depends on the prior commands it conflicts with (read-after-
+// write, write-after-read, or write-after-write). Independent chains of work
+// such as the branches of a model can then execute concurrently. A real global
+// barrier is only inserted when the tracking capacity is exhausted.
 typedef struct {
   iree_hal_resource_t resource;
 
@@ -46,6 +311,10 @@ typedef struct {
   // Arena used for all allocations; references the shared device block pool.
   iree_arena_allocator_t arena;
 
+  // Arena used for state only needed while recording (between begin and end).
+  // Shares the device block pool and is reset when recording ends.
+  iree_arena_allocator_t scratch_arena;
+
   // One or more tasks at the root of the command buffer task DAG.
   // These tasks are all able to execute concurrently and will be the initial
   // ready task set in the submission.
@@ -58,6 +327,12 @@ typedef struct {
   // An empty list indicates that root_tasks are also the leaves.
   iree_task_list_t leaf_tasks;
 
+  // All commands recorded into a reusable command buffer in recording order.
+  // Unused (and empty) for one-shot command buffers.
+  iree_hal_task_cmd_record_t* record_head;
+  iree_hal_task_cmd_record_t* record_tail;
+  iree_host_size_t record_count;
+
   // TODO(benvanik): move this out of the struct and allocate from the arena -
   // we only need this during recording and it's ~4KB of waste otherwise.
   // State tracked within the command buffer during recording only.
@@ -70,12 +345,9 @@ typedef struct {
     // other tasks we'll be emitting as we walk the command stream.
     iree_task_barrier_t* open_barrier;
 
-    // The number of tasks in the open barrier (|open_tasks|), used to quickly
-    // allocate storage for the task list without needing to walk the list.
-    iree_host_size_t open_task_count;
-
-    // All execution tasks emitted that must execute after |open_barrier|.
-    iree_task_list_t open_tasks;
+    // All execution tasks emitted that must execute after |open_barrier| and
+    // the buffer ranges they access. Allocated from the scratch arena.
+    iree_hal_task_hazard_tracker_t* hazards;
 
     // A flattened list of all available descriptor set bindings.
     // As descriptor sets are pushed/bound the bindings will be updated to
@@ -114,20 +386,6 @@ iree_status_t iree_hal_task_command_buffer_create(
   IREE_ASSERT_ARGUMENT(device);
   IREE_ASSERT_ARGUMENT(out_command_buffer);
   *out_command_buffer = NULL;
-  if (mode != IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT) {
-    // If we want reuse we'd need to support duplicating the task DAG after
-    // recording or have some kind of copy-on-submit behavior that does so if
-    // a command buffer is submitted for execution twice. Allowing for the same
-    // command buffer to be enqueued multiple times would be fine so long as
-    // execution doesn't overlap (`cmdbuf|cmdbuf` vs
-    // `cmdbuf -> semaphore -> cmdbuf`) though we'd still need to be careful
-    // that we did the enqueuing and reset of the task structures at the right
-    // times. Definitely something that'll be useful in the future... but not
-    // today :)
-    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                            "only one-shot command buffer usage is supported");
-  }
-
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_task_command_buffer_t* command_buffer = NULL;
@@ -142,8 +400,12 @@ iree_status_t iree_hal_task_command_buffer_create(
     command_buffer->mode = mode;
     command_buffer->allowed_categories = command_categories;
     iree_arena_initialize(block_pool, &command_buffer->arena);
+    iree_arena_initialize(block_pool, &command_buffer->scratch_arena);
     iree_task_list_initialize(&command_buffer->root_tasks);
     iree_task_list_initialize(&command_buffer->leaf_tasks);
+    command_buffer->record_head = NULL;
+    command_buffer->record_tail = NULL;
+    command_buffer->record_count = 0;
     memset(&command_buffer->state, 0, sizeof(command_buffer->state));
     *out_command_buffer = (iree_hal_command_buffer_t*)command_buffer;
   }
@@ -152,12 +414,33 @@ iree_status_t iree_hal_task_command_buffer_create(
   return status;
 }
 
+// Returns true if the command buffer may be issued multiple times.
+static inline bool iree_hal_task_command_buffer_is_reusable(
+    const iree_hal_task_command_buffer_t* command_buffer) {
+  return !iree_all_bits_set(command_buffer->mode,
+                            IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT);
+}
+
 static void iree_hal_task_command_buffer_reset(
     iree_hal_task_command_buffer_t* command_buffer) {
   memset(&command_buffer->state, 0, sizeof(command_buffer->state));
-  iree_task_list_discard(&command_buffer->leaf_tasks);
-  iree_task_list_discard(&command_buffer->root_tasks);
+  if (iree_hal_task_command_buffer_is_reusable(command_buffer)) {
+    // Template tasks are never submitted and own no resources so there's
+    // nothing to discard: all of their memory is in the arena.
+    iree_task_list_initialize(&command_buffer->leaf_tasks);
+    iree_task_list_initialize(&command_buffer->root_tasks);
+  } else if (iree_task_list_is_empty(&command_buffer->root_tasks)) {
+    iree_task_list_discard(&command_buffer->leaf_tasks);
+  } else {
+    // Leaf tasks are reachable from the roots and are discarded along with
+    // them once all of their predecessors have been.
+    iree_task_list_discard(&command_buffer->root_tasks);
+  }
+  command_buffer->record_head = NULL;
+  command_buffer->record_tail = NULL;
+  command_buffer->record_count = 0;
   iree_arena_reset(&command_buffer->arena);
+  iree_arena_reset(&command_buffer->scratch_arena);
 }
 
 static void iree_hal_task_command_buffer_destroy(
@@ -169,6 +452,7 @@ static void iree_hal_task_command_buffer_destroy(
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_task_command_buffer_reset(command_buffer);
+  iree_arena_deinitialize(&command_buffer->scratch_arena);
   iree_arena_deinitialize(&command_buffer->arena);
   iree_allocator_free(host_allocator, command_buffer);
 
@@ -189,11 +473,43 @@ iree_hal_task_command_buffer_allowed_categories(
 static iree_status_t iree_hal_task_command_buffer_flush_tasks(
     iree_hal_task_command_buffer_t* command_buffer);
 
+// Allocates |cmd_size| bytes from the command buffer arena for a command that
+// starts with a task of |task_size| bytes. Commands in reusable command buffers
+// are prefixed with an iree_hal_task_cmd_record_t so that they can be cloned on
+// issue.
+static iree_status_t iree_hal_task_command_buffer_allocate_cmd(
+    iree_hal_task_command_buffer_t* command_buffer, iree_host_size_t task_size,
+    iree_host_size_t cmd_size, void** out_cmd) {
+  if (!iree_hal_task_command_buffer_is_reusable(command_buffer)) {
+    return iree_arena_allocate(&command_buffer->arena, cmd_size, out_cmd);
+  }
+  *out_cmd = NULL;
+  iree_hal_task_cmd_record_t* record = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(
+      &command_buffer->arena, IREE_HAL_TASK_CMD_RECORD_SIZE + cmd_size,
+      (void**)&record));
+  record->next = NULL;
+  record->ordinal = command_buffer->record_count++;
+  record->task_size = task_size;
+  if (command_buffer->record_tail) {
+    command_buffer->record_tail->next = record;
+  } else {
+    command_buffer->record_head = record;
+  }
+  command_buffer->record_tail = record;
+  *out_cmd = iree_hal_task_cmd_record_task(record);
+  return iree_ok_status();
+}
+
 static iree_status_t iree_hal_task_command_buffer_begin(
     iree_hal_command_buffer_t* base_command_buffer) {
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
   iree_hal_task_command_buffer_reset(command_buffer);
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(
+      &command_buffer->scratch_arena, sizeof(*command_buffer->state.hazards),
+      (void**)&command_buffer->state.hazards));
+  iree_hal_task_hazard_tracker_reset(command_buffer->state.hazards);
   return iree_ok_status();
 }
 
@@ -214,6 +530,53 @@ static iree_status_t iree_hal_task_command_buffer_end(
                         &command_buffer->root_tasks);
   }
 
+  // Hazard tracking state is only needed while recording.
+  command_buffer->state.hazards = NULL;
+  iree_arena_reset(&command_buffer->scratch_arena);
+
+  return iree_ok_status();
+}
+
+// Sets |task| to notify all tasks in |dependent_mask| (indexing the open hazard
+// nodes) upon completion. A barrier task is inserted if there are multiple
+// dependents as tasks only have a single completion task.
+static iree_status_t iree_hal_task_command_buffer_fork_to_nodes(
+    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* task,
+    uint64_t dependent_mask) {
+  iree_host_size_t dependent_task_count =
+      iree_math_count_ones_u64(dependent_mask);
+  if (dependent_task_count == 0) return iree_ok_status();
+  iree_hal_task_hazard_node_t* nodes = command_buffer->state.hazards->nodes;
+  if (dependent_task_count == 1) {
+    // Special-case: only one dependent so we can avoid the additional barrier
+    // overhead by reusing the completion task.
+    int i = iree_math_count_trailing_zeros_u64(dependent_mask);
+    iree_task_set_completion_task(task, nodes[i].task);
+    return iree_ok_status();
+  }
+
+  iree_task_barrier_t* barrier = NULL;
+  if (task->type == IREE_TASK_TYPE_BARRIER) {
+    barrier = (iree_task_barrier_t*)task;
+  } else {
+    IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_allocate_cmd(
+        command_buffer, sizeof(*barrier), sizeof(*barrier), (void**)&barrier));
+    iree_task_barrier_initialize_empty(command_buffer->scope, barrier);
+    iree_task_set_completion_task(task, &barrier->header);
+  }
+
+  // Allocate the list of tasks we'll stash back on the barrier.
+  iree_task_t** dependent_tasks = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(
+      &command_buffer->arena, dependent_task_count * sizeof(iree_task_t*),
+      (void**)&dependent_tasks));
+  for (iree_host_size_t i = 0; i < dependent_task_count; ++i) {
+    int j = iree_math_count_trailing_zeros_u64(dependent_mask);
+    dependent_mask &= dependent_mask - 1;
+    dependent_tasks[i] = nodes[j].task;
+  }
+  iree_task_barrier_set_dependent_tasks(barrier, dependent_task_count,
+                                        dependent_tasks);
   return iree_ok_status();
 }
 
@@ -224,53 +587,65 @@ static iree_status_t iree_hal_task_command_buffer_end(
 // tasks that will be recorded after (if any).
 static iree_status_t iree_hal_task_command_buffer_flush_tasks(
     iree_hal_task_command_buffer_t* command_buffer) {
+  iree_hal_task_hazard_tracker_t* hazards = command_buffer->state.hazards;
+  iree_host_size_t node_count = hazards->node_count;
+  iree_hal_task_hazard_node_t* nodes = hazards->nodes;
+  if (node_count == 0) {
+    command_buffer->state.open_barrier = NULL;
+    return iree_ok_status();
+  }
+
+  // Partition the open tasks into those with no predecessors (roots of the
+  // open scope) and those with no dependents (leaves of the open scope).
+  uint64_t root_mask = 0;
+  uint64_t leaf_mask = 0;
+  for (iree_host_size_t i = 0; i < node_count; ++i) {
+    if (!nodes[i].predecessor_mask) root_mask |= 1ull << i;
+    if (!nodes[i].dependent_mask) leaf_mask |= 1ull << i;
+  }
+
+  // If this is the first set of tasks recorded and there are dependencies
+  // between them then we need a single root to fork from as the root and leaf
+  // task lists can't share tasks.
   iree_task_barrier_t* open_barrier = command_buffer->state.open_barrier;
+  if (open_barrier == NULL && root_mask != leaf_mask) {
+    IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_allocate_cmd(
+        command_buffer, sizeof(*open_barrier), sizeof(*open_barrier),
+        (void**)&open_barrier));
+    iree_task_barrier_initialize_empty(command_buffer->scope, open_barrier);
+    iree_task_list_push_back(&command_buffer->root_tasks,
+                             &open_barrier->header);
+  }
+
+  // Fork out from the previous barrier to all of the open tasks that don't
+  // depend on other open tasks and then between the open tasks.
   if (open_barrier != NULL) {
-    // There is an open barrier we need to fixup the fork out to all of the open
-    // tasks that were recorded after it.
-    iree_task_t* task_head =
-        iree_task_list_front(&command_buffer->state.open_tasks);
-    iree_host_size_t dependent_task_count =
-        command_buffer->state.open_task_count;
-    if (dependent_task_count == 1) {
-      // Special-case: only one open task so we can avoid the additional barrier
-      // overhead by reusing the completion task.
-      iree_task_set_completion_task(&open_barrier->header, task_head);
-    } else if (dependent_task_count > 1) {
-      // Allocate the list of tasks we'll stash back on the previous barrier.
-      // Since we couldn't know at the time how many tasks would end up in the
-      // barrier we had to defer it until now.
-      iree_task_t** dependent_tasks = NULL;
-      IREE_RETURN_IF_ERROR(iree_arena_allocate(
-          &command_buffer->arena, dependent_task_count * sizeof(iree_task_t*),
-          (void**)&dependent_tasks));
-      iree_task_t* task = task_head;
-      for (iree_host_size_t i = 0; i < dependent_task_count; ++i) {
-        dependent_tasks[i] = task;
-        task = task->next_task;
-      }
-      iree_task_barrier_set_dependent_tasks(open_barrier, dependent_task_count,
-                                            dependent_tasks);
-    }
+    IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_fork_to_nodes(
+        command_buffer, &open_barrier->header, root_mask));
+  }
+  for (iree_host_size_t i = 0; i < node_count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_fork_to_nodes(
+        command_buffer, nodes[i].task, nodes[i].dependent_mask));
   }
   command_buffer->state.open_barrier = NULL;
 
-  // Move the open tasks to the tail as they represent the first half of the
-  // *next* barrier that will be inserted.
-  if (command_buffer->state.open_task_count > 0) {
-    iree_task_list_move(&command_buffer->state.open_tasks,
-                        &command_buffer->leaf_tasks);
-    command_buffer->state.open_task_count = 0;
+  // The open tasks without dependents are now the tail as they represent the
+  // first half of the *next* barrier that will be inserted.
+  iree_task_list_initialize(&command_buffer->leaf_tasks);
+  for (iree_host_size_t i = 0; i < node_count; ++i) {
+    if (leaf_mask & (1ull << i)) {
+      iree_task_list_push_back(&command_buffer->leaf_tasks, nodes[i].task);
+    }
   }
+  iree_hal_task_hazard_tracker_reset(hazards);
 
   return iree_ok_status();
 }
 
 // Emits a global barrier, splitting execution into all prior recorded tasks
-// and all subsequent recorded tasks. This is currently the critical piece that
-// limits our concurrency: changing to fine-grained barriers (via barrier
-// buffers or events) will allow more work to overlap at the cost of more brain
-// to build out the proper task graph.
+// and all subsequent recorded tasks. This is only used when hazard tracking
+// runs out of capacity as it limits concurrency: nothing recorded after the
+// barrier can overlap with anything recorded before it.
 static iree_status_t iree_hal_task_command_buffer_emit_global_barrier(
     iree_hal_task_command_buffer_t* command_buffer) {
   // Flush open tasks to the previous barrier. This resets our state such that
@@ -285,8 +660,8 @@ static iree_status_t iree_hal_task_command_buffer_emit_global_barrier(
   // it so we can setup the join from previous tasks (the first half of the
   // synchronization domain).
   iree_task_barrier_t* barrier = NULL;
-  IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
-                                           sizeof(*barrier), (void**)&barrier));
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_allocate_cmd(
+      command_buffer, sizeof(*barrier), sizeof(*barrier), (void**)&barrier));
   iree_task_barrier_initialize_empty(command_buffer->scope, barrier);
 
   // If there were previous tasks then join them to the barrier.
@@ -311,24 +686,58 @@ static iree_status_t iree_hal_task_command_buffer_emit_global_barrier(
 
   // NOTE: all new tasks emitted will be executed after this barrier.
   command_buffer->state.open_barrier = barrier;
-  command_buffer->state.open_task_count = 0;
 
   return iree_ok_status();
 }
 
 // Emits a the given execution |task| into the current open synchronization
-// scope (after state.open_barrier and before the next barrier).
+// scope (after state.open_barrier and before the next barrier). The task will
+// depend on all prior tasks in the scope recorded before an execution barrier
+// that have accesses conflicting with |accesses|.
 static iree_status_t iree_hal_task_command_buffer_emit_execution_task(
-    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* task) {
-  if (command_buffer->state.open_barrier == NULL) {
-    // If there is no open barrier then we are at the head and going right into
-    // the task DAG.
-    iree_task_list_push_back(&command_buffer->leaf_tasks, task);
-  } else {
-    // Append to the open task list that will be flushed to the open barrier.
-    iree_task_list_push_back(&command_buffer->state.open_tasks, task);
-    ++command_buffer->state.open_task_count;
+    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* task,
+    iree_host_size_t access_count, const iree_hal_task_access_t* accesses) {
+  IREE_ASSERT_LE(access_count,
+                 IREE_HAL_TASK_COMMAND_BUFFER_MAX_HAZARD_ACCESSES);
+  iree_hal_task_hazard_tracker_t* hazards = command_buffer->state.hazards;
+  if (hazards->node_count == IREE_HAL_TASK_COMMAND_BUFFER_MAX_HAZARD_COMMANDS ||
+      hazards->access_count + access_count >
+          IREE_HAL_TASK_COMMAND_BUFFER_MAX_HAZARD_ACCESSES) {
+    // Out of tracking capacity: conservatively join all prior work.
+    IREE_RETURN_IF_ERROR(
+        iree_hal_task_command_buffer_emit_global_barrier(command_buffer));
+  }
+
+  // Find all open tasks separated from this one by a barrier that it conflicts
+  // with.
+  uint64_t conflict_mask = 0;
+  for (iree_host_size_t i = 0; i < access_count; ++i) {
+    conflict_mask |= iree_hal_task_hazard_tracker_query(hazards, &accesses[i]);
+  }
+
+  // Drop conflicting tasks that are already ordered before another one.
+  iree_hal_task_hazard_node_t* nodes = hazards->nodes;
+  uint64_t ancestor_mask = 0;
+  for (uint64_t mask = conflict_mask; mask; mask &= mask - 1) {
+    ancestor_mask |= nodes[iree_math_count_trailing_zeros_u64(mask)]
+                         .ancestor_mask;
+  }
+  uint64_t predecessor_mask = conflict_mask & ~ancestor_mask;
+
+  iree_host_size_t node_ordinal = hazards->node_count++;
+  for (uint64_t mask = predecessor_mask; mask; mask &= mask - 1) {
+    nodes[iree_math_count_trailing_zeros_u64(mask)].dependent_mask |=
+        1ull << node_ordinal;
   }
+  iree_hal_task_hazard_node_t* node = &nodes[node_ordinal];
+  node->task = task;
+  node->predecessor_mask = predecessor_mask;
+  node->ancestor_mask = ancestor_mask | conflict_mask;
+  node->dependent_mask = 0;
+
+  iree_hal_task_hazard_tracker_append(hazards, access_count, accesses,
+                                      node_ordinal);
+
   return iree_ok_status();
 }
 
@@ -336,6 +745,94 @@ static iree_status_t iree_hal_task_command_buffer_emit_execution_task(
 // iree_hal_task_command_buffer_t execution
 //===----------------------------------------------------------------------===//
 
+// Clones the template task DAG of a reusable |command_buffer| into |arena|.
+// Only the task headers are cloned: the closures of the cloned tasks continue
+// to reference the template commands as they are immutable after recording.
+// |out_tasks| will receive a map of command ordinal to cloned task.
+static iree_status_t iree_hal_task_command_buffer_clone_tasks(
+    iree_hal_task_command_buffer_t* command_buffer,
+    iree_arena_allocator_t* arena, iree_task_t*** out_tasks) {
+  *out_tasks = NULL;
+
+  iree_task_t** tasks = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(
+      arena, command_buffer->record_count * sizeof(*tasks), (void**)&tasks));
+  for (iree_hal_task_cmd_record_t* record = command_buffer->record_head;
+       record != NULL; record = record->next) {
+    iree_task_t* task = NULL;
+    IREE_RETURN_IF_ERROR(
+        iree_arena_allocate(arena, record->task_size, (void**)&task));
+    memcpy(task, iree_hal_task_cmd_record_task(record), record->task_size);
+    task->next_task = NULL;
+    tasks[record->ordinal] = task;
+  }
+
+  // Remap the DAG edges from the template tasks to their clones. The pending
+  // dependency counts were copied from the template and need no fixup.
+  for (iree_hal_task_cmd_record_t* record = command_buffer->record_head;
+       record != NULL; record = record->next) {
+    const iree_task_t* template_task = iree_hal_task_cmd_record_task(record);
+    iree_task_t* task = tasks[record->ordinal];
+    if (template_task->completion_task) {
+      task->completion_task = tasks[iree_hal_task_cmd_record_ordinal(
+          template_task->completion_task)];
+    }
+    if (task->type == IREE_TASK_TYPE_BARRIER) {
+      iree_task_barrier_t* barrier = (iree_task_barrier_t*)task;
+      if (barrier->dependent_task_count == 0) continue;
+      iree_task_t** dependent_tasks = NULL;
+      IREE_RETURN_IF_ERROR(iree_arena_allocate(
+          arena, barrier->dependent_task_count * sizeof(*dependent_tasks),
+          (void**)&dependent_tasks));
+      for (iree_host_size_t i = 0; i < barrier->dependent_task_count; ++i) {
+        dependent_tasks[i] = tasks[iree_hal_task_cmd_record_ordinal(
+            barrier->dependent_tasks[i])];
+      }
+      barrier->dependent_tasks = dependent_tasks;
+    }
+  }
+
+  *out_tasks = tasks;
+  return iree_ok_status();
+}
+
+// Issues a clone of the template task DAG of a reusable |command_buffer|.
+// The command buffer itself is not modified and may be issued again
+// (including concurrently) so long as it is not reset or released while any
+// issue is in-flight.
+static iree_status_t iree_hal_task_command_buffer_issue_reusable(
+    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* retire_task,
+    iree_arena_allocator_t* arena, iree_task_submission_t* pending_submission) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_task_t** tasks = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0,
+      iree_hal_task_command_buffer_clone_tasks(command_buffer, arena, &tasks));
+
+  // Chain the retire task onto the clones of the leaf tasks (or the root tasks
+  // if this is a single layer DAG).
+  const iree_task_list_t* leaf_tasks =
+      iree_task_list_is_empty(&command_buffer->leaf_tasks)
+          ? &command_buffer->root_tasks
+          : &command_buffer->leaf_tasks;
+  for (iree_task_t* task = leaf_tasks->head; task != NULL;
+       task = task->next_task) {
+    iree_task_set_completion_task(
+        tasks[iree_hal_task_cmd_record_ordinal(task)], retire_task);
+  }
+
+  // Enqueue the clones of all root tasks that are ready to run immediately.
+  for (iree_task_t* task = command_buffer->root_tasks.head; task != NULL;
+       task = task->next_task) {
+    iree_task_submission_enqueue(pending_submission,
+                                 tasks[iree_hal_task_cmd_record_ordinal(task)]);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
 iree_status_t iree_hal_task_command_buffer_issue(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_task_queue_state_t* queue_state, iree_task_t* retire_task,
@@ -349,6 +846,12 @@ iree_status_t iree_hal_task_command_buffer_issue(
     return iree_ok_status();
   }
 
+  // Reusable command buffers keep their tasks as a template and issue clones.
+  if (iree_hal_task_command_buffer_is_reusable(command_buffer)) {
+    return iree_hal_task_command_buffer_issue_reusable(
+        command_buffer, retire_task, arena, pending_submission);
+  }
+
   bool has_leaf_tasks = !iree_task_list_is_empty(&command_buffer->leaf_tasks);
   if (has_leaf_tasks) {
     // Chain the retire task onto the leaf tasks as their completion indicates
@@ -392,9 +895,11 @@ static iree_status_t iree_hal_task_command_buffer_execution_barrier(
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
 
-  // TODO(benvanik): actual DAG construction. Right now we are just doing simple
-  // global barriers each time and forcing a join-fork point.
-  return iree_hal_task_command_buffer_emit_global_barrier(command_buffer);
+  // NOTE: the barrier is only noted here; commands recorded after it will
+  // depend on the commands recorded before it that they conflict with.
+  // TODO(benvanik): use the buffer barriers to scope the hazards.
+  iree_hal_task_hazard_tracker_barrier(command_buffer->state.hazards);
+  return iree_ok_status();
 }
 
 //===----------------------------------------------------------------------===//
@@ -434,8 +939,9 @@ static iree_status_t iree_hal_task_command_buffer_wait_events(
     const iree_hal_buffer_barrier_t* buffer_barriers) {
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
-  // TODO(#4518): implement events. For now we just insert global barriers.
-  return iree_hal_task_command_buffer_emit_global_barrier(command_buffer);
+  // TODO(#4518): implement events. For now we just treat waits as barriers.
+  iree_hal_task_hazard_tracker_barrier(command_buffer->state.hazards);
+  return iree_ok_status();
 }
 
 //===----------------------------------------------------------------------===//
@@ -447,18 +953,85 @@ static iree_status_t iree_hal_task_command_buffer_discard_buffer(
   return iree_ok_status();
 }
 
+//===----------------------------------------------------------------------===//
+// Transfer tiling
+//===----------------------------------------------------------------------===//
+// Large fills and copies are recorded as dispatches with one workgroup per
+// IREE_HAL_TASK_TRANSFER_TILE_SIZE bytes so that they are spread across all
+// workers instead of stalling a single one.
+
+// Returns the number of tiles used to transfer |length| bytes or 0 if the
+// transfer should be performed by a single call.
+static uint32_t iree_hal_task_transfer_tile_count(iree_device_size_t length) {
+  if (length < IREE_HAL_TASK_TRANSFER_MIN_SPLIT_SIZE) return 0;
+  return (uint32_t)((length + IREE_HAL_TASK_TRANSFER_TILE_SIZE - 1) /
+                    IREE_HAL_TASK_TRANSFER_TILE_SIZE);
+}
+
+// Initializes |out_task| to dispatch |closure| over |tile_count| tiles.
+static void iree_hal_task_transfer_dispatch_initialize(
+    iree_task_scope_t* scope, iree_task_dispatch_closure_t closure,
+    uint32_t tile_count, iree_task_dispatch_t* out_task) {
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {tile_count, 1, 1};
+  iree_task_dispatch_initialize(scope, closure, workgroup_size,
+                                workgroup_count, out_task);
+}
+
+// Returns the byte range of |length| covered by the tile in |tile_context|.
+static void iree_hal_task_transfer_tile_range(
+    const iree_task_tile_context_t* tile_context, iree_device_size_t length,
+    iree_device_size_t* out_tile_offset, iree_device_size_t* out_tile_length) {
+  iree_device_size_t tile_offset =
+      (iree_device_size_t)tile_context->workgroup_xyz[0] *
+      IREE_HAL_TASK_TRANSFER_TILE_SIZE;
+  *out_tile_offset = tile_offset;
+  *out_tile_length =
+      iree_min(length - tile_offset, IREE_HAL_TASK_TRANSFER_TILE_SIZE);
+}
+
+#if defined(IREE_ARCH_X86_64)
+// Fills |length| bytes at |target| with |pattern| using non-temporal stores.
+static void iree_hal_task_fill_nontemporal(uint8_t* target,
+                                           iree_host_size_t length,
+                                           const uint8_t* pattern,
+                                           iree_host_size_t pattern_length) {
+  // Stores are aligned to 16 bytes: the unaligned head is written bytewise and
+  // as 16 is a multiple of the pattern length the pattern then has the same
+  // phase at every 16 byte boundary.
+  iree_host_size_t head_length =
+      iree_min(length, (16 - ((uintptr_t)target & 15)) & 15);
+  for (iree_host_size_t i = 0; i < head_length; ++i) {
+    target[i] = pattern[i % pattern_length];
+  }
+  uint8_t pattern_bytes[16];
+  for (iree_host_size_t i = 0; i < sizeof(pattern_bytes); ++i) {
+    pattern_bytes[i] = pattern[(head_length + i) % pattern_length];
+  }
+  target += head_length;
+  length -= head_length;
+  __m128i value = _mm_loadu_si128((const __m128i*)pattern_bytes);
+  for (; length >= 16; target += 16, length -= 16) {
+    _mm_stream_si128((__m128i*)target, value);
+  }
+  memcpy(target, pattern_bytes, length);
+  _mm_sfence();
+}
+#endif  // IREE_ARCH_X86_64
+
 //===----------------------------------------------------------------------===//
 // iree_hal_command_buffer_fill_buffer
 //===----------------------------------------------------------------------===//
-// NOTE: for large fills we could dispatch this as tiles for parallelism.
-// We'd want to do some measurement for when it's worth it; filling a 200KB
-// buffer: maybe not, filling a 200MB buffer: yeah.
 
 typedef struct {
-  iree_task_call_t task;
+  union {
+    iree_task_call_t call;
+    iree_task_dispatch_t dispatch;
+  } task;
   iree_hal_buffer_t* target_buffer;
   iree_device_size_t target_offset;
   iree_device_size_t length;
+  bool nontemporal;
   uint32_t pattern_length;
   uint8_t pattern[8];
 } iree_hal_cmd_fill_buffer_t;
@@ -476,6 +1049,47 @@ static iree_status_t iree_hal_cmd_fill_buffer(
   return status;
 }
 
+static iree_status_t iree_hal_cmd_fill_buffer_tile(
+    uintptr_t user_context, const iree_task_tile_context_t* tile_context,
+    iree_task_submission_t* pending_submission) {
+  const iree_hal_cmd_fill_buffer_t* cmd =
+      (const iree_hal_cmd_fill_buffer_t*)user_context;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_device_size_t tile_offset = 0;
+  iree_device_size_t tile_length = 0;
+  iree_hal_task_transfer_tile_range(tile_context, cmd->length, &tile_offset,
+                                    &tile_length);
+#if defined(IREE_ARCH_X86_64)
+  if (cmd->nontemporal) {
+    iree_hal_buffer_mapping_t target_mapping;
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0,
+        iree_hal_buffer_map_range(
+            cmd->target_buffer, IREE_HAL_MEMORY_ACCESS_DISCARD_WRITE,
+            cmd->target_offset + tile_offset, tile_length, &target_mapping));
+    iree_hal_task_fill_nontemporal(target_mapping.contents.data,
+                                   target_mapping.contents.data_length,
+                                   cmd->pattern, cmd->pattern_length);
+    iree_status_t status = iree_ok_status();
+    if (!iree_all_bits_set(iree_hal_buffer_memory_type(cmd->target_buffer),
+                           IREE_HAL_MEMORY_TYPE_HOST_COHERENT)) {
+      status =
+          iree_hal_buffer_flush_range(&target_mapping, 0, IREE_WHOLE_BUFFER);
+    }
+    iree_hal_buffer_unmap_range(&target_mapping);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+#endif  // IREE_ARCH_X86_64
+
+  iree_status_t status = iree_hal_buffer_fill(
+      cmd->target_buffer, cmd->target_offset + tile_offset, tile_length,
+      cmd->pattern, cmd->pattern_length);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 static iree_status_t iree_hal_task_command_buffer_fill_buffer(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_buffer_t* target_buffer, iree_device_size_t target_offset,
@@ -484,22 +1098,58 @@ static iree_status_t iree_hal_task_command_buffer_fill_buffer(
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
 
-  iree_hal_cmd_fill_buffer_t* cmd = NULL;
-  IREE_RETURN_IF_ERROR(
-      iree_arena_allocate(&command_buffer->arena, sizeof(*cmd), (void**)&cmd));
+  if (IREE_UNLIKELY(pattern_length != 1 && pattern_length != 2 &&
+                    pattern_length != 4)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "fill patterns must be 1, 2, or 4 bytes (got %zu)",
+                            pattern_length);
+  }
+  if (length == IREE_WHOLE_BUFFER) {
+    length = iree_hal_buffer_byte_length(target_buffer) - target_offset;
+  }
+  if (IREE_UNLIKELY((target_offset % pattern_length) != 0) ||
+      IREE_UNLIKELY((length % pattern_length) != 0)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "attempting to fill a range with %zu byte values "
+                            "that is not aligned (offset=%" PRIu64
+                            ", length=%" PRIu64 ")",
+                            pattern_length, target_offset, length);
+  }
+  uint32_t tile_count = iree_hal_task_transfer_tile_count(length);
 
-  iree_task_call_initialize(
-      command_buffer->scope,
-      iree_task_make_call_closure(iree_hal_cmd_fill_buffer, (uintptr_t)cmd),
-      &cmd->task);
+  iree_hal_cmd_fill_buffer_t* cmd = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_allocate_cmd(
+      command_buffer,
+      tile_count ? sizeof(cmd->task.dispatch) : sizeof(cmd->task.call),
+      sizeof(*cmd), (void**)&cmd));
+
+  if (tile_count) {
+    iree_hal_task_transfer_dispatch_initialize(
+        command_buffer->scope,
+        iree_task_make_dispatch_closure(iree_hal_cmd_fill_buffer_tile,
+                                        (uintptr_t)cmd),
+        tile_count, &cmd->task.dispatch);
+  } else {
+    iree_task_call_initialize(
+        command_buffer->scope,
+        iree_task_make_call_closure(iree_hal_cmd_fill_buffer, (uintptr_t)cmd),
+        &cmd->task.call);
+  }
   cmd->target_buffer = target_buffer;
   cmd->target_offset = target_offset;
   cmd->length = length;
+#if defined(IREE_ARCH_X86_64)
+  cmd->nontemporal = length >= IREE_HAL_TASK_TRANSFER_MIN_NONTEMPORAL_SIZE;
+#else
+  cmd->nontemporal = false;
+#endif  // IREE_ARCH_X86_64
   memcpy(cmd->pattern, pattern, pattern_length);
   cmd->pattern_length = pattern_length;
 
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  iree_hal_task_access_t access = iree_hal_task_access_make(
+      target_buffer, target_offset, length, /*is_write=*/true);
+  return iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.call.header, 1, &access);
 }
 
 //===----------------------------------------------------------------------===//
@@ -537,8 +1187,8 @@ static iree_status_t iree_hal_task_command_buffer_update_buffer(
       sizeof(iree_hal_cmd_update_buffer_t) + length;
 
   iree_hal_cmd_update_buffer_t* cmd = NULL;
-  IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
-                                           total_cmd_size, (void**)&cmd));
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_allocate_cmd(
+      command_buffer, sizeof(cmd->task), total_cmd_size, (void**)&cmd));
 
   iree_task_call_initialize(
       command_buffer->scope,
@@ -551,19 +1201,21 @@ static iree_status_t iree_hal_task_command_buffer_update_buffer(
   memcpy(cmd->source_buffer, (const uint8_t*)source_buffer + source_offset,
          cmd->length);
 
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  iree_hal_task_access_t access = iree_hal_task_access_make(
+      target_buffer, target_offset, length, /*is_write=*/true);
+  return iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.header, 1, &access);
 }
 
 //===----------------------------------------------------------------------===//
 // iree_hal_command_buffer_copy_buffer
 //===----------------------------------------------------------------------===//
-// NOTE: for large copies we could dispatch this as tiles for parallelism.
-// We'd want to do some measurement for when it's worth it; copying a 200KB
-// buffer: maybe not, copying a 200MB buffer: yeah.
 
 typedef struct {
-  iree_task_call_t task;
+  union {
+    iree_task_call_t call;
+    iree_task_dispatch_t dispatch;
+  } task;
   iree_hal_buffer_t* source_buffer;
   iree_device_size_t source_offset;
   iree_hal_buffer_t* target_buffer;
@@ -584,6 +1236,25 @@ static iree_status_t iree_hal_cmd_copy_buffer(
   return status;
 }
 
+static iree_status_t iree_hal_cmd_copy_buffer_tile(
+    uintptr_t user_context, const iree_task_tile_context_t* tile_context,
+    iree_task_submission_t* pending_submission) {
+  const iree_hal_cmd_copy_buffer_t* cmd =
+      (const iree_hal_cmd_copy_buffer_t*)user_context;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_device_size_t tile_offset = 0;
+  iree_device_size_t tile_length = 0;
+  iree_hal_task_transfer_tile_range(tile_context, cmd->length, &tile_offset,
+                                    &tile_length);
+  iree_status_t status = iree_hal_buffer_copy_data(
+      cmd->source_buffer, cmd->source_offset + tile_offset, cmd->target_buffer,
+      cmd->target_offset + tile_offset, tile_length);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 static iree_status_t iree_hal_task_command_buffer_copy_buffer(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_buffer_t* source_buffer, iree_device_size_t source_offset,
@@ -592,22 +1263,47 @@ static iree_status_t iree_hal_task_command_buffer_copy_buffer(
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
 
-  iree_hal_cmd_copy_buffer_t* cmd = NULL;
-  IREE_RETURN_IF_ERROR(
-      iree_arena_allocate(&command_buffer->arena, sizeof(*cmd), (void**)&cmd));
+  if (length == IREE_WHOLE_BUFFER) {
+    // Whole buffer copy requested - that could mean either, so take the min.
+    length =
+        iree_min(iree_hal_buffer_byte_length(source_buffer) - source_offset,
+                 iree_hal_buffer_byte_length(target_buffer) - target_offset);
+  }
+  uint32_t tile_count = iree_hal_task_transfer_tile_count(length);
 
-  iree_task_call_initialize(
-      command_buffer->scope,
-      iree_task_make_call_closure(iree_hal_cmd_copy_buffer, (uintptr_t)cmd),
-      &cmd->task);
+  iree_hal_cmd_copy_buffer_t* cmd = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_allocate_cmd(
+      command_buffer,
+      tile_count ? sizeof(cmd->task.dispatch) : sizeof(cmd->task.call),
+      sizeof(*cmd), (void**)&cmd));
+
+  if (tile_count) {
+    iree_hal_task_transfer_dispatch_initialize(
+        command_buffer->scope,
+        iree_task_make_dispatch_closure(iree_hal_cmd_copy_buffer_tile,
+                                        (uintptr_t)cmd),
+        tile_count, &cmd->task.dispatch);
+  } else {
+    iree_task_call_initialize(
+        command_buffer->scope,
+        iree_task_make_call_closure(iree_hal_cmd_copy_buffer, (uintptr_t)cmd),
+        &cmd->task.call);
+  }
   cmd->source_buffer = (iree_hal_buffer_t*)source_buffer;
   cmd->source_offset = source_offset;
   cmd->target_buffer = (iree_hal_buffer_t*)target_buffer;
   cmd->target_offset = target_offset;
   cmd->length = length;
 
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  iree_hal_task_access_t accesses[2] = {
+      iree_hal_task_access_make(source_buffer, source_offset, length,
+                                /*is_write=*/false),
+      iree_hal_task_access_make(target_buffer, target_offset, length,
+                                /*is_write=*/true),
+  };
+  return iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.call.header, IREE_ARRAYSIZE(accesses),
+      accesses);
 }
 
 //===----------------------------------------------------------------------===//
@@ -668,16 +1364,25 @@ static iree_status_t iree_hal_task_command_buffer_push_descriptor_set(
                               "buffer binding index out of bounds");
     }
     iree_host_size_t binding_ordinal = binding_base + bindings[i].binding;
+    iree_hal_memory_access_t access =
+        local_set_layout->bindings[binding_ordinal].access;
 
     // TODO(benvanik): track mapping so we can properly map/unmap/flush/etc.
     iree_hal_buffer_mapping_t buffer_mapping;
     IREE_RETURN_IF_ERROR(iree_hal_buffer_map_range(
-        bindings[i].buffer, local_set_layout->bindings[binding_ordinal].access,
-        bindings[i].offset, bindings[i].length, &buffer_mapping));
+        bindings[i].buffer, access, bindings[i].offset, bindings[i].length,
+        &buffer_mapping));
     command_buffer->state.bindings[binding_ordinal] =
         buffer_mapping.contents.data;
     command_buffer->state.binding_lengths[binding_ordinal] =
         buffer_mapping.contents.data_length;
+
+    command_buffer->state.hazards->binding_accesses[binding_ordinal] =
+        iree_hal_task_access_make(
+            bindings[i].buffer, bindings[i].offset,
+            buffer_mapping.contents.data_length,
+            iree_any_bit_set(access, IREE_HAL_MEMORY_ACCESS_WRITE |
+                                         IREE_HAL_MEMORY_ACCESS_DISCARD));
   }
 
   return iree_ok_status();
@@ -718,15 +1423,21 @@ static iree_status_t iree_hal_cmd_dispatch_tile(
       (const iree_hal_cmd_dispatch_t*)user_context;
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_hal_executable_dispatch_state_v0_t state;
   // TODO(benvanik): wire up device state (imports, etc) and cache on the
   // command buffer for reuse across all tiles.
+  iree_hal_executable_dispatch_state_v1_t state = {
+      .worker_id = tile_context->worker_id,
+      .worker_count = tile_context->worker_count,
+      .cpu_features = cmd->executable->cpu_features,
+  };
 
   iree_hal_local_executable_call_t call = {
       .state = &state,
       .push_constants = cmd->push_constants,
       .bindings = cmd->bindings,
       .binding_lengths = cmd->binding_lengths,
+      .local_memory =
+          cmd->task.local_memory_size ? tile_context->local_memory.data : NULL,
   };
   memcpy(call.workgroup_id.value, tile_context->workgroup_xyz,
          sizeof(iree_hal_vec3_t));
@@ -745,6 +1456,7 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_executable_t* executable, int32_t entry_point,
     uint32_t workgroup_x, uint32_t workgroup_y, uint32_t workgroup_z,
+    const iree_hal_task_access_t* indirect_access,
     iree_hal_cmd_dispatch_t** out_cmd) {
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
@@ -757,14 +1469,26 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
   iree_hal_local_binding_mask_t used_binding_mask = local_layout->used_bindings;
   iree_host_size_t used_binding_count =
       iree_math_count_ones_u64(used_binding_mask);
+  iree_host_size_t local_memory_size =
+      local_executable->local_memory_sizes
+          ? local_executable->local_memory_sizes[entry_point]
+          : 0;
+  if (IREE_UNLIKELY(local_memory_size >
+                    IREE_TASK_WORKER_MAX_LOCAL_MEMORY_SIZE)) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "entry point %d requires %zu bytes of local memory "
+                            "but workers have a maximum of %d",
+                            entry_point, local_memory_size,
+                            IREE_TASK_WORKER_MAX_LOCAL_MEMORY_SIZE);
+  }
 
   iree_hal_cmd_dispatch_t* cmd = NULL;
   iree_host_size_t total_cmd_size =
       sizeof(*cmd) + push_constant_count * sizeof(uint32_t) +
       used_binding_count * sizeof(iree_hal_executable_binding_ptr_t) +
       used_binding_count * sizeof(iree_device_size_t);
-  IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
-                                           total_cmd_size, (void**)&cmd));
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_allocate_cmd(
+      command_buffer, sizeof(cmd->task), total_cmd_size, (void**)&cmd));
 
   cmd->executable = local_executable;
   cmd->ordinal = entry_point;
@@ -776,6 +1500,11 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
                                 iree_task_make_dispatch_closure(
                                     iree_hal_cmd_dispatch_tile, (uintptr_t)cmd),
                                 workgroup_size, workgroup_count, &cmd->task);
+  cmd->task.local_memory_size = local_memory_size;
+
+  // Profile the dispatch so that subsequent dispatches of the same entry point
+  // are tiled based on how long its workgroups take to execute.
+  cmd->task.profile = &local_executable->dispatch_profiles[entry_point];
 
   // Copy only the push constant range used by the executable.
   uint8_t* cmd_ptr = (uint8_t*)cmd + sizeof(*cmd);
@@ -796,6 +1525,11 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
   cmd_ptr += used_binding_count * sizeof(*cmd->bindings);
   cmd->binding_lengths = (iree_device_size_t*)cmd_ptr;
   cmd_ptr += used_binding_count * sizeof(*cmd->binding_lengths);
+  iree_hal_task_access_t
+      accesses[IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *
+                   IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT +
+               1];
+  iree_host_size_t access_count = 0;
   iree_host_size_t binding_base = 0;
   for (iree_host_size_t i = 0; i < used_binding_count; ++i) {
     int mask_offset = iree_math_count_trailing_zeros_u64(used_binding_mask);
@@ -809,11 +1543,16 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
       return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
                               "(flat) binding %d is NULL", binding_ordinal);
     }
+    accesses[access_count++] =
+        command_buffer->state.hazards->binding_accesses[binding_ordinal];
+  }
+  if (indirect_access) {
+    accesses[access_count++] = *indirect_access;
   }
 
   *out_cmd = cmd;
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  return iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.header, access_count, accesses);
 }
 
 static iree_status_t iree_hal_task_command_buffer_dispatch(
@@ -823,7 +1562,7 @@ static iree_status_t iree_hal_task_command_buffer_dispatch(
   iree_hal_cmd_dispatch_t* cmd = NULL;
   return iree_hal_task_command_buffer_build_dispatch(
       base_command_buffer, executable, entry_point, workgroup_x, workgroup_y,
-      workgroup_z, &cmd);
+      workgroup_z, /*indirect_access=*/NULL, &cmd);
 }
 
 static iree_status_t iree_hal_task_command_buffer_dispatch_indirect(
@@ -837,9 +1576,16 @@ static iree_status_t iree_hal_task_command_buffer_dispatch_indirect(
       workgroups_buffer, IREE_HAL_MEMORY_ACCESS_READ, workgroups_offset,
       3 * sizeof(uint32_t), &buffer_mapping));
 
+  // The workgroup count is read when the dispatch is issued and must be
+  // ordered after any command that produces it.
+  iree_hal_task_access_t indirect_access =
+      iree_hal_task_access_make(workgroups_buffer, workgroups_offset,
+                                3 * sizeof(uint32_t), /*is_write=*/false);
+
   iree_hal_cmd_dispatch_t* cmd = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_build_dispatch(
-      base_command_buffer, executable, entry_point, 0, 0, 0, &cmd));
+      base_command_buffer, executable, entry_point, 0, 0, 0, &indirect_access,
+      &cmd));
   cmd->task.workgroup_count.ptr = (const uint32_t*)buffer_mapping.contents.data;
   cmd->task.header.flags |= IREE_TASK_FLAG_DISPATCH_INDIRECT;
   return iree_ok_status();
@@ -25,6 +25,10 @@
 extern "C" {
 #endif  // __cplusplus
 
+// Creates a command buffer that records into a task DAG for |scope|.
+// Command buffers created without IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT are
+// reusable: the recorded DAG is kept as a template and each issue enqueues a
+// clone of it allocated from the issuing submission arena.
 iree_status_t iree_hal_task_command_buffer_create(
     iree_hal_device_t* device, iree_task_scope_t* scope,
     iree_hal_command_buffer_mode_t mode,
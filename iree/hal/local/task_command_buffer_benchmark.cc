@@ -0,0 +1,294 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the rate at which the same command buffer shape can be submitted to
+// a task device. One-shot command buffers must be re-recorded for every
+// submission while reusable command buffers are recorded once and have their
+// task DAG cloned on each issue.
+//
+// Also measures how command buffers with independent chains of work separated
+// by execution barriers execute: barriers only order commands that access
+// overlapping buffer ranges and chains of differing cost should not wait on
+// each other.
+//
+// Large fills and copies are split across workers; these are compared against
+// performing the same transfer on the calling thread as a single call task
+// would.
+
+#include "benchmark/benchmark.h"
+#include "iree/base/api.h"
+#include "iree/base/logging.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/task_device.h"
+#include "iree/task/executor.h"
+#include "iree/task/topology.h"
+
+namespace {
+
+// Number of commands recorded between each execution barrier.
+constexpr int kCommandsPerBarrier = 4;
+
+// Bytes filled by each command.
+constexpr iree_device_size_t kCommandLength = 64;
+
+// Worker groups used when measuring large transfers.
+constexpr iree_host_size_t kTransferGroupCount = 4;
+
+struct DeviceState {
+  DeviceState(iree_device_size_t buffer_size, iree_host_size_t group_count) {
+    iree_task_topology_t topology;
+    iree_task_topology_initialize_from_group_count(group_count, &topology);
+    IREE_CHECK_OK(iree_task_executor_create(
+        IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+        IREE_TASK_EXECUTOR_DEFAULT_WORKER_SPIN_NS, iree_allocator_system(),
+        &executor));
+    iree_task_topology_deinitialize(&topology);
+
+    iree_hal_task_device_params_t params;
+    iree_hal_task_device_params_initialize(&params);
+    IREE_CHECK_OK(iree_hal_task_device_create(
+        iree_make_cstring_view("task"), &params, executor,
+        /*loader_count=*/0, /*loaders=*/NULL, /*executable_store=*/NULL,
+        iree_allocator_system(), &device));
+
+    IREE_CHECK_OK(iree_hal_allocator_allocate_buffer(
+        iree_hal_device_allocator(device),
+        IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_ALL, buffer_size, &buffer));
+
+    IREE_CHECK_OK(iree_hal_semaphore_create(device, 0ull, &semaphore));
+  }
+
+  ~DeviceState() {
+    iree_hal_semaphore_release(semaphore);
+    iree_hal_buffer_release(buffer);
+    iree_hal_device_release(device);
+    iree_task_executor_release(executor);
+  }
+
+  // Records |command_count| fills split into layers by execution barriers.
+  iree_hal_command_buffer_t* Record(iree_hal_command_buffer_mode_t mode,
+                                    int command_count) {
+    iree_hal_command_buffer_t* command_buffer = NULL;
+    IREE_CHECK_OK(iree_hal_command_buffer_create(
+        device, mode, IREE_HAL_COMMAND_CATEGORY_TRANSFER, &command_buffer));
+    IREE_CHECK_OK(iree_hal_command_buffer_begin(command_buffer));
+    for (int i = 0; i < command_count; ++i) {
+      if (i > 0 && (i % kCommandsPerBarrier) == 0) {
+        IREE_CHECK_OK(iree_hal_command_buffer_execution_barrier(
+            command_buffer, IREE_HAL_EXECUTION_STAGE_TRANSFER,
+            IREE_HAL_EXECUTION_STAGE_TRANSFER,
+            IREE_HAL_EXECUTION_BARRIER_FLAG_NONE, 0, NULL, 0, NULL));
+      }
+      uint32_t pattern = (uint32_t)i;
+      IREE_CHECK_OK(iree_hal_command_buffer_fill_buffer(
+          command_buffer, buffer, i * kCommandLength, kCommandLength, &pattern,
+          sizeof(pattern)));
+    }
+    IREE_CHECK_OK(iree_hal_command_buffer_end(command_buffer));
+    return command_buffer;
+  }
+
+  // Submits |command_buffer| and waits for it to complete.
+  void SubmitAndWait(iree_hal_command_buffer_t* command_buffer) {
+    uint64_t signal_value = ++payload;
+    iree_hal_submission_batch_t batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.command_buffer_count = 1;
+    batch.command_buffers = &command_buffer;
+    batch.signal_semaphores.count = 1;
+    batch.signal_semaphores.semaphores = &semaphore;
+    batch.signal_semaphores.payload_values = &signal_value;
+    IREE_CHECK_OK(iree_hal_device_queue_submit(
+        device, IREE_HAL_COMMAND_CATEGORY_TRANSFER, /*queue_affinity=*/0,
+        /*batch_count=*/1, &batch));
+    IREE_CHECK_OK(iree_hal_semaphore_wait_with_deadline(
+        semaphore, signal_value, IREE_TIME_INFINITE_FUTURE));
+  }
+
+  iree_task_executor_t* executor = NULL;
+  iree_hal_device_t* device = NULL;
+  iree_hal_buffer_t* buffer = NULL;
+  iree_hal_semaphore_t* semaphore = NULL;
+  uint64_t payload = 0;
+};
+
+// Submits a command buffer of state.range(0) fills and waits for completion.
+// When state.range(1) is 0 the command buffer is one-shot and must be
+// re-recorded before each submission; when 1 it is reusable and recorded once.
+static void BM_SubmitCommandBuffer(benchmark::State& state) {
+  const int command_count = (int)state.range(0);
+  const bool reusable = state.range(1) != 0;
+  DeviceState device_state(command_count * kCommandLength,
+                           /*group_count=*/1);
+
+  iree_hal_command_buffer_t* reusable_command_buffer = NULL;
+  if (reusable) {
+    reusable_command_buffer = device_state.Record(/*mode=*/0, command_count);
+  }
+
+  for (auto _ : state) {
+    if (reusable) {
+      device_state.SubmitAndWait(reusable_command_buffer);
+    } else {
+      iree_hal_command_buffer_t* command_buffer = device_state.Record(
+          IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT, command_count);
+      device_state.SubmitAndWait(command_buffer);
+      iree_hal_command_buffer_release(command_buffer);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  iree_hal_command_buffer_release(reusable_command_buffer);
+}
+BENCHMARK(BM_SubmitCommandBuffer)
+    ->ArgNames({"commands", "reusable"})
+    ->ArgsProduct({{1, 16, 128}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+// Records state.range(0) branches of state.range(1) copies each where every
+// copy reads the output of the previous copy in its branch. Layers of copies
+// are separated by execution barriers. Branch i copies (i + 1) times as many
+// bytes as branch 0 so that without overlap-aware barriers every layer would
+// wait on the slowest branch.
+static void BM_IndependentBranches(benchmark::State& state) {
+  const int branch_count = (int)state.range(0);
+  const int layer_count = (int)state.range(1);
+  constexpr iree_device_size_t kBranchUnitLength = 64 * 1024;
+
+  // Each branch ping-pongs between two halves of its own range of the buffer.
+  iree_device_size_t branch_offsets[8];
+  iree_device_size_t branch_lengths[8];
+  IREE_CHECK_LE(branch_count, (int)IREE_ARRAYSIZE(branch_offsets));
+  iree_device_size_t buffer_size = 0;
+  for (int i = 0; i < branch_count; ++i) {
+    branch_offsets[i] = buffer_size;
+    branch_lengths[i] = (i + 1) * kBranchUnitLength;
+    buffer_size += 2 * branch_lengths[i];
+  }
+  DeviceState device_state(buffer_size, /*group_count=*/branch_count);
+
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_CHECK_OK(iree_hal_command_buffer_create(
+      device_state.device, /*mode=*/0, IREE_HAL_COMMAND_CATEGORY_TRANSFER,
+      &command_buffer));
+  IREE_CHECK_OK(iree_hal_command_buffer_begin(command_buffer));
+  for (int layer = 0; layer < layer_count; ++layer) {
+    if (layer > 0) {
+      IREE_CHECK_OK(iree_hal_command_buffer_execution_barrier(
+          command_buffer, IREE_HAL_EXECUTION_STAGE_TRANSFER,
+          IREE_HAL_EXECUTION_STAGE_TRANSFER,
+          IREE_HAL_EXECUTION_BARRIER_FLAG_NONE, 0, NULL, 0, NULL));
+    }
+    for (int i = 0; i < branch_count; ++i) {
+      iree_device_size_t source_offset =
+          branch_offsets[i] + (layer % 2) * branch_lengths[i];
+      iree_device_size_t target_offset =
+          branch_offsets[i] + ((layer + 1) % 2) * branch_lengths[i];
+      IREE_CHECK_OK(iree_hal_command_buffer_copy_buffer(
+          command_buffer, device_state.buffer, source_offset,
+          device_state.buffer, target_offset, branch_lengths[i]));
+    }
+  }
+  IREE_CHECK_OK(iree_hal_command_buffer_end(command_buffer));
+
+  for (auto _ : state) {
+    device_state.SubmitAndWait(command_buffer);
+  }
+  state.SetBytesProcessed(state.iterations() * layer_count * buffer_size / 2);
+
+  iree_hal_command_buffer_release(command_buffer);
+}
+BENCHMARK(BM_IndependentBranches)
+    ->ArgNames({"branches", "layers"})
+    ->ArgsProduct({{1, 2, 4}, {8, 32}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+// Fills state.range(0) bytes. When state.range(1) is 0 the fill is performed
+// directly on the calling thread and when 1 it is recorded into a reusable
+// command buffer and submitted to the device.
+static void BM_FillBuffer(benchmark::State& state) {
+  const iree_device_size_t length = (iree_device_size_t)state.range(0);
+  const bool use_command_buffer = state.range(1) != 0;
+  DeviceState device_state(length, kTransferGroupCount);
+  const uint32_t pattern = 0xCDCDCDCDu;
+
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_CHECK_OK(iree_hal_command_buffer_create(
+      device_state.device, /*mode=*/0, IREE_HAL_COMMAND_CATEGORY_TRANSFER,
+      &command_buffer));
+  IREE_CHECK_OK(iree_hal_command_buffer_begin(command_buffer));
+  IREE_CHECK_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer, device_state.buffer, 0, length, &pattern,
+      sizeof(pattern)));
+  IREE_CHECK_OK(iree_hal_command_buffer_end(command_buffer));
+
+  for (auto _ : state) {
+    if (use_command_buffer) {
+      device_state.SubmitAndWait(command_buffer);
+    } else {
+      IREE_CHECK_OK(iree_hal_buffer_fill(device_state.buffer, 0, length,
+                                         &pattern, sizeof(pattern)));
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * length);
+
+  iree_hal_command_buffer_release(command_buffer);
+}
+BENCHMARK(BM_FillBuffer)
+    ->ArgNames({"bytes", "command_buffer"})
+    ->ArgsProduct({{256 * 1024, 4 * 1024 * 1024, 64 * 1024 * 1024}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+// Copies state.range(0) bytes from the first half of a buffer to the second.
+// state.range(1) selects between a direct copy and a command buffer as with
+// BM_FillBuffer.
+static void BM_CopyBuffer(benchmark::State& state) {
+  const iree_device_size_t length = (iree_device_size_t)state.range(0);
+  const bool use_command_buffer = state.range(1) != 0;
+  DeviceState device_state(2 * length, kTransferGroupCount);
+  IREE_CHECK_OK(iree_hal_buffer_zero(device_state.buffer, 0, 2 * length));
+
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_CHECK_OK(iree_hal_command_buffer_create(
+      device_state.device, /*mode=*/0, IREE_HAL_COMMAND_CATEGORY_TRANSFER,
+      &command_buffer));
+  IREE_CHECK_OK(iree_hal_command_buffer_begin(command_buffer));
+  IREE_CHECK_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer, device_state.buffer, 0, device_state.buffer, length,
+      length));
+  IREE_CHECK_OK(iree_hal_command_buffer_end(command_buffer));
+
+  for (auto _ : state) {
+    if (use_command_buffer) {
+      device_state.SubmitAndWait(command_buffer);
+    } else {
+      IREE_CHECK_OK(iree_hal_buffer_copy_data(
+          device_state.buffer, 0, device_state.buffer, length, length));
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * length);
+
+  iree_hal_command_buffer_release(command_buffer);
+}
+BENCHMARK(BM_CopyBuffer)
+    ->ArgNames({"bytes", "command_buffer"})
+    ->ArgsProduct({{256 * 1024, 4 * 1024 * 1024, 64 * 1024 * 1024}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+}  // namespace
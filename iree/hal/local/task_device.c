@@ -48,6 +48,9 @@ typedef struct {
   iree_host_size_t loader_count;
   iree_hal_executable_loader_t** loaders;
 
+  // Executables shared by all executable caches created from the device.
+  iree_hal_local_executable_store_t* executable_store;
+
   iree_allocator_t host_allocator;
   iree_hal_allocator_t* device_allocator;
 
@@ -85,8 +88,9 @@ static iree_status_t iree_hal_task_device_check_params(
 iree_status_t iree_hal_task_device_create(
     iree_string_view_t identifier, const iree_hal_task_device_params_t* params,
     iree_task_executor_t* executor, iree_host_size_t loader_count,
-    iree_hal_executable_loader_t** loaders, iree_allocator_t host_allocator,
-    iree_hal_device_t** out_device) {
+    iree_hal_executable_loader_t** loaders,
+    iree_hal_local_executable_store_t* executable_store,
+    iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
   IREE_ASSERT_ARGUMENT(params);
   IREE_ASSERT_ARGUMENT(!loader_count || loaders);
   IREE_ASSERT_ARGUMENT(out_device);
@@ -129,6 +133,9 @@ iree_status_t iree_hal_task_device_create(
       iree_hal_executable_loader_retain(device->loaders[i]);
     }
 
+    device->executable_store = executable_store;
+    iree_hal_local_executable_store_retain(device->executable_store);
+
     device->queue_count = params->queue_count;
     for (iree_host_size_t i = 0; i < device->queue_count; ++i) {
       // TODO(benvanik): add a number to each queue ID.
@@ -138,6 +145,11 @@ iree_status_t iree_hal_task_device_create(
     }
   }
 
+  if (iree_status_is_ok(status) && !device->executable_store) {
+    status = iree_hal_local_executable_store_create(host_allocator,
+                                                    &device->executable_store);
+  }
+
   if (iree_status_is_ok(status)) {
     status = iree_hal_allocator_create_heap(identifier, host_allocator,
                                             &device->device_allocator);
@@ -169,6 +181,7 @@ static void iree_hal_task_device_destroy(iree_hal_device_t* base_device) {
   for (iree_host_size_t i = 0; i < device->loader_count; ++i) {
     iree_hal_executable_loader_release(device->loaders[i]);
   }
+  iree_hal_local_executable_store_release(device->executable_store);
   iree_task_executor_release(device->executor);
   iree_hal_local_event_pool_free(device->event_pool);
   iree_arena_block_pool_deinitialize(&device->large_block_pool);
@@ -197,6 +210,24 @@ static iree_hal_allocator_t* iree_hal_task_device_allocator(
   return device->device_allocator;
 }
 
+iree_status_t iree_hal_task_device_consume_statistics(
+    iree_hal_device_t* base_device,
+    iree_task_dispatch_statistics_t* out_statistics) {
+  IREE_ASSERT_ARGUMENT(base_device);
+  IREE_ASSERT_ARGUMENT(out_statistics);
+  memset(out_statistics, 0, sizeof(*out_statistics));
+  if (!iree_hal_resource_is(base_device, &iree_hal_task_device_vtable)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "device is not a task device");
+  }
+  iree_hal_task_device_t* device = (iree_hal_task_device_t*)base_device;
+  for (iree_host_size_t i = 0; i < device->queue_count; ++i) {
+    iree_task_dispatch_statistics_consume(
+        &device->queues[i].scope.dispatch_statistics, out_statistics);
+  }
+  return iree_ok_status();
+}
+
 static iree_status_t iree_hal_task_device_create_command_buffer(
     iree_hal_device_t* base_device, iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
@@ -243,7 +274,8 @@ static iree_status_t iree_hal_task_device_create_executable_cache(
   iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
   return iree_hal_local_executable_cache_create(
       identifier, device->loader_count, device->loaders,
-      iree_hal_device_host_allocator(base_device), out_executable_cache);
+      device->executable_store, iree_hal_device_host_allocator(base_device),
+      out_executable_cache);
 }
 
 static iree_status_t iree_hal_task_device_create_executable_layout(
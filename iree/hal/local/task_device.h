@@ -18,6 +18,7 @@
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
 #include "iree/hal/local/executable_loader.h"
+#include "iree/hal/local/local_executable_cache.h"
 #include "iree/task/executor.h"
 
 #ifdef __cplusplus
@@ -45,11 +46,25 @@ void iree_hal_task_device_params_initialize(
 // Creates a new iree/task/-based local CPU device that uses |executor| for
 // scheduling tasks. |loaders| is the set of executable loaders that are
 // available for loading in the device context.
+//
+// Executables loaded by all executable caches created from the device are
+// shared through |executable_store|; passing the same store to multiple
+// devices using the same |loaders| shares them across the devices as well.
+// If omitted the device creates its own store.
 iree_status_t iree_hal_task_device_create(
     iree_string_view_t identifier, const iree_hal_task_device_params_t* params,
     iree_task_executor_t* executor, iree_host_size_t loader_count,
-    iree_hal_executable_loader_t** loaders, iree_allocator_t host_allocator,
-    iree_hal_device_t** out_device);
+    iree_hal_executable_loader_t** loaders,
+    iree_hal_local_executable_store_t* executable_store,
+    iree_allocator_t host_allocator, iree_hal_device_t** out_device);
+
+// Returns and resets the dispatch statistics aggregated across all queues of
+// |device| since the last call. Statistics may tear (non-atomic update across
+// fields) if queried while work is in-flight.
+// Fails with IREE_STATUS_INVALID_ARGUMENT if |device| is not a task device.
+iree_status_t iree_hal_task_device_consume_statistics(
+    iree_hal_device_t* device,
+    iree_task_dispatch_statistics_t* out_statistics);
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -27,6 +27,9 @@ typedef struct {
 
   iree_task_executor_t* executor;
 
+  // Executables shared by all devices created from the driver.
+  iree_hal_local_executable_store_t* executable_store;
+
   iree_host_size_t loader_count;
   iree_hal_executable_loader_t* loaders[];
 } iree_hal_task_driver_t;
@@ -71,6 +74,8 @@ iree_status_t iree_hal_task_driver_create(
     driver->executor = executor;
     iree_task_executor_retain(driver->executor);
 
+    driver->executable_store = NULL;
+
     driver->loader_count = loader_count;
     for (iree_host_size_t i = 0; i < driver->loader_count; ++i) {
       driver->loaders[i] = loaders[i];
@@ -78,6 +83,11 @@ iree_status_t iree_hal_task_driver_create(
     }
   }
 
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_local_executable_store_create(host_allocator,
+                                                    &driver->executable_store);
+  }
+
   if (iree_status_is_ok(status)) {
     *out_driver = (iree_hal_driver_t*)driver;
   } else {
@@ -95,6 +105,7 @@ static void iree_hal_task_driver_destroy(iree_hal_driver_t* base_driver) {
   for (iree_host_size_t i = 0; i < driver->loader_count; ++i) {
     iree_hal_executable_loader_release(driver->loaders[i]);
   }
+  iree_hal_local_executable_store_release(driver->executable_store);
   iree_task_executor_release(driver->executor);
   iree_allocator_free(host_allocator, driver);
 
@@ -123,7 +134,8 @@ static iree_status_t iree_hal_task_driver_create_device(
   iree_hal_task_driver_t* driver = iree_hal_task_driver_cast(base_driver);
   return iree_hal_task_device_create(
       driver->identifier, &driver->default_params, driver->executor,
-      driver->loader_count, driver->loaders, allocator, out_device);
+      driver->loader_count, driver->loaders, driver->executable_store,
+      allocator, out_device);
 }
 
 static const iree_hal_driver_vtable_t iree_hal_task_driver_vtable = {
@@ -147,9 +147,26 @@ static void iree_hal_task_queue_wait_cmd_cleanup(iree_task_t* task,
 }
 
 // Allocates and initializes a iree_hal_task_queue_wait_cmd_t task.
+// Waits that are already satisfied are dropped and if none remain no task is
+// needed and |out_cmd| is set to NULL.
 static iree_status_t iree_hal_task_queue_wait_cmd_allocate(
     iree_task_scope_t* scope, const iree_hal_semaphore_list_t* wait_semaphores,
     iree_arena_allocator_t* arena, iree_hal_task_queue_wait_cmd_t** out_cmd) {
+  *out_cmd = NULL;
+
+  // Common case with pipelined submissions is waiting on semaphores that were
+  // signaled by prior submissions that have already retired. Checking here
+  // avoids the wait task and the scheduling hop it requires on the issue path.
+  iree_host_size_t pending_count = 0;
+  for (iree_host_size_t i = 0; i < wait_semaphores->count; ++i) {
+    if (!iree_hal_task_semaphore_is_reached(
+            wait_semaphores->semaphores[i],
+            wait_semaphores->payload_values[i])) {
+      ++pending_count;
+    }
+  }
+  if (pending_count == 0) return iree_ok_status();
+
   iree_hal_task_queue_wait_cmd_t* cmd = NULL;
   IREE_RETURN_IF_ERROR(iree_arena_allocate(arena, sizeof(*cmd), (void**)&cmd));
   iree_task_call_initialize(
@@ -160,7 +177,8 @@ static iree_status_t iree_hal_task_queue_wait_cmd_allocate(
   cmd->arena = arena;
 
   // Clone the wait semaphores from the batch - we retain them and their
-  // payloads.
+  // payloads. All are kept if any are pending as the ones satisfied now are
+  // cheap to check again when the command executes.
   IREE_RETURN_IF_ERROR(iree_hal_semaphore_list_clone(wait_semaphores, arena,
                                                      &cmd->wait_semaphores));
 
@@ -187,11 +205,36 @@ typedef struct {
   // if we are the last issue pending.
   iree_hal_task_queue_t* queue;
 
+  // Issue of the next submission to the queue, if any, that must not begin
+  // until this issue has completed. Guarded by the queue mutex. The edge can't
+  // be our completion task as that is the retire task of our own submission.
+  iree_task_t* next_issue_task;
+
   // Command buffers to be issued in the order the appeared in the submission.
   iree_host_size_t command_buffer_count;
   iree_hal_command_buffer_t* command_buffers[];
 } iree_hal_task_queue_issue_cmd_t;
 
+// Releases the issue of the next submission chained onto |cmd| (if any) now
+// that |cmd| has issued all of its commands.
+static void iree_hal_task_queue_issue_cmd_release_next(
+    iree_hal_task_queue_issue_cmd_t* cmd,
+    iree_task_submission_t* pending_submission) {
+  iree_slim_mutex_lock(&cmd->queue->mutex);
+  iree_task_t* next_issue_task = cmd->next_issue_task;
+  cmd->next_issue_task = NULL;
+  if (cmd->queue->tail_issue_task == &cmd->task.header) {
+    cmd->queue->tail_issue_task = NULL;
+  }
+  iree_slim_mutex_unlock(&cmd->queue->mutex);
+
+  if (next_issue_task &&
+      iree_atomic_fetch_sub_int32(&next_issue_task->pending_dependency_count,
+                                  1, iree_memory_order_acq_rel) == 1) {
+    iree_task_submission_enqueue(pending_submission, next_issue_task);
+  }
+}
+
 // Issues a set of command buffers without waiting for them to complete.
 static iree_status_t iree_hal_task_queue_issue_cmd(
     uintptr_t user_context, iree_task_t* task,
@@ -212,12 +255,18 @@ static iree_status_t iree_hal_task_queue_issue_cmd(
     }
   }
 
+  // Even on failure the next submission must be allowed to issue or it (and
+  // everything submitted after it) will never complete.
+  iree_hal_task_queue_issue_cmd_release_next(cmd, pending_submission);
+
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
 
 // Cleanup for iree_hal_task_queue_issue_cmd_t that resets the queue state
-// tracking the last in-flight issue.
+// tracking the last in-flight issue. This is normally done when the issue
+// completes but the issue may be discarded without ever executing (such as
+// during executor shutdown).
 static void iree_hal_task_queue_issue_cmd_cleanup(iree_task_t* task,
                                                   iree_status_t status) {
   iree_hal_task_queue_issue_cmd_t* cmd = (iree_hal_task_queue_issue_cmd_t*)task;
@@ -249,6 +298,7 @@ static iree_status_t iree_hal_task_queue_issue_cmd_allocate(
                            iree_hal_task_queue_issue_cmd_cleanup);
   cmd->arena = arena;
   cmd->queue = queue;
+  cmd->next_issue_task = NULL;
 
   cmd->command_buffer_count = command_buffer_count;
   memcpy(cmd->command_buffers, command_buffers,
@@ -460,18 +510,12 @@ static iree_status_t iree_hal_task_queue_submit_batch(
     return status;
   }
 
-  iree_task_submission_t submission;
-  iree_task_submission_initialize(&submission);
-
-  // Sequencing: wait on semaphores or go directly into the executor queue.
+  // Ensure that we only issue command buffers after all waits have completed.
+  // This must be done before chaining below as once chained the previous issue
+  // may release us at any time.
   if (wait_cmd != NULL) {
-    // Ensure that we only issue command buffers after all waits have completed.
     iree_task_set_completion_task(&wait_cmd->task.header,
                                   &issue_cmd->task.header);
-    iree_task_submission_enqueue(&submission, &wait_cmd->task.header);
-  } else {
-    // No waits needed; directly enqueue.
-    iree_task_submission_enqueue(&submission, &issue_cmd->task.header);
   }
 
   iree_slim_mutex_lock(&queue->mutex);
@@ -479,15 +523,32 @@ static iree_status_t iree_hal_task_queue_submit_batch(
   // If there is an in-flight issue pending then we need to chain onto that
   // so that we ensure FIFO submission order is preserved. Note that we are only
   // waiting for the issue to complete and *not* all of the commands that are
-  // issued.
+  // issued. The previous issue releases us when it completes (see
+  // iree_hal_task_queue_issue_cmd_release_next).
+  bool is_chained = false;
   if (queue->tail_issue_task != NULL) {
-    iree_task_set_completion_task(queue->tail_issue_task,
-                                  &issue_cmd->task.header);
+    iree_hal_task_queue_issue_cmd_t* tail_issue_cmd =
+        (iree_hal_task_queue_issue_cmd_t*)queue->tail_issue_task;
+    tail_issue_cmd->next_issue_task = &issue_cmd->task.header;
+    iree_atomic_fetch_add_int32(&issue_cmd->task.header.pending_dependency_count,
+                                1, iree_memory_order_relaxed);
+    is_chained = true;
   }
   queue->tail_issue_task = &issue_cmd->task.header;
 
   iree_slim_mutex_unlock(&queue->mutex);
 
+  // Sequencing: wait on semaphores, wait on the previous issue, or go directly
+  // into the executor queue.
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  if (wait_cmd != NULL) {
+    iree_task_submission_enqueue(&submission, &wait_cmd->task.header);
+  } else if (!is_chained) {
+    // No waits needed; directly enqueue.
+    iree_task_submission_enqueue(&submission, &issue_cmd->task.header);
+  }
+
   // Submit the tasks immediately. The executor may queue them up until we
   // force the flush after all batches have been processed.
   iree_task_executor_submit(queue->executor, &submission);
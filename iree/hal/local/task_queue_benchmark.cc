@@ -0,0 +1,131 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the rate at which submissions can round-trip through a task device
+// queue: the host submits a batch with no commands that signals a semaphore
+// and then waits for that signal before submitting the next. This isolates the
+// per-submission overhead of the queue (arena setup, wait/issue/retire tasks,
+// semaphore timepoints, and host waits) from any actual work.
+
+#include "benchmark/benchmark.h"
+#include "iree/base/api.h"
+#include "iree/base/logging.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/task_device.h"
+#include "iree/task/executor.h"
+#include "iree/task/topology.h"
+
+namespace {
+
+struct DeviceState {
+  DeviceState() {
+    iree_task_topology_t topology;
+    iree_task_topology_initialize_from_group_count(/*group_count=*/1,
+                                                   &topology);
+    IREE_CHECK_OK(iree_task_executor_create(
+        IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+        IREE_TASK_EXECUTOR_DEFAULT_WORKER_SPIN_NS, iree_allocator_system(),
+        &executor));
+    iree_task_topology_deinitialize(&topology);
+
+    iree_hal_task_device_params_t params;
+    iree_hal_task_device_params_initialize(&params);
+    IREE_CHECK_OK(iree_hal_task_device_create(
+        iree_make_cstring_view("task"), &params, executor,
+        /*loader_count=*/0, /*loaders=*/NULL, /*executable_store=*/NULL,
+        iree_allocator_system(), &device));
+
+    IREE_CHECK_OK(iree_hal_semaphore_create(device, 0ull, &host_semaphore));
+    IREE_CHECK_OK(iree_hal_semaphore_create(device, 0ull, &device_semaphore));
+  }
+
+  ~DeviceState() {
+    iree_hal_semaphore_release(device_semaphore);
+    iree_hal_semaphore_release(host_semaphore);
+    iree_hal_device_release(device);
+    iree_task_executor_release(executor);
+  }
+
+  // Submits a batch signaling |device_semaphore| to |signal_value| that waits
+  // on |wait_semaphore| reaching |wait_value| (if provided).
+  void Submit(iree_hal_semaphore_t* wait_semaphore, uint64_t wait_value,
+              uint64_t signal_value) {
+    iree_hal_submission_batch_t batch;
+    memset(&batch, 0, sizeof(batch));
+    if (wait_semaphore) {
+      batch.wait_semaphores.count = 1;
+      batch.wait_semaphores.semaphores = &wait_semaphore;
+      batch.wait_semaphores.payload_values = &wait_value;
+    }
+    batch.signal_semaphores.count = 1;
+    batch.signal_semaphores.semaphores = &device_semaphore;
+    batch.signal_semaphores.payload_values = &signal_value;
+    IREE_CHECK_OK(iree_hal_device_queue_submit(
+        device, IREE_HAL_COMMAND_CATEGORY_ANY, /*queue_affinity=*/0,
+        /*batch_count=*/1, &batch));
+  }
+
+  void Wait(uint64_t value) {
+    IREE_CHECK_OK(iree_hal_semaphore_wait_with_deadline(
+        device_semaphore, value, IREE_TIME_INFINITE_FUTURE));
+  }
+
+  iree_task_executor_t* executor = NULL;
+  iree_hal_device_t* device = NULL;
+  iree_hal_semaphore_t* host_semaphore = NULL;
+  iree_hal_semaphore_t* device_semaphore = NULL;
+};
+
+// Submits a batch and waits for it to retire. The batch waits on the signal
+// from the previous submission when state.range(0) is 1; that wait is always
+// satisfied by the time the batch is submitted.
+static void BM_SubmitWaitPingPong(benchmark::State& state) {
+  const bool chain_submissions = state.range(0) != 0;
+  DeviceState device_state;
+  uint64_t value = 0;
+  for (auto _ : state) {
+    device_state.Submit(chain_submissions ? device_state.device_semaphore
+                                          : NULL,
+                        value, value + 1);
+    device_state.Wait(++value);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SubmitWaitPingPong)
+    ->ArgNames({"chained"})
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+// Submits a batch that waits on a semaphore the host signals only after the
+// submission has been made, then waits for the batch to retire. Each batch
+// requires the queue to enqueue a timepoint on the unsatisfied semaphore.
+static void BM_SubmitSignalWaitPingPong(benchmark::State& state) {
+  DeviceState device_state;
+  uint64_t value = 0;
+  for (auto _ : state) {
+    ++value;
+    device_state.Submit(device_state.host_semaphore, value, value);
+    IREE_CHECK_OK(
+        iree_hal_semaphore_signal(device_state.host_semaphore, value));
+    device_state.Wait(value);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SubmitSignalWaitPingPong)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+}  // namespace
@@ -260,10 +260,12 @@ static iree_status_t iree_hal_task_semaphore_signal(
   iree_hal_task_timepoint_list_take_ready(&semaphore->timepoint_list, new_value,
                                           &ready_list);
 
-  iree_notification_post(&semaphore->notification, IREE_ALL_WAITERS);
   iree_slim_mutex_unlock(&semaphore->mutex);
 
-  // Notify all waiters - note that this must happen outside the lock.
+  // Notify all waiters - note that this must happen outside the lock so that
+  // woken waiters don't immediately block on it. The caller holds a reference
+  // to the semaphore so it remains live even if waiters release theirs.
+  iree_notification_post(&semaphore->notification, IREE_ALL_WAITERS);
   iree_hal_task_timepoint_list_notify_ready(&ready_list);
 
   return iree_ok_status();
@@ -295,13 +297,25 @@ static void iree_hal_task_semaphore_fail(iree_hal_semaphore_t* base_semaphore,
   iree_hal_task_timepoint_list_t ready_list;
   iree_hal_task_timepoint_list_move(&semaphore->timepoint_list, &ready_list);
 
-  iree_notification_post(&semaphore->notification, IREE_ALL_WAITERS);
   iree_slim_mutex_unlock(&semaphore->mutex);
 
-  // Notify all waiters - note that this must happen outside the lock.
+  // Notify all waiters - note that this must happen outside the lock so that
+  // woken waiters don't immediately block on it. The caller holds a reference
+  // to the semaphore so it remains live even if waiters release theirs.
+  iree_notification_post(&semaphore->notification, IREE_ALL_WAITERS);
   iree_hal_task_timepoint_list_notify_ready(&ready_list);
 }
 
+bool iree_hal_task_semaphore_is_reached(iree_hal_semaphore_t* base_semaphore,
+                                        uint64_t minimum_value) {
+  iree_hal_task_semaphore_t* semaphore =
+      iree_hal_task_semaphore_cast(base_semaphore);
+  iree_slim_mutex_lock(&semaphore->mutex);
+  bool is_reached = semaphore->current_value >= minimum_value;
+  iree_slim_mutex_unlock(&semaphore->mutex);
+  return is_reached;
+}
+
 // Acquires a timepoint waiting for the given value.
 // |out_timepoint| is owned by the caller and must be kept live until the
 // timepoint has been reached (or it is cancelled by the caller).
@@ -376,6 +390,19 @@ iree_status_t iree_hal_task_semaphore_enqueue_timepoint(
   return status;
 }
 
+typedef struct {
+  iree_hal_task_semaphore_t* semaphore;
+  uint64_t value;
+} iree_hal_task_semaphore_wait_condition_t;
+
+// Returns true if the semaphore has reached the value waited on (or failed).
+static bool iree_hal_task_semaphore_wait_condition(void* arg) {
+  iree_hal_task_semaphore_wait_condition_t* condition =
+      (iree_hal_task_semaphore_wait_condition_t*)arg;
+  return iree_hal_task_semaphore_is_reached(
+      (iree_hal_semaphore_t*)condition->semaphore, condition->value);
+}
+
 static iree_status_t iree_hal_task_semaphore_wait_with_deadline(
     iree_hal_semaphore_t* base_semaphore, uint64_t value,
     iree_time_t deadline_ns) {
@@ -392,6 +419,18 @@ static iree_status_t iree_hal_task_semaphore_wait_with_deadline(
     // Not satisfied but a poll, so can avoid the expensive wait handle work.
     iree_slim_mutex_unlock(&semaphore->mutex);
     return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+  } else if (deadline_ns == IREE_TIME_INFINITE_FUTURE) {
+    // Not satisfied but with no deadline we can wait on the in-process
+    // notification instead of acquiring an event from the pool and going to
+    // the kernel with a full wait handle operation.
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    iree_hal_task_semaphore_wait_condition_t condition = {
+        .semaphore = semaphore,
+        .value = value,
+    };
+    iree_notification_await(&semaphore->notification,
+                            iree_hal_task_semaphore_wait_condition, &condition);
+    return iree_ok_status();
   }
 
   // Slow path: acquire a timepoint while we hold the lock.
@@ -435,6 +474,16 @@ iree_status_t iree_hal_task_semaphore_multi_wait(
     return iree_hal_semaphore_wait_with_deadline(
         semaphore_list->semaphores[0], semaphore_list->payload_values[0],
         deadline_ns);
+  } else if (wait_mode == IREE_HAL_WAIT_MODE_ALL &&
+             deadline_ns == IREE_TIME_INFINITE_FUTURE) {
+    // Waiting on all semaphores without a deadline is equivalent to waiting on
+    // each in turn, which avoids the events and wait set entirely.
+    for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+      IREE_RETURN_IF_ERROR(iree_hal_semaphore_wait_with_deadline(
+          semaphore_list->semaphores[i], semaphore_list->payload_values[i],
+          deadline_ns));
+    }
+    return iree_ok_status();
   }
 
   IREE_TRACE_ZONE_BEGIN(z0);
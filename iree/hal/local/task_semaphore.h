@@ -32,6 +32,11 @@ iree_status_t iree_hal_task_semaphore_create(
     iree_hal_local_event_pool_t* event_pool, uint64_t initial_value,
     iree_allocator_t host_allocator, iree_hal_semaphore_t** out_semaphore);
 
+// Returns true if |semaphore| has been signaled to at least |minimum_value| (or
+// has failed) such that waits on the value are already satisfied.
+bool iree_hal_task_semaphore_is_reached(iree_hal_semaphore_t* semaphore,
+                                        uint64_t minimum_value);
+
 // Reserves a new timepoint in the timeline for the given minimum payload value.
 // |issue_task| will wait until the timeline semaphore is signaled to at least
 // |minimum_value| before proceeding, with a possible wait task generated and
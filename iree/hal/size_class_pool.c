@@ -0,0 +1,162 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/hal/size_class_pool.h"
+
+#include <string.h>
+
+#include "iree/base/internal/math.h"
+
+void iree_hal_size_class_pool_initialize(uint32_t min_size_log2,
+                                         uint32_t max_size_log2,
+                                         uint32_t subclass_bits,
+                                         iree_device_size_t max_pooled_bytes,
+                                         iree_hal_size_class_pool_t* out_pool) {
+  IREE_ASSERT_ARGUMENT(out_pool);
+  assert(subclass_bits <= min_size_log2 && min_size_log2 <= max_size_log2);
+  out_pool->min_size_log2 = min_size_log2;
+  out_pool->max_size_log2 = max_size_log2;
+  out_pool->subclass_bits = subclass_bits;
+  out_pool->class_count =
+      ((max_size_log2 - min_size_log2) << subclass_bits) + 1;
+  assert(out_pool->class_count <= IREE_HAL_SIZE_CLASS_POOL_MAX_CLASS_COUNT);
+  out_pool->max_pooled_bytes = max_pooled_bytes;
+  iree_slim_mutex_initialize(&out_pool->mutex);
+  memset(out_pool->bins, 0, sizeof(out_pool->bins));
+  memset(&out_pool->statistics, 0, sizeof(out_pool->statistics));
+}
+
+void iree_hal_size_class_pool_deinitialize(iree_hal_size_class_pool_t* pool) {
+  IREE_ASSERT_ARGUMENT(pool);
+  assert(pool->statistics.entry_count == 0);
+  iree_slim_mutex_deinitialize(&pool->mutex);
+}
+
+// Size class 0 holds 2^min_size_log2 bytes. Each power of two p in
+// [min_size_log2, max_size_log2) is followed by 2^subclass_bits classes
+// stepping by 2^(p - subclass_bits) bytes up to and including 2^(p + 1).
+iree_device_size_t iree_hal_size_class_pool_class_size(
+    const iree_hal_size_class_pool_t* pool, uint32_t size_class) {
+  if (size_class == 0) {
+    return (iree_device_size_t)1 << pool->min_size_log2;
+  }
+  uint32_t index = size_class - 1;
+  uint32_t p = pool->min_size_log2 + (index >> pool->subclass_bits);
+  uint64_t subclass = (index & ((1u << pool->subclass_bits) - 1)) + 1;
+  return (iree_device_size_t)((1ull << p) +
+                              (subclass << (p - pool->subclass_bits)));
+}
+
+uint32_t iree_hal_size_class_pool_select(const iree_hal_size_class_pool_t* pool,
+                                         iree_device_size_t size) {
+  if (size == 0) return pool->class_count;
+  uint32_t size_class = 0;
+  if ((uint64_t)size > (1ull << pool->min_size_log2)) {
+    // 2^p < size <= 2^(p + 1).
+    uint32_t p =
+        (uint32_t)(63 - iree_math_count_leading_zeros_u64((uint64_t)size - 1));
+    if (p >= pool->max_size_log2) return pool->class_count;
+    uint64_t subclass =
+        (((uint64_t)size - 1 - (1ull << p)) >> (p - pool->subclass_bits)) + 1;
+    size_class = ((p - pool->min_size_log2) << pool->subclass_bits) +
+                 (uint32_t)subclass;
+  }
+  if (iree_hal_size_class_pool_class_size(pool, size_class) >
+      pool->max_pooled_bytes) {
+    return pool->class_count;
+  }
+  return size_class;
+}
+
+iree_hal_size_class_pool_entry_t* iree_hal_size_class_pool_acquire(
+    iree_hal_size_class_pool_t* pool, uint32_t size_class, uint64_t key) {
+  iree_slim_mutex_lock(&pool->mutex);
+  iree_hal_size_class_pool_entry_t** prev_next = &pool->bins[size_class];
+  iree_hal_size_class_pool_entry_t* entry = *prev_next;
+  while (entry && entry->key != key) {
+    prev_next = &entry->next;
+    entry = *prev_next;
+  }
+  if (entry) {
+    *prev_next = entry->next;
+    entry->next = NULL;
+    pool->statistics.pooled_bytes -=
+        iree_hal_size_class_pool_class_size(pool, size_class);
+    --pool->statistics.entry_count;
+    ++pool->statistics.hit_count;
+  } else {
+    ++pool->statistics.miss_count;
+  }
+  iree_slim_mutex_unlock(&pool->mutex);
+  return entry;
+}
+
+static iree_hal_size_class_pool_entry_t* iree_hal_size_class_pool_evict_locked(
+    iree_hal_size_class_pool_t* pool, iree_device_size_t target_bytes) {
+  iree_hal_size_class_pool_entry_t* evicted_list = NULL;
+  for (int i = (int)pool->class_count - 1;
+       i >= 0 && pool->statistics.pooled_bytes > target_bytes; --i) {
+    iree_device_size_t class_size =
+        iree_hal_size_class_pool_class_size(pool, (uint32_t)i);
+    while (pool->bins[i] && pool->statistics.pooled_bytes > target_bytes) {
+      iree_hal_size_class_pool_entry_t* entry = pool->bins[i];
+      pool->bins[i] = entry->next;
+      entry->next = evicted_list;
+      evicted_list = entry;
+      pool->statistics.pooled_bytes -= class_size;
+      --pool->statistics.entry_count;
+      ++pool->statistics.eviction_count;
+    }
+  }
+  return evicted_list;
+}
+
+iree_hal_size_class_pool_entry_t* iree_hal_size_class_pool_release(
+    iree_hal_size_class_pool_t* pool, iree_hal_size_class_pool_entry_t* entry) {
+  iree_device_size_t class_size =
+      iree_hal_size_class_pool_class_size(pool, entry->size_class);
+  if (class_size > pool->max_pooled_bytes) {
+    entry->next = NULL;
+    return entry;
+  }
+  iree_slim_mutex_lock(&pool->mutex);
+  iree_hal_size_class_pool_entry_t* evicted_list = NULL;
+  if (pool->statistics.pooled_bytes + class_size > pool->max_pooled_bytes) {
+    evicted_list = iree_hal_size_class_pool_evict_locked(
+        pool, pool->max_pooled_bytes - class_size);
+  }
+  entry->next = pool->bins[entry->size_class];
+  pool->bins[entry->size_class] = entry;
+  pool->statistics.pooled_bytes += class_size;
+  ++pool->statistics.entry_count;
+  iree_slim_mutex_unlock(&pool->mutex);
+  return evicted_list;
+}
+
+iree_hal_size_class_pool_entry_t* iree_hal_size_class_pool_evict(
+    iree_hal_size_class_pool_t* pool, iree_device_size_t target_bytes) {
+  iree_slim_mutex_lock(&pool->mutex);
+  iree_hal_size_class_pool_entry_t* evicted_list =
+      iree_hal_size_class_pool_evict_locked(pool, target_bytes);
+  iree_slim_mutex_unlock(&pool->mutex);
+  return evicted_list;
+}
+
+void iree_hal_size_class_pool_query_statistics(
+    iree_hal_size_class_pool_t* pool,
+    iree_hal_size_class_pool_statistics_t* out_statistics) {
+  iree_slim_mutex_lock(&pool->mutex);
+  *out_statistics = pool->statistics;
+  iree_slim_mutex_unlock(&pool->mutex);
+}
@@ -0,0 +1,138 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef IREE_HAL_SIZE_CLASS_POOL_H_
+#define IREE_HAL_SIZE_CLASS_POOL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/base/synchronization.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Maximum number of size classes a pool may be configured with.
+#define IREE_HAL_SIZE_CLASS_POOL_MAX_CLASS_COUNT 128
+
+// An object retained by a size class pool. Embedded in the pooled object
+// (such as a buffer or the header of a block of storage) by the owner.
+typedef struct iree_hal_size_class_pool_entry_s {
+  // Next entry in the pool bin while the entry is pooled.
+  struct iree_hal_size_class_pool_entry_s* next;
+  // Size class of the entry as returned by iree_hal_size_class_pool_select.
+  uint32_t size_class;
+  // Owner-defined key that must match for an entry to be reused, such as the
+  // memory type and usage of a buffer.
+  uint64_t key;
+} iree_hal_size_class_pool_entry_t;
+
+// Statistics of a size class pool accumulated since its initialization.
+typedef struct {
+  // Total number of acquisitions serviced from a pooled entry.
+  uint64_t hit_count;
+  // Total number of acquisitions that found no matching pooled entry.
+  uint64_t miss_count;
+  // Total number of entries evicted due to the budget being exceeded or the
+  // pool being trimmed.
+  uint64_t eviction_count;
+  // Number of entries currently retained in the pool.
+  iree_host_size_t entry_count;
+  // Total size class bytes of the entries currently retained in the pool.
+  iree_device_size_t pooled_bytes;
+} iree_hal_size_class_pool_statistics_t;
+
+// Retains released objects binned by size class for reuse by subsequent
+// requests of the same size class and key, up to a byte budget. When an
+// object is released that would exceed the budget the largest pooled entries
+// are evicted first as they free the most memory with the fewest calls into
+// the owner's allocator. The pool only tracks entries; the owner allocates
+// and frees the objects they are embedded in.
+//
+// Size classes start at 2^min_size_log2 bytes and each power of two up to
+// 2^max_size_log2 is divided into 2^subclass_bits classes. With no subclasses
+// every request is rounded to the next power of two and up to half of each
+// object may be unused; each subclass bit halves that bound.
+//
+// Thread-safe.
+typedef struct {
+  uint32_t min_size_log2;
+  uint32_t max_size_log2;
+  uint32_t subclass_bits;
+  uint32_t class_count;
+
+  // Maximum total size class bytes of pooled entries.
+  iree_device_size_t max_pooled_bytes;
+
+  // Guards the bins and statistics.
+  iree_slim_mutex_t mutex;
+
+  // Pooled entries, one LIFO list per size class.
+  iree_hal_size_class_pool_entry_t*
+      bins[IREE_HAL_SIZE_CLASS_POOL_MAX_CLASS_COUNT];
+
+  iree_hal_size_class_pool_statistics_t statistics;
+} iree_hal_size_class_pool_t;
+
+// Initializes |out_pool| with size classes covering
+// [2^min_size_log2, 2^max_size_log2] bytes retaining at most
+// |max_pooled_bytes|.
+void iree_hal_size_class_pool_initialize(uint32_t min_size_log2,
+                                         uint32_t max_size_log2,
+                                         uint32_t subclass_bits,
+                                         iree_device_size_t max_pooled_bytes,
+                                         iree_hal_size_class_pool_t* out_pool);
+
+// Deinitializes |pool|. All entries must have been evicted with
+// iree_hal_size_class_pool_evict and freed by the owner.
+void iree_hal_size_class_pool_deinitialize(iree_hal_size_class_pool_t* pool);
+
+// Returns the size class that can hold |size| bytes or the class count of
+// |pool| if requests of |size| should not be pooled: they are empty, larger
+// than the largest size class, or the size class alone exceeds the budget.
+uint32_t iree_hal_size_class_pool_select(const iree_hal_size_class_pool_t* pool,
+                                         iree_device_size_t size);
+
+// Returns the number of bytes objects in |size_class| must be able to hold.
+iree_device_size_t iree_hal_size_class_pool_class_size(
+    const iree_hal_size_class_pool_t* pool, uint32_t size_class);
+
+// Removes and returns a pooled entry of |size_class| with a matching |key| or
+// NULL if there is none and the owner must allocate a new object.
+iree_hal_size_class_pool_entry_t* iree_hal_size_class_pool_acquire(
+    iree_hal_size_class_pool_t* pool, uint32_t size_class, uint64_t key);
+
+// Places |entry| into the pool, evicting larger entries as needed to remain
+// within the budget. Returns a list of entries (possibly including |entry|)
+// that the owner must free once it has released any locks of its own.
+iree_hal_size_class_pool_entry_t* iree_hal_size_class_pool_release(
+    iree_hal_size_class_pool_t* pool, iree_hal_size_class_pool_entry_t* entry);
+
+// Evicts pooled entries, largest first, until at most |target_bytes| remain
+// pooled. Returns a list of the evicted entries that the owner must free.
+iree_hal_size_class_pool_entry_t* iree_hal_size_class_pool_evict(
+    iree_hal_size_class_pool_t* pool, iree_device_size_t target_bytes);
+
+// Returns the current statistics of |pool|.
+void iree_hal_size_class_pool_query_statistics(
+    iree_hal_size_class_pool_t* pool,
+    iree_hal_size_class_pool_statistics_t* out_statistics);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_SIZE_CLASS_POOL_H_
@@ -69,8 +69,9 @@ static iree_status_t iree_hal_vmla_driver_factory_try_create(
 
   iree_task_executor_t* executor = NULL;
   if (iree_status_is_ok(status)) {
-    status = iree_task_executor_create(IREE_TASK_SCHEDULING_MODE_RESERVED,
-                                       &topology, allocator, &executor);
+    status = iree_task_executor_create(
+        IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+        IREE_TASK_EXECUTOR_DEFAULT_WORKER_SPIN_NS, allocator, &executor);
   }
 
   if (iree_status_is_ok(status)) {
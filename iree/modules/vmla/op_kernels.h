@@ -92,16 +92,6 @@ struct CompareGE {
                         absl::Span<uint8_t> dst_buffer);
 };
 
-struct Conv2D {
-  template <typename T>
-  static Status Execute(absl::Span<const T> input_buffer, ShapeSpan input_shape,
-                        absl::Span<const T> filter_buffer,
-                        ShapeSpan filter_shape, absl::Span<T> dst_buffer,
-                        ShapeSpan dst_shape, ShapeSpan strides, ShapeSpan pad_h,
-                        ShapeSpan pad_w, ShapeSpan lhs_dilation,
-                        ShapeSpan rhs_dilation, const int32_t groups);
-};
-
 struct Copy {
   template <int element_size>
   static Status Execute(absl::Span<const uint8_t> src_buffer,
@@ -422,6 +412,30 @@ struct RuntimeState {
       MatMul::CreateRuntimeState();
 };
 
+// 2D (grouped) convolution of a single HWC example.
+// The filter is laid out as [KH, KW, input channels, output channels / groups]
+// and results are accumulated into |dst_buffer|.
+struct Conv2D {
+  // Lowers the convolution to im2col + GEMM using the MatMul runtime state.
+  template <typename T>
+  static Status Execute(MatMul::RuntimeState* runtime_state,
+                        absl::Span<const T> input_buffer, ShapeSpan input_shape,
+                        absl::Span<const T> filter_buffer,
+                        ShapeSpan filter_shape, absl::Span<T> dst_buffer,
+                        ShapeSpan dst_shape, ShapeSpan strides, ShapeSpan pad_h,
+                        ShapeSpan pad_w, ShapeSpan lhs_dilation,
+                        ShapeSpan rhs_dilation, const int32_t groups);
+
+  // Direct convolution used as the reference implementation.
+  template <typename T>
+  static Status ExecuteReference(
+      absl::Span<const T> input_buffer, ShapeSpan input_shape,
+      absl::Span<const T> filter_buffer, ShapeSpan filter_shape,
+      absl::Span<T> dst_buffer, ShapeSpan dst_shape, ShapeSpan strides,
+      ShapeSpan pad_h, ShapeSpan pad_w, ShapeSpan lhs_dilation,
+      ShapeSpan rhs_dilation, const int32_t groups);
+};
+
 struct ReduceSum {
   template <typename T>
   static Status Execute(absl::Span<const T> src_buffer,
@@ -497,6 +511,7 @@ struct PoolingMax {
 // Inconsistent automated formatting here. Just disable clang-format (for now?).
 // clang-format off
 #include "iree/modules/vmla/op_kernels_generic.h"  // IWYU pragma: export
+#include "iree/modules/vmla/op_kernels_simd.h"  // IWYU pragma: export
 #include "iree/modules/vmla/op_kernels_ruy.h"  // IWYU pragma: export
 #include "iree/modules/vmla/op_kernels_fft.h"  // IWYU pragma: export
 // clang-format on
@@ -0,0 +1,216 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "absl/container/inlined_vector.h"
+#include "benchmark/benchmark.h"
+#include "iree/base/api.h"
+#include "iree/base/logging.h"
+#include "iree/modules/vmla/op_kernels.h"
+
+namespace iree {
+namespace hal {
+namespace vmla {
+namespace kernels {
+namespace {
+
+using Shape = absl::InlinedVector<int32_t, 4>;
+
+struct Conv2DShape {
+  const char* name;
+  int32_t input_size;  // square H == W
+  int32_t input_channels;
+  int32_t kernel_size;  // square KH == KW
+  int32_t output_channels;
+  int32_t stride;
+  int32_t padding;
+  int32_t groups;
+};
+
+// Common layer shapes from ResNet-50 and MobileNetV2 (batch 1).
+static const Conv2DShape kConv2DShapes[] = {
+    {"resnet_stem_7x7s2", 224, 3, 7, 64, 2, 3, 1},
+    {"resnet_3x3_56", 56, 64, 3, 64, 1, 1, 1},
+    {"resnet_1x1_56", 56, 64, 1, 256, 1, 0, 1},
+    {"resnet_3x3s2_28", 56, 128, 3, 128, 2, 1, 1},
+    {"resnet_3x3_7", 7, 512, 3, 512, 1, 1, 1},
+    {"mobilenet_dw_3x3_112", 112, 32, 3, 32, 1, 1, 32},
+    {"mobilenet_dw_3x3s2_56", 112, 96, 3, 96, 2, 1, 96},
+    {"mobilenet_pw_1x1_14", 14, 384, 1, 64, 1, 0, 1},
+};
+
+// Runs state.range(0) from kConv2DShapes with the GEMM lowering if
+// state.range(1) is set and the direct reference implementation otherwise.
+static void BM_Conv2D(benchmark::State& state) {
+  const auto& conv = kConv2DShapes[state.range(0)];
+  const bool use_gemm = state.range(1) != 0;
+  state.SetLabel(std::string(conv.name) + (use_gemm ? "/gemm" : "/reference"));
+
+  const int32_t output_size =
+      (conv.input_size + 2 * conv.padding - conv.kernel_size) / conv.stride +
+      1;
+  Shape input_shape = {conv.input_size, conv.input_size, conv.input_channels};
+  Shape filter_shape = {conv.kernel_size, conv.kernel_size,
+                        conv.input_channels,
+                        conv.output_channels / conv.groups};
+  Shape dst_shape = {output_size, output_size, conv.output_channels};
+  Shape strides = {conv.stride, conv.stride};
+  Shape padding = {conv.padding, conv.padding};
+  Shape dilation = {1, 1};
+
+  std::vector<float> input_buffer(GetElementCount(input_shape));
+  for (size_t i = 0; i < input_buffer.size(); ++i) {
+    input_buffer[i] = static_cast<float>(i % 17) * 0.125f;
+  }
+  std::vector<float> filter_buffer(GetElementCount(filter_shape));
+  for (size_t i = 0; i < filter_buffer.size(); ++i) {
+    filter_buffer[i] = static_cast<float>(i % 13) * 0.0625f - 0.5f;
+  }
+  std::vector<float> dst_buffer(GetElementCount(dst_shape));
+
+  auto runtime_state = MatMul::CreateRuntimeState();
+  for (auto _ : state) {
+    std::fill(dst_buffer.begin(), dst_buffer.end(), 0.0f);
+    if (use_gemm) {
+      IREE_CHECK_OK(Conv2D::Execute<float>(
+          runtime_state.get(), input_buffer, input_shape, filter_buffer,
+          filter_shape, absl::MakeSpan(dst_buffer), dst_shape, strides,
+          padding, padding, dilation, dilation, conv.groups));
+    } else {
+      IREE_CHECK_OK(Conv2D::ExecuteReference<float>(
+          input_buffer, input_shape, filter_buffer, filter_shape,
+          absl::MakeSpan(dst_buffer), dst_shape, strides, padding, padding,
+          dilation, dilation, conv.groups));
+    }
+    benchmark::DoNotOptimize(dst_buffer.data());
+  }
+
+  // 2 flops (multiply + add) per MAC.
+  const int64_t macs = static_cast<int64_t>(output_size) * output_size *
+                       conv.output_channels * conv.kernel_size *
+                       conv.kernel_size * (conv.input_channels / conv.groups);
+  state.counters["flops"] = benchmark::Counter(
+      2.0 * macs * state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Conv2D)
+    ->ArgNames({"shape", "gemm"})
+    ->Apply([](benchmark::internal::Benchmark* benchmark) {
+      for (int64_t i = 0; i < IREE_ARRAYSIZE(kConv2DShapes); ++i) {
+        benchmark->Args({i, 0});
+        benchmark->Args({i, 1});
+      }
+    })
+    ->Unit(benchmark::kMillisecond);
+
+//===----------------------------------------------------------------------===//
+// Elementwise and reduction kernels
+//===----------------------------------------------------------------------===//
+
+constexpr size_t kElementwiseSize = 64 * 1024;
+
+std::vector<float> MakeBenchmarkValues(size_t size) {
+  std::vector<float> values(size);
+  for (size_t i = 0; i < size; ++i) {
+    values[i] = static_cast<float>(i % 251) * 0.03125f - 4.0f;
+  }
+  return values;
+}
+
+// Runs |kernel| over kElementwiseSize floats if state.range(0) is set and the
+// scalar std:: loop |scalar| (what the generic kernels compile to) otherwise.
+template <typename KernelFn, typename ScalarFn>
+void RunUnaryBenchmark(benchmark::State& state, KernelFn kernel,
+                       ScalarFn scalar) {
+  const bool use_kernel = state.range(0) != 0;
+  state.SetLabel(use_kernel ? "kernel" : "scalar");
+  std::vector<float> src_buffer = MakeBenchmarkValues(kElementwiseSize);
+  std::vector<float> dst_buffer(kElementwiseSize);
+  for (auto _ : state) {
+    if (use_kernel) {
+      IREE_CHECK_OK(kernel(src_buffer, absl::MakeSpan(dst_buffer)));
+    } else {
+      for (size_t i = 0; i < kElementwiseSize; ++i) {
+        dst_buffer[i] = scalar(src_buffer[i]);
+      }
+    }
+    benchmark::DoNotOptimize(dst_buffer.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kElementwiseSize);
+}
+
+static void BM_AddF32(benchmark::State& state) {
+  const bool use_kernel = state.range(0) != 0;
+  state.SetLabel(use_kernel ? "kernel" : "scalar");
+  std::vector<float> lhs_buffer = MakeBenchmarkValues(kElementwiseSize);
+  std::vector<float> rhs_buffer = MakeBenchmarkValues(kElementwiseSize + 7);
+  rhs_buffer.resize(kElementwiseSize);
+  std::vector<float> dst_buffer(kElementwiseSize);
+  for (auto _ : state) {
+    if (use_kernel) {
+      IREE_CHECK_OK(Add::Execute<float>(lhs_buffer, rhs_buffer,
+                                        absl::MakeSpan(dst_buffer)));
+    } else {
+      for (size_t i = 0; i < kElementwiseSize; ++i) {
+        dst_buffer[i] = lhs_buffer[i] + rhs_buffer[i];
+      }
+    }
+    benchmark::DoNotOptimize(dst_buffer.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kElementwiseSize);
+}
+BENCHMARK(BM_AddF32)->ArgName("kernel")->Arg(0)->Arg(1);
+
+static void BM_ExpF32(benchmark::State& state) {
+  RunUnaryBenchmark(state, Exp::Execute<float>,
+                    [](float value) { return std::exp(value); });
+}
+BENCHMARK(BM_ExpF32)->ArgName("kernel")->Arg(0)->Arg(1);
+
+static void BM_TanhF32(benchmark::State& state) {
+  RunUnaryBenchmark(state, Tanh::Execute<float>,
+                    [](float value) { return std::tanh(value); });
+}
+BENCHMARK(BM_TanhF32)->ArgName("kernel")->Arg(0)->Arg(1);
+
+// Sums a [256, 256] buffer along state.range(0) (0 = outer, 1 = inner).
+static void BM_ReduceSumF32(benchmark::State& state) {
+  const int32_t dimension = static_cast<int32_t>(state.range(0));
+  Shape src_shape = {256, 256};
+  Shape dst_shape = {256};
+  std::vector<float> src_buffer =
+      MakeBenchmarkValues(GetElementCount(src_shape));
+  std::vector<float> init_buffer = {0.0f};
+  std::vector<float> dst_buffer(GetElementCount(dst_shape));
+  for (auto _ : state) {
+    IREE_CHECK_OK(ReduceSum::Execute<float>(src_buffer, init_buffer,
+                                            absl::MakeSpan(dst_buffer),
+                                            dimension, src_shape, dst_shape));
+    benchmark::DoNotOptimize(dst_buffer.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * src_buffer.size());
+}
+BENCHMARK(BM_ReduceSumF32)->ArgName("dimension")->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace kernels
+}  // namespace vmla
+}  // namespace hal
+}  // namespace iree
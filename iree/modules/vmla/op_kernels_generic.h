@@ -162,12 +162,12 @@ Status Copy::Execute(absl::Span<const uint8_t> src_buffer, ShapeSpan src_shape,
 }
 
 template <typename T>
-Status Conv2D::Execute(absl::Span<const T> input_buffer, ShapeSpan input_shape,
-                       absl::Span<const T> filter_buffer,
-                       ShapeSpan filter_shape, absl::Span<T> dst_buffer,
-                       ShapeSpan dst_shape, ShapeSpan window_strides,
-                       ShapeSpan pad_h, ShapeSpan pad_w, ShapeSpan lhs_dilation,
-                       ShapeSpan rhs_dilation, const int32_t groups) {
+Status Conv2D::ExecuteReference(
+    absl::Span<const T> input_buffer, ShapeSpan input_shape,
+    absl::Span<const T> filter_buffer, ShapeSpan filter_shape,
+    absl::Span<T> dst_buffer, ShapeSpan dst_shape, ShapeSpan window_strides,
+    ShapeSpan pad_h, ShapeSpan pad_w, ShapeSpan lhs_dilation,
+    ShapeSpan rhs_dilation, const int32_t groups) {
   const std::array<int32_t, 3> input_strides = {input_shape[1] * input_shape[2],
                                                 input_shape[2], 1};
   const std::array<int32_t, 4> filter_strides = {
@@ -177,7 +177,7 @@ Status Conv2D::Execute(absl::Span<const T> input_buffer, ShapeSpan input_shape,
                                               dst_shape[2], 1};
   // Direct 2d (grouped) convolution slow implementation. ref:
   // https://www.tensorflow.org/versions/r2.0/api_docs/python/tf/nn/convolution)
-  // TODO(ataei): Implement tiled GEMM based implementation.
+  // See Conv2D::Execute in op_kernels_ruy.h for the GEMM-based implementation.
   const int output_group_size = dst_shape[2] / groups;
   const int input_group_size = input_shape[2] / groups;
   for (int ho = 0; ho < dst_shape[0]; ho++) {
@@ -938,69 +938,37 @@ struct OrKernel {
   }
 };
 
+// Reductions over a single dimension of a row-major buffer viewed as
+// [outer, reduce, inner]. Both forms walk the source contiguously.
+// op_kernels_simd.h specializes these for vectorizable types and kernels.
 template <typename T, typename KernelImpl>
-inline void ReduceDimension(absl::Span<const T> src_buffer,
-                            absl::Span<T> dst_buffer, ShapeSpan src_shape,
-                            absl::Span<const int32_t> reduce_dims,
-                            absl::Span<const int> dst_strides, int dim,
-                            absl::Span<int> src_indices, size_t flat_src_i,
-                            size_t src_stride) {
-  if (dim < 0) {
-    // Base case of the recursion - figure out which elements should be acted
-    // upon and apply the reduction kernel to them.
-
-    // Derive destination indices from source indices.
-    // For example,
-    //     reduce_dims: [1, 2]
-    //     src_indices: [2, 1, 3, 0]
-    //                      ^  ^
-    //                      |  |
-    //                      |----- remove these dimensions
-    //     dst_indices: [2, 0]
-    //
-    // TODO(scotttodd): Clean this up somehow, share across recursion levels?
-    size_t dst_size = src_shape.size() - reduce_dims.size();
-    absl::InlinedVector<int, 8> dst_indices;
-    for (size_t i = 0; i < src_indices.size(); ++i) {
-      if (std::find(std::begin(reduce_dims), std::end(reduce_dims), i) ==
-          std::end(reduce_dims)) {
-        dst_indices.push_back(src_indices[i]);
+struct ContiguousReduce {
+  // Reduces each of |outer_size| contiguous rows of |reduce_size| elements
+  // into dst[row] (when the reduced dimension is innermost).
+  static void ReduceInner(const T* src, T* dst, size_t outer_size,
+                          size_t reduce_size) {
+    for (size_t o = 0; o < outer_size; ++o) {
+      T value = dst[o];
+      for (size_t r = 0; r < reduce_size; ++r) {
+        KernelImpl()(&value, src[r]);
       }
+      dst[o] = value;
+      src += reduce_size;
     }
-    // Compute the flattened index into dst_buffer at [dst_indices].
-    size_t dst_i = 0;
-    for (size_t i = 0; i < dst_indices.size(); ++i) {
-      dst_i += dst_indices[i] * dst_strides[dst_size - 1 - i];
-    }
-
-    // Flattened src and dst indices have been computed, invoke the kernel.
-    KernelImpl()(&dst_buffer[dst_i], src_buffer[flat_src_i]);
-    return;
   }
 
-  // Iterate through the current dimension in the source shape, recursing
-  // down one dimension at a time.
-  //
-  // This touches each element in the source buffer once, tracking complete
-  // dimensions within the shaped source buffer and using them to compute
-  // the corresponding indices (shaped and flattened) within the destination
-  // buffer. Each element in the destination buffer will be touched multiple
-  // times.
-  //
-  // Note that cache coherency isn't considered here, and some computations
-  // are redundant, so this could be optimized substantially.
-  for (size_t dim_i = 0; dim_i < src_shape[dim]; ++dim_i) {
-    src_indices[dim] = dim_i;
-
-    // Recurse down to the next dimension (e.g. 2 -> 1 -> 0 -> base case)
-    //   * Add the current stride to flat_src_i
-    //   * Multiply src_stride by this dimension's shape
-    ReduceDimension<T, KernelImpl>(src_buffer, dst_buffer, src_shape,
-                                   reduce_dims, dst_strides, dim - 1,
-                                   src_indices, flat_src_i + dim_i * src_stride,
-                                   src_stride * src_shape[dim]);
+  // Reduces |reduce_size| contiguous rows of |inner_size| elements
+  // elementwise into dst[0, inner_size).
+  static void ReduceOuter(const T* src, T* dst, size_t reduce_size,
+                          size_t inner_size) {
+    for (size_t r = 0; r < reduce_size; ++r) {
+      for (size_t i = 0; i < inner_size; ++i) {
+        KernelImpl()(&dst[i], src[i]);
+      }
+      src += inner_size;
+    }
   }
-}
+};
 
 template <typename T, typename KernelImpl>
 Status GenericReduce(absl::Span<const T> src_buffer,
@@ -1010,25 +978,30 @@ Status GenericReduce(absl::Span<const T> src_buffer,
   // Initialize using init_buffer, which is expected to be a scalar.
   std::fill_n(dst_buffer.data(), dst_buffer.size(), init_buffer[0]);
 
-  // Precompute destination strides.
-  int dst_rank = dst_shape.size();
-  absl::InlinedVector<int, 8> dst_strides;
-  size_t dst_stride = 1;
-  for (int dim_i = dst_rank - 1; dim_i >= 0; --dim_i) {
-    dst_strides.push_back(dst_stride);
-    dst_stride *= dst_shape[dim_i];
+  // Split the source shape around the reduced dimension. Every element of dst
+  // then corresponds to one (outer, inner) pair.
+  size_t outer_size = 1;
+  for (int32_t i = 0; i < dimension; ++i) {
+    outer_size *= src_shape[i];
+  }
+  const size_t reduce_size = src_shape[dimension];
+  size_t inner_size = 1;
+  for (size_t i = dimension + 1; i < src_shape.size(); ++i) {
+    inner_size *= src_shape[i];
   }
 
-  // Call the helper (recursive) function, starting with:
-  //   * source index [0, 0, ..., 0]
-  //   * the innermost dimension (last in the shape)
-  //   * flat_src_i of 0 (corresponds to [0, 0, ..., 0] above)
-  //   * source stride 1
-  absl::InlinedVector<int, 8> src_indices(src_shape.size(), 0);
-  ReduceDimension<T, KernelImpl>(src_buffer, dst_buffer, src_shape, {dimension},
-                                 absl::MakeSpan(dst_strides),
-                                 src_shape.size() - 1,
-                                 absl::MakeSpan(src_indices), 0, 1);
+  const T* src = src_buffer.data();
+  T* dst = dst_buffer.data();
+  if (inner_size == 1) {
+    ContiguousReduce<T, KernelImpl>::ReduceInner(src, dst, outer_size,
+                                                 reduce_size);
+  } else {
+    for (size_t o = 0; o < outer_size; ++o) {
+      ContiguousReduce<T, KernelImpl>::ReduceOuter(
+          src + o * reduce_size * inner_size, dst + o * inner_size,
+          reduce_size, inner_size);
+    }
+  }
 
   return OkStatus();
 }
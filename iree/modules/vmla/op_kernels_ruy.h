@@ -15,7 +15,9 @@
 #ifndef IREE_MODULES_VMLA_OP_KERNELS_RUY_H_
 #define IREE_MODULES_VMLA_OP_KERNELS_RUY_H_
 
+#include <algorithm>
 #include <type_traits>
+#include <vector>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/memory/memory.h"
@@ -123,6 +125,240 @@ Status MatMul::Execute(RuntimeState* runtime_state,
   return OkStatus();
 }
 
+namespace impl {
+
+// Upper bound on the number of im2col patch elements materialized at once.
+// Output pixels are processed in tiles so that the scratch buffer stays small
+// (and warm in cache) regardless of the input size.
+constexpr size_t kConv2DMaxPatchElements = 256 * 1024;
+
+// Geometry shared by the Conv2D lowerings.
+struct Conv2DParams {
+  int32_t input_h;
+  int32_t input_w;
+  int32_t input_c;
+  int32_t kernel_h;
+  int32_t kernel_w;
+  int32_t output_h;
+  int32_t output_w;
+  int32_t output_c;
+  int32_t groups;
+  int32_t input_group_size;
+  int32_t output_group_size;
+  ShapeSpan strides;
+  ShapeSpan pad_h;
+  ShapeSpan pad_w;
+  ShapeSpan lhs_dilation;
+  ShapeSpan rhs_dilation;
+
+  // Maps an output row/column and kernel tap to the input row/column it reads.
+  // Returns -1 if the tap falls in padding or between lhs-dilated elements.
+  int32_t InputRow(int32_t ho, int32_t kh) const {
+    int32_t ih = ho * strides[0] + kh * rhs_dilation[0] - pad_h[0];
+    if (ih < 0 || ih % lhs_dilation[0]) return -1;
+    ih /= lhs_dilation[0];
+    return ih < input_h ? ih : -1;
+  }
+  int32_t InputCol(int32_t wo, int32_t kw) const {
+    int32_t iw = wo * strides[1] + kw * rhs_dilation[1] - pad_w[0];
+    if (iw < 0 || iw % lhs_dilation[1]) return -1;
+    iw /= lhs_dilation[1];
+    return iw < input_w ? iw : -1;
+  }
+};
+
+// Gathers the receptive fields of output pixels [m_begin, m_end) of group
+// |group| into |patches| as row-major [pixel, KH * KW * input_group_size].
+// Padded taps are written as zeros.
+template <typename T>
+void Conv2DIm2Col(const Conv2DParams& params, const T* input, int32_t group,
+                  int32_t m_begin, int32_t m_end, T* patches) {
+  const int32_t channels = params.input_group_size;
+  const T* group_input = input + group * channels;
+  for (int32_t m = m_begin; m < m_end; ++m) {
+    const int32_t ho = m / params.output_w;
+    const int32_t wo = m % params.output_w;
+    for (int32_t kh = 0; kh < params.kernel_h; ++kh) {
+      const int32_t ih = params.InputRow(ho, kh);
+      for (int32_t kw = 0; kw < params.kernel_w; ++kw) {
+        const int32_t iw = ih < 0 ? -1 : params.InputCol(wo, kw);
+        if (iw < 0) {
+          std::fill_n(patches, channels, T(0));
+        } else {
+          std::copy_n(
+              group_input + (ih * params.input_w + iw) * params.input_c,
+              channels, patches);
+        }
+        patches += channels;
+      }
+    }
+  }
+}
+
+// Depthwise convolution (one input channel per group) done directly: the
+// im2col GEMMs would have a reduction depth of only KH * KW.
+template <typename T>
+void Conv2DDepthwise(const Conv2DParams& params, const T* input,
+                     const T* filter, T* dst) {
+  const int32_t multiplier = params.output_group_size;
+  const int32_t channels = params.input_c;
+  for (int32_t ho = 0; ho < params.output_h; ++ho) {
+    for (int32_t wo = 0; wo < params.output_w; ++wo) {
+      T* dst_pixel = dst + (ho * params.output_w + wo) * params.output_c;
+      for (int32_t kh = 0; kh < params.kernel_h; ++kh) {
+        const int32_t ih = params.InputRow(ho, kh);
+        if (ih < 0) continue;
+        for (int32_t kw = 0; kw < params.kernel_w; ++kw) {
+          const int32_t iw = params.InputCol(wo, kw);
+          if (iw < 0) continue;
+          const T* input_pixel = input + (ih * params.input_w + iw) * channels;
+          const T* filter_tap =
+              filter + (kh * params.kernel_w + kw) * channels * multiplier;
+          if (multiplier == 1) {
+            for (int32_t c = 0; c < channels; ++c) {
+              dst_pixel[c] += input_pixel[c] * filter_tap[c];
+            }
+          } else {
+            for (int32_t c = 0; c < channels; ++c) {
+              for (int32_t co = 0; co < multiplier; ++co) {
+                dst_pixel[c * multiplier + co] +=
+                    input_pixel[c] * filter_tap[c * multiplier + co];
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace impl
+
+template <typename T>
+Status Conv2D::Execute(MatMul::RuntimeState* runtime_state,
+                       absl::Span<const T> input_buffer, ShapeSpan input_shape,
+                       absl::Span<const T> filter_buffer,
+                       ShapeSpan filter_shape, absl::Span<T> dst_buffer,
+                       ShapeSpan dst_shape, ShapeSpan window_strides,
+                       ShapeSpan pad_h, ShapeSpan pad_w, ShapeSpan lhs_dilation,
+                       ShapeSpan rhs_dilation, const int32_t groups) {
+  static_assert(std::is_floating_point<T>::value,
+                "GEMM lowering only supports floating-point convolutions");
+  impl::Conv2DParams params;
+  params.input_h = input_shape[0];
+  params.input_w = input_shape[1];
+  params.input_c = input_shape[2];
+  params.kernel_h = filter_shape[0];
+  params.kernel_w = filter_shape[1];
+  params.output_h = dst_shape[0];
+  params.output_w = dst_shape[1];
+  params.output_c = dst_shape[2];
+  params.groups = groups;
+  params.input_group_size = params.input_c / groups;
+  params.output_group_size = params.output_c / groups;
+  params.strides = window_strides;
+  params.pad_h = pad_h;
+  params.pad_w = pad_w;
+  params.lhs_dilation = lhs_dilation;
+  params.rhs_dilation = rhs_dilation;
+
+  // Each group is a [M, K] x [K, N] GEMM with M output pixels, K taps per
+  // output pixel and N output channels.
+  const int32_t m = params.output_h * params.output_w;
+  const int32_t k =
+      params.kernel_h * params.kernel_w * params.input_group_size;
+  const int32_t n = params.output_group_size;
+  if (m == 0 || k == 0 || n == 0) return OkStatus();
+
+  if (groups > 1 && params.input_group_size == 1) {
+    impl::Conv2DDepthwise(params, input_buffer.data(), filter_buffer.data(),
+                          dst_buffer.data());
+    return OkStatus();
+  }
+
+  // A 1x1 stride-1 unpadded convolution reads each input pixel exactly once
+  // in output order: the input is already the [M, K] patch matrix.
+  const bool is_pointwise =
+      params.kernel_h == 1 && params.kernel_w == 1 && groups == 1 &&
+      window_strides[0] == 1 && window_strides[1] == 1 && pad_h[0] == 0 &&
+      pad_w[0] == 0 && lhs_dilation[0] == 1 && lhs_dilation[1] == 1 &&
+      params.output_h == params.input_h && params.output_w == params.input_w;
+
+  // The filter is [KH, KW, C, N] so with a single group it is already the
+  // row-major [K, N] filter matrix. Otherwise each group's rows are strided
+  // through the input channels and need to be packed.
+  std::vector<T> packed_filter;
+  if (groups > 1) packed_filter.resize(static_cast<size_t>(k) * n);
+
+  int32_t m_tile = m;
+  if (!is_pointwise) {
+    m_tile = std::max<int32_t>(
+        1, std::min<int32_t>(m, impl::kConv2DMaxPatchElements / k));
+  }
+  std::vector<T> patches;
+  if (!is_pointwise) patches.resize(static_cast<size_t>(m_tile) * k);
+  std::vector<T> results(static_cast<size_t>(m_tile) * params.output_c);
+
+  for (int32_t g = 0; g < groups; ++g) {
+    const T* filter_data = filter_buffer.data();
+    if (groups > 1) {
+      const int32_t taps = params.kernel_h * params.kernel_w;
+      for (int32_t tap = 0; tap < taps; ++tap) {
+        std::copy_n(filter_buffer.data() +
+                        (tap * params.input_c + g * params.input_group_size) *
+                            n,
+                    params.input_group_size * n,
+                    packed_filter.data() + tap * params.input_group_size * n);
+      }
+      filter_data = packed_filter.data();
+    }
+    ruy::Matrix<T> rhs;
+    rhs.set_data(filter_data);
+    ruy::MakeSimpleLayout(k, n, ruy::Order::kRowMajor, rhs.mutable_layout());
+
+    for (int32_t m_begin = 0; m_begin < m; m_begin += m_tile) {
+      const int32_t m_end = std::min(m, m_begin + m_tile);
+      const int32_t rows = m_end - m_begin;
+
+      ruy::Matrix<T> lhs;
+      if (is_pointwise) {
+        lhs.set_data(input_buffer.data() +
+                     static_cast<size_t>(m_begin) * params.input_c);
+      } else {
+        impl::Conv2DIm2Col(params, input_buffer.data(), g, m_begin, m_end,
+                           patches.data());
+        lhs.set_data(patches.data());
+      }
+      ruy::MakeSimpleLayout(rows, k, ruy::Order::kRowMajor,
+                            lhs.mutable_layout());
+
+      // Results for this group land in its channel slice of the pixel rows.
+      ruy::Matrix<T> dst;
+      dst.set_data(results.data() + g * n);
+      ruy::MakeSimpleLayout(rows, n, ruy::Order::kRowMajor,
+                            dst.mutable_layout());
+      dst.mutable_layout()->set_stride(params.output_c);
+
+      ruy::MulParams<T, T> mul_params;
+      ruy::Mul(lhs, rhs, mul_params, &runtime_state->context, &dst);
+
+      // Accumulate into the destination (matching the reference semantics).
+      T* dst_rows = dst_buffer.data() +
+                    static_cast<size_t>(m_begin) * params.output_c + g * n;
+      const T* result_rows = results.data() + g * n;
+      for (int32_t row = 0; row < rows; ++row) {
+        for (int32_t col = 0; col < n; ++col) {
+          dst_rows[col] += result_rows[col];
+        }
+        dst_rows += params.output_c;
+        result_rows += params.output_c;
+      }
+    }
+  }
+
+  return OkStatus();
+}
+
 }  // namespace kernels
 }  // namespace vmla
 }  // namespace hal
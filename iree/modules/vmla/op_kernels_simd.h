@@ -0,0 +1,422 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// SIMD specializations of the generic float kernels.
+//
+// A small set of vector primitives is implemented per ISA (AVX2, SSE2, and
+// NEON on aarch64) as selected at compile time. The kernels below are written
+// against those primitives and are used in place of the generic templates for
+// float buffers. When no supported ISA is available nothing is specialized and
+// the generic kernels are used.
+//
+// Transcendental functions use the same Cephes/Eigen-style approximations
+// found in most vector math libraries and are accurate to a few ulp.
+
+#ifndef IREE_MODULES_VMLA_OP_KERNELS_SIMD_H_
+#define IREE_MODULES_VMLA_OP_KERNELS_SIMD_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "absl/types/span.h"
+#include "iree/base/status.h"
+
+#if !defined(IREE_VMLA_SIMD_DISABLE)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define IREE_VMLA_SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IREE_VMLA_SIMD_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define IREE_VMLA_SIMD_NEON 1
+#endif
+#endif  // !IREE_VMLA_SIMD_DISABLE
+
+#if defined(IREE_VMLA_SIMD_AVX2) || defined(IREE_VMLA_SIMD_SSE2) || \
+    defined(IREE_VMLA_SIMD_NEON)
+#define IREE_VMLA_SIMD 1
+
+namespace iree {
+namespace hal {
+namespace vmla {
+namespace kernels {
+namespace simd {
+
+//===----------------------------------------------------------------------===//
+// Vector primitives
+//===----------------------------------------------------------------------===//
+
+#if defined(IREE_VMLA_SIMD_AVX2)
+
+using VecF32 = __m256;
+constexpr size_t kWidthF32 = 8;
+
+inline VecF32 Load(const float* p) { return _mm256_loadu_ps(p); }
+inline void Store(float* p, VecF32 v) { _mm256_storeu_ps(p, v); }
+inline VecF32 Broadcast(float v) { return _mm256_set1_ps(v); }
+inline VecF32 Add(VecF32 a, VecF32 b) { return _mm256_add_ps(a, b); }
+inline VecF32 Sub(VecF32 a, VecF32 b) { return _mm256_sub_ps(a, b); }
+inline VecF32 Mul(VecF32 a, VecF32 b) { return _mm256_mul_ps(a, b); }
+inline VecF32 Div(VecF32 a, VecF32 b) { return _mm256_div_ps(a, b); }
+// Operand order matches std::min/std::max (a is returned on ties/NaNs).
+inline VecF32 Min(VecF32 a, VecF32 b) { return _mm256_min_ps(b, a); }
+inline VecF32 Max(VecF32 a, VecF32 b) { return _mm256_max_ps(b, a); }
+inline VecF32 Sqrt(VecF32 a) { return _mm256_sqrt_ps(a); }
+inline VecF32 Abs(VecF32 a) {
+  return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a);
+}
+inline VecF32 Neg(VecF32 a) { return _mm256_xor_ps(_mm256_set1_ps(-0.0f), a); }
+inline VecF32 Floor(VecF32 a) { return _mm256_floor_ps(a); }
+// Lane mask of a < b (false for NaNs) and a per-lane select on such a mask.
+inline VecF32 Less(VecF32 a, VecF32 b) {
+  return _mm256_cmp_ps(a, b, _CMP_LT_OQ);
+}
+inline VecF32 Select(VecF32 mask, VecF32 t, VecF32 f) {
+  return _mm256_blendv_ps(f, t, mask);
+}
+inline VecF32 MulAdd(VecF32 a, VecF32 b, VecF32 c) {
+#if defined(__FMA__)
+  return _mm256_fmadd_ps(a, b, c);
+#else
+  return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif  // __FMA__
+}
+// Returns 2^n for integral |n| in the normal exponent range.
+inline VecF32 Pow2(VecF32 n) {
+  __m256i bits = _mm256_slli_epi32(
+      _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+  return _mm256_castsi256_ps(bits);
+}
+inline float ReduceAdd(VecF32 v) {
+  __m128 r = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  r = _mm_add_ps(r, _mm_movehl_ps(r, r));
+  r = _mm_add_ss(r, _mm_shuffle_ps(r, r, 1));
+  return _mm_cvtss_f32(r);
+}
+inline float ReduceMin(VecF32 v) {
+  __m128 r = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  r = _mm_min_ps(r, _mm_movehl_ps(r, r));
+  r = _mm_min_ss(r, _mm_shuffle_ps(r, r, 1));
+  return _mm_cvtss_f32(r);
+}
+inline float ReduceMax(VecF32 v) {
+  __m128 r = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  r = _mm_max_ps(r, _mm_movehl_ps(r, r));
+  r = _mm_max_ss(r, _mm_shuffle_ps(r, r, 1));
+  return _mm_cvtss_f32(r);
+}
+
+#elif defined(IREE_VMLA_SIMD_SSE2)
+
+using VecF32 = __m128;
+constexpr size_t kWidthF32 = 4;
+
+inline VecF32 Load(const float* p) { return _mm_loadu_ps(p); }
+inline void Store(float* p, VecF32 v) { _mm_storeu_ps(p, v); }
+inline VecF32 Broadcast(float v) { return _mm_set1_ps(v); }
+inline VecF32 Add(VecF32 a, VecF32 b) { return _mm_add_ps(a, b); }
+inline VecF32 Sub(VecF32 a, VecF32 b) { return _mm_sub_ps(a, b); }
+inline VecF32 Mul(VecF32 a, VecF32 b) { return _mm_mul_ps(a, b); }
+inline VecF32 Div(VecF32 a, VecF32 b) { return _mm_div_ps(a, b); }
+// Operand order matches std::min/std::max (a is returned on ties/NaNs).
+inline VecF32 Min(VecF32 a, VecF32 b) { return _mm_min_ps(b, a); }
+inline VecF32 Max(VecF32 a, VecF32 b) { return _mm_max_ps(b, a); }
+inline VecF32 Sqrt(VecF32 a) { return _mm_sqrt_ps(a); }
+inline VecF32 Abs(VecF32 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+inline VecF32 Neg(VecF32 a) { return _mm_xor_ps(_mm_set1_ps(-0.0f), a); }
+inline VecF32 Floor(VecF32 a) {
+  // Truncate and then step down for negative non-integral values. Only valid
+  // for values within int32 range, which all callers guarantee.
+  VecF32 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+  return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1.0f)));
+}
+// Lane mask of a < b (false for NaNs) and a per-lane select on such a mask.
+inline VecF32 Less(VecF32 a, VecF32 b) { return _mm_cmplt_ps(a, b); }
+inline VecF32 Select(VecF32 mask, VecF32 t, VecF32 f) {
+  return _mm_or_ps(_mm_and_ps(mask, t), _mm_andnot_ps(mask, f));
+}
+inline VecF32 MulAdd(VecF32 a, VecF32 b, VecF32 c) {
+  return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+// Returns 2^n for integral |n| in the normal exponent range.
+inline VecF32 Pow2(VecF32 n) {
+  __m128i bits = _mm_slli_epi32(
+      _mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127)), 23);
+  return _mm_castsi128_ps(bits);
+}
+inline float ReduceAdd(VecF32 v) {
+  VecF32 r = _mm_add_ps(v, _mm_movehl_ps(v, v));
+  r = _mm_add_ss(r, _mm_shuffle_ps(r, r, 1));
+  return _mm_cvtss_f32(r);
+}
+inline float ReduceMin(VecF32 v) {
+  VecF32 r = _mm_min_ps(v, _mm_movehl_ps(v, v));
+  r = _mm_min_ss(r, _mm_shuffle_ps(r, r, 1));
+  return _mm_cvtss_f32(r);
+}
+inline float ReduceMax(VecF32 v) {
+  VecF32 r = _mm_max_ps(v, _mm_movehl_ps(v, v));
+  r = _mm_max_ss(r, _mm_shuffle_ps(r, r, 1));
+  return _mm_cvtss_f32(r);
+}
+
+#elif defined(IREE_VMLA_SIMD_NEON)
+
+using VecF32 = float32x4_t;
+constexpr size_t kWidthF32 = 4;
+
+inline VecF32 Load(const float* p) { return vld1q_f32(p); }
+inline void Store(float* p, VecF32 v) { vst1q_f32(p, v); }
+inline VecF32 Broadcast(float v) { return vdupq_n_f32(v); }
+inline VecF32 Add(VecF32 a, VecF32 b) { return vaddq_f32(a, b); }
+inline VecF32 Sub(VecF32 a, VecF32 b) { return vsubq_f32(a, b); }
+inline VecF32 Mul(VecF32 a, VecF32 b) { return vmulq_f32(a, b); }
+inline VecF32 Div(VecF32 a, VecF32 b) { return vdivq_f32(a, b); }
+// Selects like std::min/std::max (a is returned on ties/NaNs).
+inline VecF32 Min(VecF32 a, VecF32 b) {
+  return vbslq_f32(vcltq_f32(b, a), b, a);
+}
+inline VecF32 Max(VecF32 a, VecF32 b) {
+  return vbslq_f32(vcltq_f32(a, b), b, a);
+}
+inline VecF32 Sqrt(VecF32 a) { return vsqrtq_f32(a); }
+inline VecF32 Abs(VecF32 a) { return vabsq_f32(a); }
+inline VecF32 Neg(VecF32 a) { return vnegq_f32(a); }
+inline VecF32 Floor(VecF32 a) { return vrndmq_f32(a); }
+// Lane mask of a < b (false for NaNs) and a per-lane select on such a mask.
+inline VecF32 Less(VecF32 a, VecF32 b) {
+  return vreinterpretq_f32_u32(vcltq_f32(a, b));
+}
+inline VecF32 Select(VecF32 mask, VecF32 t, VecF32 f) {
+  return vbslq_f32(vreinterpretq_u32_f32(mask), t, f);
+}
+inline VecF32 MulAdd(VecF32 a, VecF32 b, VecF32 c) {
+  return vfmaq_f32(c, a, b);
+}
+// Returns 2^n for integral |n| in the normal exponent range.
+inline VecF32 Pow2(VecF32 n) {
+  int32x4_t bits =
+      vshlq_n_s32(vaddq_s32(vcvtnq_s32_f32(n), vdupq_n_s32(127)), 23);
+  return vreinterpretq_f32_s32(bits);
+}
+inline float ReduceAdd(VecF32 v) { return vaddvq_f32(v); }
+inline float ReduceMin(VecF32 v) { return vminvq_f32(v); }
+inline float ReduceMax(VecF32 v) { return vmaxvq_f32(v); }
+
+#endif  // IREE_VMLA_SIMD_*
+
+// exp(x) via range reduction to x = n*ln(2) + r and a degree-6 polynomial for
+// exp(r) (Cephes expf). Inputs outside of the range the reduction supports
+// return 0 (including -inf) and +inf (including +inf) like std::exp; NaNs
+// propagate.
+inline VecF32 Exp(VecF32 x) {
+  const VecF32 min_x = Broadcast(-87.3365478515625f);
+  const VecF32 max_x = Broadcast(88.3762626647949f);
+  VecF32 underflow = Less(x, min_x);
+  VecF32 overflow = Less(max_x, x);
+  x = Min(Max(x, min_x), max_x);
+  VecF32 n = Floor(MulAdd(x, Broadcast(1.44269504088896341f), Broadcast(0.5f)));
+  x = Sub(x, Mul(n, Broadcast(0.693359375f)));
+  x = Sub(x, Mul(n, Broadcast(-2.12194440e-4f)));
+  VecF32 y = Broadcast(1.9875691500e-4f);
+  y = MulAdd(y, x, Broadcast(1.3981999507e-3f));
+  y = MulAdd(y, x, Broadcast(8.3334519073e-3f));
+  y = MulAdd(y, x, Broadcast(4.1665795894e-2f));
+  y = MulAdd(y, x, Broadcast(1.6666665459e-1f));
+  y = MulAdd(y, x, Broadcast(5.0000001201e-1f));
+  y = MulAdd(y, Mul(x, x), Add(x, Broadcast(1.0f)));
+  y = Mul(y, Pow2(n));
+  y = Select(underflow, Broadcast(0.0f), y);
+  return Select(overflow, Broadcast(std::numeric_limits<float>::infinity()), y);
+}
+
+// tanh(x) as a 13/6 rational polynomial on the clamped range [-9, 9]
+// (Eigen's fast tanh).
+inline VecF32 Tanh(VecF32 x) {
+  x = Min(Max(x, Broadcast(-9.0f)), Broadcast(9.0f));
+  VecF32 x2 = Mul(x, x);
+  VecF32 p = Broadcast(-2.76076847742355e-16f);
+  p = MulAdd(x2, p, Broadcast(2.00018790482477e-13f));
+  p = MulAdd(x2, p, Broadcast(-8.60467152213735e-11f));
+  p = MulAdd(x2, p, Broadcast(5.12229709037114e-08f));
+  p = MulAdd(x2, p, Broadcast(1.48572235717979e-05f));
+  p = MulAdd(x2, p, Broadcast(6.37261928875436e-04f));
+  p = MulAdd(x2, p, Broadcast(4.89352455891786e-03f));
+  p = Mul(x, p);
+  VecF32 q = Broadcast(1.19825839466702e-06f);
+  q = MulAdd(x2, q, Broadcast(1.18534705686654e-04f));
+  q = MulAdd(x2, q, Broadcast(2.26843463243900e-03f));
+  q = MulAdd(x2, q, Broadcast(4.89352518554385e-03f));
+  return Div(p, q);
+}
+
+//===----------------------------------------------------------------------===//
+// Loop helpers
+//===----------------------------------------------------------------------===//
+
+// Applies |op| to full vectors and then to the zero-padded remainder so that
+// the tail uses the exact same math as the body. |op| should be a lambda (not
+// a function pointer) so that it is inlined into the loop.
+template <typename Op>
+inline void UnaryF32(const float* src, float* dst, size_t count, Op op) {
+  size_t i = 0;
+  for (; i + kWidthF32 <= count; i += kWidthF32) {
+    Store(dst + i, op(Load(src + i)));
+  }
+  if (i < count) {
+    float src_tail[kWidthF32] = {0.0f};
+    float dst_tail[kWidthF32];
+    std::copy(src + i, src + count, src_tail);
+    Store(dst_tail, op(Load(src_tail)));
+    std::copy(dst_tail, dst_tail + (count - i), dst + i);
+  }
+}
+
+template <typename Op>
+inline void BinaryF32(const float* lhs, const float* rhs, float* dst,
+                      size_t count, Op op) {
+  size_t i = 0;
+  for (; i + kWidthF32 <= count; i += kWidthF32) {
+    Store(dst + i, op(Load(lhs + i), Load(rhs + i)));
+  }
+  if (i < count) {
+    // Pad with ones to keep division/etc of the unused lanes well-defined.
+    float lhs_tail[kWidthF32];
+    float rhs_tail[kWidthF32];
+    float dst_tail[kWidthF32];
+    std::fill_n(lhs_tail, kWidthF32, 1.0f);
+    std::fill_n(rhs_tail, kWidthF32, 1.0f);
+    std::copy(lhs + i, lhs + count, lhs_tail);
+    std::copy(rhs + i, rhs + count, rhs_tail);
+    Store(dst_tail, op(Load(lhs_tail), Load(rhs_tail)));
+    std::copy(dst_tail, dst_tail + (count - i), dst + i);
+  }
+}
+
+}  // namespace simd
+
+//===----------------------------------------------------------------------===//
+// Elementwise kernels
+//===----------------------------------------------------------------------===//
+
+#define IREE_VMLA_SIMD_BINARY_KERNEL(name, fn)                                 \
+  template <>                                                                 \
+  inline Status name::Execute<float>(absl::Span<const float> lhs_buffer,      \
+                                     absl::Span<const float> rhs_buffer,      \
+                                     absl::Span<float> dst_buffer) {          \
+    simd::BinaryF32(lhs_buffer.data(), rhs_buffer.data(), dst_buffer.data(), \
+                    dst_buffer.size(),                                        \
+                    [](simd::VecF32 a, simd::VecF32 b) { return fn(a, b); }); \
+    return OkStatus();                                                        \
+  }
+#define IREE_VMLA_SIMD_UNARY_KERNEL(name, fn)                                 \
+  template <>                                                                 \
+  inline Status name::Execute<float>(absl::Span<const float> src_buffer,     \
+                                     absl::Span<float> dst_buffer) {         \
+    simd::UnaryF32(src_buffer.data(), dst_buffer.data(), dst_buffer.size(), \
+                   [](simd::VecF32 a) { return fn(a); });                    \
+    return OkStatus();                                                       \
+  }
+
+IREE_VMLA_SIMD_BINARY_KERNEL(Add, simd::Add)
+IREE_VMLA_SIMD_BINARY_KERNEL(Sub, simd::Sub)
+IREE_VMLA_SIMD_BINARY_KERNEL(Mul, simd::Mul)
+IREE_VMLA_SIMD_BINARY_KERNEL(Div, simd::Div)
+IREE_VMLA_SIMD_BINARY_KERNEL(Min, simd::Min)
+IREE_VMLA_SIMD_BINARY_KERNEL(Max, simd::Max)
+IREE_VMLA_SIMD_UNARY_KERNEL(Abs, simd::Abs)
+IREE_VMLA_SIMD_UNARY_KERNEL(Neg, simd::Neg)
+IREE_VMLA_SIMD_UNARY_KERNEL(Sqrt, simd::Sqrt)
+IREE_VMLA_SIMD_UNARY_KERNEL(Exp, simd::Exp)
+IREE_VMLA_SIMD_UNARY_KERNEL(Tanh, simd::Tanh)
+
+#undef IREE_VMLA_SIMD_BINARY_KERNEL
+#undef IREE_VMLA_SIMD_UNARY_KERNEL
+
+//===----------------------------------------------------------------------===//
+// Reduction kernels
+//===----------------------------------------------------------------------===//
+
+namespace impl {
+
+// Vectorized ContiguousReduce shared by the sum/min/max kernels.
+// |VecOp| combines vectors, |HorizontalOp| folds a vector to a scalar and
+// |ScalarKernel| handles the remainder. Note that the sum is accumulated in a
+// different order than the scalar kernel and may round differently.
+template <typename ScalarKernel, simd::VecF32 (*VecOp)(simd::VecF32,
+                                                       simd::VecF32),
+          float (*HorizontalOp)(simd::VecF32)>
+struct ContiguousReduceF32 {
+  static void ReduceInner(const float* src, float* dst, size_t outer_size,
+                          size_t reduce_size) {
+    for (size_t o = 0; o < outer_size; ++o) {
+      float value = dst[o];
+      size_t r = 0;
+      if (reduce_size >= simd::kWidthF32) {
+        simd::VecF32 acc = simd::Load(src);
+        for (r = simd::kWidthF32; r + simd::kWidthF32 <= reduce_size;
+             r += simd::kWidthF32) {
+          acc = VecOp(acc, simd::Load(src + r));
+        }
+        ScalarKernel()(&value, HorizontalOp(acc));
+      }
+      for (; r < reduce_size; ++r) {
+        ScalarKernel()(&value, src[r]);
+      }
+      dst[o] = value;
+      src += reduce_size;
+    }
+  }
+
+  static void ReduceOuter(const float* src, float* dst, size_t reduce_size,
+                          size_t inner_size) {
+    for (size_t r = 0; r < reduce_size; ++r) {
+      size_t i = 0;
+      for (; i + simd::kWidthF32 <= inner_size; i += simd::kWidthF32) {
+        simd::Store(dst + i,
+                    VecOp(simd::Load(dst + i), simd::Load(src + i)));
+      }
+      for (; i < inner_size; ++i) {
+        ScalarKernel()(&dst[i], src[i]);
+      }
+      src += inner_size;
+    }
+  }
+};
+
+template <>
+struct ContiguousReduce<float, SumKernel>
+    : public ContiguousReduceF32<SumKernel, simd::Add, simd::ReduceAdd> {};
+template <>
+struct ContiguousReduce<float, MinKernel>
+    : public ContiguousReduceF32<MinKernel, simd::Min, simd::ReduceMin> {};
+template <>
+struct ContiguousReduce<float, MaxKernel>
+    : public ContiguousReduceF32<MaxKernel, simd::Max, simd::ReduceMax> {};
+
+}  // namespace impl
+
+}  // namespace kernels
+}  // namespace vmla
+}  // namespace hal
+}  // namespace iree
+
+#endif  // IREE_VMLA_SIMD
+
+#endif  // IREE_MODULES_VMLA_OP_KERNELS_SIMD_H_
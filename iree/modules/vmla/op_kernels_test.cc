@@ -425,6 +425,169 @@ TEST(ReduceMin, TwoDimensionsToOne) {
   }
 }
 
+// Deterministic values in [-range, range) that are not vector-size aligned.
+std::vector<float> MakeSignedValues(size_t size, float range) {
+  std::vector<float> v(size);
+  for (size_t i = 0; i < size; ++i) {
+    v[i] = range * (static_cast<float>((i * 7919) % 1000) / 500.0f - 1.0f);
+  }
+  return v;
+}
+
+TEST(ReduceSum, InnerDimension) {
+  Shape src_shape = {3, 37};
+  Shape dst_shape = {3};
+  std::vector<float> src_buffer = MakeSignedValues(3 * 37, 10.0f);
+  std::vector<float> init_buffer = {1.0f};
+  std::vector<float> dst_buffer(GetShapeElementCount(dst_shape), 0.0f);
+
+  IREE_EXPECT_OK(ReduceSum::Execute<float>(src_buffer, init_buffer,
+                                           absl::MakeSpan(dst_buffer),
+                                           /*dimension=*/1, src_shape,
+                                           dst_shape));
+
+  for (int i = 0; i < 3; ++i) {
+    double expected = 1.0;
+    for (int j = 0; j < 37; ++j) expected += src_buffer[i * 37 + j];
+    EXPECT_NEAR(expected, dst_buffer[i], 1e-3);
+  }
+}
+
+TEST(ReduceMax, MiddleDimension) {
+  Shape src_shape = {2, 5, 13};
+  Shape dst_shape = {2, 13};
+  std::vector<float> src_buffer = MakeSignedValues(2 * 5 * 13, 10.0f);
+  std::vector<float> init_buffer = {std::numeric_limits<float>::lowest()};
+  std::vector<float> dst_buffer(GetShapeElementCount(dst_shape), 0.0f);
+
+  IREE_EXPECT_OK(ReduceMax::Execute<float>(src_buffer, init_buffer,
+                                           absl::MakeSpan(dst_buffer),
+                                           /*dimension=*/1, src_shape,
+                                           dst_shape));
+
+  for (int o = 0; o < 2; ++o) {
+    for (int i = 0; i < 13; ++i) {
+      float expected = std::numeric_limits<float>::lowest();
+      for (int r = 0; r < 5; ++r) {
+        expected = std::max(expected, src_buffer[(o * 5 + r) * 13 + i]);
+      }
+      EXPECT_EQ(expected, dst_buffer[o * 13 + i]);
+    }
+  }
+}
+
+TEST(ReduceMin, InnerDimensionInt) {
+  Shape src_shape = {2, 9};
+  Shape dst_shape = {2};
+  std::vector<int32_t> src_buffer = MakeIota<int32_t>(18);
+  std::vector<int32_t> init_buffer = {std::numeric_limits<int32_t>::max()};
+  std::vector<int32_t> dst_buffer(GetShapeElementCount(dst_shape), 0);
+  std::vector<int32_t> expected_dst = {1, 10};
+
+  IREE_EXPECT_OK(ReduceMin::Execute<int32_t>(src_buffer, init_buffer,
+                                             absl::MakeSpan(dst_buffer),
+                                             /*dimension=*/1, src_shape,
+                                             dst_shape));
+  EXPECT_EQ(dst_buffer, expected_dst);
+}
+
+// Float elementwise kernels may be vectorized; check them against the
+// standard library on sizes that exercise both the vector body and the tail.
+class ElementwiseFloatTest : public ::testing::TestWithParam<size_t> {};
+
+TEST_P(ElementwiseFloatTest, Binary) {
+  size_t size = GetParam();
+  std::vector<float> lhs = MakeSignedValues(size, 8.0f);
+  std::vector<float> rhs = MakeSignedValues(size + 3, 4.0f);
+  rhs.erase(rhs.begin(), rhs.begin() + 3);
+  for (auto& value : rhs) {
+    if (value == 0.0f) value = 0.5f;
+  }
+  std::vector<float> dst(size);
+  auto dst_span = absl::MakeSpan(dst);
+
+  IREE_ASSERT_OK(Add::Execute<float>(lhs, rhs, dst_span));
+  for (size_t i = 0; i < size; ++i) EXPECT_EQ(lhs[i] + rhs[i], dst[i]);
+  IREE_ASSERT_OK(Sub::Execute<float>(lhs, rhs, dst_span));
+  for (size_t i = 0; i < size; ++i) EXPECT_EQ(lhs[i] - rhs[i], dst[i]);
+  IREE_ASSERT_OK(Mul::Execute<float>(lhs, rhs, dst_span));
+  for (size_t i = 0; i < size; ++i) EXPECT_EQ(lhs[i] * rhs[i], dst[i]);
+  IREE_ASSERT_OK(Div::Execute<float>(lhs, rhs, dst_span));
+  for (size_t i = 0; i < size; ++i) EXPECT_EQ(lhs[i] / rhs[i], dst[i]);
+  IREE_ASSERT_OK(Min::Execute<float>(lhs, rhs, dst_span));
+  for (size_t i = 0; i < size; ++i) {
+    EXPECT_EQ(std::min(lhs[i], rhs[i]), dst[i]);
+  }
+  IREE_ASSERT_OK(Max::Execute<float>(lhs, rhs, dst_span));
+  for (size_t i = 0; i < size; ++i) {
+    EXPECT_EQ(std::max(lhs[i], rhs[i]), dst[i]);
+  }
+}
+
+TEST_P(ElementwiseFloatTest, Unary) {
+  size_t size = GetParam();
+  std::vector<float> src = MakeSignedValues(size, 20.0f);
+  std::vector<float> dst(size);
+  auto dst_span = absl::MakeSpan(dst);
+
+  IREE_ASSERT_OK(Abs::Execute<float>(src, dst_span));
+  for (size_t i = 0; i < size; ++i) EXPECT_EQ(std::abs(src[i]), dst[i]);
+  IREE_ASSERT_OK(Neg::Execute<float>(src, dst_span));
+  for (size_t i = 0; i < size; ++i) EXPECT_EQ(-src[i], dst[i]);
+  IREE_ASSERT_OK(Exp::Execute<float>(src, dst_span));
+  for (size_t i = 0; i < size; ++i) {
+    float expected = std::exp(src[i]);
+    EXPECT_NEAR(expected, dst[i], std::abs(expected) * 1e-6f) << src[i];
+  }
+  IREE_ASSERT_OK(Tanh::Execute<float>(src, dst_span));
+  for (size_t i = 0; i < size; ++i) {
+    EXPECT_NEAR(std::tanh(src[i]), dst[i], 1e-6f) << src[i];
+  }
+  for (auto& value : src) value = std::abs(value);
+  IREE_ASSERT_OK(Sqrt::Execute<float>(src, dst_span));
+  for (size_t i = 0; i < size; ++i) EXPECT_EQ(std::sqrt(src[i]), dst[i]);
+}
+
+INSTANTIATE_TEST_SUITE_P(Sizes, ElementwiseFloatTest,
+                         ::testing::Values(1, 3, 8, 17, 1029));
+
+// Exp must saturate like std::exp outside of the range its polynomial covers,
+// most notably for the -inf used to mask out softmax inputs.
+TEST(ElementwiseFloat, ExpSpecialValues) {
+  const float inf = std::numeric_limits<float>::infinity();
+  // Underflow to exactly 0 and overflow to +inf.
+  std::vector<float> src = {-inf, -1000.0f, -200.0f, -110.0f,
+                            inf,  1000.0f,  100.0f,  89.0f};
+  std::vector<float> expected_dst = {0.0f, 0.0f, 0.0f, 0.0f,
+                                     inf,  inf,  inf,  inf};
+  std::vector<float> dst(src.size());
+  IREE_ASSERT_OK(Exp::Execute<float>(src, absl::MakeSpan(dst)));
+  EXPECT_EQ(expected_dst, dst);
+
+  // Results that are denormal may be flushed to zero.
+  src = {-88.0f, -100.0f};
+  dst.resize(src.size());
+  IREE_ASSERT_OK(Exp::Execute<float>(src, absl::MakeSpan(dst)));
+  for (size_t i = 0; i < src.size(); ++i) {
+    EXPECT_GE(dst[i], 0.0f) << src[i];
+    EXPECT_LT(dst[i], std::numeric_limits<float>::min()) << src[i];
+  }
+
+  // Values just inside of the supported range and signed zeros.
+  src = {-87.0f, 88.0f, 0.0f, -0.0f};
+  dst.resize(src.size());
+  IREE_ASSERT_OK(Exp::Execute<float>(src, absl::MakeSpan(dst)));
+  for (size_t i = 0; i < src.size(); ++i) {
+    float expected = std::exp(src[i]);
+    EXPECT_NEAR(expected, dst[i], expected * 1e-6f) << src[i];
+  }
+
+  src = {std::numeric_limits<float>::quiet_NaN()};
+  dst.resize(src.size());
+  IREE_ASSERT_OK(Exp::Execute<float>(src, absl::MakeSpan(dst)));
+  EXPECT_TRUE(std::isnan(dst[0]));
+}
+
 TEST(PoolingMax, NoOverlapping) {
   Shape src_shape = {1, 4, 6, 1};
   Shape dst_shape = {1, 2, 2, 1};
@@ -504,10 +667,11 @@ TEST(Conv2d, NoDilation) {
   }
   std::vector<float> dst_buffer(GetShapeElementCount(dst_shape), 0.0f);
 
+  auto runtime_state = MatMul::CreateRuntimeState();
   IREE_EXPECT_OK(Conv2D::Execute<float>(
-      input_buffer, input_shape, filter_buffer, filter_shape,
-      absl::MakeSpan(dst_buffer), dst_shape, strides, pad_h, pad_w,
-      lhs_dilation, rhs_dilation, 1));
+      runtime_state.get(), input_buffer, input_shape, filter_buffer,
+      filter_shape, absl::MakeSpan(dst_buffer), dst_shape, strides, pad_h,
+      pad_w, lhs_dilation, rhs_dilation, 1));
 
   for (size_t i = 0; i < dst_buffer.size(); ++i) {
     EXPECT_NEAR(expected_dst[i], dst_buffer[i], kEpsilon);
@@ -537,16 +701,100 @@ TEST(Conv2d, DepthwiseConv) {
   }
   std::vector<float> dst_buffer(GetShapeElementCount(dst_shape), 0.0f);
 
+  auto runtime_state = MatMul::CreateRuntimeState();
   IREE_EXPECT_OK(Conv2D::Execute<float>(
-      input_buffer, input_shape, filter_buffer, filter_shape,
-      absl::MakeSpan(dst_buffer), dst_shape, strides, pad_h, pad_w,
-      lhs_dilation, rhs_dilation, 2));
+      runtime_state.get(), input_buffer, input_shape, filter_buffer,
+      filter_shape, absl::MakeSpan(dst_buffer), dst_shape, strides, pad_h,
+      pad_w, lhs_dilation, rhs_dilation, 2));
 
   for (size_t i = 0; i < dst_buffer.size(); ++i) {
     EXPECT_NEAR(expected_dst[i], dst_buffer[i], kEpsilon);
   }
 }
 
+struct Conv2DTestCase {
+  Shape input_shape;   // [H, W, C]
+  Shape filter_shape;  // [KH, KW, C, N / groups]
+  int32_t groups;
+  Shape strides;
+  Shape pad_h;
+  Shape pad_w;
+  Shape lhs_dilation;
+  Shape rhs_dilation;
+};
+
+// Checks the GEMM-based lowering against the direct reference convolution.
+TEST(Conv2d, MatchesReference) {
+  const Conv2DTestCase test_cases[] = {
+      // Pointwise (1x1) convolution.
+      {{5, 7, 8}, {1, 1, 8, 6}, 1, {1, 1}, {0, 0}, {0, 0}, {1, 1}, {1, 1}},
+      // Padded 3x3.
+      {{6, 5, 3}, {3, 3, 3, 4}, 1, {1, 1}, {1, 1}, {1, 1}, {1, 1}, {1, 1}},
+      // Strided with asymmetric padding.
+      {{9, 8, 4}, {3, 2, 4, 5}, 1, {2, 3}, {1, 0}, {0, 1}, {1, 1}, {1, 1}},
+      // Strided 1x1 (not eligible for the pointwise path).
+      {{6, 6, 4}, {1, 1, 4, 3}, 1, {2, 2}, {0, 0}, {0, 0}, {1, 1}, {1, 1}},
+      // Dilated kernel.
+      {{9, 9, 2}, {3, 3, 2, 3}, 1, {1, 1}, {2, 2}, {2, 2}, {1, 1}, {2, 2}},
+      // Dilated input (as in transposed convolutions).
+      {{4, 5, 2}, {3, 3, 2, 2}, 1, {1, 1}, {2, 2}, {2, 2}, {2, 2}, {1, 1}},
+      // Grouped.
+      {{6, 7, 6}, {3, 3, 6, 2}, 3, {1, 1}, {1, 1}, {1, 1}, {1, 1}, {1, 1}},
+      // Depthwise.
+      {{7, 6, 5}, {3, 3, 5, 1}, 5, {1, 1}, {1, 1}, {1, 1}, {1, 1}, {1, 1}},
+      // Depthwise with a channel multiplier and stride.
+      {{8, 8, 3}, {3, 3, 3, 2}, 3, {2, 2}, {1, 1}, {1, 1}, {1, 1}, {1, 1}},
+  };
+  auto runtime_state = MatMul::CreateRuntimeState();
+  for (const auto& test_case : test_cases) {
+    auto output_size = [&](int dim, const Shape& pad) {
+      int32_t input_size =
+          (test_case.input_shape[dim] - 1) * test_case.lhs_dilation[dim] + 1;
+      int32_t kernel_size =
+          (test_case.filter_shape[dim] - 1) * test_case.rhs_dilation[dim] + 1;
+      return (input_size + pad[0] + pad[1] - kernel_size) /
+                 test_case.strides[dim] +
+             1;
+    };
+    Shape dst_shape = {output_size(0, test_case.pad_h),
+                       output_size(1, test_case.pad_w),
+                       test_case.filter_shape[3] * test_case.groups};
+    Shape filter_shape = test_case.filter_shape;
+    filter_shape[2] = test_case.input_shape[2];
+
+    std::vector<float> input_buffer(
+        GetShapeElementCount(test_case.input_shape));
+    for (size_t i = 0; i < input_buffer.size(); ++i) {
+      input_buffer[i] = static_cast<float>((i * 7) % 11) - 5.0f;
+    }
+    std::vector<float> filter_buffer(GetShapeElementCount(filter_shape));
+    for (size_t i = 0; i < filter_buffer.size(); ++i) {
+      filter_buffer[i] = static_cast<float>((i * 5) % 7) - 3.0f;
+    }
+    // Results are accumulated into the existing destination contents.
+    std::vector<float> expected_dst(GetShapeElementCount(dst_shape), 1.0f);
+    std::vector<float> dst_buffer(expected_dst);
+
+    IREE_EXPECT_OK(Conv2D::ExecuteReference<float>(
+        input_buffer, test_case.input_shape, filter_buffer, filter_shape,
+        absl::MakeSpan(expected_dst), dst_shape, test_case.strides,
+        test_case.pad_h, test_case.pad_w, test_case.lhs_dilation,
+        test_case.rhs_dilation, test_case.groups));
+    IREE_EXPECT_OK(Conv2D::Execute<float>(
+        runtime_state.get(), input_buffer, test_case.input_shape,
+        filter_buffer, filter_shape, absl::MakeSpan(dst_buffer), dst_shape,
+        test_case.strides, test_case.pad_h, test_case.pad_w,
+        test_case.lhs_dilation, test_case.rhs_dilation, test_case.groups));
+
+    for (size_t i = 0; i < dst_buffer.size(); ++i) {
+      EXPECT_NEAR(expected_dst[i], dst_buffer[i], kEpsilon)
+          << "element " << i << " of " << dst_shape[0] << "x" << dst_shape[1]
+          << "x" << dst_shape[2] << " output (groups=" << test_case.groups
+          << ")";
+    }
+  }
+}
+
 TEST(Transpose, 2Dimen) {
   Shape src_shape = {2, 3};
   Shape dst_shape = {3, 2};
@@ -759,8 +759,9 @@ class VMLAModuleState final {
       auto output_example =
           absl::MakeSpan(raw_dst_data + i * output_stride, output_stride);
       IREE_RETURN_IF_ERROR(kernels::Conv2D::Execute(
-          input_example, input_example_shape, filter_buffer, filter_shape_4d,
-          output_example, output_example_shape, window_strides_2d, pad_h, pad_w,
+          kernel_state_->mat_mul_state.get(), input_example,
+          input_example_shape, filter_buffer, filter_shape_4d, output_example,
+          output_example_shape, window_strides_2d, pad_h, pad_w,
           lhs_dilation.subspan(0, 2), rhs_dilation.subspan(0, 2),
           feature_group_count));
     }
@@ -19,12 +19,87 @@
 #include "iree/task/executor_impl.h"
 #include "iree/task/task_impl.h"
 
+#if defined(IREE_PLATFORM_LINUX)
+#include <errno.h>
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if defined(SYS_mbind)
+#define IREE_TASK_EXECUTOR_HAVE_NUMA_WORKER_STORAGE 1
+#endif  // SYS_mbind
+#endif  // IREE_PLATFORM_LINUX
+
 static void iree_task_executor_destroy(iree_task_executor_t* executor);
 
+#if defined(IREE_TASK_EXECUTOR_HAVE_NUMA_WORKER_STORAGE)
+
+// Allocates page-aligned storage for the workers defined by |topology| with
+// the pages backing each worker preferring the NUMA node of that worker. The
+// worker state (and in particular the local task queue) is hammered by the
+// worker thread and having it live on a remote node would make every
+// push/pop cross the interconnect.
+//
+// Groups within a node are contiguous in topologies produced by
+// iree_task_topology_initialize_from_numa_nodes and so only the pages that
+// straddle two nodes are left to the default (first-touch) policy.
+static iree_status_t iree_task_executor_allocate_numa_workers(
+    const iree_task_topology_t* topology, iree_host_size_t* out_storage_size,
+    iree_task_worker_t** out_workers) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_host_size_t page_size = (iree_host_size_t)sysconf(_SC_PAGESIZE);
+  iree_host_size_t worker_count = iree_task_topology_group_count(topology);
+  iree_host_size_t storage_size =
+      iree_math_align(worker_count * sizeof(iree_task_worker_t), page_size);
+  uint8_t* storage = (uint8_t*)mmap(NULL, storage_size, PROT_READ | PROT_WRITE,
+                                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (storage == MAP_FAILED) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to map %zu bytes of worker storage",
+                            storage_size);
+  }
+
+  for (iree_host_size_t run_start = 0; run_start < worker_count;) {
+    uint32_t node_id = topology->groups[run_start].numa_node_id;
+    iree_host_size_t run_end = run_start + 1;
+    while (run_end < worker_count &&
+           topology->groups[run_end].numa_node_id == node_id) {
+      ++run_end;
+    }
+    uintptr_t range_start = iree_math_align(
+        (uintptr_t)storage + run_start * sizeof(iree_task_worker_t), page_size);
+    uintptr_t range_end =
+        ((uintptr_t)storage + run_end * sizeof(iree_task_worker_t)) &
+        ~(page_size - 1);
+    if (run_end == worker_count) range_end = (uintptr_t)storage + storage_size;
+    if (range_end > range_start && node_id < 8 * sizeof(unsigned long)) {
+      // NOTE: this is only a placement hint; if the policy cannot be applied
+      // (sandboxed, node offline, etc) we just end up with default placement.
+      unsigned long node_mask = 1ul << node_id;
+      syscall(SYS_mbind, (void*)range_start, range_end - range_start,
+              MPOL_PREFERRED, &node_mask, 8 * sizeof(node_mask) + 1, 0);
+    }
+    run_start = run_end;
+  }
+
+  *out_storage_size = storage_size;
+  *out_workers = (iree_task_worker_t*)storage;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static void iree_task_executor_free_numa_workers(
+    iree_host_size_t storage_size, iree_task_worker_t* workers) {
+  munmap(workers, storage_size);
+}
+
+#endif  // IREE_TASK_EXECUTOR_HAVE_NUMA_WORKER_STORAGE
+
 iree_status_t iree_task_executor_create(
     iree_task_scheduling_mode_t scheduling_mode,
-    const iree_task_topology_t* topology, iree_allocator_t allocator,
-    iree_task_executor_t** out_executor) {
+    const iree_task_topology_t* topology, iree_duration_t worker_spin_ns,
+    iree_allocator_t allocator, iree_task_executor_t** out_executor) {
   iree_host_size_t worker_count = iree_task_topology_group_count(topology);
   if (worker_count > IREE_TASK_EXECUTOR_MAX_WORKER_COUNT) {
     return iree_make_status(
@@ -45,8 +120,18 @@ iree_status_t iree_task_executor_create(
   IREE_ASSERT_ARGUMENT(out_executor);
   *out_executor = NULL;
 
-  iree_host_size_t executor_size =
-      sizeof(iree_task_executor_t) + worker_count * sizeof(iree_task_worker_t);
+  // When the workers span multiple NUMA nodes their state is allocated
+  // separately such that it can be placed on their nodes. Otherwise it lives
+  // inline with the executor.
+  bool use_numa_worker_storage = false;
+#if defined(IREE_TASK_EXECUTOR_HAVE_NUMA_WORKER_STORAGE)
+  use_numa_worker_storage = iree_task_topology_is_numa(topology);
+#endif  // IREE_TASK_EXECUTOR_HAVE_NUMA_WORKER_STORAGE
+
+  iree_host_size_t executor_size = sizeof(iree_task_executor_t);
+  if (!use_numa_worker_storage) {
+    executor_size += worker_count * sizeof(iree_task_worker_t);
+  }
 
   iree_task_executor_t* executor = NULL;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
@@ -55,6 +140,7 @@ iree_status_t iree_task_executor_create(
   iree_atomic_ref_count_init(&executor->ref_count);
   executor->allocator = allocator;
   executor->scheduling_mode = scheduling_mode;
+  executor->worker_spin_ns = iree_max(IREE_DURATION_ZERO, worker_spin_ns);
   iree_atomic_task_slist_initialize(&executor->incoming_ready_slist);
   iree_atomic_task_slist_initialize(&executor->incoming_waiting_slist);
   iree_slim_mutex_initialize(&executor->coordinator_mutex);
@@ -100,11 +186,21 @@ iree_status_t iree_task_executor_create(
         &executor->dispatch_task_pool);
   }
 
+  if (iree_status_is_ok(status)) {
+    if (use_numa_worker_storage) {
+#if defined(IREE_TASK_EXECUTOR_HAVE_NUMA_WORKER_STORAGE)
+      status = iree_task_executor_allocate_numa_workers(
+          topology, &executor->numa_worker_storage_size, &executor->workers);
+#endif  // IREE_TASK_EXECUTOR_HAVE_NUMA_WORKER_STORAGE
+    } else {
+      executor->workers = (iree_task_worker_t*)(executor + 1);
+    }
+  }
+
   // Bring up the workers; the threads will be created here but be suspended
   // (if the platform supports it) awaiting the first tasks getting scheduled.
   if (iree_status_is_ok(status)) {
     executor->worker_count = worker_count;
-    executor->workers = (iree_task_worker_t*)(executor + 1);
     iree_task_affinity_set_t worker_idle_mask = 0;
     iree_task_affinity_set_t worker_live_mask = 0;
     iree_task_affinity_set_t worker_suspend_mask = 0;
@@ -165,6 +261,12 @@ static void iree_task_executor_destroy(iree_task_executor_t* executor) {
     iree_task_worker_t* worker = &executor->workers[i];
     iree_task_worker_deinitialize(worker);
   }
+#if defined(IREE_TASK_EXECUTOR_HAVE_NUMA_WORKER_STORAGE)
+  if (executor->numa_worker_storage_size) {
+    iree_task_executor_free_numa_workers(executor->numa_worker_storage_size,
+                                         executor->workers);
+  }
+#endif  // IREE_TASK_EXECUTOR_HAVE_NUMA_WORKER_STORAGE
 
   iree_wait_set_free(executor->wait_set);
   iree_slim_mutex_deinitialize(&executor->wait_mutex);
@@ -538,6 +640,18 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
   iree_slim_mutex_lock(&executor->coordinator_mutex);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Workers have their dispatch task pool cache bound while they pump. Other
+  // threads (such as those submitting work) get a temporary cache such that
+  // issuing a dispatch takes a chunk of tasks from the pool at a time instead
+  // of hitting the shared pool for every slice/shard.
+  iree_task_pool_cache_t caller_cache;
+  iree_task_pool_cache_t* previous_cache = NULL;
+  if (!current_worker) {
+    iree_task_pool_cache_initialize(&executor->dispatch_task_pool,
+                                    &caller_cache);
+    previous_cache = iree_task_pool_cache_bind(&caller_cache);
+  }
+
   // We may be adding tasks/waiting/etc on each pass through coordination - to
   // ensure we completely drain the incoming queues and satisfied waits we loop
   // until there's nothing left to coordinate.
@@ -620,6 +734,11 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
     }
   } while (schedule_dirty);
 
+  if (!current_worker) {
+    iree_task_pool_cache_bind(previous_cache);
+    iree_task_pool_cache_deinitialize(&caller_cache);
+  }
+
   iree_slim_mutex_unlock(&executor->coordinator_mutex);
   IREE_TRACE_ZONE_END(z0);
 }
@@ -677,7 +796,9 @@ static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
 // We do a scan through ideal victims indicated by the
 // |constructive_sharing_mask|; these are the workers most likely to have some
 // cache benefits to taking their work as they share some level of the cache
-// hierarchy and should be better to steal from than any random worker.
+// hierarchy and should be better to steal from than any random worker. If none
+// of those have work we try the rest of the workers within our NUMA node
+// (|numa_node_mask|) before finally crossing over to other nodes.
 //
 // To prevent biasing any particular victim we use a fast prng function to
 // select where in the set of potential victims defined by the topology
@@ -687,7 +808,8 @@ static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
 iree_task_t* iree_task_executor_try_steal_task(
     iree_task_executor_t* executor,
     iree_task_affinity_set_t constructive_sharing_mask,
-    uint32_t max_theft_attempts, iree_prng_minilcg128_state_t* theft_prng,
+    iree_task_affinity_set_t numa_node_mask, uint32_t max_theft_attempts,
+    iree_prng_minilcg128_state_t* theft_prng,
     iree_task_queue_t* local_task_queue) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
@@ -717,11 +839,23 @@ iree_task_t* iree_task_executor_try_steal_task(
   if (task) {
     IREE_TRACE_ZONE_APPEND_TEXT(z0, "local");
   } else {
+    // Try the remaining workers within our NUMA node. Tasks and the memory
+    // they touch are likely to have been produced on the node they were
+    // posted to and stealing across nodes has to pull all of that across the
+    // interconnect.
+    victim_mask &= ~constructive_sharing_mask;
     task = iree_task_executor_try_steal_task_from_affinity_set(
-        executor, victim_mask & ~constructive_sharing_mask, max_theft_attempts,
+        executor, victim_mask & numa_node_mask, max_theft_attempts,
         rotation_offset, local_task_queue);
     if (task) {
       IREE_TRACE_ZONE_APPEND_TEXT(z0, "non-local");
+    } else {
+      task = iree_task_executor_try_steal_task_from_affinity_set(
+          executor, victim_mask & ~numa_node_mask, max_theft_attempts,
+          rotation_offset, local_task_queue);
+      if (task) {
+        IREE_TRACE_ZONE_APPEND_TEXT(z0, "remote-node");
+      }
     }
   }
 
@@ -307,11 +307,15 @@ typedef struct iree_task_executor_s iree_task_executor_t;
 
 // Creates a task executor using the specified topology.
 // |topology| is only used during creation and need not live beyond this call.
+// |worker_spin_ns| is the duration workers spin looking for new work after
+// running out before parking in the kernel; IREE_DURATION_ZERO parks
+// immediately and topology groups may override it (see
+// iree_task_topology_group_t::worker_spin_ns).
 // |out_executor| must be released by the caller.
 iree_status_t iree_task_executor_create(
     iree_task_scheduling_mode_t scheduling_mode,
-    const iree_task_topology_t* topology, iree_allocator_t allocator,
-    iree_task_executor_t** out_executor);
+    const iree_task_topology_t* topology, iree_duration_t worker_spin_ns,
+    iree_allocator_t allocator, iree_task_executor_t** out_executor);
 
 // Retains the given |executor| for the caller.
 void iree_task_executor_retain(iree_task_executor_t* executor);
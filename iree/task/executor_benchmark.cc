@@ -0,0 +1,501 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "iree/base/api.h"
+#include "iree/base/logging.h"
+#include "iree/task/executor.h"
+#include "iree/task/pool.h"
+#include "iree/task/queue.h"
+#include "iree/task/scope.h"
+#include "iree/task/task.h"
+#include "iree/task/topology.h"
+
+namespace {
+
+//==============================================================================
+// Executor utilities
+//==============================================================================
+
+// Executor and scope used for the duration of a single benchmark run.
+// Workers are created up-front so that thread startup is not measured.
+class ExecutorState {
+ public:
+  explicit ExecutorState(iree_host_size_t worker_count,
+                         iree_duration_t worker_spin_ns =
+                             IREE_TASK_EXECUTOR_DEFAULT_WORKER_SPIN_NS) {
+    iree_task_topology_t topology;
+    iree_task_topology_initialize_from_group_count(worker_count, &topology);
+    IREE_CHECK_OK(iree_task_executor_create(
+        IREE_TASK_SCHEDULING_MODE_RESERVED, &topology, worker_spin_ns,
+        iree_allocator_system(), &executor_));
+    iree_task_topology_deinitialize(&topology);
+    iree_task_scope_initialize(iree_make_cstring_view("benchmark"), &scope_);
+  }
+
+  ~ExecutorState() {
+    iree_task_scope_deinitialize(&scope_);
+    iree_task_executor_release(executor_);
+  }
+
+  iree_task_executor_t* executor() { return executor_; }
+  iree_task_scope_t* scope() { return &scope_; }
+
+  // Submits |submission| with a fence joining |tail_tasks| and waits for the
+  // scope to go idle.
+  void SubmitAndWaitIdle(iree_task_submission_t* submission,
+                         iree_task_t* const* tail_tasks,
+                         iree_host_size_t tail_task_count) {
+    iree_task_fence_t* fence = NULL;
+    IREE_CHECK_OK(iree_task_executor_acquire_fence(executor_, &scope_, &fence));
+    for (iree_host_size_t i = 0; i < tail_task_count; ++i) {
+      iree_task_set_completion_task(tail_tasks[i], &fence->header);
+    }
+    iree_task_executor_submit(executor_, submission);
+    iree_task_executor_flush(executor_);
+    IREE_CHECK_OK(
+        iree_task_scope_wait_idle(&scope_, IREE_TIME_INFINITE_FUTURE));
+  }
+
+ private:
+  iree_task_executor_t* executor_ = NULL;
+  iree_task_scope_t scope_;
+};
+
+//==============================================================================
+// Nop-heavy task graphs
+//==============================================================================
+
+static iree_status_t NopCall(uintptr_t user_context, iree_task_t* task,
+                             iree_task_submission_t* pending_submission) {
+  return iree_ok_status();
+}
+
+// A wide fan-out of trivial call tasks. Each call is routed to a worker
+// through the coordinator and the cost is dominated by posting, queuing, and
+// stealing overhead.
+void BM_NopCallFanout(benchmark::State& state) {
+  ExecutorState executor_state(state.range(0));
+  const iree_host_size_t task_count = state.range(1);
+  std::vector<iree_task_call_t> calls(task_count);
+  std::vector<iree_task_t*> tail_tasks(task_count);
+  for (auto _ : state) {
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    for (iree_host_size_t i = 0; i < task_count; ++i) {
+      iree_task_call_initialize(executor_state.scope(),
+                                iree_task_make_call_closure(NopCall, 0),
+                                &calls[i]);
+      tail_tasks[i] = &calls[i].header;
+      iree_task_submission_enqueue(&submission, &calls[i].header);
+    }
+    executor_state.SubmitAndWaitIdle(&submission, tail_tasks.data(),
+                                     tail_tasks.size());
+  }
+  state.SetItemsProcessed(state.iterations() * task_count);
+}
+BENCHMARK(BM_NopCallFanout)
+    ->ArgNames({"workers", "tasks"})
+    ->ArgsProduct({{1, 4, 16, 32}, {64, 1024}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+//==============================================================================
+// Dispatch-heavy task graphs
+//==============================================================================
+
+static iree_status_t NopTile(uintptr_t user_context,
+                             const iree_task_tile_context_t* tile_context,
+                             iree_task_submission_t* pending_submission) {
+  benchmark::DoNotOptimize(tile_context->workgroup_xyz[0]);
+  return iree_ok_status();
+}
+
+// Reports the dispatch statistics accumulated in |scope| as per-dispatch
+// benchmark counters.
+static void ReportDispatchStatistics(benchmark::State& state,
+                                     iree_task_scope_t* scope,
+                                     int64_t dispatch_count) {
+  iree_task_dispatch_statistics_t statistics =
+      iree_task_scope_consume_statistics(scope);
+  auto load = [](iree_atomic_int64_t* value) {
+    return (double)iree_atomic_load_int64(value, iree_memory_order_relaxed);
+  };
+  double shard_count = load(&statistics.shard_count);
+  double shard_duration_ns = load(&statistics.shard_duration_ns);
+  state.counters["shards"] = shard_count / dispatch_count;
+  state.counters["stolen"] =
+      shard_count ? load(&statistics.stolen_shard_count) / shard_count : 0.0;
+  state.counters["idle"] =
+      shard_count ? load(&statistics.idle_shard_count) / shard_count : 0.0;
+  state.counters["wakes"] =
+      load(&statistics.worker_wake_count) / dispatch_count;
+  state.counters["sched"] =
+      shard_duration_ns
+          ? 1.0 - load(&statistics.tile_duration_ns) / shard_duration_ns
+          : 0.0;
+}
+
+// A sequence of dispatches with many tiny tiles. Sliced dispatches produce one
+// task per slice that gets spread over the worker queues and stolen as workers
+// run dry.
+//
+// The dispatch statistics are reported as counters: slices/shards and worker
+// wakes per dispatch, the fraction of slices/shards that were stolen or found
+// no work, and the fraction of slice/shard time spent outside of tiles. The
+// durations are only collected in builds with
+// -DIREE_TASK_DISPATCH_STATISTICS_TIMING=1.
+void DispatchSequence(benchmark::State& state, iree_task_flags_t flags,
+                      iree_task_dispatch_closure_t closure) {
+  ExecutorState executor_state(state.range(0));
+  const uint32_t tile_count = (uint32_t)state.range(1);
+  const iree_host_size_t dispatch_count = 16;
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {tile_count, 1, 1};
+  std::vector<iree_task_dispatch_t> dispatches(dispatch_count);
+  for (auto _ : state) {
+    for (iree_host_size_t i = 0; i < dispatch_count; ++i) {
+      iree_task_dispatch_initialize(executor_state.scope(), closure,
+                                    workgroup_size, workgroup_count,
+                                    &dispatches[i]);
+      dispatches[i].header.flags |= flags;
+      if (i > 0) {
+        iree_task_set_completion_task(&dispatches[i - 1].header,
+                                      &dispatches[i].header);
+      }
+    }
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    iree_task_submission_enqueue(&submission, &dispatches[0].header);
+    iree_task_t* tail_task = &dispatches.back().header;
+    executor_state.SubmitAndWaitIdle(&submission, &tail_task, 1);
+  }
+  state.SetItemsProcessed(state.iterations() * dispatch_count * tile_count);
+  ReportDispatchStatistics(state, executor_state.scope(),
+                           state.iterations() * dispatch_count);
+}
+
+void BM_DispatchSliced(benchmark::State& state) {
+  DispatchSequence(state, IREE_TASK_FLAG_DISPATCH_SLICED,
+                   iree_task_make_dispatch_closure(NopTile, 0));
+}
+BENCHMARK(BM_DispatchSliced)
+    ->ArgNames({"workers", "tiles"})
+    ->ArgsProduct({{1, 4, 16, 32}, {256, 8192}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_DispatchSharded(benchmark::State& state) {
+  DispatchSequence(state, 0, iree_task_make_dispatch_closure(NopTile, 0));
+}
+BENCHMARK(BM_DispatchSharded)
+    ->ArgNames({"workers", "tiles"})
+    ->ArgsProduct({{1, 4, 16, 32}, {256, 8192}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+//==============================================================================
+// Adaptive dispatch tiling
+//==============================================================================
+
+// Spins for |user_context| iterations to simulate a tile of a given cost.
+static iree_status_t SpinTile(uintptr_t user_context,
+                              const iree_task_tile_context_t* tile_context,
+                              iree_task_submission_t* pending_submission) {
+  uint64_t value = tile_context->workgroup_xyz[0];
+  for (uintptr_t i = 0; i < user_context; ++i) {
+    value = value * 6364136223846793005ull + 1442695040888963407ull;
+  }
+  benchmark::DoNotOptimize(value);
+  return iree_ok_status();
+}
+
+// Repeatedly issues the same dispatch either with the fixed tiling parameters
+// from tuning.h or with an iree_task_dispatch_profile_t such that tiling adapts
+// to the measured tile cost. Grids range from many cheap tiles to a handful of
+// expensive ones with roughly the same total work.
+void ProfiledDispatch(benchmark::State& state, iree_task_flags_t flags) {
+  ExecutorState executor_state(state.range(0));
+  const uint32_t tile_count = (uint32_t)state.range(1);
+  const uintptr_t tile_cost = (uintptr_t)state.range(2);
+  const bool adaptive = state.range(3) != 0;
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {tile_count, 1, 1};
+  iree_task_dispatch_profile_t profile;
+  iree_task_dispatch_profile_initialize(&profile);
+  for (auto _ : state) {
+    iree_task_dispatch_t dispatch;
+    iree_task_dispatch_initialize(
+        executor_state.scope(),
+        iree_task_make_dispatch_closure(SpinTile, tile_cost), workgroup_size,
+        workgroup_count, &dispatch);
+    dispatch.header.flags |= flags;
+    dispatch.profile = adaptive ? &profile : NULL;
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    iree_task_submission_enqueue(&submission, &dispatch.header);
+    iree_task_t* tail_task = &dispatch.header;
+    executor_state.SubmitAndWaitIdle(&submission, &tail_task, 1);
+  }
+  state.counters["tile_ns"] =
+      (double)iree_task_dispatch_profile_tile_duration(&profile);
+  state.SetItemsProcessed(state.iterations() * tile_count);
+}
+
+static void ProfiledDispatchArgs(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"workers", "tiles", "cost", "adaptive"});
+  for (int64_t worker_count : {1, 2, 4, 8, 16, 32}) {
+    for (auto grid : {std::make_pair(16384, 16), std::make_pair(256, 1024),
+                      std::make_pair(4, 65536)}) {
+      for (int64_t adaptive : {0, 1}) {
+        benchmark->Args({worker_count, grid.first, grid.second, adaptive});
+      }
+    }
+  }
+}
+
+void BM_ProfiledDispatchSharded(benchmark::State& state) {
+  ProfiledDispatch(state, 0);
+}
+BENCHMARK(BM_ProfiledDispatchSharded)
+    ->Apply(ProfiledDispatchArgs)
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_ProfiledDispatchSliced(benchmark::State& state) {
+  ProfiledDispatch(state, IREE_TASK_FLAG_DISPATCH_SLICED);
+}
+BENCHMARK(BM_ProfiledDispatchSliced)
+    ->Apply(ProfiledDispatchArgs)
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+//==============================================================================
+// Dispatch statistics overhead
+//==============================================================================
+
+// The dispatch sequences above with tiles of a given cost. The empty tiles
+// above bound the overhead of the dispatch statistics from above; this
+// measures it for tiles doing a small amount of work. Compare a default build
+// with one using -DIREE_TASK_DISPATCH_STATISTICS_TIMING=1 (or one without the
+// statistics) to measure the cost of the clock reads (or of the counters).
+void BM_DispatchStatisticsOverhead(benchmark::State& state) {
+  DispatchSequence(state, state.range(2) ? IREE_TASK_FLAG_DISPATCH_SLICED : 0,
+                   iree_task_make_dispatch_closure(
+                       SpinTile, (uintptr_t)state.range(3)));
+}
+BENCHMARK(BM_DispatchStatisticsOverhead)
+    ->ArgNames({"workers", "tiles", "sliced", "cost"})
+    ->ArgsProduct({{1, 4}, {8192}, {0, 1}, {0, 16, 64}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+//==============================================================================
+// Worker wake latency
+//==============================================================================
+
+// Records the time the first tile of the dispatch began executing into the
+// std::atomic<iree_time_t> passed as |user_context|.
+static iree_status_t FirstTileTimeTile(
+    uintptr_t user_context, const iree_task_tile_context_t* tile_context,
+    iree_task_submission_t* pending_submission) {
+  auto* first_tile_time = (std::atomic<iree_time_t>*)user_context;
+  iree_time_t expected_time = 0;
+  first_tile_time->compare_exchange_strong(expected_time, iree_time_now(),
+                                           std::memory_order_relaxed);
+  return iree_ok_status();
+}
+
+// Measures the latency from submitting a dispatch to its first tile running
+// when the submitter does |gap_us| of its own work between dispatches (as a
+// host program interleaving tiny dispatches with other logic would). With
+// spinning disabled the workers park as soon as they run dry and every
+// dispatch pays for a kernel wake; with spinning enabled gaps shorter than the
+// spin duration find the workers still awake.
+void BM_SubmitToFirstTile(benchmark::State& state) {
+  const iree_host_size_t worker_count = state.range(0);
+  const bool spin = state.range(1) != 0;
+  const iree_duration_t gap_ns = state.range(2) * 1000;
+  ExecutorState executor_state(
+      worker_count,
+      spin ? IREE_TASK_EXECUTOR_DEFAULT_WORKER_SPIN_NS : IREE_DURATION_ZERO);
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {(uint32_t)worker_count, 1, 1};
+  std::atomic<iree_time_t> first_tile_time = {0};
+  for (auto _ : state) {
+    iree_time_t gap_deadline_ns = iree_time_now() + gap_ns;
+    while (iree_time_now() < gap_deadline_ns) {
+      // Busy host work; the submitter isn't waiting on the executor here.
+    }
+
+    first_tile_time = 0;
+    iree_task_dispatch_t dispatch;
+    iree_task_dispatch_initialize(
+        executor_state.scope(),
+        iree_task_make_dispatch_closure(FirstTileTimeTile,
+                                        (uintptr_t)&first_tile_time),
+        workgroup_size, workgroup_count, &dispatch);
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    iree_task_submission_enqueue(&submission, &dispatch.header);
+    iree_task_t* tail_task = &dispatch.header;
+    iree_time_t submit_time = iree_time_now();
+    executor_state.SubmitAndWaitIdle(&submission, &tail_task, 1);
+    state.SetIterationTime((first_tile_time - submit_time) / 1e9);
+  }
+}
+BENCHMARK(BM_SubmitToFirstTile)
+    ->ArgNames({"workers", "spin", "gap_us"})
+    ->ArgsProduct({{1, 4, 16}, {0, 1}, {10, 1000}})
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond);
+
+//==============================================================================
+// iree_task_pool_t
+//==============================================================================
+
+// Many threads acquiring and releasing small batches of tasks from one shared
+// pool, as workers issuing and retiring dispatch shards do. With caching each
+// thread binds an iree_task_pool_cache_t and only touches the shared pool to
+// move chunks of tasks while without it every acquire and release does.
+void BM_PoolAcquireRelease(benchmark::State& state) {
+  static iree_task_pool_t* pool = ([]() -> iree_task_pool_t* {
+    auto* pool = new iree_task_pool_t();
+    IREE_CHECK_OK(iree_task_pool_initialize(
+        iree_allocator_system(), sizeof(iree_task_dispatch_shard_t),
+        /*initial_capacity=*/0, pool));
+    return pool;
+  })();
+  const bool cached = state.range(0) != 0;
+  const int batch_size = 16;
+  iree_task_pool_cache_t cache;
+  if (cached) {
+    iree_task_pool_cache_initialize(pool, &cache);
+    iree_task_pool_cache_bind(&cache);
+  }
+  iree_task_t* tasks[batch_size];
+  for (auto _ : state) {
+    for (int i = 0; i < batch_size; ++i) {
+      IREE_CHECK_OK(iree_task_pool_acquire(pool, &tasks[i]));
+      tasks[i]->pool = pool;
+      benchmark::DoNotOptimize(tasks[i]);
+    }
+    for (int i = 0; i < batch_size; ++i) {
+      iree_task_pool_release(pool, tasks[i]);
+    }
+  }
+  if (cached) {
+    iree_task_pool_cache_bind(NULL);
+    iree_task_pool_cache_deinitialize(&cache);
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+BENCHMARK(BM_PoolAcquireRelease)
+    ->ArgName("cached")
+    ->Arg(0)
+    ->Arg(1)
+    ->UseRealTime()
+    ->Threads(1)
+    ->Threads(8)
+    ->Threads(64);
+
+//==============================================================================
+// iree_task_queue_t
+//==============================================================================
+
+// Owner-only push/pop cost with no thieves present; this is the path taken by
+// every task a worker executes.
+void BM_QueueAppendPop(benchmark::State& state) {
+  const int task_count = (int)state.range(0);
+  std::vector<iree_task_t> tasks(task_count);
+  iree_task_queue_t queue;
+  iree_task_queue_initialize(&queue);
+  for (auto _ : state) {
+    iree_task_list_t list;
+    iree_task_list_initialize(&list);
+    for (int i = 0; i < task_count; ++i) {
+      iree_task_list_push_front(&list, &tasks[i]);
+    }
+    iree_task_queue_append_from_lifo_list_unsafe(&queue, &list);
+    while (iree_task_t* task = iree_task_queue_pop_front(&queue)) {
+      benchmark::DoNotOptimize(task);
+    }
+  }
+  iree_task_queue_deinitialize(&queue);
+  state.SetItemsProcessed(state.iterations() * task_count);
+}
+BENCHMARK(BM_QueueAppendPop)->Arg(8)->Arg(64)->Arg(256);
+
+// The owner drains its queue while thieves continuously try to steal from it.
+// Measures owner throughput under steal contention.
+void BM_QueuePopUnderTheft(benchmark::State& state) {
+  const int thief_count = (int)state.range(0);
+  const int task_count = 256;
+  std::vector<iree_task_t> tasks(task_count);
+  iree_task_queue_t queue;
+  iree_task_queue_initialize(&queue);
+
+  std::atomic<bool> done = {false};
+  std::atomic<int64_t> stolen_count = {0};
+  std::vector<std::thread> thieves;
+  for (int i = 0; i < thief_count; ++i) {
+    thieves.emplace_back([&]() {
+      iree_task_queue_t target_queue;
+      iree_task_queue_initialize(&target_queue);
+      while (!done.load(std::memory_order_relaxed)) {
+        iree_task_t* task = iree_task_queue_try_steal(&queue, &target_queue, 4);
+        while (task) {
+          benchmark::DoNotOptimize(task);
+          stolen_count.fetch_add(1, std::memory_order_release);
+          task = iree_task_queue_pop_front(&target_queue);
+        }
+      }
+      iree_task_queue_deinitialize(&target_queue);
+    });
+  }
+
+  int64_t popped_count = 0;
+  int64_t total_count = 0;
+  for (auto _ : state) {
+    iree_task_list_t list;
+    iree_task_list_initialize(&list);
+    for (int i = 0; i < task_count; ++i) {
+      iree_task_list_push_front(&list, &tasks[i]);
+    }
+    iree_task_queue_append_from_lifo_list_unsafe(&queue, &list);
+    while (iree_task_t* task = iree_task_queue_pop_front(&queue)) {
+      benchmark::DoNotOptimize(task);
+      ++popped_count;
+    }
+    // Wait for thieves to finish with any tasks they took before reusing them.
+    // The queue is empty so nothing new can be stolen.
+    total_count += task_count;
+    while (popped_count + stolen_count.load(std::memory_order_acquire) <
+           total_count) {
+      std::this_thread::yield();
+    }
+  }
+  done = true;
+  for (auto& thief : thieves) thief.join();
+  iree_task_queue_deinitialize(&queue);
+  state.SetItemsProcessed(popped_count);
+}
+BENCHMARK(BM_QueuePopUnderTheft)->Arg(1)->Arg(3)->Arg(7)->UseRealTime();
+
+}  // namespace
@@ -40,6 +40,10 @@ struct iree_task_executor_s {
   // TODO(benvanik): make mutable; currently always the same reserved value.
   iree_task_scheduling_mode_t scheduling_mode;
 
+  // Duration workers spin looking for new work before parking unless
+  // overridden by their topology group.
+  iree_duration_t worker_spin_ns;
+
   // State used by the work-stealing operations performed by donated threads.
   // This is **NOT SYNCHRONIZED** and relies on the fact that we actually don't
   // much care about the precise selection of workers enough to mind any tears
@@ -107,6 +111,11 @@ struct iree_task_executor_s {
   // live join/leave behavior we could change this to a registration mechanism.
   iree_host_size_t worker_count;
   iree_task_worker_t* workers;  // [worker_count]
+
+  // Size of the separately mapped storage for |workers| when the workers span
+  // multiple NUMA nodes and have been placed on their nodes. 0 when |workers|
+  // is allocated inline with the executor.
+  iree_host_size_t numa_worker_storage_size;
 };
 
 // Merges a submission into the primary FIFO queues.
@@ -138,10 +147,15 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
 // Tries to steal an entire task from a sibling worker (based on topology).
 // Returns a task that is available (has not yet begun processing at all).
 // May steal multiple tasks and add them to the |local_task_queue|.
+//
+// Victims are tried in order of locality: first those in the
+// |constructive_sharing_mask|, then the remaining workers in the same NUMA node
+// as indicated by |numa_node_mask|, and only then workers on other nodes.
 iree_task_t* iree_task_executor_try_steal_task(
     iree_task_executor_t* executor,
     iree_task_affinity_set_t constructive_sharing_mask,
-    uint32_t max_theft_attempts, iree_prng_minilcg128_state_t* theft_prng,
+    iree_task_affinity_set_t numa_node_mask, uint32_t max_theft_attempts,
+    iree_prng_minilcg128_state_t* theft_prng,
     iree_task_queue_t* local_task_queue);
 
 #ifdef __cplusplus
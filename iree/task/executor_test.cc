@@ -64,8 +64,9 @@ TEST(ExecutorTest, Any) {
   iree_task_executor_t* executor = NULL;
   iree_task_scheduling_mode_t scheduling_mode =
       IREE_TASK_SCHEDULING_MODE_RESERVED;
-  IREE_CHECK_OK(iree_task_executor_create(scheduling_mode, &topology, allocator,
-                                          &executor));
+  IREE_CHECK_OK(iree_task_executor_create(
+      scheduling_mode, &topology, IREE_TASK_EXECUTOR_DEFAULT_WORKER_SPIN_NS,
+      allocator, &executor));
   iree_task_topology_deinitialize(&topology);
 
   //
@@ -97,8 +98,6 @@ TEST(ExecutorTest, Any) {
             IREE_TRACE_SCOPE0("tile0");
             EXPECT_EQ(0, user_context);
             simulate_work(tile_context);
-            iree_atomic_fetch_add_int32(&tile_context->statistics->reserved, 1,
-                                        iree_memory_order_relaxed);
             return iree_ok_status();
           },
           0),
@@ -117,8 +116,6 @@ TEST(ExecutorTest, Any) {
             IREE_TRACE_SCOPE0("tile1");
             EXPECT_EQ(0, user_context);
             simulate_work(tile_context);
-            iree_atomic_fetch_add_int32(&tile_context->statistics->reserved, 1,
-                                        iree_memory_order_relaxed);
             return iree_ok_status();
           },
           0),
@@ -174,8 +171,72 @@ TEST(ExecutorTest, Any) {
 
   IREE_CHECK_OK(iree_task_scope_wait_idle(&scope_a, IREE_TIME_INFINITE_FUTURE));
 
+  // Both dispatches roll their statistics up into the scope.
+  iree_task_dispatch_statistics_t statistics =
+      iree_task_scope_consume_statistics(&scope_a);
+  EXPECT_EQ(32 * 4 * 2 + 16 * 2 * 1,
+            iree_atomic_load_int64(&statistics.tile_count,
+                                   iree_memory_order_relaxed));
+
   iree_task_scope_deinitialize(&scope_a);
   iree_task_executor_release(executor);
 }
 
+// Tests that executors with workers spread across NUMA nodes run work to
+// completion. The nodes are synthetic so the placement itself is only a hint
+// and is expected to fail gracefully on single-node machines.
+TEST(ExecutorTest, MultipleNumaNodes) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/4, &topology);
+  for (iree_host_size_t i = 0; i < topology.group_count; ++i) {
+    iree_task_topology_group_t* group = &topology.groups[i];
+    group->numa_node_id = (uint32_t)(i / 2);
+    group->constructive_sharing_mask = 0;
+    group->numa_node_mask = 1ull << (i ^ 1);
+  }
+
+  iree_task_executor_t* executor = NULL;
+  IREE_ASSERT_OK(iree_task_executor_create(
+      IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+      IREE_TASK_EXECUTOR_DEFAULT_WORKER_SPIN_NS, iree_allocator_system(),
+      &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("numa"), &scope);
+
+  static iree_atomic_int32_t tile_count = IREE_ATOMIC_VAR_INIT(0);
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {64, 4, 1};
+  iree_task_dispatch_t dispatch;
+  iree_task_dispatch_initialize(
+      &scope,
+      iree_task_make_dispatch_closure(
+          [](uintptr_t user_context,
+             const iree_task_tile_context_t* tile_context,
+             iree_task_submission_t* pending_submission) {
+            iree_atomic_fetch_add_int32(&tile_count, 1,
+                                        iree_memory_order_relaxed);
+            return iree_ok_status();
+          },
+          0),
+      workgroup_size, workgroup_count, &dispatch);
+
+  iree_task_fence_t* fence = NULL;
+  IREE_ASSERT_OK(iree_task_executor_acquire_fence(executor, &scope, &fence));
+  iree_task_set_completion_task(&dispatch.header, &fence->header);
+
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, &dispatch.header);
+  iree_task_executor_submit(executor, &submission);
+  iree_task_executor_flush(executor);
+  IREE_ASSERT_OK(iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_EQ(64 * 4,
+            iree_atomic_load_int32(&tile_count, iree_memory_order_relaxed));
+
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+
 }  // namespace
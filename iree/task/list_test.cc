@@ -117,6 +117,46 @@ TEST(TaskListTest, Discard) {
   // IMPLICIT: if the tasks were not released back to the pool we'll leak.
 }
 
+// Counts how many times each task (by flags value) has been cleaned up.
+static int discard_join_cleanup_counts[4];
+static void DiscardJoinCleanup(iree_task_t* task, iree_status_t status) {
+  ++discard_join_cleanup_counts[task->flags];
+}
+
+TEST(TaskListTest, DiscardJoin) {
+  auto pool = AllocateNopPool();
+  auto scope = AllocateScope("a");
+  for (size_t i = 0; i < IREE_ARRAYSIZE(discard_join_cleanup_counts); ++i) {
+    discard_join_cleanup_counts[i] = 0;
+  }
+
+  // task0, task1, task2 all join into task3.
+  auto task0 = AcquireNopTask(pool, scope, 0);
+  auto task1 = AcquireNopTask(pool, scope, 1);
+  auto task2 = AcquireNopTask(pool, scope, 2);
+  auto task3 = AcquireNopTask(pool, scope, 3);
+  iree_task_set_cleanup_fn(task0, DiscardJoinCleanup);
+  iree_task_set_cleanup_fn(task1, DiscardJoinCleanup);
+  iree_task_set_cleanup_fn(task2, DiscardJoinCleanup);
+  iree_task_set_cleanup_fn(task3, DiscardJoinCleanup);
+  iree_task_set_completion_task(task0, task3);
+  iree_task_set_completion_task(task1, task3);
+  iree_task_set_completion_task(task2, task3);
+
+  iree_task_list_t list;
+  iree_task_list_initialize(&list);
+  iree_task_list_push_back(&list, task0);
+  iree_task_list_push_back(&list, task1);
+  iree_task_list_push_back(&list, task2);
+  iree_task_list_discard(&list);
+  EXPECT_TRUE(iree_task_list_is_empty(&list));
+
+  // The join task must be discarded exactly once, after all predecessors.
+  for (size_t i = 0; i < IREE_ARRAYSIZE(discard_join_cleanup_counts); ++i) {
+    EXPECT_EQ(1, discard_join_cleanup_counts[i]);
+  }
+}
+
 TEST(TaskListTest, PushFront) {
   auto pool = AllocateNopPool();
   auto scope = AllocateScope("a");
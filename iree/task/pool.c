@@ -35,6 +35,78 @@
 // bumps us into the next power of two bucket.
 #define IREE_TASK_POOL_MIN_GROWTH_CAPACITY (255)
 
+// Maximum number of tasks in a chunk moved between the shared pool and caches.
+// Larger chunks reduce how often caches touch the shared pool while smaller
+// chunks reduce the number of free tasks that may be stranded in idle caches.
+#define IREE_TASK_POOL_CHUNK_CAPACITY (32)
+
+// Number of tasks a cache may hold before it returns a chunk to the shared
+// pool. Must be larger than IREE_TASK_POOL_CHUNK_CAPACITY so that a thread
+// alternating between acquiring and releasing around a chunk boundary doesn't
+// thrash chunks in and out of the shared pool.
+#define IREE_TASK_POOL_CACHE_HIGH_WATER_MARK \
+  (2 * IREE_TASK_POOL_CHUNK_CAPACITY)
+
+static_assert(sizeof(iree_task_pool_chunk_t) <= sizeof(iree_task_t),
+              "chunk headers are stored in free tasks");
+
+// Cache bound to the calling thread with iree_task_pool_cache_bind, if any.
+static IREE_THREAD_LOCAL iree_task_pool_cache_t* iree_task_pool_thread_cache =
+    NULL;
+
+// Returns the cache bound to the calling thread if it caches |pool|.
+static inline iree_task_pool_cache_t* iree_task_pool_lookup_cache(
+    iree_task_pool_t* pool) {
+  iree_task_pool_cache_t* cache = iree_task_pool_thread_cache;
+  return cache && cache->pool == pool ? cache : NULL;
+}
+
+// Forms a chunk from the |task_count| tasks starting at |head| and linked by
+// next_task. The last task must be linked to NULL.
+static iree_task_pool_chunk_t* iree_task_pool_make_chunk(
+    iree_task_t* head, iree_host_size_t task_count) {
+  iree_task_pool_chunk_t* chunk = (iree_task_pool_chunk_t*)head;
+  chunk->tail_tasks = task_count > 1 ? head->next_task : NULL;
+  chunk->task_count = task_count;
+  iree_atomic_task_pool_chunk_slist_set_next(chunk, NULL);
+  return chunk;
+}
+
+// Returns the |task_count| tasks starting at |head| to the pool as one chunk.
+static void iree_task_pool_push_chunk(iree_task_pool_t* pool,
+                                      iree_task_t* head,
+                                      iree_host_size_t task_count) {
+  if (!task_count) return;
+  iree_atomic_task_pool_chunk_slist_push(
+      &pool->available_slist, iree_task_pool_make_chunk(head, task_count));
+}
+
+// Pops a chunk from the pool and returns its tasks linked by next_task, with
+// the last task linked to NULL. Returns NULL if the pool is empty.
+static iree_task_t* iree_task_pool_pop_chunk(iree_task_pool_t* pool,
+                                             iree_host_size_t* out_task_count) {
+  iree_task_pool_chunk_t* chunk =
+      iree_atomic_task_pool_chunk_slist_pop(&pool->available_slist);
+  if (!chunk) {
+    *out_task_count = 0;
+    return NULL;
+  }
+  iree_task_t* tail_tasks = chunk->tail_tasks;
+  iree_host_size_t task_count = chunk->task_count;
+  iree_task_t* head = (iree_task_t*)chunk;
+  head->next_task = tail_tasks;
+  *out_task_count = task_count;
+  return head;
+}
+
+// Returns the task |count| - 1 links after |head|.
+static iree_task_t* iree_task_pool_walk(iree_task_t* head,
+                                        iree_host_size_t count) {
+  iree_task_t* task = head;
+  for (iree_host_size_t i = 1; i < count; ++i) task = task->next_task;
+  return task;
+}
+
 // Grows the task pool by at least |minimum_capacity| on top of its current
 // capacity. The actual number of tasks available may be rounded up to make the
 // allocated blocks more allocator-friendly sizes.
@@ -79,39 +151,53 @@ static iree_status_t iree_task_pool_grow(iree_task_pool_t* pool,
   // for tasks than we were asked for. Ensure we actually make use of them.
   iree_host_size_t actual_capacity =
       (aligned_block_size - header_size) / pool->task_size;
+  uint8_t* base_ptr = (uint8_t*)allocation + header_size;
 
-  // Stitch together the tasks by setting all next pointers.
-  // Since we are going to be touching all the pages the order here is important
-  // as once we insert these new tasks into the available_slist they'll be
-  // popped out head->tail. To ensure the head that gets popped first is still
-  // warm in cache we construct the list backwards, with the tail tasks being
-  // fine to be evicted.
+  // Stitch together the tasks into chunks of adjacent tasks. Since we are going
+  // to be touching all the pages the order here is important: the chunks are
+  // built from the end of the block backwards such that the chunk at the start
+  // of the block - which is popped first - is the most recently touched and
+  // still warm in cache.
   //
   // The nice thing about this walk is that it ensures that if there were any
   // zero-fill-on-demand trickery going on the pages are all wired here vs.
   // when the tasks are first acquired from the list where it'd be harder to
   // track.
-  uintptr_t p = ((uintptr_t)allocation + aligned_block_size) - pool->task_size;
-  iree_task_t* head = (iree_task_t*)p;
-  iree_task_t* tail = head;
-  head->next_task = NULL;
-  head->pool = pool;
-  for (iree_host_size_t i = 0; i < actual_capacity; ++i, p -= pool->task_size) {
-    iree_task_t* task = (iree_task_t*)p;
-    task->next_task = head;
-    task->pool = pool;
-    head = task;
-  }
+  iree_task_pool_chunk_t* chunk_head = NULL;
+  iree_task_pool_chunk_t* chunk_tail = NULL;
+  iree_host_size_t chunk_end = actual_capacity;
+  while (chunk_end > 0) {
+    iree_host_size_t chunk_begin =
+        chunk_end > IREE_TASK_POOL_CHUNK_CAPACITY
+            ? chunk_end - IREE_TASK_POOL_CHUNK_CAPACITY
+            : 0;
+    iree_task_t* head = NULL;
+    for (iree_host_size_t i = chunk_end; i > chunk_begin; --i) {
+      iree_task_t* task = (iree_task_t*)(base_ptr + (i - 1) * pool->task_size);
+      task->next_task = head;
+      task->pool = pool;
+      head = task;
+    }
+    iree_host_size_t task_count = chunk_end - chunk_begin;
+    chunk_end = chunk_begin;
+
+    // If the caller needs a task we can slice off the head of the first chunk
+    // to return prior to adding it to the slist where it may get stolen.
+    if (chunk_begin == 0 && out_task) {
+      *out_task = head;
+      head = head->next_task;
+      if (!--task_count) break;
+    }
 
-  // If the caller needs a task we can slice off the head to return prior to
-  // adding it to the slist where it may get stolen.
-  if (out_task) {
-    *out_task = head;
-    head = head->next_task;
+    iree_task_pool_chunk_t* chunk = iree_task_pool_make_chunk(head, task_count);
+    iree_atomic_task_pool_chunk_slist_set_next(chunk, chunk_head);
+    chunk_head = chunk;
+    if (!chunk_tail) chunk_tail = chunk;
   }
 
-  // Concatenate the list of new free tasks into the pool.
-  iree_atomic_task_slist_concat(&pool->available_slist, head, tail);
+  // Concatenate the new free chunks into the pool.
+  iree_atomic_task_pool_chunk_slist_concat(&pool->available_slist, chunk_head,
+                                           chunk_tail);
 
   IREE_TRACE_ZONE_END(z0);
   return iree_ok_status();
@@ -128,7 +214,7 @@ iree_status_t iree_task_pool_initialize(iree_allocator_t allocator,
   out_pool->allocator = allocator;
   out_pool->task_size = task_size;
   iree_atomic_task_allocation_slist_initialize(&out_pool->allocations_slist);
-  iree_atomic_task_slist_initialize(&out_pool->available_slist);
+  iree_atomic_task_pool_chunk_slist_initialize(&out_pool->available_slist);
   iree_status_t status =
       iree_task_pool_grow(out_pool, initial_capacity, /*out_task=*/NULL);
 
@@ -151,7 +237,7 @@ void iree_task_pool_deinitialize(iree_task_pool_t* pool) {
     }
   }
   iree_atomic_task_allocation_slist_deinitialize(&pool->allocations_slist);
-  iree_atomic_task_slist_deinitialize(&pool->available_slist);
+  iree_atomic_task_pool_chunk_slist_deinitialize(&pool->available_slist);
 
   IREE_TRACE_ZONE_END(z0);
 }
@@ -163,10 +249,10 @@ void iree_task_pool_trim(iree_task_pool_t* pool) {
 
   // We only need to flush the list to empty it - these are just references into
   // the allocations and don't need to be released.
-  iree_task_t* task_head = NULL;
-  iree_atomic_task_slist_flush(&pool->available_slist,
-                               IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_LIFO,
-                               &task_head, /*tail=*/NULL);
+  iree_task_pool_chunk_t* chunk_head = NULL;
+  iree_atomic_task_pool_chunk_slist_flush(
+      &pool->available_slist, IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_LIFO,
+      &chunk_head, /*tail=*/NULL);
 
   iree_task_allocation_header_t* allocation_head = NULL;
   if (iree_atomic_task_allocation_slist_flush(
@@ -184,13 +270,39 @@ void iree_task_pool_trim(iree_task_pool_t* pool) {
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Acquires a task from |cache|, refilling it from the pool if it is empty.
+static iree_status_t iree_task_pool_cache_acquire(iree_task_pool_cache_t* cache,
+                                                  iree_task_t** out_task) {
+  if (IREE_UNLIKELY(!cache->head)) {
+    cache->head = iree_task_pool_pop_chunk(cache->pool, &cache->count);
+    if (!cache->head) {
+      // Pool is empty; grow it and take our task directly from the new block.
+      // The rest of the new tasks will be picked up on our next refill (if
+      // another thread doesn't get to them first).
+      return iree_task_pool_grow(cache->pool,
+                                 IREE_TASK_POOL_MIN_GROWTH_CAPACITY, out_task);
+    }
+  }
+  iree_task_t* task = cache->head;
+  cache->head = task->next_task;
+  --cache->count;
+  *out_task = task;
+  return iree_ok_status();
+}
+
 iree_status_t iree_task_pool_acquire(iree_task_pool_t* pool,
                                      iree_task_t** out_task) {
   if (!pool) return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED);
 
-  // Attempt to acquire a task from the available list.
-  iree_task_t* task = iree_atomic_task_slist_pop(&pool->available_slist);
+  iree_task_pool_cache_t* cache = iree_task_pool_lookup_cache(pool);
+  if (cache) return iree_task_pool_cache_acquire(cache, out_task);
+
+  // Attempt to acquire a task from the available list. We take the head of the
+  // first chunk and give the rest back.
+  iree_host_size_t task_count = 0;
+  iree_task_t* task = iree_task_pool_pop_chunk(pool, &task_count);
   if (task) {
+    iree_task_pool_push_chunk(pool, task->next_task, task_count - 1);
     *out_task = task;
     return iree_ok_status();
   }
@@ -208,90 +320,112 @@ iree_status_t iree_task_pool_acquire_many(iree_task_pool_t* pool,
                                           iree_host_size_t count,
                                           iree_task_list_t* out_list) {
   if (!pool) return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED);
-
-  // If we acquire more than the requested count we need to give those leftovers
-  // back to the pool before we leave.
-  iree_task_list_t leftover_tasks;
-  iree_task_list_initialize(&leftover_tasks);
   iree_task_list_initialize(out_list);
 
   iree_status_t status = iree_ok_status();
-  while (count) {
-    // Flush the entire available list so we can start operating on it.
-    // This is where the potential race comes in: if another thread goes to
-    // acquire a task while we have the list local here it'll grow the list so
-    // it can meet its demand. That's still correct behavior but will result in
-    // potentially more wasted memory than if the other thread would have
-    // waited. Thankfully we save memory in so many other places that in the
-    // rare case there are multiple concurrent schedulers acquiring tasks it's
-    // not the end of the world.
-    iree_task_list_t acquired_tasks;
-    iree_task_list_initialize(&acquired_tasks);
-    if (iree_atomic_task_slist_flush(
-            &pool->available_slist,
-            IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_LIFO,
-            &acquired_tasks.head,
-            /*tail=*/NULL)) {
-      // Had some items in the pool; eat up to the requested count.
-      // Note that we may run out and need to allocate more or have gotten
-      // too many during the flush and need to track those leftovers.
-      //
-      // Instead of having the slist flush walk the list and give us a tail we
-      // do that here: we need to walk the list anyway to partition it.
-      iree_task_t* p = acquired_tasks.head;
-      while (count > 0) {
-        p = iree_atomic_task_slist_get_next(p);
-        if (!p) break;
-        acquired_tasks.tail = p;
-        --count;
-      }
-
-      // If we got everything we need then we have to put all of the flushed
-      // tasks we didn't use into the leftover list.
-      if (count == 0) {
-        iree_task_list_t acquire_leftovers;
-        iree_task_list_initialize(&acquire_leftovers);
-        acquire_leftovers.head =
-            iree_atomic_task_slist_get_next(acquired_tasks.tail);
-        iree_atomic_task_slist_set_next(acquired_tasks.tail, NULL);
-        p = acquire_leftovers.head;
-        iree_task_t* next;
-        while ((next = iree_atomic_task_slist_get_next(p))) p = next;
-        acquire_leftovers.tail = p;
-        iree_task_list_append(&leftover_tasks, &acquire_leftovers);
-      }
-
-      // Add the tasks we did acquire to our result list.
-      // NOTE: this is unmeasured but the intuition is that we want to put the
-      // tasks we just acquired at the head of the list so that they are warm
-      // upon return to the caller who will then be touching the head of the
-      // list immediately.
-      iree_task_list_prepend(out_list, &acquired_tasks);
-    }
-
-    // If we still need more tasks but ran out of ones in the flush list then we
-    // need to grow some more.
-    if (count > 0) {
+  while (count > 0) {
+    // Take as many tasks as we need from the next chunk and return the rest.
+    iree_host_size_t chunk_count = 0;
+    iree_task_t* head = iree_task_pool_pop_chunk(pool, &chunk_count);
+    if (!head) {
+      // Ran out of tasks and need to grow. Another thread may snipe some of
+      // the new tasks before we get to them in which case we'll just grow
+      // again.
       status = iree_task_pool_grow(pool, count, /*out_task=*/NULL);
       if (IREE_UNLIKELY(!iree_status_is_ok(status))) break;
+      continue;
     }
+    iree_host_size_t take_count = iree_min(count, chunk_count);
+    iree_task_list_t acquired_tasks;
+    acquired_tasks.head = head;
+    acquired_tasks.tail = iree_task_pool_walk(head, take_count);
+    iree_task_t* leftover_head = acquired_tasks.tail->next_task;
+    acquired_tasks.tail->next_task = NULL;
+    iree_task_pool_push_chunk(pool, leftover_head, chunk_count - take_count);
+
+    // NOTE: this is unmeasured but the intuition is that we want to put the
+    // tasks we just acquired at the head of the list so that they are warm
+    // upon return to the caller who will then be touching the head of the
+    // list immediately.
+    iree_task_list_prepend(out_list, &acquired_tasks);
+    count -= take_count;
   }
 
-  // Return leftovers that we acquired but didn't need to the pool.
-  iree_atomic_task_slist_concat(&pool->available_slist, leftover_tasks.head,
-                                leftover_tasks.tail);
-
   // Upon failure return any tasks we may have already acquired from the pool.
   if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
-    iree_atomic_task_slist_concat(&pool->available_slist, out_list->head,
-                                  out_list->tail);
+    iree_task_t* task = NULL;
+    while ((task = iree_task_list_pop_front(out_list))) {
+      iree_task_pool_push_chunk(pool, task, 1);
+    }
   }
 
   return status;
 }
 
+// Returns all but the most recently released IREE_TASK_POOL_CHUNK_CAPACITY
+// tasks in |cache| to its pool as a chunk.
+static void iree_task_pool_cache_trim(iree_task_pool_cache_t* cache) {
+  iree_task_t* keep_tail =
+      iree_task_pool_walk(cache->head, IREE_TASK_POOL_CHUNK_CAPACITY);
+  iree_task_t* return_head = keep_tail->next_task;
+  keep_tail->next_task = NULL;
+  iree_task_pool_push_chunk(cache->pool, return_head,
+                            cache->count - IREE_TASK_POOL_CHUNK_CAPACITY);
+  cache->count = IREE_TASK_POOL_CHUNK_CAPACITY;
+}
+
 void iree_task_pool_release(iree_task_pool_t* pool, iree_task_t* task) {
   if (!pool) return;
   IREE_ASSERT_EQ(task->pool, pool);
-  iree_atomic_task_slist_push(&pool->available_slist, task);
+
+  iree_task_pool_cache_t* cache = iree_task_pool_lookup_cache(pool);
+  if (!cache) {
+    iree_task_pool_push_chunk(pool, task, 1);
+    return;
+  }
+
+  // Cache releases are LIFO so the next acquire gets the task warmest in cache.
+  // Once the cache grows past its high-water mark we return the colder tasks.
+  task->next_task = cache->head;
+  cache->head = task;
+  if (IREE_UNLIKELY(++cache->count >= IREE_TASK_POOL_CACHE_HIGH_WATER_MARK)) {
+    iree_task_pool_cache_trim(cache);
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// iree_task_pool_cache_t
+//===----------------------------------------------------------------------===//
+
+void iree_task_pool_cache_initialize(iree_task_pool_t* pool,
+                                     iree_task_pool_cache_t* out_cache) {
+  out_cache->pool = pool;
+  out_cache->head = NULL;
+  out_cache->count = 0;
+}
+
+void iree_task_pool_cache_deinitialize(iree_task_pool_cache_t* cache) {
+  IREE_ASSERT_NE(iree_task_pool_thread_cache, cache);
+  iree_task_pool_cache_flush(cache);
+}
+
+void iree_task_pool_cache_flush(iree_task_pool_cache_t* cache) {
+  while (cache->count > 0) {
+    iree_host_size_t task_count =
+        iree_min(cache->count, (iree_host_size_t)IREE_TASK_POOL_CHUNK_CAPACITY);
+    iree_task_t* head = cache->head;
+    iree_task_t* tail = iree_task_pool_walk(head, task_count);
+    cache->head = tail->next_task;
+    tail->next_task = NULL;
+    cache->count -= task_count;
+    iree_task_pool_push_chunk(cache->pool, head, task_count);
+  }
+  cache->head = NULL;
+}
+
+iree_task_pool_cache_t* iree_task_pool_cache_bind(
+    iree_task_pool_cache_t* cache) {
+  iree_task_pool_cache_t* previous_cache = iree_task_pool_thread_cache;
+  iree_task_pool_thread_cache = cache;
+  return previous_cache;
 }
@@ -39,6 +39,25 @@ IREE_TYPED_ATOMIC_SLIST_WRAPPER(iree_atomic_task_allocation,
                                 iree_task_allocation_header_t,
                                 offsetof(iree_task_allocation_header_t, next));
 
+// A chunk of free tasks stored in a task pool.
+// Free tasks have no meaningful contents and the first task of each chunk is
+// reused to store the chunk header. Chunks are built from tasks that are
+// adjacent in memory when the pool grows such that the caches that acquire a
+// chunk at a time walk memory linearly instead of hopping around the heap.
+typedef struct iree_task_pool_chunk_s {
+  // Next chunk in the pool available_slist. Aliases iree_task_t::next_task.
+  iree_atomic_slist_intrusive_ptr_t* next;
+  // Remaining tasks in the chunk after this one linked by next_task.
+  iree_task_t* tail_tasks;
+  // Total number of tasks in the chunk including this one.
+  iree_host_size_t task_count;
+} iree_task_pool_chunk_t;
+
+// An atomic approximately LIFO singly-linked list.
+IREE_TYPED_ATOMIC_SLIST_WRAPPER(iree_atomic_task_pool_chunk,
+                                iree_task_pool_chunk_t,
+                                offsetof(iree_task_pool_chunk_t, next));
+
 // Shared thread-safe pool of iree_task_t structures of a particular size.
 // This can be used to quickly allocate blocks of tasks to be initialized by
 // task producers, enqueued, and then eventually recycled back to the pool.
@@ -50,6 +69,10 @@ IREE_TYPED_ATOMIC_SLIST_WRAPPER(iree_atomic_task_allocation,
 // Pools can either be fixed-size with a maximum number of available tasks that
 // can be outstanding at any time or growable to allow the pool to be grown
 // unbounded after initialization.
+//
+// Threads that frequently acquire and release tasks (such as executor workers)
+// should bind an iree_task_pool_cache_t so that the shared pool is only touched
+// when moving whole chunks of tasks in or out of the cache.
 typedef struct iree_task_pool_s {
   // Allocator used for allocating/freeing each allocation block.
   iree_allocator_t allocator;
@@ -66,15 +89,12 @@ typedef struct iree_task_pool_s {
   // Head of a linked list of all allocations made by the pool.
   iree_atomic_task_allocation_slist_t allocations_slist;
 
-  // Linked list of free tasks used as a stack (LIFO).
-  // This is not a great structure for this as over time the tasks will get out
-  // of order and walking the linked list will incur cache misses. We offset
-  // that cost a bit by knowing that the time between walking the list to
-  // acquire tasks and when we initialize the tasks is short and that we would
-  // have triggered a cache miss anyway. In the future we can explore other
-  // approaches (such as small chunked linear lists) that better exploit spatial
-  // locality, if needed.
-  iree_atomic_task_slist_t available_slist;
+  // Linked list of free task chunks used as a stack (LIFO).
+  // Chunks are up to IREE_TASK_POOL_CHUNK_CAPACITY tasks and are formed from
+  // contiguous tasks when the pool grows or from the tasks a cache has most
+  // recently released. Tasks released without a cache are returned as chunks
+  // of one task.
+  iree_atomic_task_pool_chunk_slist_t available_slist;
 } iree_task_pool_t;
 
 // Initializes a task pool and optionally performs an initial task allocation.
@@ -102,11 +122,6 @@ iree_status_t iree_task_pool_acquire(iree_task_pool_t* pool,
 // Acquires a set of tasks from the task pool. The returned tasks will have
 // undefined contents besides their intrusive next pointers and must be
 // intialized by the caller.
-//
-// WARNING: this may cause growth during races if multiple threads are trying to
-// acquire at the same time. Our usage patterns here are such that this is never
-// the case, though, as all acquisition from the internal executor pools happens
-// with the coordination lock held.
 iree_status_t iree_task_pool_acquire_many(iree_task_pool_t* pool,
                                           iree_host_size_t count,
                                           iree_task_list_t* out_list);
@@ -115,6 +130,46 @@ iree_status_t iree_task_pool_acquire_many(iree_task_pool_t* pool,
 // Callers must ensure the task is no longer in use.
 void iree_task_pool_release(iree_task_pool_t* pool, iree_task_t* task);
 
+//===----------------------------------------------------------------------===//
+// iree_task_pool_cache_t
+//===----------------------------------------------------------------------===//
+
+// A single-threaded cache of free tasks from a task pool.
+// While bound to a thread with iree_task_pool_cache_bind all acquires and
+// releases made by that thread against the cached pool use the cache and only
+// touch the shared pool to refill the cache a chunk at a time when it runs
+// out or to return a chunk when the cache grows past its high-water mark.
+//
+// Caches must only be used by a single thread at a time and must be
+// deinitialized (returning their tasks) before the pool is deinitialized.
+typedef struct iree_task_pool_cache_s {
+  // Pool the cached tasks were acquired from and will be returned to.
+  iree_task_pool_t* pool;
+  // LIFO list of free tasks with the most recently released at the head.
+  iree_task_t* head;
+  // Total number of tasks in the list.
+  iree_host_size_t count;
+} iree_task_pool_cache_t;
+
+// Initializes an empty cache of tasks from |pool|.
+void iree_task_pool_cache_initialize(iree_task_pool_t* pool,
+                                     iree_task_pool_cache_t* out_cache);
+
+// Deinitializes |cache| and returns all cached tasks to the pool.
+// The cache must not be bound to any thread.
+void iree_task_pool_cache_deinitialize(iree_task_pool_cache_t* cache);
+
+// Returns all cached tasks to the pool. Threads should flush their caches
+// before they go idle for long periods so that other threads can use the tasks.
+void iree_task_pool_cache_flush(iree_task_pool_cache_t* cache);
+
+// Binds |cache| to the calling thread such that acquires and releases made by
+// the thread against the cache pool use the cache. Pass NULL to unbind.
+// Returns the cache previously bound to the thread (if any) so that callers
+// can restore it when binding a temporary cache.
+iree_task_pool_cache_t* iree_task_pool_cache_bind(
+    iree_task_pool_cache_t* cache);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
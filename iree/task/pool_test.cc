@@ -14,6 +14,9 @@
 
 #include "iree/task/pool.h"
 
+#include <cstring>
+#include <vector>
+
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
 
@@ -95,4 +98,60 @@ TEST(PoolTest, Trim) {
   iree_task_pool_deinitialize(&pool);
 }
 
+TEST(PoolTest, AcquireMany) {
+  iree_task_pool_t pool;
+  IREE_ASSERT_OK(iree_task_pool_initialize(iree_allocator_system(),
+                                           sizeof(iree_test_task_t), 2, &pool));
+
+  // Acquire more tasks than a single chunk/allocation holds.
+  iree_task_list_t list;
+  IREE_ASSERT_OK(iree_task_pool_acquire_many(&pool, 300, &list));
+  EXPECT_EQ(300u, iree_task_list_calculate_size(&list));
+  while (iree_task_t* task = iree_task_list_pop_front(&list)) {
+    task->pool = &pool;
+    iree_task_pool_release(&pool, task);
+  }
+
+  iree_task_pool_deinitialize(&pool);
+}
+
+TEST(PoolTest, Cache) {
+  iree_task_pool_t pool;
+  IREE_ASSERT_OK(iree_task_pool_initialize(iree_allocator_system(),
+                                           sizeof(iree_test_task_t), 2, &pool));
+  iree_task_pool_cache_t cache;
+  iree_task_pool_cache_initialize(&pool, &cache);
+  EXPECT_EQ(nullptr, iree_task_pool_cache_bind(&cache));
+
+  // Acquire enough tasks to refill the cache a few times and release them all
+  // to push the cache past its high-water mark.
+  std::vector<iree_test_task_t*> tasks(200);
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    IREE_ASSERT_OK(iree_task_pool_acquire(&pool, (iree_task_t**)&tasks[i]));
+    tasks[i]->base.pool = &pool;
+    memset(tasks[i]->payload, (int)i, sizeof(tasks[i]->payload));
+  }
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    EXPECT_EQ((uint8_t)i, tasks[i]->payload[0]);
+    iree_task_pool_release(&pool, (iree_task_t*)tasks[i]);
+  }
+  EXPECT_GT(cache.count, 0u);
+
+  // Flushing returns everything to the pool where it can be acquired without
+  // the cache.
+  EXPECT_EQ(&cache, iree_task_pool_cache_bind(NULL));
+  iree_task_pool_cache_flush(&cache);
+  EXPECT_EQ(0u, cache.count);
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    IREE_ASSERT_OK(iree_task_pool_acquire(&pool, (iree_task_t**)&tasks[i]));
+    tasks[i]->base.pool = &pool;
+  }
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    iree_task_pool_release(&pool, (iree_task_t*)tasks[i]);
+  }
+
+  iree_task_pool_cache_deinitialize(&cache);
+  iree_task_pool_deinitialize(&pool);
+}
+
 }  // namespace
@@ -35,6 +35,14 @@ iree_host_size_t iree_task_post_batch_worker_count(
   return post_batch->executor->worker_count;
 }
 
+iree_task_affinity_set_t iree_task_post_batch_idle_worker_mask(
+    const iree_task_post_batch_t* post_batch) {
+  return iree_atomic_task_affinity_set_load(
+             &post_batch->executor->worker_idle_mask,
+             iree_memory_order_relaxed) &
+         ~post_batch->worker_pending_mask;
+}
+
 static iree_host_size_t iree_task_post_batch_select_random_worker(
     iree_task_post_batch_t* post_batch, iree_task_affinity_set_t affinity_set) {
   iree_task_affinity_set_t worker_live_mask =
@@ -55,6 +55,11 @@ void iree_task_post_batch_initialize(iree_task_executor_t* executor,
 iree_host_size_t iree_task_post_batch_worker_count(
     const iree_task_post_batch_t* post_batch);
 
+// Returns a mask of the workers that are currently idle and have no tasks
+// pending in the batch; posting to any of them will require waking it.
+iree_task_affinity_set_t iree_task_post_batch_idle_worker_mask(
+    const iree_task_post_batch_t* post_batch);
+
 // Selects a random worker from the given affinity set.
 iree_host_size_t iree_task_post_batch_select_worker(
     iree_task_post_batch_t* post_batch, iree_task_affinity_set_t affinity_set);
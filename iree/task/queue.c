@@ -16,82 +16,256 @@
 
 #include <assert.h>
 
+#include "iree/base/internal/debugging.h"
+
+static_assert((IREE_TASK_QUEUE_CAPACITY & (IREE_TASK_QUEUE_CAPACITY - 1)) == 0,
+              "IREE_TASK_QUEUE_CAPACITY must be a power of two");
+
+#define IREE_TASK_QUEUE_SLOT(queue, index) \
+  (&(queue)->tasks[(index) & (IREE_TASK_QUEUE_CAPACITY - 1)])
+
+//==============================================================================
+// Chase-Lev deque primitives
+//==============================================================================
+// The memory orderings here follow "Correct and Efficient Work-Stealing for
+// Weak Memory Models" (Lê, Pop, Cohen, Zappa Nardelli; PPoPP'13), figure 1.
+
+// Pushes |task| onto the bottom (front) of the deque.
+// Returns false if the deque is full and the task was not pushed.
+// Must only be called by the owner.
+static bool iree_task_queue_push_bottom(iree_task_queue_t* queue,
+                                        iree_task_t* task) {
+  int64_t b = iree_atomic_load_int64(&queue->bottom, iree_memory_order_relaxed);
+  int64_t t = iree_atomic_load_int64(&queue->top, iree_memory_order_acquire);
+  if (b - t >= IREE_TASK_QUEUE_CAPACITY) return false;
+  iree_atomic_store_intptr(IREE_TASK_QUEUE_SLOT(queue, b), (intptr_t)task,
+                           iree_memory_order_relaxed);
+  iree_atomic_thread_fence(iree_memory_order_release);
+  iree_atomic_store_int64(&queue->bottom, b + 1, iree_memory_order_relaxed);
+  return true;
+}
+
+// Pops a task from the bottom (front) of the deque, if any.
+// Must only be called by the owner.
+static iree_task_t* iree_task_queue_take_bottom(iree_task_queue_t* queue) {
+  int64_t b =
+      iree_atomic_load_int64(&queue->bottom, iree_memory_order_relaxed) - 1;
+  iree_atomic_store_int64(&queue->bottom, b, iree_memory_order_relaxed);
+  iree_atomic_thread_fence(iree_memory_order_seq_cst);
+  int64_t t = iree_atomic_load_int64(&queue->top, iree_memory_order_relaxed);
+  if (t > b) {
+    // Empty; restore bottom.
+    iree_atomic_store_int64(&queue->bottom, b + 1, iree_memory_order_relaxed);
+    return NULL;
+  }
+  iree_task_t* task = (iree_task_t*)iree_atomic_load_intptr(
+      IREE_TASK_QUEUE_SLOT(queue, b), iree_memory_order_relaxed);
+  if (t == b) {
+    // Last task in the deque; race any thieves for it.
+    if (!iree_atomic_compare_exchange_strong_int64(
+            &queue->top, &t, t + 1, iree_memory_order_seq_cst,
+            iree_memory_order_relaxed)) {
+      // A thief got it first.
+      task = NULL;
+    }
+    iree_atomic_store_int64(&queue->bottom, b + 1, iree_memory_order_relaxed);
+  }
+  return task;
+}
+
+// Steals a task from the top (back) of the deque, if any.
+// Returns NULL if the deque was observed empty. |out_lost_race| is set if the
+// deque was not empty but another thread claimed the task first.
+// May be called from any thread.
+static iree_task_t* iree_task_queue_steal_top(iree_task_queue_t* queue,
+                                              bool* out_lost_race) {
+  *out_lost_race = false;
+  int64_t t = iree_atomic_load_int64(&queue->top, iree_memory_order_acquire);
+  iree_atomic_thread_fence(iree_memory_order_seq_cst);
+  int64_t b = iree_atomic_load_int64(&queue->bottom, iree_memory_order_acquire);
+  if (t >= b) return NULL;
+  iree_task_t* task = (iree_task_t*)iree_atomic_load_intptr(
+      IREE_TASK_QUEUE_SLOT(queue, t), iree_memory_order_relaxed);
+  if (!iree_atomic_compare_exchange_strong_int64(&queue->top, &t, t + 1,
+                                                 iree_memory_order_seq_cst,
+                                                 iree_memory_order_relaxed)) {
+    *out_lost_race = true;
+    return NULL;
+  }
+  return task;
+}
+
+// Returns the approximate number of tasks in the deque (excluding overflow).
+static int64_t iree_task_queue_deque_size(iree_task_queue_t* queue) {
+  int64_t t = iree_atomic_load_int64(&queue->top, iree_memory_order_acquire);
+  int64_t b = iree_atomic_load_int64(&queue->bottom, iree_memory_order_acquire);
+  return b - t;
+}
+
+// Moves tasks from the front of the overflow list into the deque until the
+// deque is full or the overflow list is empty. Must only be called by the
+// owner.
+//
+// The overflow list logically sits behind the deque but the owner can only
+// push to the front (bottom) of the deque. To place the overflow tasks behind
+// those already in the deque the owner takes back the tasks remaining in the
+// deque (racing thieves for them as usual) and pushes everything back-to-front.
+// The cost is proportional to the deque size so callers on hot paths should
+// only refill once the deque has drained sufficiently.
+static void iree_task_queue_refill_from_overflow(iree_task_queue_t* queue) {
+  if (iree_task_list_is_empty(&queue->overflow_list)) return;
+
+  // Take back the tasks in the deque front-to-back and keep them in LIFO order
+  // so that the front task is pushed last.
+  iree_task_list_t deque_lifo_list;
+  iree_task_list_initialize(&deque_lifo_list);
+  iree_host_size_t deque_count = 0;
+  iree_task_t* task = NULL;
+  while ((task = iree_task_queue_take_bottom(queue))) {
+    iree_task_list_push_front(&deque_lifo_list, task);
+    ++deque_count;
+  }
+
+  // Slice off the front of the overflow list to fill the remaining capacity,
+  // also in LIFO order.
+  iree_task_list_t overflow_lifo_list;
+  iree_task_list_initialize(&overflow_lifo_list);
+  for (iree_host_size_t i = deque_count; i < IREE_TASK_QUEUE_CAPACITY; ++i) {
+    task = iree_task_list_pop_front(&queue->overflow_list);
+    if (!task) break;
+    iree_task_list_push_front(&overflow_lifo_list, task);
+  }
+
+  // Push the back of the queue first so that the original front task ends up
+  // at the bottom of the deque.
+  while ((task = iree_task_list_pop_front(&overflow_lifo_list)) ||
+         (task = iree_task_list_pop_front(&deque_lifo_list))) {
+    bool did_push = iree_task_queue_push_bottom(queue, task);
+    IREE_ASSERT(did_push);
+    (void)did_push;
+  }
+}
+
+// Appends a FIFO |list| to the back of the queue.
+// Must only be called by the owner.
+static void iree_task_queue_append_fifo_list(iree_task_queue_t* queue,
+                                             iree_task_list_t* list) {
+  if (iree_task_list_is_empty(list)) return;
+  // The owner can only push to the front so anything appended goes into the
+  // overflow list. We immediately move as much as fits into the deque so that
+  // the tasks are available for stealing even if the owner is busy running a
+  // long task from the front of the deque.
+  iree_task_list_append(&queue->overflow_list, list);
+  if (iree_task_queue_deque_size(queue) < IREE_TASK_QUEUE_CAPACITY) {
+    iree_task_queue_refill_from_overflow(queue);
+  }
+}
+
+//==============================================================================
+// iree_task_queue_t
+//==============================================================================
+
 void iree_task_queue_initialize(iree_task_queue_t* out_queue) {
   memset(out_queue, 0, sizeof(*out_queue));
-  iree_slim_mutex_initialize(&out_queue->mutex);
-  iree_task_list_initialize(&out_queue->list);
+  iree_atomic_store_int64(&out_queue->top, 0, iree_memory_order_relaxed);
+  iree_atomic_store_int64(&out_queue->bottom, 0, iree_memory_order_relaxed);
+  iree_task_list_initialize(&out_queue->overflow_list);
 }
 
 void iree_task_queue_deinitialize(iree_task_queue_t* queue) {
-  iree_task_list_discard(&queue->list);
-  iree_slim_mutex_deinitialize(&queue->mutex);
+  // Gather up all tasks still in the deque and discard them with the overflow.
+  iree_task_list_t discard_list;
+  iree_task_list_initialize(&discard_list);
+  iree_task_t* task = NULL;
+  while ((task = iree_task_queue_take_bottom(queue))) {
+    iree_task_list_push_back(&discard_list, task);
+  }
+  iree_task_list_append(&discard_list, &queue->overflow_list);
+  iree_task_list_discard(&discard_list);
 }
 
 bool iree_task_queue_is_empty(iree_task_queue_t* queue) {
-  iree_slim_mutex_lock(&queue->mutex);
-  bool is_empty = iree_task_list_is_empty(&queue->list);
-  iree_slim_mutex_unlock(&queue->mutex);
-  return is_empty;
+  return iree_task_queue_deque_size(queue) <= 0 &&
+         iree_task_list_is_empty(&queue->overflow_list);
 }
 
 void iree_task_queue_push_front(iree_task_queue_t* queue, iree_task_t* task) {
-  iree_slim_mutex_lock(&queue->mutex);
-  iree_task_list_push_front(&queue->list, task);
-  iree_slim_mutex_unlock(&queue->mutex);
+  while (!iree_task_queue_push_bottom(queue, task)) {
+    // Deque is full; move the task at the back of the deque to the front of the
+    // overflow list (which logically follows the deque) to make room. We use
+    // the same path as thieves so if we lose the race there's now space.
+    bool lost_race = false;
+    iree_task_t* back_task = iree_task_queue_steal_top(queue, &lost_race);
+    if (back_task) {
+      iree_task_list_push_front(&queue->overflow_list, back_task);
+    }
+  }
 }
 
 void iree_task_queue_append_from_lifo_list_unsafe(iree_task_queue_t* queue,
                                                   iree_task_list_t* list) {
-  // NOTE: reversing the list outside of the lock.
   iree_task_list_reverse(list);
-  iree_slim_mutex_lock(&queue->mutex);
-  iree_task_list_append(&queue->list, list);
-  iree_slim_mutex_unlock(&queue->mutex);
+  iree_task_queue_append_fifo_list(queue, list);
 }
 
 iree_task_t* iree_task_queue_flush_from_lifo_slist(
     iree_task_queue_t* queue, iree_atomic_task_slist_t* source_slist) {
-  // Perform the flush and swap outside of the lock; acquiring the list is
-  // atomic and then we own it exclusively.
+  // Perform the flush and swap; acquiring the list is atomic and then we own it
+  // exclusively.
   iree_task_list_t suffix;
   iree_task_list_initialize(&suffix);
-  bool did_flush = iree_atomic_task_slist_flush(
-      source_slist, IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_FIFO,
-      &suffix.head, &suffix.tail);
-
-  // Append the tasks and pop off the front for return.
-  iree_slim_mutex_lock(&queue->mutex);
-  if (did_flush) iree_task_list_append(&queue->list, &suffix);
-  iree_task_t* next_task = iree_task_list_pop_front(&queue->list);
-  iree_slim_mutex_unlock(&queue->mutex);
+  if (iree_atomic_task_slist_flush(
+          source_slist, IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_FIFO,
+          &suffix.head, &suffix.tail)) {
+    iree_task_queue_append_fifo_list(queue, &suffix);
+  }
 
-  return next_task;
+  // Pop off the front for return.
+  return iree_task_queue_pop_front(queue);
 }
 
 iree_task_t* iree_task_queue_pop_front(iree_task_queue_t* queue) {
-  iree_slim_mutex_lock(&queue->mutex);
-  iree_task_t* next_task = iree_task_list_pop_front(&queue->list);
-  iree_slim_mutex_unlock(&queue->mutex);
-  return next_task;
+  // Once the deque has drained to half capacity pull in more from the
+  // overflow so that thieves continue to see it; refilling at half keeps the
+  // cost of retaking the remaining deque tasks amortized.
+  if (!iree_task_list_is_empty(&queue->overflow_list) &&
+      iree_task_queue_deque_size(queue) <= IREE_TASK_QUEUE_CAPACITY / 2) {
+    iree_task_queue_refill_from_overflow(queue);
+  }
+  return iree_task_queue_take_bottom(queue);
 }
 
 iree_task_t* iree_task_queue_try_steal(iree_task_queue_t* source_queue,
                                        iree_task_queue_t* target_queue,
                                        iree_host_size_t max_tasks) {
-  // First attempt to steal up to max_tasks from the source queue.
+  // Steal up to half of the tasks in the source queue (rounded up such that a
+  // single remaining task is always stolen). The victim is likely working on
+  // its last items and we can help it out by popping them off.
+  int64_t available = iree_task_queue_deque_size(source_queue);
+  if (available <= 0) return NULL;
+  iree_host_size_t steal_count =
+      iree_min(max_tasks, (iree_host_size_t)((available + 1) / 2));
+
+  // Each task is claimed individually from the top of the victim deque. The
+  // tasks come off back-to-front so we build the stolen list in FIFO order by
+  // pushing each to the front.
   iree_task_list_t stolen_tasks;
   iree_task_list_initialize(&stolen_tasks);
-  iree_slim_mutex_lock(&source_queue->mutex);
-  iree_task_list_split(&source_queue->list, max_tasks, &stolen_tasks);
-  iree_slim_mutex_unlock(&source_queue->mutex);
+  iree_host_size_t stolen_count = 0;
+  while (stolen_count < steal_count) {
+    bool lost_race = false;
+    iree_task_t* task = iree_task_queue_steal_top(source_queue, &lost_race);
+    if (task) {
+      task->flags |= IREE_TASK_FLAG_STOLEN;
+      iree_task_list_push_front(&stolen_tasks, task);
+      ++stolen_count;
+    } else if (!lost_race) {
+      break;  // empty
+    }
+  }
+  if (iree_task_list_is_empty(&stolen_tasks)) return NULL;
 
   // Add any stolen tasks to the target queue and pop off the head for return.
-  iree_task_t* next_task = NULL;
-  if (!iree_task_list_is_empty(&stolen_tasks)) {
-    iree_slim_mutex_lock(&target_queue->mutex);
-    iree_task_list_append(&target_queue->list, &stolen_tasks);
-    next_task = iree_task_list_pop_front(&target_queue->list);
-    iree_slim_mutex_unlock(&target_queue->mutex);
-  }
-  return next_task;
+  iree_task_queue_append_fifo_list(target_queue, &stolen_tasks);
+  return iree_task_queue_pop_front(target_queue);
 }
@@ -16,15 +16,16 @@
 #define IREE_TASK_QUEUE_H_
 
 #include "iree/base/api.h"
-#include "iree/base/synchronization.h"
+#include "iree/base/internal/atomics.h"
 #include "iree/task/list.h"
 #include "iree/task/task.h"
+#include "iree/task/tuning.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif  // __cplusplus
 
-// A simple work-stealing LIFO queue modeled on a Chase-Lev concurrent deque.
+// A work-stealing queue built on a Chase-Lev concurrent deque.
 // This is used by workers to maintain their thread-local working lists. The
 // workers keep the tasks they will process in FIFO order. They allow it to
 // empty and then refresh it with more tasks from the incoming worker mailbox.
@@ -32,19 +33,14 @@ extern "C" {
 // accesses and the only other accesses are thieves that hopefully we can just
 // improve our distribution to vs. introducing a slowdown here.
 //
-// A futex is used to synchronize access; because the common case is that of
-// only the worker that owns the queue touching it for pushing and popping items
-// this puts us into the sweet-spot of uncontended lightweight exclusive locks.
-// Since futices are effectively just single machine words managed with atomic
-// ops we can avoid a lot of the traditional atomic tomfoolery one finds in
-// systems like these that originated prior to the introduction of futices while
-// also keeping the tiny overhead of the pure atomic solutions.
-//
-// We can also take advantage of the futex providing an actual exclusive region
-// such that our data structure can be whatever we want as opposed to needing to
-// be something that someone had figured out how to make atomic. For example,
-// common implementations of work-stealing queues are all bounded as unbounded
-// atomic deques are an unsolved problem in CS.
+// The owning worker pushes and pops at the bottom of the deque with plain
+// loads and stores (plus a single fence on pop) and only needs a CAS when it
+// races a thief for the very last task. Thieves never block each other or the
+// owner: they read the top of the deque and claim the task with a CAS on the
+// top index. Prior to this the queue was an iree_task_list_t guarded by a
+// futex; uncontended that was cheap but with many workers all trying to steal
+// from the same victim (wide dispatches of small tiles on 32+ core machines)
+// the victim ended up fighting every thief for the lock on each pop.
 //
 // Very rarely when another worker runs out of work it'll try to steal tasks
 // from nearby workers and use this queue type to do it: the assumption is that
@@ -55,27 +51,31 @@ extern "C" {
 // cache pessimism for all thieves. Let's hope we can schedule deterministic-
 // enough tiles such that theft is rare!
 //
-// Our queue variant here is tuned for the use case we have: we exclusively
-// push in multiple tasks at a time (flushed from the mailbox) and exclusively
-// pop a single task a time (what to work on next). The stealing part is batched
-// so that when a remote worker has to perform a theft it takes a good chunk of
-// tasks in one go (hopefully roughly half) to reduce the total overhead when
-// there is high imbalance in workloads.
-//
-// Flushing from the mailbox slist (LIFO) to our list (FIFO) requires a full
-// walk of the incoming task linked list. This is generally fine as the number
-// of tasks in any given flush is low(ish) and by walking in reverse order to
-// then process forward the cache should be hot as the worker starts making its
-// way back through the tasks. As we walk forward we'll be using the task fields
-// for execution and retiring of tasks (notifing dependencies/etc) and the
-// intrusive next pointer sitting next to those should be in-cache when we need
-// to access it. This, combined with slab allocation of tasks in command buffers
-// to begin with gives us the (probabilistically) same characteristics of a flat
-// array walked with an index as is common in other work queues but with the
-// flexibility to reorder tasks as we see fit (theft, redistribution/rotation,
-// reprioritization, etc).
-//
-// Similar concepts, though implemented with atomics:
+// To keep the FIFO processing order the owner expects we store the queue
+// "upside down": the front of the queue (next task the owner will run) is at
+// the bottom of the deque and the back of the queue (the task the owner would
+// get to last) is at the top where thieves consume. Lists of tasks appended to
+// the queue are pushed back-to-front so that the first task in the list is the
+// first one popped.
+//
+// Classic Chase-Lev deques either grow by reallocating their ring buffer (and
+// then need some form of deferred reclamation for the old buffer thieves may
+// still be reading) or are bounded. We are bounded to
+// IREE_TASK_QUEUE_CAPACITY tasks and spill anything beyond that into an
+// owner-only overflow list that logically sits behind the deque. Appended tasks
+// are moved into the deque immediately up to its capacity (regardless of how
+// many tasks it already holds) and the owner refills it from the overflow list
+// as it drains. Tasks in the overflow list cannot be stolen, but since they are
+// only ever there when the owner already has a full deque of work thieves have
+// plenty to choose from.
+//
+// Stealing is batched so that when a remote worker has to perform a theft it
+// takes a good chunk of tasks in one go (up to roughly half) to reduce the
+// total overhead when there is high imbalance in workloads. Each task is
+// claimed with its own CAS; claiming a range at once is not safe against a
+// concurrent owner pop in the Chase-Lev protocol.
+//
+// References:
 //   "Dynamic Circular Work-Stealing Deque":
 //   http://citeseerx.ist.psu.edu/viewdoc/download?doi=10.1.1.170.1097&rep=rep1&type=pdf
 //   "Correct and Efficient Work-Stealing for Weak Memory Models":
@@ -84,36 +84,38 @@ extern "C" {
 //   https://blog.molecular-matters.com/2015/08/24/job-system-2-0-lock-free-work-stealing-part-1-basics/
 //
 // Useful diagram from https://github.com/injinj/WSQ
-// Much of this implementation is inspired from that; though significant
-// reworking was required for our FIFO->LIFO->FIFO sandwich.
 //  +--------+ <- tasks[0]
 //  |  top   | <- stealers consume here: task = tasks[top++]
-//  |        |
+//  |        |    (back of our FIFO)
 //  |   ||   |
 //  |        |
 //  |   vv   |
 //  | bottom | <- owner pushes here:    tasks[bottom++] = task
 //  |        |    owner consumes here:  task = tasks[--bottom]
-//  |        |
+//  |        |    (front of our FIFO)
 //  +--------+ <- tasks[IREE_TASK_QUEUE_CAPACITY-1]
-//
-// Unlike that implementation, though, our task list is unbounded because we use
-// a linked list. To keep our options open, though, I've left the API of this
-// implementation compatible with classic atomic work-stealing queues. I'm
-// hopeful this will not need to be revisted for awhile, though!
-//
-// Future improvement idea: have the owner of the queue maintain a theft point
-// skip list that makes it possible for thieves to quickly come in and slice
-// off batches of tasks at the tail of the queue. Since we are a singly-linked
-// list we can't easily just walk backward and we don't want to be introducing
-// cache line contention as thieves start touching the same tasks as the worker
-// is while processing.
 typedef struct {
-  // Must be held when manipulating the queue. >90% accesses are by the owner.
-  iree_slim_mutex_t mutex;
+  // Index of the next task thieves will steal; monotonically increasing.
+  // Thieves (and the owner when racing for the last task) advance this with a
+  // CAS. Indices are 64-bit so that they never wrap in practice.
+  iree_atomic_int64_t top;
+
+  // Keeps thieves hammering on |top| from invalidating the line the owner is
+  // hammering on with |bottom|.
+  uint8_t _top_padding[iree_hardware_destructive_interference_size -
+                       sizeof(iree_atomic_int64_t)];
 
-  // FIFO task list.
-  iree_task_list_t list IREE_GUARDED_BY(mutex);
+  // Index one past the task at the front of the queue. Only written by the
+  // owning worker.
+  iree_atomic_int64_t bottom;
+
+  // Owner-only FIFO list of tasks that logically follow the tasks in the deque.
+  // Populated when the deque is full or when appending to a non-empty deque
+  // (as the owner can only push to the front).
+  iree_task_list_t overflow_list;
+
+  // Ring buffer of iree_task_t* indexed by top/bottom modulo the capacity.
+  iree_atomic_intptr_t tasks[IREE_TASK_QUEUE_CAPACITY];
 } iree_task_queue_t;
 
 // Initializes a work-stealing task queue in-place.
@@ -125,6 +127,8 @@ void iree_task_queue_deinitialize(iree_task_queue_t* queue);
 
 // Returns true if the queue is empty.
 // Note that due to races this may return both false-positives and -negatives.
+//
+// Must only be called from the owning worker's thread.
 bool iree_task_queue_is_empty(iree_task_queue_t* queue);
 
 // Pushes a task to the front of the queue.
@@ -160,7 +164,7 @@ iree_task_t* iree_task_queue_pop_front(iree_task_queue_t* queue);
 // |target_queue| and the first of the stolen tasks is returned.
 //
 // It's expected this is not called from the queue's owning worker, though it's
-// valid to do so.
+// valid to do so. Must only be called from the thread owning |target_queue|.
 iree_task_t* iree_task_queue_try_steal(iree_task_queue_t* source_queue,
                                        iree_task_queue_t* target_queue,
                                        iree_host_size_t max_tasks);
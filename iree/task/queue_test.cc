@@ -14,6 +14,10 @@
 
 #include "iree/task/queue.h"
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
 
@@ -328,4 +332,200 @@ TEST(QueueTest, TryStealAll) {
   iree_task_queue_deinitialize(&target_queue);
 }
 
+TEST(QueueTest, AppendListOverflow) {
+  iree_task_queue_t queue;
+  iree_task_queue_initialize(&queue);
+
+  // Append more tasks than fit in the deque; the remainder should spill into
+  // the overflow list and still be popped in FIFO order.
+  static const int kTaskCount = IREE_TASK_QUEUE_CAPACITY * 2 + 3;
+  std::vector<iree_task_t> tasks(kTaskCount);
+  iree_task_list_t list = {0};
+  for (int i = 0; i < kTaskCount; ++i) {
+    tasks[i] = {0};
+    iree_task_list_push_front(&list, &tasks[i]);
+  }
+  iree_task_queue_append_from_lifo_list_unsafe(&queue, &list);
+  EXPECT_TRUE(iree_task_list_is_empty(&list));
+
+  for (int i = 0; i < kTaskCount; ++i) {
+    EXPECT_FALSE(iree_task_queue_is_empty(&queue));
+    EXPECT_EQ(&tasks[i], iree_task_queue_pop_front(&queue));
+  }
+  EXPECT_TRUE(iree_task_queue_is_empty(&queue));
+  EXPECT_FALSE(iree_task_queue_pop_front(&queue));
+
+  iree_task_queue_deinitialize(&queue);
+}
+
+TEST(QueueTest, TryStealAppendedToNonEmpty) {
+  iree_task_queue_t source_queue;
+  iree_task_queue_initialize(&source_queue);
+  iree_task_queue_t target_queue;
+  iree_task_queue_initialize(&target_queue);
+
+  // The owner has a task queued (such as the remainder of a long running
+  // dispatch) when a batch arrives. The batch must be visible to thieves.
+  iree_task_t task_a = {0};
+  iree_task_queue_push_front(&source_queue, &task_a);
+  static const int kTaskCount = 16;
+  std::vector<iree_task_t> tasks(kTaskCount);
+  iree_task_list_t list = {0};
+  for (int i = 0; i < kTaskCount; ++i) {
+    tasks[i] = {0};
+    iree_task_list_push_front(&list, &tasks[i]);
+  }
+  iree_task_queue_append_from_lifo_list_unsafe(&source_queue, &list);
+
+  // Thieves take from the back: half of the 17 tasks rounded up, the first
+  // of which is returned and the rest left in the target queue.
+  EXPECT_EQ(&tasks[kTaskCount - 9],
+            iree_task_queue_try_steal(&source_queue, &target_queue, 100));
+  for (int i = kTaskCount - 8; i < kTaskCount; ++i) {
+    EXPECT_EQ(&tasks[i], iree_task_queue_pop_front(&target_queue));
+  }
+  EXPECT_TRUE(iree_task_queue_is_empty(&target_queue));
+
+  // The owner still runs its task first followed by the rest of the batch.
+  EXPECT_EQ(&task_a, iree_task_queue_pop_front(&source_queue));
+  for (int i = 0; i < kTaskCount - 9; ++i) {
+    EXPECT_EQ(&tasks[i], iree_task_queue_pop_front(&source_queue));
+  }
+  EXPECT_TRUE(iree_task_queue_is_empty(&source_queue));
+
+  iree_task_queue_deinitialize(&source_queue);
+  iree_task_queue_deinitialize(&target_queue);
+}
+
+TEST(QueueTest, TryStealAppendedOverflow) {
+  iree_task_queue_t source_queue;
+  iree_task_queue_initialize(&source_queue);
+  iree_task_queue_t target_queue;
+  iree_task_queue_initialize(&target_queue);
+
+  // Append two batches that together exceed the deque capacity while the deque
+  // holds a task. Stealing drains the deque and the owner refilling it as it
+  // pops makes the overflow visible again; every task must be seen exactly
+  // once with each queue preserving FIFO order.
+  iree_task_t task_a = {0};
+  iree_task_queue_push_front(&source_queue, &task_a);
+  static const int kTaskCount = IREE_TASK_QUEUE_CAPACITY + 100;
+  std::vector<iree_task_t> tasks(kTaskCount);
+  iree_task_list_t list = {0};
+  for (int i = 0; i < kTaskCount; ++i) {
+    tasks[i] = {0};
+    iree_task_list_push_front(&list, &tasks[i]);
+  }
+  iree_task_queue_append_from_lifo_list_unsafe(&source_queue, &list);
+
+  std::vector<int> hit_counts(kTaskCount + 1, 0);
+  auto record = [&](iree_task_t* task) {
+    ++hit_counts[task == &task_a ? kTaskCount : task - tasks.data()];
+  };
+  int last_owner_index = -1;
+  while (!iree_task_queue_is_empty(&source_queue)) {
+    iree_task_t* task =
+        iree_task_queue_try_steal(&source_queue, &target_queue, 64);
+    while (task) {
+      record(task);
+      task = iree_task_queue_pop_front(&target_queue);
+    }
+    task = iree_task_queue_pop_front(&source_queue);
+    if (!task) continue;
+    record(task);
+    if (task != &task_a) {
+      int index = (int)(task - tasks.data());
+      EXPECT_LT(last_owner_index, index);
+      last_owner_index = index;
+    }
+  }
+  for (int hit_count : hit_counts) EXPECT_EQ(1, hit_count);
+
+  iree_task_queue_deinitialize(&source_queue);
+  iree_task_queue_deinitialize(&target_queue);
+}
+
+TEST(QueueTest, PushFrontFull) {
+  iree_task_queue_t queue;
+  iree_task_queue_initialize(&queue);
+
+  // Fill the deque and then push one more to the front; the task at the back
+  // should be moved into the overflow list and order preserved.
+  static const int kTaskCount = IREE_TASK_QUEUE_CAPACITY + 1;
+  std::vector<iree_task_t> tasks(kTaskCount);
+  for (int i = kTaskCount - 1; i >= 0; --i) {
+    tasks[i] = {0};
+    iree_task_queue_push_front(&queue, &tasks[i]);
+  }
+  for (int i = 0; i < kTaskCount; ++i) {
+    EXPECT_EQ(&tasks[i], iree_task_queue_pop_front(&queue));
+  }
+  EXPECT_TRUE(iree_task_queue_is_empty(&queue));
+
+  iree_task_queue_deinitialize(&queue);
+}
+
+// Runs an owner popping from its queue while several thieves steal from it and
+// ensures every task is processed exactly once.
+TEST(QueueTest, ConcurrentSteal) {
+  static const int kThiefCount = 4;
+  static const int kTaskCount = 64 * 1024;
+
+  iree_task_queue_t source_queue;
+  iree_task_queue_initialize(&source_queue);
+  std::vector<iree_task_t> tasks(kTaskCount);
+  std::vector<std::atomic<int>> hit_counts(kTaskCount);
+  for (auto& hit_count : hit_counts) hit_count = 0;
+  auto process_task = [&](iree_task_t* task) {
+    ++hit_counts[task - tasks.data()];
+  };
+
+  std::atomic<bool> owner_done = {false};
+  std::vector<std::thread> thieves;
+  for (int i = 0; i < kThiefCount; ++i) {
+    thieves.emplace_back([&]() {
+      iree_task_queue_t target_queue;
+      iree_task_queue_initialize(&target_queue);
+      while (!owner_done.load()) {
+        iree_task_t* task =
+            iree_task_queue_try_steal(&source_queue, &target_queue, 8);
+        while (task) {
+          process_task(task);
+          task = iree_task_queue_pop_front(&target_queue);
+        }
+      }
+      iree_task_queue_deinitialize(&target_queue);
+    });
+  }
+
+  // Feed the queue in batches as the worker would when flushing its mailbox.
+  static const int kBatchSize = 100;
+  for (int base = 0; base < kTaskCount; base += kBatchSize) {
+    iree_task_list_t list = {0};
+    for (int i = base; i < std::min(base + kBatchSize, kTaskCount); ++i) {
+      tasks[i] = {0};
+      iree_task_list_push_front(&list, &tasks[i]);
+    }
+    iree_task_queue_append_from_lifo_list_unsafe(&source_queue, &list);
+    iree_task_t* task = NULL;
+    for (int j = 0; j < kBatchSize / 2; ++j) {
+      if (!(task = iree_task_queue_pop_front(&source_queue))) break;
+      process_task(task);
+    }
+  }
+  iree_task_t* task = NULL;
+  while ((task = iree_task_queue_pop_front(&source_queue))) {
+    process_task(task);
+  }
+  owner_done = true;
+  for (auto& thief : thieves) thief.join();
+
+  EXPECT_TRUE(iree_task_queue_is_empty(&source_queue));
+  for (int i = 0; i < kTaskCount; ++i) {
+    ASSERT_EQ(1, hit_counts[i].load()) << "task " << i;
+  }
+
+  iree_task_queue_deinitialize(&source_queue);
+}
+
 }  // namespace
@@ -66,8 +66,9 @@ iree_string_view_t iree_task_scope_name(iree_task_scope_t* scope) {
 
 iree_task_dispatch_statistics_t iree_task_scope_consume_statistics(
     iree_task_scope_t* scope) {
-  iree_task_dispatch_statistics_t result = scope->dispatch_statistics;
-  memset(&scope->dispatch_statistics, 0, sizeof(scope->dispatch_statistics));
+  iree_task_dispatch_statistics_t result;
+  memset(&result, 0, sizeof(result));
+  iree_task_dispatch_statistics_consume(&scope->dispatch_statistics, &result);
   return result;
 }
 
@@ -70,6 +70,18 @@ static void iree_task_cleanup(iree_task_t* task, iree_status_t status) {
   }
 }
 
+// Releases one pending dependency on |dependent_task| and adds it to the
+// |discard_worklist| once all of its predecessors have been discarded. Tasks
+// joining multiple predecessors (barrier targets, partially-ordered command
+// buffer nodes) are reachable along each edge but must be discarded only once.
+static void iree_task_discard_dependent(iree_task_t* dependent_task,
+                                        iree_task_list_t* discard_worklist) {
+  if (iree_atomic_fetch_sub_int32(&dependent_task->pending_dependency_count, 1,
+                                  iree_memory_order_acq_rel) == 1) {
+    iree_task_list_push_front(discard_worklist, dependent_task);
+  }
+}
+
 void iree_task_discard(iree_task_t* task, iree_task_list_t* discard_worklist) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
@@ -80,7 +92,7 @@ void iree_task_discard(iree_task_t* task, iree_task_list_t* discard_worklist) {
   // Almost all tasks will have a completion task; some may have additional
   // dependent tasks (like barriers) that will be handled below.
   if (task->completion_task) {
-    iree_task_list_push_front(discard_worklist, task->completion_task);
+    iree_task_discard_dependent(task->completion_task, discard_worklist);
   }
 
   switch (task->type) {
@@ -91,8 +103,8 @@ void iree_task_discard(iree_task_t* task, iree_task_list_t* discard_worklist) {
     case IREE_TASK_TYPE_BARRIER: {
       iree_task_barrier_t* barrier_task = (iree_task_barrier_t*)task;
       for (uint32_t i = 0; i < barrier_task->dependent_task_count; ++i) {
-        iree_task_list_push_front(discard_worklist,
-                                  barrier_task->dependent_tasks[i]);
+        iree_task_discard_dependent(barrier_task->dependent_tasks[i],
+                                    discard_worklist);
       }
       break;
     }
@@ -352,7 +364,158 @@ static uint32_t iree_task_tile_to_color(
 void iree_task_dispatch_statistics_merge(
     const iree_task_dispatch_statistics_t* source,
     iree_task_dispatch_statistics_t* target) {
-  // TODO(benvanik): statistics.
+#define IREE_TASK_DISPATCH_STATISTICS_MERGE_FIELD(field)                      \
+  {                                                                           \
+    int64_t value = iree_atomic_load_int64(                                   \
+        (iree_atomic_int64_t*)&source->field, iree_memory_order_relaxed);    \
+    if (value) {                                                              \
+      iree_atomic_fetch_add_int64(&target->field, value,                      \
+                                  iree_memory_order_relaxed);                 \
+    }                                                                         \
+  }
+  IREE_TASK_DISPATCH_STATISTICS_MERGE_FIELD(tile_count);
+  IREE_TASK_DISPATCH_STATISTICS_MERGE_FIELD(shard_count);
+  IREE_TASK_DISPATCH_STATISTICS_MERGE_FIELD(stolen_shard_count);
+  IREE_TASK_DISPATCH_STATISTICS_MERGE_FIELD(idle_shard_count);
+  IREE_TASK_DISPATCH_STATISTICS_MERGE_FIELD(worker_wake_count);
+  IREE_TASK_DISPATCH_STATISTICS_MERGE_FIELD(tile_duration_ns);
+  IREE_TASK_DISPATCH_STATISTICS_MERGE_FIELD(shard_duration_ns);
+#undef IREE_TASK_DISPATCH_STATISTICS_MERGE_FIELD
+}
+
+void iree_task_dispatch_statistics_consume(
+    iree_task_dispatch_statistics_t* source,
+    iree_task_dispatch_statistics_t* target) {
+#define IREE_TASK_DISPATCH_STATISTICS_CONSUME_FIELD(field)                  \
+  iree_atomic_fetch_add_int64(                                              \
+      &target->field,                                                       \
+      iree_atomic_exchange_int64(&source->field, 0,                         \
+                                 iree_memory_order_relaxed),                \
+      iree_memory_order_relaxed);
+  IREE_TASK_DISPATCH_STATISTICS_CONSUME_FIELD(tile_count);
+  IREE_TASK_DISPATCH_STATISTICS_CONSUME_FIELD(shard_count);
+  IREE_TASK_DISPATCH_STATISTICS_CONSUME_FIELD(stolen_shard_count);
+  IREE_TASK_DISPATCH_STATISTICS_CONSUME_FIELD(idle_shard_count);
+  IREE_TASK_DISPATCH_STATISTICS_CONSUME_FIELD(worker_wake_count);
+  IREE_TASK_DISPATCH_STATISTICS_CONSUME_FIELD(tile_duration_ns);
+  IREE_TASK_DISPATCH_STATISTICS_CONSUME_FIELD(shard_duration_ns);
+#undef IREE_TASK_DISPATCH_STATISTICS_CONSUME_FIELD
+}
+
+// Returns the current monotonic time if statistics timing is enabled or 0
+// otherwise.
+static inline iree_time_t iree_task_dispatch_statistics_time_now(void) {
+#if IREE_TASK_DISPATCH_STATISTICS_TIMING
+  return iree_time_monotonic_now();
+#else
+  return 0;
+#endif  // IREE_TASK_DISPATCH_STATISTICS_TIMING
+}
+
+// Returns the duration between |start_time_ns| and |end_time_ns| as sampled by
+// iree_task_dispatch_statistics_time_now (0 when timing is disabled).
+static inline int64_t iree_task_dispatch_statistics_duration(
+    iree_time_t start_time_ns, iree_time_t end_time_ns) {
+  return end_time_ns - start_time_ns;
+}
+
+// Locally accumulated shard counters that are published to the shared
+// iree_task_dispatch_statistics_t once the shard completes. Kept as plain
+// values so that the per-tile bookkeeping needs no atomic operations.
+typedef struct {
+  int64_t tile_count;
+  // Tiles and time of the reservations that were timed; see
+  // IREE_TASK_DISPATCH_STATISTICS_TILE_SAMPLE_INTERVAL.
+  int64_t sampled_tile_count;
+  int64_t sampled_tile_duration_ns;
+} iree_task_dispatch_shard_counters_t;
+
+// Adds |value| to a |field| of statistics only accessed by the calling thread.
+// Avoids the cost of an atomic read-modify-write.
+static inline void iree_task_dispatch_statistics_add_local(
+    iree_atomic_int64_t* field, int64_t value) {
+  iree_atomic_store_int64(
+      field, iree_atomic_load_int64(field, iree_memory_order_relaxed) + value,
+      iree_memory_order_relaxed);
+}
+
+// Publishes the |counters| of a shard |task| that executed from
+// |start_time_ns| to |end_time_ns| into |statistics| (which is local to the
+// shard).
+static void iree_task_dispatch_statistics_record_shard(
+    const iree_task_t* task,
+    const iree_task_dispatch_shard_counters_t* counters,
+    iree_time_t start_time_ns, iree_time_t end_time_ns,
+    iree_task_dispatch_statistics_t* statistics) {
+  iree_task_dispatch_statistics_add_local(&statistics->tile_count,
+                                          counters->tile_count);
+  iree_task_dispatch_statistics_add_local(&statistics->shard_count, 1);
+  if (task->flags & IREE_TASK_FLAG_STOLEN) {
+    iree_task_dispatch_statistics_add_local(&statistics->stolen_shard_count,
+                                            1);
+  }
+  if (counters->tile_count == 0) {
+    iree_task_dispatch_statistics_add_local(&statistics->idle_shard_count, 1);
+  }
+#if IREE_TASK_DISPATCH_STATISTICS_TIMING
+  int64_t shard_duration_ns =
+      iree_task_dispatch_statistics_duration(start_time_ns, end_time_ns);
+  int64_t tile_duration_ns = 0;
+  if (counters->sampled_tile_count > 0) {
+    tile_duration_ns = iree_min(
+        shard_duration_ns, counters->sampled_tile_duration_ns *
+                               counters->tile_count /
+                               counters->sampled_tile_count);
+  }
+  iree_task_dispatch_statistics_add_local(&statistics->tile_duration_ns,
+                                          tile_duration_ns);
+  iree_task_dispatch_statistics_add_local(&statistics->shard_duration_ns,
+                                          shard_duration_ns);
+#endif  // IREE_TASK_DISPATCH_STATISTICS_TIMING
+}
+
+// Records the number of workers in |posted_worker_mask| that were idle when the
+// dispatch was issued as woken by |dispatch_task|.
+static void iree_task_dispatch_record_worker_wakes(
+    iree_task_dispatch_t* dispatch_task,
+    iree_task_affinity_set_t idle_worker_mask,
+    iree_task_affinity_set_t posted_worker_mask) {
+  int wake_count =
+      iree_task_affinity_set_count_ones(idle_worker_mask & posted_worker_mask);
+  if (wake_count > 0) {
+    iree_atomic_fetch_add_int64(&dispatch_task->statistics.worker_wake_count,
+                                wake_count, iree_memory_order_relaxed);
+  }
+}
+
+void iree_task_dispatch_profile_initialize(
+    iree_task_dispatch_profile_t* out_profile) {
+  iree_atomic_store_int64(&out_profile->tile_duration_ns, 0,
+                          iree_memory_order_relaxed);
+}
+
+int64_t iree_task_dispatch_profile_tile_duration(
+    const iree_task_dispatch_profile_t* profile) {
+  return iree_atomic_load_int64(
+      (iree_atomic_int64_t*)&profile->tile_duration_ns,
+      iree_memory_order_relaxed);
+}
+
+void iree_task_dispatch_profile_update(iree_task_dispatch_profile_t* profile,
+                                       int64_t tile_duration_ns) {
+  // Clamp so that we can distinguish "measured as really fast" from "never
+  // measured" (0).
+  tile_duration_ns = iree_max(1, tile_duration_ns);
+  int64_t old_duration_ns = iree_task_dispatch_profile_tile_duration(profile);
+  int64_t new_duration_ns =
+      old_duration_ns
+          ? old_duration_ns + (tile_duration_ns - old_duration_ns) / 4
+          : tile_duration_ns;
+  // NOTE: racing updates from concurrent dispatches may drop samples; the
+  // estimate is only a hint and will converge over subsequent dispatches.
+  iree_atomic_store_int64(&profile->tile_duration_ns,
+                          iree_max(1, new_duration_ns),
+                          iree_memory_order_relaxed);
 }
 
 //==============================================================================
@@ -367,7 +530,11 @@ static void iree_task_dispatch_initialize_base(
   memcpy(out_task->workgroup_size, workgroup_size,
          sizeof(out_task->workgroup_size));
   out_task->shared_memory_size = 0;
+  out_task->local_memory_size = 0;
   memset(&out_task->statistics, 0, sizeof(out_task->statistics));
+  out_task->profile = NULL;
+  iree_atomic_store_int64(&out_task->tile_duration_total_ns, 0,
+                          iree_memory_order_relaxed);
 }
 
 void iree_task_dispatch_initialize(iree_task_scope_t* scope,
@@ -389,6 +556,84 @@ void iree_task_dispatch_initialize_indirect(
   out_task->workgroup_count.ptr = workgroup_count_ptr;
 }
 
+// Fetches the workgroup count of |dispatch_task| (directly or indirectly).
+// By the task being ready to execute we know any dependencies on the
+// indirection buffer have been satisfied and its safe to read.
+static void iree_task_dispatch_get_workgroup_count(
+    const iree_task_dispatch_t* dispatch_task,
+    uint32_t out_workgroup_count[3]) {
+  if (dispatch_task->header.flags & IREE_TASK_FLAG_DISPATCH_INDIRECT) {
+    memcpy(out_workgroup_count, dispatch_task->workgroup_count.ptr,
+           3 * sizeof(uint32_t));
+  } else {
+    memcpy(out_workgroup_count, dispatch_task->workgroup_count.value,
+           3 * sizeof(uint32_t));
+  }
+}
+
+// Selects tiling parameters for a profiled dispatch of |tile_count| tiles.
+// Returns false if the dispatch has no profile or the profile has no estimate
+// yet, in which case the fixed tuning parameters should be used instead.
+//
+// On success |out_tiles_per_reservation| is the number of tiles that should be
+// batched together into each slice/shard reservation to hit
+// IREE_TASK_DISPATCH_TARGET_RESERVATION_DURATION_NS and |out_worker_count| is
+// the number of workers (<= |worker_count|) the work should be spread across.
+static bool iree_task_dispatch_select_adaptive_tiling(
+    const iree_task_dispatch_t* dispatch_task, uint32_t tile_count,
+    iree_host_size_t worker_count, uint32_t* out_tiles_per_reservation,
+    iree_host_size_t* out_worker_count) {
+  if (!dispatch_task->profile) return false;
+  int64_t tile_duration_ns =
+      iree_task_dispatch_profile_tile_duration(dispatch_task->profile);
+  if (tile_duration_ns <= 0) return false;
+
+  // Use only as many workers as the dispatch can keep busy for a meaningful
+  // amount of time.
+  int64_t total_duration_ns = tile_duration_ns * (int64_t)tile_count;
+  int64_t useful_worker_count =
+      total_duration_ns / IREE_TASK_DISPATCH_MIN_WORKER_DURATION_NS;
+  iree_host_size_t selected_worker_count = (iree_host_size_t)iree_max(
+      1, iree_min(useful_worker_count,
+                  (int64_t)iree_min(worker_count, tile_count)));
+
+  // Batch tiles to hit the target duration per reservation but ensure that
+  // each worker gets several reservations so that imbalances can be absorbed.
+  int64_t tiles_per_reservation = iree_min(
+      IREE_TASK_DISPATCH_TARGET_RESERVATION_DURATION_NS / tile_duration_ns,
+      IREE_TASK_DISPATCH_MAX_ADAPTIVE_TILES_PER_RESERVATION);
+  int64_t balanced_tiles_per_reservation =
+      tile_count /
+      (selected_worker_count * IREE_TASK_DISPATCH_MIN_RESERVATIONS_PER_WORKER);
+  tiles_per_reservation =
+      iree_min(tiles_per_reservation, balanced_tiles_per_reservation);
+
+  *out_tiles_per_reservation = (uint32_t)iree_max(1, tiles_per_reservation);
+  *out_worker_count = selected_worker_count;
+  return true;
+}
+
+// Returns the current monotonic time if the dispatch is profiled (has a
+// non-NULL |tile_duration_total_ns|) or statistics timing is enabled and 0
+// otherwise.
+static inline iree_time_t iree_task_dispatch_time_now(
+    iree_atomic_int64_t* tile_duration_total_ns) {
+  return tile_duration_total_ns ? iree_time_monotonic_now()
+                                : iree_task_dispatch_statistics_time_now();
+}
+
+// Accumulates the time spent executing tiles from |start_time_ns| to
+// |end_time_ns| into |tile_duration_total_ns| (if profiling).
+static void iree_task_dispatch_accumulate_tile_duration(
+    iree_atomic_int64_t* tile_duration_total_ns, iree_time_t start_time_ns,
+    iree_time_t end_time_ns) {
+  if (!tile_duration_total_ns) return;
+  iree_time_t duration_ns = end_time_ns - start_time_ns;
+  if (duration_ns <= 0) return;
+  iree_atomic_fetch_add_int64(tile_duration_total_ns, duration_ns,
+                              iree_memory_order_relaxed);
+}
+
 void iree_task_dispatch_issue_sliced(iree_task_dispatch_t* dispatch_task,
                                      iree_task_pool_t* slice_task_pool,
                                      iree_task_submission_t* pending_submission,
@@ -400,16 +645,8 @@ void iree_task_dispatch_issue_sliced(iree_task_dispatch_t* dispatch_task,
   dispatch_task->header.flags |= IREE_TASK_FLAG_DISPATCH_RETIRE;
 
   // Fetch the workgroup count (directly or indirectly).
-  // By the task being ready to execute we know any dependencies on the
-  // indirection buffer have been satisfied and its safe to read.
   uint32_t workgroup_count[3];
-  if (dispatch_task->header.flags & IREE_TASK_FLAG_DISPATCH_INDIRECT) {
-    memcpy(workgroup_count, dispatch_task->workgroup_count.ptr,
-           sizeof(workgroup_count));
-  } else {
-    memcpy(workgroup_count, dispatch_task->workgroup_count.value,
-           sizeof(workgroup_count));
-  }
+  iree_task_dispatch_get_workgroup_count(dispatch_task, workgroup_count);
   uint32_t total_workgroup_count =
       workgroup_count[0] * workgroup_count[1] * workgroup_count[2];
   if (total_workgroup_count == 0) {
@@ -428,22 +665,47 @@ void iree_task_dispatch_issue_sliced(iree_task_dispatch_t* dispatch_task,
 #endif  // IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
 
   // Divide up all tiles into slices, our finest-granularity scheduling task.
-  const uint32_t tiles_per_slice_x = IREE_TASK_DISPATCH_TILES_PER_SLICE_X;
-  const uint32_t tiles_per_slice_y = IREE_TASK_DISPATCH_TILES_PER_SLICE_Y;
-  const uint32_t tiles_per_slice_z = IREE_TASK_DISPATCH_TILES_PER_SLICE_Z;
-  uint32_t slice_count_x = iree_max(1, workgroup_count[0] / tiles_per_slice_x);
-  uint32_t slice_count_y = iree_max(1, workgroup_count[1] / tiles_per_slice_y);
-  uint32_t slice_count_z = iree_max(1, workgroup_count[2] / tiles_per_slice_z);
-
-  // Compute how many slices each worker will process.
-  uint32_t slice_count = slice_count_x * slice_count_y * slice_count_z;
+  // If the dispatch is profiled we batch up tiles along X (and then Y once an
+  // entire row fits) such that each slice hits the target duration. Otherwise
+  // we use the fixed tuning parameters.
   iree_host_size_t worker_count = iree_task_post_batch_worker_count(post_batch);
-  uint32_t slices_per_worker = iree_max(1, slice_count / worker_count);
+  uint32_t tiles_per_slice_x = IREE_TASK_DISPATCH_TILES_PER_SLICE_X;
+  uint32_t tiles_per_slice_y = IREE_TASK_DISPATCH_TILES_PER_SLICE_Y;
+  uint32_t tiles_per_slice_z = IREE_TASK_DISPATCH_TILES_PER_SLICE_Z;
+  uint32_t tiles_per_slice = 0;
+  iree_host_size_t used_worker_count = worker_count;
+  if (iree_task_dispatch_select_adaptive_tiling(
+          dispatch_task, total_workgroup_count, worker_count, &tiles_per_slice,
+          &used_worker_count)) {
+    tiles_per_slice_x = iree_min(tiles_per_slice, workgroup_count[0]);
+    tiles_per_slice_y =
+        tiles_per_slice_x == workgroup_count[0]
+            ? iree_min(tiles_per_slice / tiles_per_slice_x, workgroup_count[1])
+            : 1;
+    tiles_per_slice_z = 1;
+    IREE_TRACE_ZONE_APPEND_VALUE(z0, tiles_per_slice);
+  }
+  uint32_t slice_count_x =
+      (workgroup_count[0] + tiles_per_slice_x - 1) / tiles_per_slice_x;
+  uint32_t slice_count_y =
+      (workgroup_count[1] + tiles_per_slice_y - 1) / tiles_per_slice_y;
+  uint32_t slice_count_z =
+      (workgroup_count[2] + tiles_per_slice_z - 1) / tiles_per_slice_z;
+
+  // Compute how many slices each worker will process. Rounded up so that the
+  // remainder is spread over the selected workers instead of spilling onto
+  // workers beyond them.
+  uint32_t slice_count = slice_count_x * slice_count_y * slice_count_z;
+  uint32_t slices_per_worker =
+      (uint32_t)((slice_count + used_worker_count - 1) / used_worker_count);
 
   // Randomize starting worker.
   iree_host_size_t worker_offset = iree_task_post_batch_select_worker(
       post_batch, dispatch_task->header.affinity_set);
   iree_host_size_t worker_index = worker_offset;
+  iree_task_affinity_set_t idle_worker_mask =
+      iree_task_post_batch_idle_worker_mask(post_batch);
+  iree_task_affinity_set_t posted_worker_mask = 0;
 
   // TODO(benvanik): rework this with some science. For now we just iteratively
   // divide up the space from outer->inner scheduling dimension, but ideally
@@ -478,6 +740,8 @@ void iree_task_dispatch_issue_sliced(iree_task_dispatch_t* dispatch_task,
         // Enqueue on the worker selected for the task.
         iree_task_post_batch_enqueue(post_batch, worker_index % worker_count,
                                      &slice_task->header);
+        posted_worker_mask |=
+            iree_task_affinity_for_worker(worker_index % worker_count);
         if (++worker_slice_count >= slices_per_worker) {
           ++worker_index;
           worker_slice_count = 0;
@@ -486,6 +750,13 @@ void iree_task_dispatch_issue_sliced(iree_task_dispatch_t* dispatch_task,
     }
   }
 
+  iree_task_dispatch_record_worker_wakes(dispatch_task, idle_worker_mask,
+                                         posted_worker_mask);
+  iree_atomic_fetch_add_int64(&dispatch_task->statistics.tile_count,
+                              total_workgroup_count, iree_memory_order_relaxed);
+  iree_atomic_fetch_add_int64(&dispatch_task->statistics.shard_count,
+                              slice_count, iree_memory_order_relaxed);
+
   // NOTE: the dispatch is not retired until all slices complete. Upon the last
   // slice completing the lucky worker will retire the task inline and
   // potentially queue up more ready tasks that follow.
@@ -515,15 +786,8 @@ void iree_task_dispatch_issue_sharded(
   shared_state->dispatch_task = dispatch_task;
 
   // Fetch the workgroup count (directly or indirectly).
-  // By the task being ready to execute we know any dependencies on the
-  // indirection buffer have been satisfied and its safe to read.
-  if (dispatch_task->header.flags & IREE_TASK_FLAG_DISPATCH_INDIRECT) {
-    memcpy(shared_state->workgroup_count, dispatch_task->workgroup_count.ptr,
-           sizeof(shared_state->workgroup_count));
-  } else {
-    memcpy(shared_state->workgroup_count, dispatch_task->workgroup_count.value,
-           sizeof(shared_state->workgroup_count));
-  }
+  iree_task_dispatch_get_workgroup_count(dispatch_task,
+                                         shared_state->workgroup_count);
 
 #if IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
   char xyz_string[32];
@@ -555,8 +819,15 @@ void iree_task_dispatch_issue_sharded(
   // Compute how many tiles we want each shard to reserve at a time from the
   // larger grid. A higher number reduces overhead and improves locality while
   // a lower number reduces maximum worst-case latency (coarser work stealing).
-  if (shared_state->tile_count <
-      worker_count * IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION) {
+  // If the dispatch is profiled we derive both the reservation size and the
+  // shard count from the measured tile duration.
+  if (iree_task_dispatch_select_adaptive_tiling(
+          dispatch_task, shared_state->tile_count, worker_count,
+          &shared_state->tiles_per_reservation, &shard_count)) {
+    IREE_TRACE_ZONE_APPEND_VALUE(z0, shared_state->tiles_per_reservation);
+  } else if (shared_state->tile_count <
+             worker_count *
+                 IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION) {
     // Grid is small - allow it to be eagerly sliced up.
     shared_state->tiles_per_reservation = 1;
   } else {
@@ -568,6 +839,9 @@ void iree_task_dispatch_issue_sharded(
   iree_host_size_t worker_offset = iree_task_post_batch_select_worker(
       post_batch, dispatch_task->header.affinity_set);
   iree_host_size_t worker_index = worker_offset;
+  iree_task_affinity_set_t idle_worker_mask =
+      iree_task_post_batch_idle_worker_mask(post_batch);
+  iree_task_affinity_set_t posted_worker_mask = 0;
 
   for (iree_host_size_t i = 0; i < shard_count; ++i) {
     // Allocate and initialize the shard.
@@ -577,9 +851,14 @@ void iree_task_dispatch_issue_sharded(
     // Enqueue on the worker selected for the task.
     iree_task_post_batch_enqueue(post_batch, worker_index % worker_count,
                                  &shard_task->header);
+    posted_worker_mask |=
+        iree_task_affinity_for_worker(worker_index % worker_count);
     ++worker_index;
   }
 
+  iree_task_dispatch_record_worker_wakes(dispatch_task, idle_worker_mask,
+                                         posted_worker_mask);
+
   // NOTE: the dispatch is not retired until all shards complete. Upon the last
   // shard completing the lucky worker will retire the task inline and
   // potentially queue up more ready tasks that follow.
@@ -600,6 +879,21 @@ void iree_task_dispatch_retire(iree_task_dispatch_t* dispatch_task,
 
   // TODO(benvanik): attach statistics to the tracy zone.
 
+  // Fold the measured per-tile duration into the profile so that subsequent
+  // dispatches of the same function can be tiled based on it.
+  if (dispatch_task->profile) {
+    int64_t tile_duration_total_ns = iree_atomic_load_int64(
+        &dispatch_task->tile_duration_total_ns, iree_memory_order_relaxed);
+    uint32_t workgroup_count[3];
+    iree_task_dispatch_get_workgroup_count(dispatch_task, workgroup_count);
+    uint32_t tile_count =
+        workgroup_count[0] * workgroup_count[1] * workgroup_count[2];
+    if (tile_duration_total_ns > 0 && tile_count > 0) {
+      iree_task_dispatch_profile_update(dispatch_task->profile,
+                                        tile_duration_total_ns / tile_count);
+    }
+  }
+
   // Merge the statistics from the dispatch into the scope so we can track all
   // of the work without tracking all the dispatches at a global level.
   iree_task_dispatch_statistics_merge(
@@ -637,11 +931,15 @@ void iree_task_dispatch_slice_initialize(iree_task_dispatch_t* dispatch_task,
   // We'll have to ensure we have the memory available prior to scheduling the
   // dispatch and probably just pass it in as an argument in here.
   out_task->shared_memory = iree_make_byte_span(NULL, 0);
+  out_task->local_memory_size = dispatch_task->local_memory_size;
 
   // Wire up dispatch statistics; we'll track on the slice while we run and
   // then the per-slice statistics will roll up into the dispatch statistics.
   out_task->dispatch_statistics = &dispatch_task->statistics;
   memset(&out_task->slice_statistics, 0, sizeof(out_task->slice_statistics));
+
+  out_task->tile_duration_total_ns =
+      dispatch_task->profile ? &dispatch_task->tile_duration_total_ns : NULL;
 }
 
 iree_task_dispatch_slice_t* iree_task_dispatch_slice_allocate(
@@ -663,7 +961,8 @@ iree_task_dispatch_slice_t* iree_task_dispatch_slice_allocate(
 }
 
 iree_status_t iree_task_dispatch_slice_execute(
-    iree_task_dispatch_slice_t* task,
+    iree_task_dispatch_slice_t* task, uint32_t worker_id,
+    uint32_t worker_count, iree_byte_span_t local_memory,
     iree_task_submission_t* pending_submission) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
@@ -678,8 +977,17 @@ iree_status_t iree_task_dispatch_slice_execute(
   memcpy(&tile_context.workgroup_count, task->workgroup_count,
          sizeof(tile_context.workgroup_count));
   tile_context.shared_memory = task->shared_memory;
+  tile_context.worker_id = worker_id;
+  tile_context.worker_count = worker_count;
+  tile_context.local_memory = local_memory;
   tile_context.statistics = &task->slice_statistics;
 
+  // Sample the clock if the dispatch is being profiled or statistics timing is
+  // enabled. Slices have no scheduling work between tiles and the whole range
+  // is timed at once.
+  iree_time_t start_time_ns =
+      iree_task_dispatch_time_now(task->tile_duration_total_ns);
+
   const uint32_t base_x = task->workgroup_base[0];
   const uint32_t base_y = task->workgroup_base[1];
   const uint32_t base_z = task->workgroup_base[2];
@@ -718,6 +1026,28 @@ iree_status_t iree_task_dispatch_slice_execute(
     }
   }
 
+  iree_time_t end_time_ns =
+      iree_task_dispatch_time_now(task->tile_duration_total_ns);
+  iree_task_dispatch_accumulate_tile_duration(task->tile_duration_total_ns,
+                                              start_time_ns, end_time_ns);
+
+  // Slice and tile counts are added to the dispatch in bulk when it is issued
+  // so that only what can't be known up-front is tracked per slice. As there is
+  // no scheduling work between the tiles of a slice the entire slice duration
+  // is attributed to the tiles.
+  if (task->header.flags & IREE_TASK_FLAG_STOLEN) {
+    iree_task_dispatch_statistics_add_local(
+        &task->slice_statistics.stolen_shard_count, 1);
+  }
+#if IREE_TASK_DISPATCH_STATISTICS_TIMING
+  int64_t duration_ns =
+      iree_task_dispatch_statistics_duration(start_time_ns, end_time_ns);
+  iree_task_dispatch_statistics_add_local(
+      &task->slice_statistics.tile_duration_ns, duration_ns);
+  iree_task_dispatch_statistics_add_local(
+      &task->slice_statistics.shard_duration_ns, duration_ns);
+#endif  // IREE_TASK_DISPATCH_STATISTICS_TIMING
+
   // Push aggregate statistics up to the dispatch.
   if (task->dispatch_statistics) {
     iree_task_dispatch_statistics_merge(&task->slice_statistics,
@@ -729,6 +1059,13 @@ iree_status_t iree_task_dispatch_slice_execute(
   return iree_ok_status();
 }
 
+void iree_task_dispatch_slice_fail(iree_task_dispatch_slice_t* task,
+                                   iree_status_t status,
+                                   iree_task_submission_t* pending_submission) {
+  iree_task_scope_fail(task->header.scope, &task->header, status);
+  iree_task_retire(&task->header, pending_submission);
+}
+
 //==============================================================================
 // IREE_TASK_TYPE_DISPATCH_SHARD
 //==============================================================================
@@ -760,7 +1097,8 @@ iree_task_dispatch_shard_t* iree_task_dispatch_shard_allocate(
 }
 
 iree_status_t iree_task_dispatch_shard_execute(
-    iree_task_dispatch_shard_t* task,
+    iree_task_dispatch_shard_t* task, uint32_t worker_id,
+    uint32_t worker_count, iree_byte_span_t local_memory,
     iree_task_submission_t* pending_submission) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
@@ -774,6 +1112,9 @@ iree_status_t iree_task_dispatch_shard_execute(
   memcpy(&tile_context.workgroup_count, task->shared_state->workgroup_count,
          sizeof(tile_context.workgroup_count));
   tile_context.shared_memory = shared_state->shared_memory;
+  tile_context.worker_id = worker_id;
+  tile_context.worker_count = worker_count;
+  tile_context.local_memory = local_memory;
   uint32_t workgroup_count_x = tile_context.workgroup_count[0];
   uint32_t workgroup_count_y = tile_context.workgroup_count[1];
 
@@ -784,6 +1125,16 @@ iree_status_t iree_task_dispatch_shard_execute(
   memset(&shard_statistics, 0, sizeof(shard_statistics));
   tile_context.statistics = &shard_statistics;
 
+  // Sample the clock if the dispatch is being profiled or statistics timing is
+  // enabled.
+  iree_atomic_int64_t* tile_duration_total_ns =
+      dispatch_task->profile ? &dispatch_task->tile_duration_total_ns : NULL;
+  iree_time_t start_time_ns =
+      iree_task_dispatch_time_now(tile_duration_total_ns);
+  uint32_t reservations_until_sample = 0;
+  iree_task_dispatch_shard_counters_t counters;
+  memset(&counters, 0, sizeof(counters));
+
   // Loop over all tiles until they are all processed.
   const uint32_t tile_count = shared_state->tile_count;
   const uint32_t tiles_per_reservation = shared_state->tiles_per_reservation;
@@ -797,6 +1148,18 @@ iree_status_t iree_task_dispatch_shard_execute(
 
     const uint32_t tile_range =
         iree_min(tile_base + tiles_per_reservation, tile_count);
+    counters.tile_count += tile_range - tile_base;
+
+    // Only time every Nth reservation so that the clock reads don't dominate
+    // when tiles are small.
+    const bool sample_reservation = IREE_TASK_DISPATCH_STATISTICS_TIMING &&
+                                    reservations_until_sample-- == 0;
+    if (sample_reservation) {
+      reservations_until_sample =
+          IREE_TASK_DISPATCH_STATISTICS_TILE_SAMPLE_INTERVAL - 1;
+    }
+    iree_time_t reservation_start_time_ns =
+        sample_reservation ? iree_time_monotonic_now() : 0;
     for (uint32_t tile_index = tile_base; tile_index < tile_range;
          ++tile_index) {
       // TODO(benvanik): faster math here, especially knowing we pull off N
@@ -832,9 +1195,22 @@ iree_status_t iree_task_dispatch_shard_execute(
       }
     }
 
+    if (sample_reservation) {
+      counters.sampled_tile_count += tile_range - tile_base;
+      counters.sampled_tile_duration_ns +=
+          iree_task_dispatch_statistics_duration(reservation_start_time_ns,
+                                                 iree_time_monotonic_now());
+    }
     tile_base = next_tile_base;
   }
 
+  iree_time_t end_time_ns = iree_task_dispatch_time_now(tile_duration_total_ns);
+  iree_task_dispatch_accumulate_tile_duration(tile_duration_total_ns,
+                                              start_time_ns, end_time_ns);
+  iree_task_dispatch_statistics_record_shard(&task->header, &counters,
+                                             start_time_ns, end_time_ns,
+                                             &shard_statistics);
+
   // Push aggregate statistics up to the dispatch.
   iree_task_dispatch_statistics_merge(&shard_statistics,
                                       &dispatch_task->statistics);
@@ -843,3 +1219,10 @@ iree_status_t iree_task_dispatch_shard_execute(
   IREE_TRACE_ZONE_END(z0);
   return iree_ok_status();
 }
+
+void iree_task_dispatch_shard_fail(iree_task_dispatch_shard_t* task,
+                                   iree_status_t status,
+                                   iree_task_submission_t* pending_submission) {
+  iree_task_scope_fail(task->header.scope, &task->header, status);
+  iree_task_retire(&task->header, pending_submission);
+}
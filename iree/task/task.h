@@ -116,6 +116,10 @@ enum iree_task_flags_e {
   // behavior but without an additional task as dispatches are still required
   // to store information for slices.
   IREE_TASK_FLAG_DISPATCH_RETIRE = 1u << 3,
+
+  // The task was stolen from the worker it was originally posted to by another
+  // worker. Only used for statistics.
+  IREE_TASK_FLAG_STOLEN = 1u << 4,
 };
 typedef uint16_t iree_task_flags_t;
 
@@ -209,7 +213,8 @@ bool iree_task_is_ready(iree_task_t* task);
 
 // Discards the task and any dependent tasks.
 // Any dependent tasks that need to be discarded will be added to
-// |discard_worklist| for the caller to continue discarding.
+// |discard_worklist| for the caller to continue discarding. A dependent task
+// is added only once all of its pending dependencies have been discarded.
 void iree_task_discard(iree_task_t* task, iree_task_list_t* discard_worklist);
 
 //==============================================================================
@@ -390,9 +395,31 @@ void iree_task_wait_initialize(iree_task_scope_t* scope,
 // If we find ourselves with a lot of hardware-specific counters (vs more
 // generic ones like 'l2 cache misses' or 'ipc') then we can sprinkle in some
 // #ifdefs.
+//
+// The executor populates the counters below as slices/shards complete; tile
+// functions are free to add to them as well (for example to report their own
+// work) via the iree_task_tile_context_t::statistics pointer.
 typedef struct {
-  // TODO(benvanik): statistics counters.
-  iree_atomic_int32_t reserved;
+  // Total number of tiles executed.
+  iree_atomic_int64_t tile_count;
+  // Total number of slices/shards executed.
+  iree_atomic_int64_t shard_count;
+  // Number of slices/shards executed by a worker that stole them from the
+  // worker they were originally posted to. shard_count - stolen_shard_count
+  // were executed by the worker they were posted to.
+  iree_atomic_int64_t stolen_shard_count;
+  // Number of slices/shards that found no tiles remaining to execute by the
+  // time they ran (other shards had completed the whole grid).
+  iree_atomic_int64_t idle_shard_count;
+  // Number of workers that were idle when the dispatch was issued and had to
+  // be woken to process slices/shards posted to them.
+  iree_atomic_int64_t worker_wake_count;
+  // Total time spent within tile functions in nanoseconds.
+  iree_atomic_int64_t tile_duration_ns;
+  // Total time spent executing slices/shards in nanoseconds. The difference
+  // between this and tile_duration_ns is the scheduling overhead of tile
+  // reservation and bookkeeping.
+  iree_atomic_int64_t shard_duration_ns;
 } iree_task_dispatch_statistics_t;
 
 // Merges statistics from |source| to |target| atomically per-field.
@@ -402,6 +429,47 @@ void iree_task_dispatch_statistics_merge(
     const iree_task_dispatch_statistics_t* source,
     iree_task_dispatch_statistics_t* target);
 
+// Atomically moves statistics from |source| to |target| per-field, resetting
+// |source| to zero. Counters added to |source| concurrently are either moved
+// or retained for the next consumer but never lost.
+void iree_task_dispatch_statistics_consume(
+    iree_task_dispatch_statistics_t* source,
+    iree_task_dispatch_statistics_t* target);
+
+// Execution profile shared across all dispatches of the same function (such as
+// a particular executable entry point) used to adaptively tile dispatches.
+//
+// When a dispatch references a profile the task system measures the time spent
+// executing its tiles and folds the per-tile duration into the profile upon
+// completion. Subsequent dispatches referencing the same profile then use the
+// estimate to select how many tiles are batched together per slice/shard
+// reservation and how many workers to spread the dispatch across such that
+// each unit of scheduled work takes roughly
+// IREE_TASK_DISPATCH_TARGET_RESERVATION_DURATION_NS.
+//
+// Profiles are updated without synchronization beyond the atomic access of the
+// value itself; concurrent dispatches using the same profile may drop samples.
+// Callers must ensure that profiles remain live until all dispatches
+// referencing them have completed.
+typedef struct {
+  // Moving average of the duration of a single tile in nanoseconds or 0 if no
+  // dispatch using the profile has completed yet.
+  iree_atomic_int64_t tile_duration_ns;
+} iree_task_dispatch_profile_t;
+
+// Initializes |out_profile| with no measurements.
+void iree_task_dispatch_profile_initialize(
+    iree_task_dispatch_profile_t* out_profile);
+
+// Returns the estimated duration of a single tile in nanoseconds or 0 if no
+// measurement has been made yet.
+int64_t iree_task_dispatch_profile_tile_duration(
+    const iree_task_dispatch_profile_t* profile);
+
+// Folds a measured |tile_duration_ns| into the |profile| moving average.
+void iree_task_dispatch_profile_update(iree_task_dispatch_profile_t* profile,
+                                       int64_t tile_duration_ns);
+
 typedef struct {
   // TODO(benvanik): coroutine storage.
   // Ideally we'll be able to have a fixed coroutine storage size per dispatch
@@ -429,15 +497,27 @@ typedef iree_alignas(iree_max_align_t) struct {
   // TODO(benvanik): workgroup index to amortize calculating linear offsets.
   // (like gl_GlobalInvocationID)
 
+  // Index of the worker executing the tile in [0, worker_count). Stable for the
+  // duration of the tile and can be used to index per-worker storage such as
+  // partial accumulators without synchronization.
+  uint32_t worker_id;
+  // Total number of workers in the executor that may execute tiles.
+  uint32_t worker_count;
+
   // Incoherent memory shared across all invocations of the task.
   // Aligned to at least the natural pointer size of the machine. Functions must
   // use atomic operations to ensure proper memory ordering.
   iree_byte_span_t shared_memory;
 
+  // Scratch memory local to the worker executing the tile of at least the
+  // iree_task_dispatch_t::local_memory_size requested by the dispatch.
+  // Aligned to at least iree_max_align_t. Contents are undefined on entry and
+  // will be overwritten by other tiles executed on the same worker.
+  iree_byte_span_t local_memory;
+
   // Shared statistics counters for the dispatch slice.
   iree_task_dispatch_statistics_t* statistics;
 
-  // TODO(benvanik): cpuid uarch.
   // TODO(benvanik): per-tile coroutine storage.
 } iree_task_tile_context_t;
 
@@ -547,9 +627,24 @@ typedef iree_alignas(iree_max_align_t) struct iree_task_dispatch_s {
   // closure.
   iree_host_size_t shared_memory_size;
 
+  // Minimum size of the worker-local scratch memory passed into the
+  // iree_task_tile_context_t::local_memory of each invocation of the task
+  // closure. Workers grow their local memory as needed up to
+  // IREE_TASK_WORKER_MAX_LOCAL_MEMORY_SIZE.
+  iree_host_size_t local_memory_size;
+
   // Statistics storage used for aggregating counters across all slices.
   iree_task_dispatch_statistics_t statistics;
 
+  // Optional execution profile used to adaptively tile the dispatch. When set
+  // the dispatch will be tiled based on the profile estimate and the measured
+  // tile duration will be folded back into the profile when it completes.
+  iree_task_dispatch_profile_t* profile;
+
+  // Total time spent executing tiles across all slices/shards in nanoseconds.
+  // Only tracked when |profile| is set.
+  iree_atomic_int64_t tile_duration_total_ns;
+
   // Shared state across all slices/shards/etc.
   // Stored once per dispatch and then referenced by all subtasks.
   union {
@@ -621,6 +716,10 @@ typedef iree_alignas(iree_max_align_t) struct {
   // use atomic operations to ensure proper memory ordering.
   iree_byte_span_t shared_memory;
 
+  // Minimum size of the worker-local memory required by each tile (same as the
+  // local_memory_size in the dispatch).
+  iree_host_size_t local_memory_size;
+
   // Shared statistics counters for the entire dispatch. References the storage
   // held in the parent iree_task_dispatch_t.
   iree_task_dispatch_statistics_t* dispatch_statistics;
@@ -629,6 +728,10 @@ typedef iree_alignas(iree_max_align_t) struct {
   // contention on the shared dispatch statistics across multiple threads.
   iree_task_dispatch_statistics_t slice_statistics;
 
+  // Total tile execution time of the parent dispatch that the slice adds its
+  // own execution time to. NULL if the dispatch is not being profiled.
+  iree_atomic_int64_t* tile_duration_total_ns;
+
   // Per-tile initialized coroutine storage for all tiles in the range
   // initialized as each tile begins execution.
   // TODO(benvanik): coroutine storage as iree_task_tile_storage_t.
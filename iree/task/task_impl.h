@@ -128,14 +128,27 @@ iree_task_dispatch_slice_t* iree_task_dispatch_slice_allocate(
     iree_task_pool_t* slice_task_pool);
 
 // Executes and retires a dispatch slice task.
+// |worker_id| and |worker_count| identify the calling worker to each tile.
+// |local_memory| must be at least the local_memory_size of the slice and is
+// passed to every tile executed.
 // May block the caller for an indeterminate amount of time and should only be
 // called from threads owned by or donated to the executor.
 // Returns ok if all tiles were successfully executed and otherwise returns
 // an unspecified status (probably the first non-ok status hit).
 iree_status_t iree_task_dispatch_slice_execute(
-    iree_task_dispatch_slice_t* task,
+    iree_task_dispatch_slice_t* task, uint32_t worker_id,
+    uint32_t worker_count, iree_byte_span_t local_memory,
     iree_task_submission_t* pending_submission);
 
+// Fails a dispatch slice task that cannot be executed (such as when the
+// worker local memory it requires cannot be reserved). |status| is recorded as
+// the failure of the scope and the slice is retired without executing any
+// tiles so that the dispatch still completes and scope waiters observe the
+// failure. Takes ownership of |status|.
+void iree_task_dispatch_slice_fail(iree_task_dispatch_slice_t* task,
+                                   iree_status_t status,
+                                   iree_task_submission_t* pending_submission);
+
 //==============================================================================
 // IREE_TASK_TYPE_DISPATCH_SHARD
 //==============================================================================
@@ -148,15 +161,28 @@ iree_task_dispatch_shard_t* iree_task_dispatch_shard_allocate(
     iree_task_pool_t* shard_task_pool);
 
 // Executes and retires a dispatch shard task.
+// |worker_id| and |worker_count| identify the calling worker to each tile.
+// |local_memory| must be at least the local_memory_size of the dispatch and is
+// passed to every tile executed.
 // May block the caller for an indeterminate amount of time and should only be
 // called from threads owned by or donated to the executor.
 // Returns ok if all tiles processed in the shard successfully executed and
 // otherwise returns an unspecified status (probably the first non-ok status
 // hit).
 iree_status_t iree_task_dispatch_shard_execute(
-    iree_task_dispatch_shard_t* task,
+    iree_task_dispatch_shard_t* task, uint32_t worker_id,
+    uint32_t worker_count, iree_byte_span_t local_memory,
     iree_task_submission_t* pending_submission);
 
+// Fails a dispatch shard task that cannot be executed (such as when the worker
+// local memory it requires cannot be reserved). |status| is recorded as the
+// failure of the scope and the shard is retired without reserving any tiles;
+// other shards of the dispatch still process the remaining tiles. Takes
+// ownership of |status|.
+void iree_task_dispatch_shard_fail(iree_task_dispatch_shard_t* task,
+                                   iree_status_t status,
+                                   iree_task_submission_t* pending_submission);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
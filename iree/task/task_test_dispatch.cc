@@ -15,6 +15,7 @@
 #include <vector>
 
 #include "iree/task/testing/task_test.h"
+#include "iree/task/tuning.h"
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
 
@@ -70,7 +71,8 @@ class TaskDispatchTest : public TaskTest {
  public:
   void DispatchAndVerifyGrid(const uint32_t workgroup_size[3],
                              const uint32_t workgroup_count[3],
-                             uint32_t dispatch_flags) {
+                             uint32_t dispatch_flags,
+                             iree_task_dispatch_profile_t* profile = NULL) {
     GridCoverage coverage(workgroup_count);
     iree_task_dispatch_t task;
     iree_task_dispatch_initialize(&scope_,
@@ -78,6 +80,7 @@ class TaskDispatchTest : public TaskTest {
                                       GridCoverage::Tile, (uintptr_t)&coverage),
                                   workgroup_size, workgroup_count, &task);
     task.header.flags |= dispatch_flags;
+    task.profile = profile;
     IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
     EXPECT_TRUE(coverage.Verify());
   }
@@ -135,6 +138,226 @@ TEST_F(TaskDispatchTest, Issue345Sliced) {
                         IREE_TASK_FLAG_DISPATCH_SLICED);
 }
 
+TEST_F(TaskDispatchTest, IssueUnevenSliced) {
+  // Not a multiple of IREE_TASK_DISPATCH_TILES_PER_SLICE_X; the trailing tiles
+  // must still be covered by a partial slice.
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {IREE_TASK_DISPATCH_TILES_PER_SLICE_X + 3,
+                                       2, 1};
+  DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount,
+                        IREE_TASK_FLAG_DISPATCH_SLICED);
+}
+
+// Profiled dispatches record their tile duration on completion.
+TEST_F(TaskDispatchTest, ProfileUpdated) {
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {3, 4, 5};
+  for (uint32_t flags : {0u, (uint32_t)IREE_TASK_FLAG_DISPATCH_SLICED}) {
+    iree_task_dispatch_profile_t profile;
+    iree_task_dispatch_profile_initialize(&profile);
+    EXPECT_EQ(0, iree_task_dispatch_profile_tile_duration(&profile));
+    DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, flags, &profile);
+    EXPECT_GT(iree_task_dispatch_profile_tile_duration(&profile), 0);
+  }
+}
+
+// Dispatch statistics are rolled up into the scope and reset on consume.
+TEST_F(TaskDispatchTest, Statistics) {
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {37, 13, 3};
+  for (uint32_t flags : {0u, (uint32_t)IREE_TASK_FLAG_DISPATCH_SLICED}) {
+    iree_task_scope_consume_statistics(&scope_);
+    DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, flags);
+    iree_task_dispatch_statistics_t statistics =
+        iree_task_scope_consume_statistics(&scope_);
+    auto load = [](iree_atomic_int64_t* value) {
+      return iree_atomic_load_int64(value, iree_memory_order_relaxed);
+    };
+    EXPECT_EQ(37 * 13 * 3, load(&statistics.tile_count));
+    EXPECT_GE(load(&statistics.shard_count), 1);
+    EXPECT_LE(load(&statistics.stolen_shard_count),
+              load(&statistics.shard_count));
+    EXPECT_LE(load(&statistics.idle_shard_count),
+              load(&statistics.shard_count));
+#if IREE_TASK_DISPATCH_STATISTICS_TIMING
+    EXPECT_GT(load(&statistics.tile_duration_ns), 0);
+    EXPECT_GT(load(&statistics.shard_duration_ns), 0);
+    EXPECT_LE(load(&statistics.tile_duration_ns),
+              load(&statistics.shard_duration_ns));
+#else
+    EXPECT_EQ(0, load(&statistics.tile_duration_ns));
+    EXPECT_EQ(0, load(&statistics.shard_duration_ns));
+#endif  // IREE_TASK_DISPATCH_STATISTICS_TIMING
+
+    statistics = iree_task_scope_consume_statistics(&scope_);
+    EXPECT_EQ(0, load(&statistics.tile_count));
+    EXPECT_EQ(0, load(&statistics.shard_count));
+  }
+}
+
+// Tiles receive worker-local memory of at least the requested size, growing
+// the preallocated worker memory when required.
+TEST_F(TaskDispatchTest, LocalMemory) {
+  struct LocalMemoryCheck {
+    iree_host_size_t local_memory_size;
+    iree_atomic_int32_t failure_count;
+    static iree_status_t Tile(uintptr_t user_context,
+                              const iree_task_tile_context_t* tile_context,
+                              iree_task_submission_t* pending_submission) {
+      auto* check = reinterpret_cast<LocalMemoryCheck*>(user_context);
+      iree_byte_span_t local_memory = tile_context->local_memory;
+      if (local_memory.data_length < check->local_memory_size ||
+          ((uintptr_t)local_memory.data % iree_max_align_t) != 0) {
+        iree_atomic_fetch_add_int32(&check->failure_count, 1,
+                                    iree_memory_order_relaxed);
+        return iree_ok_status();
+      }
+      // Touch the whole requested range to catch undersized allocations.
+      memset(local_memory.data, tile_context->workgroup_xyz[0] & 0xFF,
+             check->local_memory_size);
+      return iree_ok_status();
+    }
+  };
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {31, 3, 1};
+  for (uint32_t flags : {0u, (uint32_t)IREE_TASK_FLAG_DISPATCH_SLICED}) {
+    for (iree_host_size_t local_memory_size :
+         {(iree_host_size_t)0, (iree_host_size_t)1024,
+          (iree_host_size_t)IREE_TASK_WORKER_DEFAULT_LOCAL_MEMORY_SIZE * 3}) {
+      LocalMemoryCheck check;
+      check.local_memory_size = local_memory_size;
+      check.failure_count = IREE_ATOMIC_VAR_INIT(0);
+      iree_task_dispatch_t task;
+      iree_task_dispatch_initialize(
+          &scope_,
+          iree_task_make_dispatch_closure(LocalMemoryCheck::Tile,
+                                          (uintptr_t)&check),
+          kWorkgroupSize, kWorkgroupCount, &task);
+      task.header.flags |= flags;
+      task.local_memory_size = local_memory_size;
+      IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+      EXPECT_EQ(0, iree_atomic_load_int32(&check.failure_count,
+                                          iree_memory_order_relaxed));
+    }
+  }
+}
+
+// Dispatches requiring more local memory than workers can provide fail the
+// scope and still complete instead of hanging; no tile runs without its memory.
+TEST_F(TaskDispatchTest, LocalMemoryExhausted) {
+  struct TileCounter {
+    iree_atomic_int32_t tile_count;
+    static iree_status_t Tile(uintptr_t user_context,
+                              const iree_task_tile_context_t* tile_context,
+                              iree_task_submission_t* pending_submission) {
+      auto* counter = reinterpret_cast<TileCounter*>(user_context);
+      iree_atomic_fetch_add_int32(&counter->tile_count, 1,
+                                  iree_memory_order_relaxed);
+      return iree_ok_status();
+    }
+  };
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {31, 3, 1};
+  for (uint32_t flags : {0u, (uint32_t)IREE_TASK_FLAG_DISPATCH_SLICED}) {
+    TileCounter counter;
+    counter.tile_count = IREE_ATOMIC_VAR_INIT(0);
+    iree_task_dispatch_t task;
+    iree_task_dispatch_initialize(
+        &scope_,
+        iree_task_make_dispatch_closure(TileCounter::Tile,
+                                        (uintptr_t)&counter),
+        kWorkgroupSize, kWorkgroupCount, &task);
+    task.header.flags |= flags;
+    task.local_memory_size = IREE_TASK_WORKER_MAX_LOCAL_MEMORY_SIZE + 1;
+    IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+    EXPECT_EQ(0, iree_atomic_load_int32(&counter.tile_count,
+                                        iree_memory_order_relaxed));
+    iree_status_t status = iree_task_scope_consume_status(&scope_);
+    EXPECT_EQ(IREE_STATUS_RESOURCE_EXHAUSTED, iree_status_code(status));
+    iree_status_ignore(status);
+  }
+}
+
+// Tiles accumulate into per-worker storage indexed by worker_id without any
+// synchronization; the totals must account for every tile exactly once.
+TEST_F(TaskDispatchTest, WorkerId) {
+  struct WorkerIdCheck {
+    iree_atomic_int32_t worker_count;
+    uint32_t tile_counts[IREE_TASK_EXECUTOR_MAX_WORKER_COUNT];
+    iree_atomic_int32_t failure_count;
+    static iree_status_t Tile(uintptr_t user_context,
+                              const iree_task_tile_context_t* tile_context,
+                              iree_task_submission_t* pending_submission) {
+      auto* check = reinterpret_cast<WorkerIdCheck*>(user_context);
+      // All tiles must observe the same worker count as the first one.
+      int32_t worker_count = 0;
+      iree_atomic_compare_exchange_strong_int32(
+          &check->worker_count, &worker_count,
+          (int32_t)tile_context->worker_count, iree_memory_order_relaxed,
+          iree_memory_order_relaxed);
+      if (worker_count == 0) worker_count = tile_context->worker_count;
+      if (tile_context->worker_count != (uint32_t)worker_count ||
+          tile_context->worker_count > IREE_TASK_EXECUTOR_MAX_WORKER_COUNT ||
+          tile_context->worker_id >= tile_context->worker_count) {
+        iree_atomic_fetch_add_int32(&check->failure_count, 1,
+                                    iree_memory_order_relaxed);
+        return iree_ok_status();
+      }
+      ++check->tile_counts[tile_context->worker_id];
+      return iree_ok_status();
+    }
+  };
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {67, 5, 3};
+  for (uint32_t flags : {0u, (uint32_t)IREE_TASK_FLAG_DISPATCH_SLICED}) {
+    WorkerIdCheck check;
+    memset(&check, 0, sizeof(check));
+    iree_task_dispatch_t task;
+    iree_task_dispatch_initialize(
+        &scope_,
+        iree_task_make_dispatch_closure(WorkerIdCheck::Tile,
+                                        (uintptr_t)&check),
+        kWorkgroupSize, kWorkgroupCount, &task);
+    task.header.flags |= flags;
+    IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+    EXPECT_EQ(0, iree_atomic_load_int32(&check.failure_count,
+                                        iree_memory_order_relaxed));
+    uint32_t total_count = 0;
+    for (uint32_t i = 0; i < IREE_TASK_EXECUTOR_MAX_WORKER_COUNT; ++i) {
+      total_count += check.tile_counts[i];
+    }
+    EXPECT_EQ(kWorkgroupCount[0] * kWorkgroupCount[1] * kWorkgroupCount[2],
+              total_count);
+  }
+}
+
+TEST_F(TaskDispatchTest, ProfileMovingAverage) {
+  iree_task_dispatch_profile_t profile;
+  iree_task_dispatch_profile_initialize(&profile);
+  iree_task_dispatch_profile_update(&profile, 1000);
+  EXPECT_EQ(1000, iree_task_dispatch_profile_tile_duration(&profile));
+  iree_task_dispatch_profile_update(&profile, 2000);
+  EXPECT_EQ(1250, iree_task_dispatch_profile_tile_duration(&profile));
+  iree_task_dispatch_profile_update(&profile, 0);
+  EXPECT_GT(iree_task_dispatch_profile_tile_duration(&profile), 0);
+}
+
+// Tiles estimated as very cheap get batched into large slices/reservations
+// and tiles estimated as very expensive get one tile per slice/reservation;
+// either way the entire grid must be covered exactly once.
+TEST_F(TaskDispatchTest, IssueProfiled) {
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {37, 13, 3};
+  for (int64_t tile_duration_ns : {1ll, 1000ll, 1000000000ll}) {
+    for (uint32_t flags : {0u, (uint32_t)IREE_TASK_FLAG_DISPATCH_SLICED}) {
+      iree_task_dispatch_profile_t profile;
+      iree_task_dispatch_profile_initialize(&profile);
+      iree_task_dispatch_profile_update(&profile, tile_duration_ns);
+      DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, flags, &profile);
+    }
+  }
+}
+
 TEST_F(TaskDispatchTest, IssueIndirect) {
   static const uint32_t kWorkgroupSize[3] = {1, 1, 1};
   static const uint32_t kWorkgroupCount[3] = {3, 4, 5};
@@ -32,9 +32,10 @@ class TaskTest : public ::testing::Test {
   virtual void SetUp() {
     iree_task_topology_t topology;
     iree_task_topology_initialize_from_group_count(8, &topology);
-    IREE_ASSERT_OK(iree_task_executor_create(IREE_TASK_SCHEDULING_MODE_RESERVED,
-                                             &topology, iree_allocator_system(),
-                                             &executor_));
+    IREE_ASSERT_OK(iree_task_executor_create(
+        IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+        IREE_TASK_EXECUTOR_DEFAULT_WORKER_SPIN_NS, iree_allocator_system(),
+        &executor_));
     iree_task_topology_deinitialize(&topology);
 
     iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope_);
@@ -17,6 +17,7 @@
 #include <assert.h>
 #include <cpuinfo.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "iree/base/internal/debugging.h"
 #include "iree/base/internal/math.h"
@@ -31,6 +32,8 @@ void iree_task_topology_group_initialize(
            group_index);
   iree_thread_affinity_set_any(&out_group->ideal_thread_affinity);
   out_group->constructive_sharing_mask = IREE_TASK_TOPOLOGY_GROUP_MASK_ALL;
+  out_group->numa_node_mask = IREE_TASK_TOPOLOGY_GROUP_MASK_ALL;
+  out_group->worker_spin_ns = IREE_TASK_TOPOLOGY_GROUP_WORKER_SPIN_DEFAULT;
 }
 
 void iree_task_topology_initialize(iree_task_topology_t* out_topology) {
@@ -273,6 +276,11 @@ static void iree_task_topology_initialize_fallback(
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Assigns each group to the NUMA node containing the processor its ideal
+// thread affinity is pinned to. Defined with the NUMA node discovery below.
+static void iree_task_topology_assign_numa_nodes(
+    iree_task_topology_t* topology);
+
 // Matches all cores.
 static bool iree_task_topology_core_filter_all(const struct cpuinfo_core* core,
                                                uintptr_t user_data) {
@@ -341,6 +349,7 @@ void iree_task_topology_initialize_from_physical_cores_with_filter(
   }
 
   iree_task_topology_fixup_constructive_sharing_masks(out_topology);
+  iree_task_topology_assign_numa_nodes(out_topology);
   IREE_TRACE_ZONE_END(z0);
 }
 
@@ -380,5 +389,282 @@ void iree_task_topology_initialize_from_unique_l2_cache_groups(
   }
 
   iree_task_topology_fixup_constructive_sharing_masks(out_topology);
+  iree_task_topology_assign_numa_nodes(out_topology);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+//===----------------------------------------------------------------------===//
+// NUMA node discovery
+//===----------------------------------------------------------------------===//
+
+bool iree_task_topology_is_numa(const iree_task_topology_t* topology) {
+  for (iree_host_size_t i = 1; i < topology->group_count; ++i) {
+    if (topology->groups[i].numa_node_id != topology->groups[0].numa_node_id) {
+      return true;
+    }
+  }
+  return false;
+}
+
+#if defined(IREE_PLATFORM_LINUX)
+
+// Maximum number of NUMA nodes that will be considered during discovery.
+// Nodes with IDs beyond this are ignored.
+#define IREE_TASK_TOPOLOGY_MAX_NUMA_NODE_COUNT 64
+
+// Maximum number of logical CPUs (by linux ID) that will be considered during
+// discovery. CPUs with IDs beyond this are ignored.
+#define IREE_TASK_TOPOLOGY_MAX_CPU_COUNT 1024
+
+// A bitset of IDs as parsed from a sysfs list (like "0-3,8-11").
+typedef struct {
+  uint64_t words[IREE_TASK_TOPOLOGY_MAX_CPU_COUNT / 64];
+} iree_task_topology_id_set_t;
+
+static bool iree_task_topology_id_set_test(
+    const iree_task_topology_id_set_t* set, uint32_t id) {
+  return id < IREE_TASK_TOPOLOGY_MAX_CPU_COUNT &&
+         (set->words[id / 64] & (1ull << (id % 64))) != 0;
+}
+
+// Reads the sysfs list file at |path| (like "0-3,8-11\n") into |out_set|.
+// Returns false if the file could not be read.
+static bool iree_task_topology_read_id_set(
+    const char* path, iree_task_topology_id_set_t* out_set) {
+  memset(out_set, 0, sizeof(*out_set));
+  FILE* file = fopen(path, "r");
+  if (!file) return false;
+  char buffer[1024];
+  size_t length = fread(buffer, 1, sizeof(buffer) - 1, file);
+  fclose(file);
+  buffer[length] = 0;
+
+  const char* p = buffer;
+  while (*p >= '0' && *p <= '9') {
+    char* end = NULL;
+    unsigned long range_start = strtoul(p, &end, 10);
+    unsigned long range_end = range_start;
+    p = end;
+    if (*p == '-') {
+      range_end = strtoul(p + 1, &end, 10);
+      p = end;
+    }
+    for (unsigned long id = range_start;
+         id <= range_end && id < IREE_TASK_TOPOLOGY_MAX_CPU_COUNT; ++id) {
+      out_set->words[id / 64] |= 1ull << (id % 64);
+    }
+    if (*p == ',') ++p;
+  }
+  return true;
+}
+
+// Reads the set of logical CPUs (by linux ID) within |node_id|.
+static bool iree_task_topology_read_numa_node_cpus(
+    uint32_t node_id, iree_task_topology_id_set_t* out_cpus) {
+  char path[64];
+  snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist",
+           node_id);
+  return iree_task_topology_read_id_set(path, out_cpus);
+}
+
+// Returns the cpuinfo processor with the given linux |cpu_id| or NULL if
+// cpuinfo is not available or the CPU is unknown.
+static const struct cpuinfo_processor* iree_task_topology_find_processor(
+    uint32_t cpu_id) {
+  if (!iree_task_topology_is_cpuinfo_available()) return NULL;
+  for (uint32_t i = 0; i < cpuinfo_get_processors_count(); ++i) {
+    const struct cpuinfo_processor* processor = cpuinfo_get_processor(i);
+    if (processor->linux_id == (int)cpu_id) return processor;
+  }
+  return NULL;
+}
+
+// Returns true if |cpu_id| should have a group created for it. When cpuinfo is
+// available only the first processor of each physical core is selected so that
+// SMT siblings don't get their own groups.
+static bool iree_task_topology_is_numa_cpu_selected(uint32_t cpu_id) {
+  if (!iree_task_topology_is_cpuinfo_available()) return true;
+  const struct cpuinfo_processor* processor =
+      iree_task_topology_find_processor(cpu_id);
+  return processor &&
+         processor == cpuinfo_get_processor(processor->core->processor_start);
+}
+
+// Populates |out_group| for the logical CPU |cpu_id| within |node_id|.
+static void iree_task_topology_group_initialize_from_numa_cpu(
+    uint32_t group_index, uint32_t node_id, uint32_t cpu_id,
+    iree_task_topology_group_t* out_group) {
+  const struct cpuinfo_processor* processor =
+      iree_task_topology_find_processor(cpu_id);
+  if (processor) {
+    iree_task_topology_group_initialize_from_core(group_index, processor->core,
+                                                  out_group);
+  } else {
+    iree_task_topology_group_initialize(group_index, out_group);
+    out_group->ideal_thread_affinity.specified = 1;
+    out_group->ideal_thread_affinity.id = cpu_id;
+  }
+  out_group->numa_node_id = node_id;
+}
+
+// Sets the numa_node_mask of each group to all other groups with the same
+// numa_node_id.
+static void iree_task_topology_fixup_numa_node_masks(
+    iree_task_topology_t* topology) {
+  for (iree_host_size_t i = 0; i < topology->group_count; ++i) {
+    iree_task_topology_group_t* group = &topology->groups[i];
+    iree_task_topology_group_mask_t group_mask = 0;
+    for (iree_host_size_t j = 0; j < topology->group_count; ++j) {
+      if (i == j) continue;
+      const iree_task_topology_group_t* other_group = &topology->groups[j];
+      if (other_group->numa_node_id == group->numa_node_id) {
+        group_mask |= 1ull << other_group->group_index;
+      }
+    }
+    group->numa_node_mask = group_mask;
+  }
+}
+
+static void iree_task_topology_assign_numa_nodes(
+    iree_task_topology_t* topology) {
+  iree_task_topology_id_set_t node_set;
+  if (!iree_task_topology_read_id_set("/sys/devices/system/node/online",
+                                      &node_set)) {
+    return;
+  }
+  iree_task_topology_id_set_t cpu_set;
+  for (uint32_t node_id = 0; node_id < IREE_TASK_TOPOLOGY_MAX_NUMA_NODE_COUNT;
+       ++node_id) {
+    if (!iree_task_topology_id_set_test(&node_set, node_id)) continue;
+    if (!iree_task_topology_read_numa_node_cpus(node_id, &cpu_set)) continue;
+    for (iree_host_size_t i = 0; i < topology->group_count; ++i) {
+      iree_task_topology_group_t* group = &topology->groups[i];
+      if (group->ideal_thread_affinity.specified &&
+          iree_task_topology_id_set_test(&cpu_set,
+                                         group->ideal_thread_affinity.id)) {
+        group->numa_node_id = node_id;
+      }
+    }
+  }
+  // Single node topologies keep the default masks so that they behave exactly
+  // as if no node information was available.
+  if (iree_task_topology_is_numa(topology)) {
+    iree_task_topology_fixup_numa_node_masks(topology);
+  }
+}
+
+void iree_task_topology_initialize_from_numa_nodes(
+    iree_host_size_t max_group_count, iree_task_topology_t* out_topology) {
+  max_group_count =
+      iree_min(max_group_count, IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT);
+
+  iree_task_topology_id_set_t node_set;
+  if (!iree_task_topology_read_id_set("/sys/devices/system/node/online",
+                                      &node_set)) {
+    iree_task_topology_initialize_from_physical_cores(max_group_count,
+                                                      out_topology);
+    return;
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Count the selectable cores within each node.
+  uint32_t node_ids[IREE_TASK_TOPOLOGY_MAX_NUMA_NODE_COUNT];
+  iree_host_size_t node_core_counts[IREE_TASK_TOPOLOGY_MAX_NUMA_NODE_COUNT];
+  iree_host_size_t node_count = 0;
+  iree_host_size_t total_core_count = 0;
+  iree_task_topology_id_set_t cpu_set;
+  for (uint32_t node_id = 0; node_id < IREE_TASK_TOPOLOGY_MAX_NUMA_NODE_COUNT;
+       ++node_id) {
+    if (!iree_task_topology_id_set_test(&node_set, node_id)) continue;
+    if (!iree_task_topology_read_numa_node_cpus(node_id, &cpu_set)) continue;
+    iree_host_size_t core_count = 0;
+    for (uint32_t cpu_id = 0; cpu_id < IREE_TASK_TOPOLOGY_MAX_CPU_COUNT;
+         ++cpu_id) {
+      if (iree_task_topology_id_set_test(&cpu_set, cpu_id) &&
+          iree_task_topology_is_numa_cpu_selected(cpu_id)) {
+        ++core_count;
+      }
+    }
+    if (!core_count) continue;  // memory-only node
+    node_ids[node_count] = node_id;
+    node_core_counts[node_count] = core_count;
+    total_core_count += core_count;
+    ++node_count;
+  }
+  if (!node_count) {
+    IREE_TRACE_ZONE_END(z0);
+    iree_task_topology_initialize_from_physical_cores(max_group_count,
+                                                      out_topology);
+    return;
+  }
+
+  // Distribute the groups round-robin across the nodes so that if we can't
+  // use all cores each node still gets an even share.
+  iree_host_size_t node_group_counts[IREE_TASK_TOPOLOGY_MAX_NUMA_NODE_COUNT];
+  memset(node_group_counts, 0, sizeof(node_group_counts));
+  iree_host_size_t group_count = iree_min(max_group_count, total_core_count);
+  for (iree_host_size_t assigned_count = 0; assigned_count < group_count;) {
+    for (iree_host_size_t i = 0; i < node_count && assigned_count < group_count;
+         ++i) {
+      if (node_group_counts[i] < node_core_counts[i]) {
+        ++node_group_counts[i];
+        ++assigned_count;
+      }
+    }
+  }
+
+  // Emit the groups for each node in order so that the groups in each node
+  // are contiguous.
+  iree_task_topology_initialize(out_topology);
+  for (iree_host_size_t i = 0; i < node_count; ++i) {
+    if (!iree_task_topology_read_numa_node_cpus(node_ids[i], &cpu_set)) {
+      continue;
+    }
+    iree_host_size_t node_group_count = 0;
+    for (uint32_t cpu_id = 0; cpu_id < IREE_TASK_TOPOLOGY_MAX_CPU_COUNT &&
+                              node_group_count < node_group_counts[i];
+         ++cpu_id) {
+      if (!iree_task_topology_id_set_test(&cpu_set, cpu_id) ||
+          !iree_task_topology_is_numa_cpu_selected(cpu_id)) {
+        continue;
+      }
+      iree_task_topology_group_initialize_from_numa_cpu(
+          out_topology->group_count, node_ids[i], cpu_id,
+          &out_topology->groups[out_topology->group_count]);
+      ++out_topology->group_count;
+      ++node_group_count;
+    }
+  }
+
+  iree_task_topology_fixup_numa_node_masks(out_topology);
+  if (iree_task_topology_is_cpuinfo_available()) {
+    iree_task_topology_fixup_constructive_sharing_masks(out_topology);
+  } else {
+    // Without cache information the best guess we have is that all cores
+    // within a node share some cache (such as a per-socket L3).
+    for (iree_host_size_t i = 0; i < out_topology->group_count; ++i) {
+      out_topology->groups[i].constructive_sharing_mask =
+          out_topology->groups[i].numa_node_mask;
+    }
+  }
+
   IREE_TRACE_ZONE_END(z0);
 }
+
+#else
+
+static void iree_task_topology_assign_numa_nodes(
+    iree_task_topology_t* topology) {
+  // NUMA discovery is only implemented for Linux.
+}
+
+void iree_task_topology_initialize_from_numa_nodes(
+    iree_host_size_t max_group_count, iree_task_topology_t* out_topology) {
+  // NUMA discovery is only implemented for Linux; other platforms could use
+  // GetNumaNodeProcessorMaskEx (Windows) and the like.
+  iree_task_topology_initialize_from_physical_cores(max_group_count,
+                                                    out_topology);
+}
+
+#endif  // IREE_PLATFORM_LINUX
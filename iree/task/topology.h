@@ -60,8 +60,28 @@ typedef struct {
   // workers in a group all share an L2 cache then the groups indicated here may
   // all share the same L3 cache.
   iree_task_topology_group_mask_t constructive_sharing_mask;
+
+  // NUMA node containing the processors of this group. Always 0 on systems
+  // without NUMA or when the topology was constructed without node information.
+  uint32_t numa_node_id;
+
+  // A bitmask of other group indices that reside within the same NUMA node.
+  // Workers will exhaust potential victims within their own node before
+  // stealing work from groups on other nodes as doing so requires the task
+  // data (and the memory the task touches) to cross the interconnect.
+  iree_task_topology_group_mask_t numa_node_mask;
+
+  // Duration workers in this group spin looking for new work before parking or
+  // IREE_TASK_TOPOLOGY_GROUP_WORKER_SPIN_DEFAULT to use the executor-wide
+  // duration. Groups of cores that are expensive to wake (such as those in
+  // deep sleep states or on remote NUMA nodes) may want to spin longer while
+  // efficiency cores may want to park immediately with IREE_DURATION_ZERO.
+  iree_duration_t worker_spin_ns;
 } iree_task_topology_group_t;
 
+// Indicates that a group should use the spin duration of its executor.
+#define IREE_TASK_TOPOLOGY_GROUP_WORKER_SPIN_DEFAULT ((iree_duration_t)-1)
+
 // Initializes |out_group| with a |group_index| derived name.
 void iree_task_topology_group_initialize(uint8_t group_index,
                                          iree_task_topology_group_t* out_group);
@@ -134,6 +154,11 @@ void iree_task_topology_initialize_from_group_count(
 //
 // If detailed cache information is not available this is a decent
 // approximation that can be used as a fallback.
+//
+// On Linux each group has its numa_node_id and numa_node_mask populated from
+// the NUMA node of its core. Unlike with
+// iree_task_topology_initialize_from_numa_nodes the groups are not ordered or
+// distributed by node.
 void iree_task_topology_initialize_from_physical_cores(
     iree_host_size_t max_core_count, iree_task_topology_t* out_topology);
 
@@ -166,9 +191,28 @@ void iree_task_topology_initialize_from_physical_cores_with_filter(
 //
 // If detailed cache information is not available this falls back to the same
 // behavior as iree_task_topology_initialize_from_physical_cores.
+//
+// Groups are assigned NUMA nodes as with
+// iree_task_topology_initialize_from_physical_cores.
 void iree_task_topology_initialize_from_unique_l2_cache_groups(
     iree_host_size_t max_group_count, iree_task_topology_t* out_topology);
 
+// Initializes a topology with one group for each physical core in each NUMA
+// node of the machine. Groups are ordered by node such that all groups within
+// a node are contiguous and each group has its numa_node_id and numa_node_mask
+// populated. If |max_group_count| is less than the total number of available
+// cores the groups are distributed evenly across all nodes.
+//
+// NUMA nodes are discovered from /sys/devices/system/node on Linux. If NUMA
+// information is not available this falls back to the same behavior as
+// iree_task_topology_initialize_from_physical_cores with all groups placed
+// within node 0.
+void iree_task_topology_initialize_from_numa_nodes(
+    iree_host_size_t max_group_count, iree_task_topology_t* out_topology);
+
+// Returns true if the groups in |topology| span more than one NUMA node.
+bool iree_task_topology_is_numa(const iree_task_topology_t* topology);
+
 // TODO(#4654): more helpers and better defaults for the platforms we support.
 // Users can always make their own but just using these is the common path.
 // Ideas:
@@ -151,4 +151,79 @@ TEST(TopologyTest, FromPhysicalCores) {
   iree_task_topology_deinitialize(&topology);
 }
 
+TEST(TopologyTest, FromNumaNodes) {
+  static constexpr iree_host_size_t kMaxGroupCount = 4;
+  iree_task_topology_t topology;
+  iree_task_topology_initialize(&topology);
+  iree_task_topology_initialize_from_numa_nodes(kMaxGroupCount, &topology);
+  EnsureTopologyValid(kMaxGroupCount, &topology);
+
+  // Groups must be ordered by node and the node masks must contain exactly the
+  // other groups within the same node.
+  for (iree_host_size_t i = 0; i < iree_task_topology_group_count(&topology);
+       ++i) {
+    const iree_task_topology_group_t* group =
+        iree_task_topology_get_group(&topology, i);
+    if (i > 0) {
+      EXPECT_LE(iree_task_topology_get_group(&topology, i - 1)->numa_node_id,
+                group->numa_node_id);
+    }
+    EXPECT_EQ(0, group->numa_node_mask & (1ull << i));
+    for (iree_host_size_t j = 0; j < iree_task_topology_group_count(&topology);
+         ++j) {
+      if (i == j) continue;
+      const iree_task_topology_group_t* other_group =
+          iree_task_topology_get_group(&topology, j);
+      if (group->numa_node_id == other_group->numa_node_id) {
+        EXPECT_NE(0, group->numa_node_mask & (1ull << j));
+      } else {
+        EXPECT_EQ(0, group->numa_node_mask & (1ull << j));
+      }
+    }
+  }
+
+  iree_task_topology_deinitialize(&topology);
+}
+
+// Topologies built from cpuinfo place each group in the NUMA node of the
+// processor it is pinned to, matching the NUMA node topology.
+TEST(TopologyTest, FromUniqueL2CacheGroupsNumaNodes) {
+  static constexpr iree_host_size_t kMaxGroupCount = 64;
+  iree_task_topology_t numa_topology;
+  iree_task_topology_initialize_from_numa_nodes(kMaxGroupCount, &numa_topology);
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_unique_l2_cache_groups(kMaxGroupCount,
+                                                            &topology);
+  EnsureTopologyValid(kMaxGroupCount, &topology);
+
+  for (iree_host_size_t i = 0; i < iree_task_topology_group_count(&topology);
+       ++i) {
+    const iree_task_topology_group_t* group =
+        iree_task_topology_get_group(&topology, i);
+    if (!group->ideal_thread_affinity.specified) continue;
+    for (iree_host_size_t j = 0;
+         j < iree_task_topology_group_count(&numa_topology); ++j) {
+      const iree_task_topology_group_t* numa_group =
+          iree_task_topology_get_group(&numa_topology, j);
+      if (numa_group->ideal_thread_affinity.specified &&
+          numa_group->ideal_thread_affinity.id ==
+              group->ideal_thread_affinity.id) {
+        EXPECT_EQ(numa_group->numa_node_id, group->numa_node_id);
+      }
+    }
+  }
+
+  iree_task_topology_deinitialize(&topology);
+  iree_task_topology_deinitialize(&numa_topology);
+}
+
+TEST(TopologyTest, IsNuma) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(4, &topology);
+  EXPECT_FALSE(iree_task_topology_is_numa(&topology));
+  topology.groups[3].numa_node_id = 1;
+  EXPECT_TRUE(iree_task_topology_is_numa(&topology));
+  iree_task_topology_deinitialize(&topology);
+}
+
 }  // namespace
@@ -66,6 +66,30 @@ extern "C" {
 // the available workers.
 #define IREE_TASK_EXECUTOR_MAX_THEFT_ATTEMPTS_DIVISOR (1)
 
+// Default duration a worker spins looking for new work after it runs out
+// before parking in the kernel. Used by callers of iree_task_executor_create
+// that have no better information about their workload.
+//
+// Spinning keeps the worker on-core and lets it pick up work posted shortly
+// after it went idle without paying for a kernel wake (often 10-100us under
+// load), at the cost of burning CPU time when no work arrives. Workloads that
+// issue many small back-to-back dispatches benefit the most while mostly-idle
+// or power-sensitive deployments should use 0 to park immediately.
+#define IREE_TASK_EXECUTOR_DEFAULT_WORKER_SPIN_NS (50 * 1000)
+
+// Size of the scratch memory each worker preallocates for the tiles it
+// executes (see iree_task_tile_context_t::local_memory).
+//
+// Dispatches that request more local memory grow the memory of the workers
+// that execute them on first use; this only sets the amount available without
+// any allocation on the worker thread. Each worker holds its own copy so the
+// total cost is this * worker count bytes.
+#define IREE_TASK_WORKER_DEFAULT_LOCAL_MEMORY_SIZE (64 * 1024)
+
+// Maximum size of the scratch memory a worker will grow to. Dispatches
+// requesting more local memory than this fail.
+#define IREE_TASK_WORKER_MAX_LOCAL_MEMORY_SIZE (64 * 1024 * 1024)
+
 // Maximum number of tasks that will be stolen in one go from another worker.
 //
 // Too few tasks will cause additional overhead as the worker repeatedly sips
@@ -86,6 +110,17 @@ extern "C" {
 #define IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT \
   IREE_TASK_EXECUTOR_MAX_WORKER_COUNT
 
+// Maximum number of tasks that can be held in the lock-free portion of a worker
+// queue. Tasks beyond this are kept in an owner-only overflow list that thieves
+// cannot steal from until the owner moves them into the queue. Must be a power
+// of two.
+//
+// Each worker queue stores this many task pointers inline so the cost is
+// IREE_TASK_QUEUE_CAPACITY * sizeof(void*) bytes per worker. A dispatch is
+// generally fanned out as ~1 shard per worker (or slices of a handful of tiles)
+// so this only needs to cover a burst of posts between pumps.
+#define IREE_TASK_QUEUE_CAPACITY (512)
+
 // Number of tiles that will be batched into a single slice along each XYZ dim.
 //
 // Larger numbers reduce overhead and ensure that more tiles are executed
@@ -118,6 +153,50 @@ extern "C" {
 // memory).
 #define IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION (8)
 
+// Target duration of a single unit of scheduled dispatch work (a slice or a
+// shard tile reservation) when the dispatch has an execution profile.
+//
+// Dispatches with an iree_task_dispatch_profile_t use the measured per-tile
+// duration to batch tiles such that each slice/reservation takes roughly this
+// long, replacing the fixed IREE_TASK_DISPATCH_TILES_PER_SLICE_* and
+// IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION values. Longer durations
+// amortize scheduling overhead and shorter durations improve load balancing.
+#define IREE_TASK_DISPATCH_TARGET_RESERVATION_DURATION_NS (50 * 1000)
+
+// Minimum estimated duration of the work given to each worker of a profiled
+// dispatch. Dispatches estimated to be smaller than this times the worker count
+// are spread across fewer workers as waking a worker and moving the data to
+// its caches would cost more than the parallelism gains.
+#define IREE_TASK_DISPATCH_MIN_WORKER_DURATION_NS (20 * 1000)
+
+// Minimum number of slices/reservations each participating worker should
+// receive from a profiled dispatch. Having more than one allows workers that
+// finish early to steal (or reserve) work from those running behind.
+#define IREE_TASK_DISPATCH_MIN_RESERVATIONS_PER_WORKER (4)
+
+// Maximum number of tiles that will be batched into a single slice/reservation
+// of a profiled dispatch.
+#define IREE_TASK_DISPATCH_MAX_ADAPTIVE_TILES_PER_RESERVATION (1024)
+
+// Whether to measure the time spent in tile functions and in slice/shard
+// execution for iree_task_dispatch_statistics_t. The clock is sampled at the
+// start and end of every slice and shard and around one in every
+// IREE_TASK_DISPATCH_STATISTICS_TILE_SAMPLE_INTERVAL shard tile reservations.
+// Slices are only a few tiles each and with tiles doing no work the clock
+// still costs more than the tiles themselves: with a ~45ns clock
+// executor_benchmark measures +107% on sliced and +18% on sharded dispatches
+// of empty tiles. Timing is therefore opt-in. When disabled the duration
+// statistics are reported as 0 while all counts are still tracked.
+#if !defined(IREE_TASK_DISPATCH_STATISTICS_TIMING)
+#define IREE_TASK_DISPATCH_STATISTICS_TIMING 0
+#endif  // !IREE_TASK_DISPATCH_STATISTICS_TIMING
+
+// Number of shard tile reservations per timed reservation when
+// IREE_TASK_DISPATCH_STATISTICS_TIMING is enabled. The first reservation of
+// each shard is always timed and the tile duration of the shard is
+// extrapolated from the timed reservations.
+#define IREE_TASK_DISPATCH_STATISTICS_TILE_SAMPLE_INTERVAL (16)
+
 // Whether to enable per-tile colors for each tile tracing zone based on the
 // tile grid xyz. Not cheap and can be disabled to reduce tracing overhead.
 // TODO(#4017): make per-tile color tracing fast enough to always have on.
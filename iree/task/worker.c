@@ -29,13 +29,22 @@ iree_status_t iree_task_worker_initialize(
 
   out_worker->executor = executor;
   out_worker->worker_bit = iree_task_affinity_for_worker(worker_index);
+  out_worker->worker_index = (uint32_t)worker_index;
   out_worker->ideal_thread_affinity = topology_group->ideal_thread_affinity;
   out_worker->constructive_sharing_mask =
       topology_group->constructive_sharing_mask;
+  out_worker->numa_node_mask = topology_group->numa_node_mask;
   out_worker->max_theft_attempts =
       executor->worker_count / IREE_TASK_EXECUTOR_MAX_THEFT_ATTEMPTS_DIVISOR;
+  out_worker->spin_ns =
+      topology_group->worker_spin_ns ==
+              IREE_TASK_TOPOLOGY_GROUP_WORKER_SPIN_DEFAULT
+          ? executor->worker_spin_ns
+          : topology_group->worker_spin_ns;
   iree_prng_minilcg128_initialize(iree_prng_splitmix64_next(seed_prng),
                                   &out_worker->theft_prng);
+  iree_task_pool_cache_initialize(&executor->dispatch_task_pool,
+                                  &out_worker->dispatch_task_cache);
 
   iree_task_worker_state_t initial_state = IREE_TASK_WORKER_STATE_RUNNING;
   if (executor->scheduling_mode &
@@ -54,6 +63,13 @@ iree_status_t iree_task_worker_initialize(
   iree_atomic_task_slist_initialize(&out_worker->mailbox_slist);
   iree_task_queue_initialize(&out_worker->local_task_queue);
 
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(executor->allocator,
+                                IREE_TASK_WORKER_DEFAULT_LOCAL_MEMORY_SIZE,
+                                (void**)&out_worker->local_memory.data));
+  out_worker->local_memory.data_length =
+      IREE_TASK_WORKER_DEFAULT_LOCAL_MEMORY_SIZE;
+
   iree_thread_create_params_t thread_params;
   memset(&thread_params, 0, sizeof(thread_params));
   thread_params.name = iree_make_cstring_view(topology_group->name);
@@ -95,14 +111,18 @@ void iree_task_worker_deinitialize(iree_task_worker_t* worker) {
 
   // Release unfinished tasks by flushing the mailbox (which if we're here can't
   // get anything more posted to it) and then discarding everything we still
-  // have a reference to.
+  // have a reference to. Deinitializing the local task queue discards any tasks
+  // remaining in it.
   iree_atomic_task_slist_discard(&worker->mailbox_slist);
-  iree_task_list_discard(&worker->local_task_queue.list);
 
   iree_notification_deinitialize(&worker->wake_notification);
   iree_notification_deinitialize(&worker->state_notification);
   iree_atomic_task_slist_deinitialize(&worker->mailbox_slist);
   iree_task_queue_deinitialize(&worker->local_task_queue);
+  iree_task_pool_cache_deinitialize(&worker->dispatch_task_cache);
+  if (worker->local_memory.data) {
+    iree_allocator_free(worker->executor->allocator, worker->local_memory.data);
+  }
 
   IREE_TRACE_ZONE_END(z0);
 }
@@ -158,11 +178,49 @@ iree_task_t* iree_task_worker_try_steal_task(iree_task_worker_t* worker,
 
   // If we still didn't steal any tasks then let's try the slist instead.
   task = iree_atomic_task_slist_pop(&worker->mailbox_slist);
-  if (task) return task;
+  if (task) {
+    task->flags |= IREE_TASK_FLAG_STOLEN;
+    return task;
+  }
 
   return NULL;
 }
 
+// Ensures the worker local memory is at least |minimum_size| bytes.
+// The previous contents are not preserved.
+static iree_status_t iree_task_worker_reserve_local_memory(
+    iree_task_worker_t* worker, iree_host_size_t minimum_size) {
+  if (IREE_LIKELY(minimum_size <= worker->local_memory.data_length)) {
+    return iree_ok_status();
+  }
+  if (minimum_size > IREE_TASK_WORKER_MAX_LOCAL_MEMORY_SIZE) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "dispatch requires %zu bytes of local memory but "
+                            "workers have a maximum of %d",
+                            minimum_size,
+                            IREE_TASK_WORKER_MAX_LOCAL_MEMORY_SIZE);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, minimum_size);
+
+  // Grow geometrically so that a sequence of dispatches each requiring a bit
+  // more memory doesn't reallocate every time.
+  iree_host_size_t new_size = iree_min(
+      iree_max(minimum_size, worker->local_memory.data_length * 2),
+      IREE_TASK_WORKER_MAX_LOCAL_MEMORY_SIZE);
+  iree_allocator_t allocator = worker->executor->allocator;
+  iree_allocator_free(allocator, worker->local_memory.data);
+  worker->local_memory = iree_make_byte_span(NULL, 0);
+  iree_status_t status = iree_allocator_malloc(
+      allocator, new_size, (void**)&worker->local_memory.data);
+  if (iree_status_is_ok(status)) {
+    worker->local_memory.data_length = new_size;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 // Executes a task on a worker.
 // Only task types that are scheduled to workers are handled; all others must be
 // handled by the coordinator during scheduling.
@@ -184,13 +242,36 @@ static iree_status_t iree_task_worker_execute(
       break;
     }
     case IREE_TASK_TYPE_DISPATCH_SLICE: {
+      iree_task_dispatch_slice_t* slice_task =
+          (iree_task_dispatch_slice_t*)task;
+      iree_status_t status = iree_task_worker_reserve_local_memory(
+          worker, slice_task->local_memory_size);
+      if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
+        // The tiles can't run without their local memory but the slice must
+        // still retire for the dispatch (and anything waiting on it) to
+        // complete.
+        iree_task_dispatch_slice_fail(slice_task, status, pending_submission);
+        break;
+      }
       IREE_RETURN_IF_ERROR(iree_task_dispatch_slice_execute(
-          (iree_task_dispatch_slice_t*)task, pending_submission));
+          slice_task, worker->worker_index,
+          (uint32_t)worker->executor->worker_count, worker->local_memory,
+          pending_submission));
       break;
     }
     case IREE_TASK_TYPE_DISPATCH_SHARD: {
+      iree_task_dispatch_shard_t* shard_task =
+          (iree_task_dispatch_shard_t*)task;
+      iree_status_t status = iree_task_worker_reserve_local_memory(
+          worker, shard_task->shared_state->dispatch_task->local_memory_size);
+      if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
+        iree_task_dispatch_shard_fail(shard_task, status, pending_submission);
+        break;
+      }
       IREE_RETURN_IF_ERROR(iree_task_dispatch_shard_execute(
-          (iree_task_dispatch_shard_t*)task, pending_submission));
+          shard_task, worker->worker_index,
+          (uint32_t)worker->executor->worker_count, worker->local_memory,
+          pending_submission));
       break;
     }
     default:
@@ -237,8 +318,8 @@ static bool iree_task_worker_pump_once(
   if (!task) {
     task = iree_task_executor_try_steal_task(
         worker->executor, worker->constructive_sharing_mask,
-        worker->max_theft_attempts, &worker->theft_prng,
-        &worker->local_task_queue);
+        worker->numa_node_mask, worker->max_theft_attempts,
+        &worker->theft_prng, &worker->local_task_queue);
   }
 
   // No tasks to run; let the caller know we want to wait for more.
@@ -267,10 +348,28 @@ static bool iree_task_worker_pump_once(
   return true;  // try again
 }
 
+// Spins for up to the worker spin duration waiting for the wake notification to
+// be posted. Anything that gives the worker new work - coordinators posting to
+// the mailbox, submissions waking idle workers, or exit requests - posts the
+// notification so observing a post is sufficient to know we should pump again.
+// Returns true if a post was observed.
+static bool iree_task_worker_spin_for_work(iree_task_worker_t* worker,
+                                           iree_wait_token_t wait_token) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  bool notified = iree_notification_spin_wait(&worker->wake_notification,
+                                              wait_token, worker->spin_ns);
+  IREE_TRACE_ZONE_END(z0);
+  return notified;
+}
+
 // Alternates between pumping ready tasks in the worker queue and waiting
 // for more tasks to arrive. Only returns when the worker has been asked by
 // the executor to exit.
 static void iree_task_worker_pump_until_exit(iree_task_worker_t* worker) {
+  // Whether to spin before the next time we would park. Cleared after a spin
+  // that found nothing such that we park on the following idle pass.
+  bool should_spin = worker->spin_ns > 0;
+
   // Pump the thread loop to process more tasks.
   while (true) {
     // If we fail to find any work to do we'll wait at the end of this loop.
@@ -332,11 +431,23 @@ static void iree_task_worker_pump_until_exit(iree_task_worker_t* worker) {
         !iree_task_queue_is_empty(&worker->local_task_queue)) {
       // Have more work to do; loop around to try another pump.
       iree_notification_cancel_wait(&worker->wake_notification);
+      should_spin = worker->spin_ns > 0;
+    } else if (should_spin) {
+      // Spin for a bit before parking in case more work arrives soon. The wait
+      // is cancelled first so that anyone posting work while we spin doesn't
+      // need to make a syscall to wake us. If nothing arrives we loop around
+      // once more to pick up anything we raced with and then park.
+      iree_notification_cancel_wait(&worker->wake_notification);
+      should_spin = iree_task_worker_spin_for_work(worker, wait_token);
     } else {
+      // Return our cached tasks to the pool while we are parked so that
+      // other threads issuing work can use them.
+      iree_task_pool_cache_flush(&worker->dispatch_task_cache);
       IREE_TRACE_ZONE_BEGIN_NAMED(z_wait,
                                   "iree_task_worker_main_pump_wake_wait");
       iree_notification_commit_wait(&worker->wake_notification, wait_token);
       IREE_TRACE_ZONE_END(z_wait);
+      should_spin = worker->spin_ns > 0;
     }
 
     // Wait completed.
@@ -362,7 +473,9 @@ static int iree_task_worker_main(iree_task_worker_t* worker) {
       IREE_TASK_WORKER_STATE_EXITING;
   if (IREE_LIKELY(should_run)) {
     // << work happens here >>
+    iree_task_pool_cache_bind(&worker->dispatch_task_cache);
     iree_task_worker_pump_until_exit(worker);
+    iree_task_pool_cache_bind(NULL);
   }
 
   IREE_TRACE_ZONE_END(thread_zone);
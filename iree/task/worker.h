@@ -22,6 +22,7 @@
 #include "iree/task/affinity_set.h"
 #include "iree/task/executor.h"
 #include "iree/task/list.h"
+#include "iree/task/pool.h"
 #include "iree/task/queue.h"
 #include "iree/task/tuning.h"
 
@@ -90,6 +91,9 @@ typedef struct iree_task_worker_s {
   // Bit the worker represents in the various worker bitsets.
   iree_task_affinity_set_t worker_bit;
 
+  // Index of the worker in the executor worker list.
+  uint32_t worker_index;
+
   // Ideal thread affinity for the worker thread.
   iree_thread_affinity_t ideal_thread_affinity;
 
@@ -100,15 +104,33 @@ typedef struct iree_task_worker_s {
   // all share the same L3 cache.
   iree_task_affinity_set_t constructive_sharing_mask;
 
+  // A bitmask of other group indices that reside within the same NUMA node.
+  // Thieves try these workers before stealing from workers on other nodes.
+  iree_task_affinity_set_t numa_node_mask;
+
   // Maximum number of attempts to make when trying to steal tasks from other
   // workers. This could be 64 (try stealing from all workers) or just a handful
   // (try stealing from these 3 other cores that share your L3 cache).
   uint32_t max_theft_attempts;
 
+  // Duration the worker spins waiting for new work after running out before
+  // parking on wake_notification. IREE_DURATION_ZERO parks immediately.
+  iree_duration_t spin_ns;
+
   // Rotation counter for work stealing (ensures we don't favor one victim).
   // Only ever touched by the worker thread as it steals work.
   iree_prng_minilcg128_state_t theft_prng;
 
+  // Cache of tasks from the executor dispatch task pool used for the slices
+  // and shards this worker issues and retires. Bound to the worker thread while
+  // it pumps and flushed back to the pool when the worker parks.
+  iree_task_pool_cache_t dispatch_task_cache;
+
+  // Scratch memory passed to the dispatch tiles executed by the worker.
+  // Preallocated with IREE_TASK_WORKER_DEFAULT_LOCAL_MEMORY_SIZE bytes and
+  // grown by the worker thread when a dispatch requires more.
+  iree_byte_span_t local_memory;
+
   // Thread handle of the worker. If the thread has exited the handle will
   // remain valid so that the executor can query its state.
   iree_thread_t* thread;
@@ -17,7 +17,6 @@
 #include "absl/flags/usage.h"
 #include "absl/strings/string_view.h"
 #include "benchmark/benchmark.h"
-#include "iree/base/internal/file_io.h"
 #include "iree/base/internal/flags.h"
 #include "iree/base/status.h"
 #include "iree/base/tracing.h"
@@ -105,18 +104,6 @@ void RegisterModuleBenchmarks(
       ->Unit(benchmark::kMillisecond);
 }
 
-Status GetModuleContentsFromFlags(std::string* out_contents) {
-  IREE_TRACE_SCOPE0("GetModuleContentsFromFlags");
-  auto module_file = absl::GetFlag(FLAGS_module_file);
-  if (module_file == "-") {
-    *out_contents = std::string{std::istreambuf_iterator<char>(std::cin),
-                                std::istreambuf_iterator<char>()};
-  } else {
-    IREE_RETURN_IF_ERROR(file_io::GetFileContents(module_file, out_contents));
-  }
-  return OkStatus();
-}
-
 // TODO(hanchung): Consider to refactor this out and reuse in iree-run-module.
 // This class helps organize required resources for IREE. The order of
 // construction and destruction for resources matters. And the lifetime of
@@ -164,8 +151,6 @@ class IREEBenchmark {
     IREE_TRACE_SCOPE0("IREEBenchmark::Init");
     IREE_TRACE_FRAME_MARK_BEGIN_NAMED("init");
 
-    IREE_RETURN_IF_ERROR(GetModuleContentsFromFlags(&module_data_));
-
     IREE_RETURN_IF_ERROR(iree_hal_module_register_types());
     IREE_RETURN_IF_ERROR(
         iree_vm_instance_create(iree_allocator_system(), &instance_));
@@ -174,7 +159,8 @@ class IREEBenchmark {
     IREE_RETURN_IF_ERROR(
         iree::CreateDevice(absl::GetFlag(FLAGS_driver), &device_));
     IREE_RETURN_IF_ERROR(CreateHalModule(device_, &hal_module_));
-    IREE_RETURN_IF_ERROR(LoadBytecodeModule(module_data_, &input_module_));
+    IREE_RETURN_IF_ERROR(LoadBytecodeModuleFromFile(
+        absl::GetFlag(FLAGS_module_file), &input_module_));
 
     // Order matters. The input module will likely be dependent on the hal
     // module.
@@ -246,7 +232,6 @@ class IREEBenchmark {
     return iree::OkStatus();
   }
 
-  std::string module_data_;
   iree_vm_instance_t* instance_;
   iree_hal_device_t* device_;
   iree_vm_module_t* hal_module_;
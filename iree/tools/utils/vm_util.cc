@@ -24,6 +24,7 @@
 #include "iree/base/internal/file_io.h"
 #include "iree/base/signature_mangle.h"
 #include "iree/base/status.h"
+#include "iree/base/tracing.h"
 #include "iree/hal/api.h"
 #include "iree/modules/hal/hal_module.h"
 #include "iree/vm/bytecode_module.h"
@@ -279,4 +280,31 @@ Status LoadBytecodeModule(absl::string_view module_data,
       "deserializing module");
   return OkStatus();
 }
+
+Status LoadBytecodeModule(iree_const_byte_span_t module_data,
+                          iree_allocator_t module_data_allocator,
+                          iree_vm_module_t** out_module) {
+  iree_status_t status = iree_vm_bytecode_module_create(
+      module_data, module_data_allocator, iree_allocator_system(), out_module);
+  if (!iree_status_is_ok(status)) {
+    // The module only takes ownership of the data on success.
+    iree_allocator_free(module_data_allocator, (void*)module_data.data);
+  }
+  IREE_RETURN_IF_ERROR(status, "deserializing module");
+  return OkStatus();
+}
+
+Status LoadBytecodeModuleFromFile(const std::string& path,
+                                  iree_vm_module_t** out_module) {
+  IREE_TRACE_SCOPE0("LoadBytecodeModuleFromFile");
+  iree_const_byte_span_t module_data = iree_make_const_byte_span(NULL, 0);
+  iree_allocator_t module_data_allocator = iree_allocator_null();
+  // Pipes can't be mapped and MapFileContents reads them into a heap
+  // allocation instead; stdin redirected from a file is still mapped.
+  IREE_RETURN_IF_ERROR(
+      file_io::MapFileContents(path == "-" ? "/dev/stdin" : path, &module_data,
+                               &module_data_allocator),
+      "loading module '%s'", path.c_str());
+  return LoadBytecodeModule(module_data, module_data_allocator, out_module);
+}
 }  // namespace iree
@@ -97,6 +97,22 @@ Status CreateHalModule(iree_hal_device_t* device,
 Status LoadBytecodeModule(absl::string_view module_data,
                           iree_vm_module_t** out_module);
 
+// Loads a VM bytecode module from |module_data| and takes ownership of it.
+// |module_data_allocator| is used to free the data when the module is destroyed
+// (or immediately on failure). Passing the deallocator from
+// file_io::MapFileContents keeps module rodata in the mapped file pages.
+// The returned |out_module| must be released by the caller.
+Status LoadBytecodeModule(iree_const_byte_span_t module_data,
+                          iree_allocator_t module_data_allocator,
+                          iree_vm_module_t** out_module);
+
+// Loads a VM bytecode module from the file at |path|, or stdin if |path| is
+// "-". Files are memory-mapped and ownership of the mapping is transferred to
+// the module so that rodata is never copied.
+// The returned |out_module| must be released by the caller.
+Status LoadBytecodeModuleFromFile(const std::string& path,
+                                  iree_vm_module_t** out_module);
+
 }  // namespace iree
 
 #endif  // IREE_TOOLS_UTILS_VM_UTIL_H_
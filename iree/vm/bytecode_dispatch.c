@@ -35,18 +35,25 @@ static void iree_vm_bytecode_dispatch_remap_branch_registers(
     const iree_vm_registers_t regs,
     const iree_vm_register_remap_list_t* IREE_RESTRICT remap_list) {
   for (int i = 0; i < remap_list->size; ++i) {
-    // TODO(benvanik): change encoding to avoid this branching.
-    // Could write two arrays: one for prims and one for refs.
-    uint16_t src_reg = remap_list->pairs[i].src_reg;
-    uint16_t dst_reg = remap_list->pairs[i].dst_reg;
-    if (src_reg & IREE_REF_REGISTER_TYPE_BIT) {
-      iree_vm_ref_retain_or_move(src_reg & IREE_REF_REGISTER_MOVE_BIT,
-                                 &regs.ref[src_reg & regs.ref_mask],
-                                 &regs.ref[dst_reg & regs.ref_mask]);
-    } else {
-      regs.i32[dst_reg & regs.i32_mask] = regs.i32[src_reg & regs.i32_mask];
+    // Runs are copied in ascending order to match the order the compiler
+    // sequenced the individual register moves in.
+    uint16_t src_reg = remap_list->runs[i].src_reg;
+    uint16_t dst_reg = remap_list->runs[i].dst_reg;
+    uint16_t length = remap_list->runs[i].length;
+    for (uint16_t j = 0; j < length; ++j) {
+      regs.i32[(dst_reg + j) & regs.i32_mask] =
+          regs.i32[(src_reg + j) & regs.i32_mask];
     }
   }
+  const iree_vm_register_ref_remap_list_t* IREE_RESTRICT ref_list =
+      iree_vm_register_remap_list_refs(remap_list);
+  for (int i = 0; i < ref_list->size; ++i) {
+    uint16_t src_reg = ref_list->pairs[i].src_reg;
+    uint16_t dst_reg = ref_list->pairs[i].dst_reg;
+    iree_vm_ref_retain_or_move(src_reg & IREE_REF_REGISTER_MOVE_BIT,
+                               &regs.ref[src_reg & regs.ref_mask],
+                               &regs.ref[dst_reg & regs.ref_mask]);
+  }
 }
 
 // Discards ref registers in the list if they are marked move.
@@ -1489,6 +1496,8 @@ iree_status_t iree_vm_bytecode_dispatch(
 #else
       return iree_make_status(IREE_STATUS_UNIMPLEMENTED);
 #endif  // IREE_VM_EXT_I64_ENABLE
+
+      DISPATCH_UNHANDLED_EXT();
     }
     END_DISPATCH_PREFIX();
 
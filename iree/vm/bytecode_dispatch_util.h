@@ -104,21 +104,50 @@ typedef struct {
   iree_host_size_t ref_register_offset;
 } iree_vm_bytecode_frame_storage_t;
 
-// Interleaved src-dst register sets for branch register remapping.
+// Register sets for branch register remapping split by register bank so that
+// no per-register type checks are needed when branching.
 // This structure is an overlay for the bytecode that is serialized in a
-// matching format.
+// matching format:
+//   [i32 run count] [i32 runs...] [ref pair count] [ref pairs...]
+//
+// i32 registers are copied in runs of contiguous registers such that
+// multiple adjacent block arguments (or the two halves of an i64) are moved
+// as one bulk copy. The ref pairs immediately follow the i32 runs and can be
+// located with iree_vm_register_remap_list_refs.
 typedef struct {
   uint16_t size;
-  struct pair {
+  struct run {
     uint16_t src_reg;
     uint16_t dst_reg;
-  } pairs[];
+    uint16_t length;
+  } runs[];
 } iree_vm_register_remap_list_t;
 static_assert(iree_alignof(iree_vm_register_remap_list_t) == 2,
               "Expecting byte alignment (to avoid padding)");
-static_assert(offsetof(iree_vm_register_remap_list_t, pairs) == 2,
+static_assert(offsetof(iree_vm_register_remap_list_t, runs) == 2,
+              "Expect no padding in the struct");
+
+// Interleaved src-dst ref register pairs for branch register remapping.
+typedef struct {
+  uint16_t size;
+  struct pair {
+    uint16_t src_reg;
+    uint16_t dst_reg;
+  } pairs[];
+} iree_vm_register_ref_remap_list_t;
+static_assert(iree_alignof(iree_vm_register_ref_remap_list_t) == 2,
+              "Expecting byte alignment (to avoid padding)");
+static_assert(offsetof(iree_vm_register_ref_remap_list_t, pairs) == 2,
               "Expect no padding in the struct");
 
+// Returns the ref register pairs following the i32 runs in |remap_list|.
+static inline const iree_vm_register_ref_remap_list_t*
+iree_vm_register_remap_list_refs(
+    const iree_vm_register_remap_list_t* remap_list) {
+  return (const iree_vm_register_ref_remap_list_t*)&remap_list
+      ->runs[remap_list->size];
+}
+
 // Maps a type ID to a type def with clamping for out of bounds values.
 static inline const iree_vm_type_def_t* iree_vm_map_type(
     iree_vm_bytecode_module_t* module, int32_t type_id) {
@@ -145,11 +174,26 @@ static inline const iree_vm_type_def_t* iree_vm_map_type(
 #define IREE_DISPATCH_LOG_CALL(...)
 #endif  // IREE_DISPATCH_LOGGING
 
+// Selects the interpreter dispatch mode at build time. Computed goto is used by
+// default wherever the compiler supports labels-as-values. Define
+// IREE_VM_BYTECODE_DISPATCH_COMPUTED_GOTO=0 to force the switch-based loop
+// (bytecode_module_switch_benchmark does this to compare the two).
+#if !defined(IREE_VM_BYTECODE_DISPATCH_COMPUTED_GOTO)
 #if defined(IREE_COMPILER_MSVC) && !defined(IREE_COMPILER_CLANG)
-#define IREE_DISPATCH_MODE_SWITCH 1
+#define IREE_VM_BYTECODE_DISPATCH_COMPUTED_GOTO 0
 #else
-#define IREE_DISPATCH_MODE_COMPUTED_GOTO 1
+#define IREE_VM_BYTECODE_DISPATCH_COMPUTED_GOTO 1
 #endif  // MSVC
+#endif  // !IREE_VM_BYTECODE_DISPATCH_COMPUTED_GOTO
+
+#if IREE_VM_BYTECODE_DISPATCH_COMPUTED_GOTO
+#if defined(IREE_COMPILER_MSVC) && !defined(IREE_COMPILER_CLANG)
+#error "MSVC does not support computed goto; use switch dispatch"
+#endif  // MSVC
+#define IREE_DISPATCH_MODE_COMPUTED_GOTO 1
+#else
+#define IREE_DISPATCH_MODE_SWITCH 1
+#endif  // IREE_VM_BYTECODE_DISPATCH_COMPUTED_GOTO
 
 #ifndef NDEBUG
 #define VMCHECK(expr) assert(expr)
@@ -224,11 +268,16 @@ static const int kRegSize = sizeof(uint16_t);
   (out_str)->data = (const char*)&bytecode_data[pc + 2]; \
   pc += 2 + (out_str)->size;
 #define VM_DecBranchTarget(block_name) VM_DecConstI32(name)
-#define VM_DecBranchOperands(operands_name)                                   \
-  (const iree_vm_register_remap_list_t*)&bytecode_data[pc];                   \
-  pc +=                                                                       \
-      kRegSize + ((const iree_vm_register_list_t*)&bytecode_data[pc])->size * \
-                     2 * kRegSize;
+#define VM_DecBranchOperands(operands_name)                            \
+  (const iree_vm_register_remap_list_t*)&bytecode_data[pc];            \
+  pc += kRegSize +                                                     \
+        ((const iree_vm_register_remap_list_t*)&bytecode_data[pc])     \
+                ->size *                                               \
+            3 * kRegSize;                                              \
+  pc += kRegSize +                                                     \
+        ((const iree_vm_register_ref_remap_list_t*)&bytecode_data[pc]) \
+                ->size *                                               \
+            2 * kRegSize;
 #define VM_DecOperandRegI32(name)      \
   regs.i32[OP_I16(0) & regs.i32_mask]; \
   pc += kRegSize;
@@ -338,8 +387,8 @@ static const int kRegSize = sizeof(uint16_t);
     return iree_make_status(IREE_STATUS_UNIMPLEMENTED, \
                             "unhandled core opcode");  \
   }
-#define DISPATCH_UNHANDLED_EXT                             \
-  () default : {                                           \
+#define DISPATCH_UNHANDLED_EXT()                           \
+  default: {                                               \
     VMCHECK(0);                                            \
     return iree_make_status(IREE_STATUS_UNIMPLEMENTED,     \
                             "unhandled extension opcode"); \
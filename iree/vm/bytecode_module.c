@@ -121,6 +121,16 @@ static iree_status_t iree_vm_bytecode_module_flatbuffer_verify(
   iree_vm_BytecodeModuleDef_table_t module_def =
       iree_vm_BytecodeModuleDef_as_root(flatbuffer_data.data);
 
+  uint32_t bytecode_version =
+      iree_vm_BytecodeModuleDef_bytecode_version(module_def);
+  if (bytecode_version != IREE_VM_BYTECODE_VERSION) {
+    return iree_make_status(
+        IREE_STATUS_UNIMPLEMENTED,
+        "module bytecode version %u is not supported by this runtime "
+        "(expected %u); recompile the module with a matching compiler",
+        bytecode_version, IREE_VM_BYTECODE_VERSION);
+  }
+
   flatbuffers_string_t name = iree_vm_BytecodeModuleDef_name(module_def);
   if (!flatbuffers_string_len(name)) {
     return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
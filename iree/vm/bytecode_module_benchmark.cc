@@ -74,11 +74,27 @@ static iree_status_t native_import_module_create(
       &interface, &native_import_module_descriptor_, allocator, out_module);
 }
 
+// Name of the interpreter dispatch mode this binary was built with. The same
+// source is built as bytecode_module_benchmark and
+// bytecode_module_switch_benchmark so results can be compared across modes.
+#if defined(IREE_VM_BYTECODE_DISPATCH_COMPUTED_GOTO) && \
+    !IREE_VM_BYTECODE_DISPATCH_COMPUTED_GOTO
+static const char kDispatchMode[] = "switch";
+#elif defined(_MSC_VER) && !defined(__clang__)
+static const char kDispatchMode[] = "switch";
+#else
+static const char kDispatchMode[] = "computed_goto";
+#endif  // IREE_VM_BYTECODE_DISPATCH_COMPUTED_GOTO
+
 // Benchmarks the given exported function, optionally passing in arguments.
+// If |ops_per_item| is provided then the average time per executed bytecode op
+// is reported as the ns_per_op counter, where each of the |batch_size| items
+// processed per call executes |ops_per_item| ops.
 static iree_status_t RunFunction(benchmark::State& state,
                                  absl::string_view function_name,
                                  absl::Span<const int32_t> i32_args,
-                                 int result_count, int64_t batch_size = 1) {
+                                 int result_count, int64_t batch_size = 1,
+                                 int64_t ops_per_item = 0) {
   iree_vm_instance_t* instance = NULL;
   IREE_CHECK_OK(iree_vm_instance_create(iree_allocator_system(), &instance));
 
@@ -119,6 +135,7 @@ static iree_status_t RunFunction(benchmark::State& state,
 
   IREE_VM_INLINE_STACK_INITIALIZE(
       stack, iree_vm_context_state_resolver(context), iree_allocator_system());
+  iree_time_t start_time_ns = iree_time_now();
   while (state.KeepRunningBatch(batch_size)) {
     for (iree_host_size_t i = 0; i < i32_args.size(); ++i) {
       reinterpret_cast<int32_t*>(call.arguments.data)[i] = i32_args[i];
@@ -128,8 +145,16 @@ static iree_status_t RunFunction(benchmark::State& state,
     IREE_CHECK_OK(bytecode_module->begin_call(bytecode_module->self, stack,
                                               &call, &result));
   }
+  iree_time_t end_time_ns = iree_time_now();
   iree_vm_stack_deinitialize(stack);
 
+  state.SetLabel(kDispatchMode);
+  if (ops_per_item > 0 && state.iterations() > 0) {
+    state.counters["ns_per_op"] =
+        static_cast<double>(end_time_ns - start_time_ns) /
+        (static_cast<double>(state.iterations()) * ops_per_item);
+  }
+
   iree_vm_module_release(import_module);
   iree_vm_module_release(bytecode_module);
   iree_vm_context_release(context);
@@ -301,8 +326,36 @@ static void BM_LoopSumBytecode(benchmark::State& state) {
   IREE_CHECK_OK(RunFunction(state, "bytecode_module_benchmark.loop_sum",
                             {static_cast<int32_t>(state.range(0))},
                             /*result_count=*/1,
-                            /*batch_size=*/state.range(0)));
+                            /*batch_size=*/state.range(0),
+                            /*ops_per_item=*/3));
 }
 BENCHMARK(BM_LoopSumBytecode)->Arg(100000);
 
+static void BM_LoopAluBytecode(benchmark::State& state) {
+  IREE_CHECK_OK(RunFunction(state, "bytecode_module_benchmark.loop_alu",
+                            {static_cast<int32_t>(state.range(0))},
+                            /*result_count=*/1,
+                            /*batch_size=*/state.range(0),
+                            /*ops_per_item=*/7));
+}
+BENCHMARK(BM_LoopAluBytecode)->Arg(100000);
+
+static void BM_LoopListBytecode(benchmark::State& state) {
+  IREE_CHECK_OK(RunFunction(state, "bytecode_module_benchmark.loop_list",
+                            {static_cast<int32_t>(state.range(0))},
+                            /*result_count=*/1,
+                            /*batch_size=*/state.range(0),
+                            /*ops_per_item=*/7));
+}
+BENCHMARK(BM_LoopListBytecode)->Arg(100000);
+
+static void BM_LoopRemapBytecode(benchmark::State& state) {
+  IREE_CHECK_OK(RunFunction(state, "bytecode_module_benchmark.loop_remap",
+                            {static_cast<int32_t>(state.range(0))},
+                            /*result_count=*/1,
+                            /*batch_size=*/state.range(0),
+                            /*ops_per_item=*/3));
+}
+BENCHMARK(BM_LoopRemapBytecode)->Arg(100000);
+
 }  // namespace
@@ -76,4 +76,68 @@ vm.module @bytecode_module_benchmark {
   ^loop_exit(%ie : i32):
     vm.return %ie : i32
   }
+
+  // Measures a loop dominated by i32 arithmetic (like shape calculations).
+  // Executes 7 ops per iteration.
+  vm.export @loop_alu
+  vm.func @loop_alu(%count : i32) -> i32 {
+    %c1 = vm.const.i32 1 : i32
+    %c3 = vm.const.i32 3 : i32
+    %c255 = vm.const.i32 255 : i32
+    %zero = vm.const.i32.zero : i32
+    vm.br ^loop(%zero, %zero : i32, i32)
+  ^loop(%i : i32, %acc : i32):
+    %0 = vm.mul.i32 %i, %c3 : i32
+    %1 = vm.add.i32 %0, %acc : i32
+    %2 = vm.and.i32 %1, %c255 : i32
+    %acc_next = vm.xor.i32 %2, %i : i32
+    %in = vm.add.i32 %i, %c1 : i32
+    %cmp = vm.cmp.lt.i32.s %in, %count : i32
+    vm.cond_br %cmp, ^loop(%in, %acc_next : i32, i32), ^loop_exit(%acc_next : i32)
+  ^loop_exit(%result : i32):
+    vm.return %result : i32
+  }
+
+  // Measures a loop reading and writing list elements.
+  // Executes 7 ops per iteration.
+  vm.export @loop_list
+  vm.func @loop_list(%count : i32) -> i32 {
+    %c1 = vm.const.i32 1 : i32
+    %c15 = vm.const.i32 15 : i32
+    %c16 = vm.const.i32 16 : i32
+    %zero = vm.const.i32.zero : i32
+    %list = vm.list.alloc %c16 : (i32) -> !vm.list<i32>
+    vm.list.resize %list, %c16 : (!vm.list<i32>, i32)
+    vm.br ^loop(%zero : i32)
+  ^loop(%i : i32):
+    %index = vm.and.i32 %i, %c15 : i32
+    %value = vm.list.get.i32 %list, %index : (!vm.list<i32>, i32) -> i32
+    %value_next = vm.add.i32 %value, %i : i32
+    vm.list.set.i32 %list, %index, %value_next : (!vm.list<i32>, i32, i32)
+    %in = vm.add.i32 %i, %c1 : i32
+    %cmp = vm.cmp.lt.i32.s %in, %count : i32
+    vm.cond_br %cmp, ^loop(%in : i32), ^loop_exit(%in : i32)
+  ^loop_exit(%ie : i32):
+    vm.return %ie : i32
+  }
+
+  // Measures branch register remapping on a loop back-edge carrying several
+  // i32 values and refs that get rotated each iteration.
+  // Executes 3 ops per iteration.
+  vm.export @loop_remap
+  vm.func @loop_remap(%count : i32) -> i32 {
+    %c1 = vm.const.i32 1 : i32
+    %c2 = vm.const.i32 2 : i32
+    %c3 = vm.const.i32 3 : i32
+    %zero = vm.const.i32.zero : i32
+    %list0 = vm.list.alloc %c1 : (i32) -> !vm.list<i32>
+    %list1 = vm.list.alloc %c1 : (i32) -> !vm.list<i32>
+    vm.br ^loop(%zero, %c1, %c2, %c3, %zero, %list0, %list1 : i32, i32, i32, i32, i32, !vm.list<i32>, !vm.list<i32>)
+  ^loop(%i : i32, %a : i32, %b : i32, %c : i32, %d : i32, %l0 : !vm.list<i32>, %l1 : !vm.list<i32>):
+    %in = vm.add.i32 %i, %c1 : i32
+    %cmp = vm.cmp.lt.i32.s %in, %count : i32
+    vm.cond_br %cmp, ^loop(%in, %b, %c, %d, %a, %l1, %l0 : i32, i32, i32, i32, i32, !vm.list<i32>, !vm.list<i32>), ^loop_exit(%a : i32)
+  ^loop_exit(%result : i32):
+    vm.return %result : i32
+  }
 }
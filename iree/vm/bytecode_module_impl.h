@@ -35,6 +35,13 @@
 extern "C" {
 #endif  // __cplusplus
 
+// Version of the bytecode op table and operand encoding implemented by the
+// interpreter. Must match the version written by the compiler (see
+// kBytecodeVersion in iree/compiler/Dialect/VM/Target/Bytecode/).
+//   0: initial encoding; modules without a recorded version.
+//   1: branch register remap lists split into i32 runs and ref pairs.
+#define IREE_VM_BYTECODE_VERSION 1u
+
 #define VMMAX(a, b) (((a) > (b)) ? (a) : (b))
 #define VMMIN(a, b) (((a) < (b)) ? (a) : (b))
 
@@ -0,0 +1,260 @@
+#!/usr/bin/env python3
+
+# Copyright 2021 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Tunes the LLVM AOT backend matmul tile sizes for a target CPU.
+
+Each matmul (MxNxK) or batch matmul (BxMxNxK) shape is compiled with a set of
+candidate tile size configurations and benchmarked with iree-benchmark-module
+on the host. The fastest configuration for each shape is written to a tuning
+database that iree-translate reads with
+--iree-codegen-linalg-to-llvm-kernel-dispatch-tuning-db.
+
+The benchmarks run on the host, so --target_cpu should name the host CPU (or
+the script should be run on a machine with the target CPU).
+
+Example usage:
+  ./tune_llvm_matmul_tile_sizes.py IREE_BUILD_DIR \
+      --target_cpu=skylake-avx512 \
+      --shapes=384x512x128,4x256x256x64 \
+      --output=/tmp/matmul_tuning_db.json
+"""
+
+import argparse
+import itertools
+import json
+import os
+import subprocess
+import tempfile
+
+DEFAULT_WORKGROUP_TILE_SIZES = [32, 64, 128, 256]
+DEFAULT_L1_TILE_SIZES = [16, 32, 64]
+DEFAULT_VECTOR_TILE_SIZES = [4, 8]
+
+
+def parse_int_list(value):
+  return [int(v) for v in value.split(',')]
+
+
+def parse_arguments():
+  """Parses command-line options."""
+  parser = argparse.ArgumentParser(
+      description='Tunes LLVM AOT matmul tile sizes for a target CPU')
+  parser.add_argument('build_dir',
+                      metavar='BUILD_PATH',
+                      type=str,
+                      help='Base build directory.')
+  parser.add_argument('--target_cpu',
+                      type=str,
+                      required=True,
+                      help='CPU passed to --iree-llvm-target-cpu.')
+  parser.add_argument(
+      '--shapes',
+      type=str,
+      required=True,
+      help='Comma-separated MxNxK matmul or BxMxNxK batch matmul shapes.')
+  parser.add_argument('--output',
+                      type=str,
+                      required=True,
+                      help='Path of the tuning database to write.')
+  parser.add_argument('--merge',
+                      action='store_true',
+                      help='Merge into an existing database at --output.')
+  parser.add_argument('--workgroup_tile_sizes',
+                      type=parse_int_list,
+                      default=DEFAULT_WORKGROUP_TILE_SIZES)
+  parser.add_argument('--l1_tile_sizes',
+                      type=parse_int_list,
+                      default=DEFAULT_L1_TILE_SIZES)
+  parser.add_argument('--vector_tile_sizes',
+                      type=parse_int_list,
+                      default=DEFAULT_VECTOR_TILE_SIZES)
+  parser.add_argument('--benchmark_repetitions', type=int, default=5)
+
+  parsed_args = parser.parse_args()
+  if not os.path.isdir(parsed_args.build_dir):
+    raise parser.error('expected path to a directory')
+  return parsed_args
+
+
+def parse_shape(shape_str):
+  shape = [int(d) for d in shape_str.split('x')]
+  if len(shape) not in (3, 4):
+    raise ValueError(f'expected MxNxK or BxMxNxK, got "{shape_str}"')
+  return shape
+
+
+def get_op_name(shape):
+  return 'linalg.batch_matmul' if len(shape) == 4 else 'linalg.matmul'
+
+
+def generate_module(shape):
+  """Returns an MLIR module with a single (batch) matmul of |shape|."""
+  if len(shape) == 3:
+    m, n, k = shape
+    lhs = f'tensor<{m}x{k}xf32>'
+    rhs = f'tensor<{k}x{n}xf32>'
+    result = f'tensor<{m}x{n}xf32>'
+    op = f'"mhlo.dot"(%lhs, %rhs) : ({lhs}, {rhs}) -> {result}'
+  else:
+    b, m, n, k = shape
+    lhs = f'tensor<{b}x{m}x{k}xf32>'
+    rhs = f'tensor<{b}x{k}x{n}xf32>'
+    result = f'tensor<{b}x{m}x{n}xf32>'
+    op = f'''"mhlo.dot_general"(%lhs, %rhs) {{
+      dot_dimension_numbers = {{
+        lhs_batching_dimensions = dense<0> : tensor<1xi64>,
+        lhs_contracting_dimensions = dense<2> : tensor<1xi64>,
+        rhs_batching_dimensions = dense<0> : tensor<1xi64>,
+        rhs_contracting_dimensions = dense<1> : tensor<1xi64>
+      }}}} : ({lhs}, {rhs}) -> {result}'''
+  return f'''func @matmul(%lhs: {lhs}, %rhs: {rhs}) -> {result}
+    attributes {{ iree.module.export }} {{
+  %0 = {op}
+  return %0 : {result}
+}}
+'''
+
+
+def get_function_inputs(shape):
+  """Returns the --function_inputs of the module for |shape|."""
+  if len(shape) == 3:
+    m, n, k = shape
+    return f'{m}x{k}xf32,{k}x{n}xf32'
+  b, m, n, k = shape
+  return f'{b}x{m}x{k}xf32,{b}x{k}x{n}xf32'
+
+
+def generate_candidates(shape, args):
+  """Yields the candidate tile sizes for each tiling level of |shape|."""
+  m, n, k = shape[-3:]
+  batch_prefix = [1] if len(shape) == 4 else []
+  for workgroup, l1, vector in itertools.product(args.workgroup_tile_sizes,
+                                                 args.l1_tile_sizes,
+                                                 args.vector_tile_sizes):
+    if l1 > workgroup or vector > l1:
+      continue
+    # Skip tiles that exceed the problem; they only duplicate smaller ones.
+    if workgroup > max(m, n) or l1 > k:
+      continue
+    yield [
+        batch_prefix + [workgroup, workgroup],
+        batch_prefix + [l1, l1, l1],
+        batch_prefix + [vector, vector, vector],
+    ]
+
+
+def make_config(target_cpu, shape, tile_sizes):
+  return {
+      'target_cpu': target_cpu,
+      'op': get_op_name(shape),
+      'element_type': 'f32',
+      'shape': shape,
+      'tile_sizes': tile_sizes,
+  }
+
+
+def benchmark_config(args, work_dir, shape, tile_sizes):
+  """Returns the median time in ms of the module compiled with |tile_sizes|."""
+  tools_dir = os.path.join(args.build_dir, 'iree', 'tools')
+  module_path = os.path.join(work_dir, 'matmul.mlir')
+  database_path = os.path.join(work_dir, 'candidate.json')
+  vmfb_path = os.path.join(work_dir, 'matmul.vmfb')
+  with open(module_path, 'w') as f:
+    f.write(generate_module(shape))
+  with open(database_path, 'w') as f:
+    json.dump({'configs': [make_config(args.target_cpu, shape, tile_sizes)]},
+              f)
+
+  subprocess.run([
+      os.path.join(tools_dir, 'iree-translate'),
+      '--iree-mlir-to-vm-bytecode-module',
+      '--iree-hal-target-backends=dylib-llvm-aot',
+      f'--iree-llvm-target-cpu={args.target_cpu}',
+      '--iree-codegen-linalg-to-llvm-kernel-dispatch-tuning-db=' +
+      database_path,
+      module_path,
+      '-o',
+      vmfb_path,
+  ],
+                 check=True)
+  process = subprocess.run(
+      [
+          os.path.join(tools_dir, 'iree-benchmark-module'),
+          f'--module_file={vmfb_path}',
+          '--driver=dylib',
+          '--entry_function=matmul',
+          f'--function_inputs={get_function_inputs(shape)}',
+          f'--benchmark_repetitions={args.benchmark_repetitions}',
+          '--benchmark_report_aggregates_only=true',
+          '--benchmark_format=json',
+      ],
+      check=True,
+      # TODO(#4131) python>=3.7: Use capture_output=True.
+      stdout=subprocess.PIPE,
+      # TODO(#4131) python>=3.7: Replace 'universal_newlines' with 'text'.
+      universal_newlines=True)
+  benchmarks = json.loads(process.stdout)['benchmarks']
+  medians = [b for b in benchmarks if b['name'].endswith('_median')]
+  result = (medians or benchmarks)[0]
+  to_ms = {'ns': 1e-6, 'us': 1e-3, 'ms': 1.0, 's': 1e3}
+  return result['real_time'] * to_ms[result['time_unit']]
+
+
+def tune_shape(args, work_dir, shape):
+  """Returns the fastest tile sizes for |shape| and their time in ms."""
+  best_tile_sizes = None
+  best_time_ms = None
+  for tile_sizes in generate_candidates(shape, args):
+    try:
+      time_ms = benchmark_config(args, work_dir, shape, tile_sizes)
+    except subprocess.CalledProcessError as e:
+      print(f'  {tile_sizes}: failed ({e})')
+      continue
+    print(f'  {tile_sizes}: {time_ms:.3f} ms')
+    if best_time_ms is None or time_ms < best_time_ms:
+      best_tile_sizes = tile_sizes
+      best_time_ms = time_ms
+  return best_tile_sizes, best_time_ms
+
+
+def main(args):
+  configs = []
+  if args.merge and os.path.exists(args.output):
+    with open(args.output) as f:
+      configs = json.load(f)['configs']
+
+  with tempfile.TemporaryDirectory() as work_dir:
+    for shape_str in args.shapes.split(','):
+      shape = parse_shape(shape_str)
+      print(f'Tuning {get_op_name(shape)} {shape_str} for {args.target_cpu}')
+      tile_sizes, time_ms = tune_shape(args, work_dir, shape)
+      if tile_sizes is None:
+        print('  no candidate succeeded; skipping')
+        continue
+      print(f'  best: {tile_sizes} ({time_ms:.3f} ms)')
+      config = make_config(args.target_cpu, shape, tile_sizes)
+      configs = [
+          c for c in configs if (c.get('target_cpu'), c['op'], c['shape']) !=
+          (args.target_cpu, config['op'], shape)
+      ]
+      configs.append(config)
+
+  with open(args.output, 'w') as f:
+    json.dump({'configs': configs}, f, indent=2)
+    f.write('\n')
+
+
+if __name__ == '__main__':
+  main(parse_arguments())